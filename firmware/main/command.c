@@ -0,0 +1,331 @@
+/**
+ * @file command.c
+ * @brief Text command dispatch shared by all interfaces
+ */
+
+#include "command.h"
+#include "crockpot.h"
+#include "fleet.h"
+#include "metrics.h"
+#include "ota.h"
+#include "schedule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct command command_t;
+
+/**
+ * @brief Command handler
+ *
+ * @param cmd     Table entry (for its arg)
+ * @param args    Text after the verb, leading spaces skipped (may be "")
+ * @param out     Reply buffer
+ * @param out_len Reply buffer size
+ * @return true on success
+ */
+typedef bool (*command_handler_t)(const command_t* cmd, const char* args,
+                                  char* out, size_t out_len);
+
+struct command {
+    const char* verb;           // Lowercase, without '/'
+    command_handler_t handler;
+    int arg;                    // Handler-specific (e.g. target state)
+    command_access_t access;    // Least access that may run it
+    const char* help;           // NULL = not listed in help
+};
+
+static bool cmd_help(const command_t* cmd, const char* args, char* out, size_t out_len);
+
+static bool cmd_status(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd; (void)args;
+    crockpot_status_t status = crockpot_get_status();
+    char temp[12];
+    char setpoint[12];
+    temp_format_f(temp, sizeof(temp), status.temperature);
+    temp_format_f(setpoint, sizeof(setpoint), status.setpoint);
+
+    snprintf(out, out_len,
+        "Crockpot Status:\n"
+        "State: %s\n"
+        "Temperature: %s F\n"
+        "Setpoint: %s F (heater %u%%)\n"
+        "Uptime: %lu seconds\n"
+        "WiFi: %s\n"
+        "Sensor: %s",
+        crockpot_state_to_string(status.state),
+        temp,
+        setpoint, status.heater_duty_pct,
+        (unsigned long)status.uptime_seconds,
+        status.wifi_connected ? "Connected" : "Disconnected",
+        status.sensor_error ? "ERROR" : "OK"
+    );
+    return true;
+}
+
+static bool cmd_stats(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd; (void)args;
+    metrics_format_summary(out, out_len);
+    return true;
+}
+
+static bool cmd_set_state(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)args;
+    crockpot_state_t state = (crockpot_state_t)cmd->arg;
+    const char* name = crockpot_state_to_string(state);
+
+    if (!crockpot_set_state(state)) {
+        if (state == CROCKPOT_OFF) {
+            snprintf(out, out_len, "Failed to turn off crockpot");
+        } else {
+            snprintf(out, out_len, "Failed to set crockpot to %s", cmd->verb);
+        }
+        return false;
+    }
+
+    if (state == CROCKPOT_OFF) {
+        snprintf(out, out_len, "Crockpot turned OFF");
+    } else {
+        snprintf(out, out_len, "Crockpot set to %s", name);
+    }
+    return true;
+}
+
+static bool cmd_setpoint(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd;
+    temp_cc_t setpoint;
+
+    if (!temp_parse_f(args, &setpoint)) {
+        snprintf(out, out_len, "Usage: /setpoint <%d-%d F>",
+                 CROCKPOT_SETPOINT_MIN_F, CROCKPOT_SETPOINT_MAX_F);
+        return false;
+    }
+
+    char temp[12];
+    temp_format_f(temp, sizeof(temp), setpoint);
+
+    if (!crockpot_set_setpoint(setpoint)) {
+        snprintf(out, out_len, "Cannot set %s F (range %d-%d F, not while OFF)",
+                 temp, CROCKPOT_SETPOINT_MIN_F, CROCKPOT_SETPOINT_MAX_F);
+        return false;
+    }
+
+    snprintf(out, out_len, "Setpoint set to %s F", temp);
+    return true;
+}
+
+static bool cmd_fleet(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd;
+
+    if (*args != '\0') {
+        snprintf(out, out_len, "Usage: /fleet (to join: /join <N> <key>)");
+        return false;
+    }
+
+    fleet_format_status(out, out_len);
+    return true;
+}
+
+// Admin only: the key is all that authenticates fleet packets, and routed
+// commands run with admin access on the receiving pot
+static bool cmd_join(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd;
+
+    // "<pot> [key]" or "off"
+    char* end;
+    unsigned long pot = strtoul(args, &end, 10);
+    const char* key = end;
+    while (isspace((unsigned char)*key)) key++;
+    if (strcasecmp(args, "off") == 0) {
+        pot = 0;
+        key = "";
+    } else if (end == args || (*end != '\0' && !isspace((unsigned char)*end)) ||
+               pot < 1 || pot > 255) {
+        snprintf(out, out_len, "Usage: /join <pot 1-255> [key] | off");
+        return false;
+    }
+
+    size_t key_len = strlen(key);
+    if (key_len > 0 && (key_len < FLEET_KEY_MIN_LEN || key_len > FLEET_KEY_MAX_LEN)) {
+        snprintf(out, out_len, "Fleet key must be %d-%d characters",
+                 FLEET_KEY_MIN_LEN, FLEET_KEY_MAX_LEN);
+        return false;
+    }
+
+    if (!fleet_set_pot((uint8_t)pot, key_len > 0 ? key : NULL)) {
+        snprintf(out, out_len, "Failed to save fleet setting");
+        return false;
+    }
+
+    if (pot == 0) {
+        snprintf(out, out_len, "Fleet mode off after the next reboot");
+    } else {
+        snprintf(out, out_len, "Joining the fleet as pot%lu after the next reboot%s", pot,
+                 fleet_has_key() ? "" : " (set the fleet key first: /join <N> <key>)");
+    }
+    return true;
+}
+
+static bool cmd_schedule(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd;
+    schedule_program_t program;
+
+    if (*args == '\0') {
+        schedule_format_status(out, out_len);
+        return true;
+    }
+
+    if (strcasecmp(args, "stop") == 0) {
+        schedule_stop();
+        snprintf(out, out_len, "Program stopped");
+        return true;
+    }
+
+    if (!schedule_parse(args, &program)) {
+        snprintf(out, out_len,
+                 "Usage: /schedule <steps> | stop\n"
+                 "Step: <state> [2h|90m] [until >=180]\n"
+                 "Example: /schedule high until 180, low 6h, warm\n"
+                 "Presets: slowcook, quickwarm, allday");
+        return false;
+    }
+
+    if (!schedule_start(&program)) {
+        snprintf(out, out_len, "Failed to start program");
+        return false;
+    }
+
+    schedule_format_status(out, out_len);
+    return true;
+}
+
+static bool cmd_update(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd;
+
+    if (*args == '\0') {
+        ota_format_status(out, out_len);
+        return true;
+    }
+
+    // "<url> [sha256]"
+    char url[OTA_URL_MAX_LEN + 2];
+    size_t len = 0;
+    while (args[len] && !isspace((unsigned char)args[len]) && len < sizeof(url) - 1) {
+        url[len] = args[len];
+        len++;
+    }
+    url[len] = '\0';
+
+    const char* sha = args + len;
+    while (*sha && !isspace((unsigned char)*sha)) sha++;    // Rest of an over-long URL
+    while (isspace((unsigned char)*sha)) sha++;
+
+    return ota_start(url, *sha ? sha : NULL, out, out_len);
+}
+
+// Sorted by verb for bsearch(); keep it that way when adding commands
+static const command_t s_commands[] = {
+    { "fleet",    cmd_fleet,     0,             COMMAND_ACCESS_USER,  "Show the fleet" },
+    { "help",     cmd_help,      0,             COMMAND_ACCESS_USER,  "Show this help" },
+    { "high",     cmd_set_state, CROCKPOT_HIGH, COMMAND_ACCESS_USER,  "Set to high" },
+    { "join",     cmd_join,      0,             COMMAND_ACCESS_ADMIN, "Join the fleet as pot N, or leave it (off)" },
+    { "low",      cmd_set_state, CROCKPOT_LOW,  COMMAND_ACCESS_USER,  "Set to low" },
+    { "off",      cmd_set_state, CROCKPOT_OFF,  COMMAND_ACCESS_USER,  "Turn off" },
+    { "schedule", cmd_schedule,  0,             COMMAND_ACCESS_USER,  "Show, start or stop a program" },
+    { "setpoint", cmd_setpoint,  0,             COMMAND_ACCESS_USER,  "Set target temperature (F)" },
+    { "start",    cmd_status,    0,             COMMAND_ACCESS_USER,  NULL },
+    { "stats",    cmd_stats,     0,             COMMAND_ACCESS_USER,  "Show task, heap and latency stats" },
+    { "status",   cmd_status,    0,             COMMAND_ACCESS_USER,  "Show current status" },
+    { "update",   cmd_update,    0,             COMMAND_ACCESS_ADMIN, "Show firmware, or update from an HTTPS URL" },
+    { "warm",     cmd_set_state, CROCKPOT_WARM, COMMAND_ACCESS_USER,  "Set to warm" },
+};
+
+#define COMMAND_COUNT (sizeof(s_commands) / sizeof(s_commands[0]))
+
+static bool cmd_help(const command_t* cmd, const char* args, char* out, size_t out_len)
+{
+    (void)cmd; (void)args;
+    size_t n = (size_t)snprintf(out, out_len, "IoT Crockpot Commands:");
+
+    for (size_t i = 0; i < COMMAND_COUNT && n < out_len; i++) {
+        if (s_commands[i].help != NULL) {
+            n += (size_t)snprintf(out + n, out_len - n, "\n/%s - %s",
+                                  s_commands[i].verb, s_commands[i].help);
+        }
+    }
+    return true;
+}
+
+static int compare_verb(const void* key, const void* elem)
+{
+    return strcmp((const char*)key, ((const command_t*)elem)->verb);
+}
+
+command_result_t command_execute(const char* line, command_access_t access,
+                                 char* out, size_t out_len)
+{
+    if (line == NULL || out == NULL || out_len == 0) {
+        return COMMAND_UNKNOWN;
+    }
+
+    while (isspace((unsigned char)*line)) line++;
+    const char* word = line;
+    if (*line == '/') line++;
+
+    // Lowercase verb up to whitespace or "@botname"
+    char verb[COMMAND_VERB_MAX_LEN + 1];
+    size_t len = 0;
+    while (line[len] && !isspace((unsigned char)line[len]) && line[len] != '@') {
+        if (len == COMMAND_VERB_MAX_LEN) {
+            len = 0;    // Too long to be a verb
+            break;
+        }
+        verb[len] = (char)tolower((unsigned char)line[len]);
+        len++;
+    }
+    verb[len] = '\0';
+
+    const char* verb_end = line + strlen(verb);
+    while (*verb_end && !isspace((unsigned char)*verb_end) && *verb_end != '@') verb_end++;
+    const char* args = verb_end;
+    while (*args && !isspace((unsigned char)*args)) args++;    // Skip @botname
+    while (isspace((unsigned char)*args)) args++;
+
+    const command_t* cmd = (len > 0)
+        ? bsearch(verb, s_commands, COMMAND_COUNT, sizeof(s_commands[0]), compare_verb)
+        : NULL;
+
+    // "/pot3 high" runs "high" on fleet pot 3
+    if (cmd == NULL && strncmp(verb, "pot", 3) == 0 && isdigit((unsigned char)verb[3])) {
+        char* end;
+        unsigned long pot = strtoul(verb + 3, &end, 10);
+        if (*end == '\0' && pot >= 1 && pot <= 255) {
+            return fleet_route((uint8_t)pot, args, access, out, out_len)
+                   ? COMMAND_OK : COMMAND_FAILED;
+        }
+    }
+
+    if (cmd == NULL) {
+        snprintf(out, out_len, "Unknown command: %.*s\nType /help for available commands.",
+                 (int)(verb_end - word), word);
+        return COMMAND_UNKNOWN;
+    }
+
+    if (access < cmd->access) {
+        snprintf(out, out_len, "/%s is not allowed from here", cmd->verb);
+        return COMMAND_FAILED;
+    }
+
+    return cmd->handler(cmd, args, out, out_len) ? COMMAND_OK : COMMAND_FAILED;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file command.h
+ * @brief Text command dispatch shared by all interfaces
+ *
+ * One table of verbs ("status", "high", ...) with handlers that write
+ * their reply into a caller-provided buffer. Telegram, and later the
+ * HTTP and MQTT frontends, pass the raw command text to
+ * command_execute() and send back whatever it wrote. Each verb has an
+ * access level; the caller says how far it trusts the sender.
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What the sender of a command may do
+ *
+ * Each interface decides how far it trusts its sender (see
+ * TELEGRAM_ADMIN_CHATS, MQTT_ADMIN_COMMANDS); the local network is never
+ * trusted with admin commands.
+ */
+typedef enum {
+    COMMAND_ACCESS_USER,    // Operate the pot: state, setpoint, programs, status
+    COMMAND_ACCESS_ADMIN    // Also replace the firmware and change the fleet key
+} command_access_t;
+
+/**
+ * @brief Command outcome
+ */
+typedef enum {
+    COMMAND_OK,         // Handled; reply written
+    COMMAND_FAILED,     // Handler ran but the action failed; reply explains
+    COMMAND_UNKNOWN     // No such verb; reply points at help
+} command_result_t;
+
+/**
+ * @brief Parse and run one command
+ *
+ * Accepts "verb [args]" with an optional leading '/' and an optional
+ * "@botname" suffix on the verb. Verbs are case-insensitive. Nothing is
+ * allocated; the reply is always null-terminated (truncated if needed).
+ *
+ * @param line    Command text, e.g. "/status" or "high"
+ * @param access  What the sender may do (commands above it are refused)
+ * @param out     Reply buffer
+ * @param out_len Reply buffer size
+ * @return Outcome
+ */
+command_result_t command_execute(const char* line, command_access_t access,
+                                 char* out, size_t out_len);
+
+// Longest verb accepted (longer input is unknown)
+#define COMMAND_VERB_MAX_LEN 16
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_H
@@ -0,0 +1,255 @@
+/**
+ * @file config.c
+ * @brief Persistent user settings
+ *
+ * NVS layout: one blob, a config_header_t followed by the first
+ * header.length bytes of config_t. The CRC32 covers those bytes.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crc.h"
+#include "nvs.h"
+
+static const char* TAG = "config";
+
+typedef struct __attribute__((packed)) {
+    uint16_t version;
+    uint16_t length;            // Bytes of config_t that follow
+    uint32_t crc;
+} config_header_t;
+
+typedef struct __attribute__((packed)) {
+    config_header_t header;
+    config_t config;
+} config_blob_t;
+
+typedef struct {
+    uint32_t sections;
+    config_listener_t fn;
+    void* user_data;
+} config_listener_entry_t;
+
+// Settings, dirty flag and listeners (s_mutex)
+static SemaphoreHandle_t s_mutex = NULL;
+static config_t s_config;
+static bool s_dirty = false;
+static config_listener_entry_t s_listeners[CONFIG_MAX_LISTENERS];
+static uint8_t s_listener_count = 0;
+
+// Serializes writes so an older snapshot never lands after a newer one
+static SemaphoreHandle_t s_write_mutex = NULL;
+static config_blob_t s_blob;
+
+// The timer only wakes the writer task: a flash write or page erase must
+// not run on the esp_timer task, where it would stall input scanning
+static esp_timer_handle_t s_commit_timer = NULL;
+static TaskHandle_t s_writer_task = NULL;
+static nvs_handle_t s_nvs;
+static bool s_nvs_open = false;
+
+static void load(void)
+{
+    size_t size = sizeof(s_blob);
+    esp_err_t err = nvs_get_blob(s_nvs, CONFIG_NVS_KEY, &s_blob, &size);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(TAG, "No saved settings, using defaults");
+        return;
+    }
+    if (err != ESP_OK || size < sizeof(config_header_t)) {
+        ESP_LOGW(TAG, "Unreadable settings (%s), using defaults", esp_err_to_name(err));
+        return;
+    }
+
+    const config_header_t* header = &s_blob.header;
+    if (header->version != CONFIG_VERSION ||
+        header->length > sizeof(config_t) ||
+        size != sizeof(config_header_t) + header->length ||
+        header->crc != esp_crc32_le(0, (const uint8_t*)&s_blob.config, header->length)) {
+        ESP_LOGW(TAG, "Saved settings invalid (version %u, %u bytes), using defaults",
+                 header->version, header->length);
+        return;
+    }
+
+    // Shorter blobs come from older firmware: newer fields keep defaults
+    memcpy(&s_config, &s_blob.config, header->length);
+
+    // Strings are stored terminated; make sure of it
+    s_config.wifi_ssid[sizeof(s_config.wifi_ssid) - 1] = '\0';
+    s_config.wifi_password[sizeof(s_config.wifi_password) - 1] = '\0';
+    s_config.telegram_token[sizeof(s_config.telegram_token) - 1] = '\0';
+    s_config.mqtt_broker_uri[sizeof(s_config.mqtt_broker_uri) - 1] = '\0';
+    s_config.fleet_key[sizeof(s_config.fleet_key) - 1] = '\0';
+
+    ESP_LOGI(TAG, "Settings loaded (sections 0x%02lx)", (unsigned long)s_config.saved);
+}
+
+static bool write_pending(void)
+{
+    if (!s_nvs_open) {
+        return !s_dirty;
+    }
+
+    xSemaphoreTake(s_write_mutex, portMAX_DELAY);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool dirty = s_dirty;
+    if (dirty) {
+        s_blob.config = s_config;
+        s_dirty = false;
+    }
+    xSemaphoreGive(s_mutex);
+
+    bool ok = true;
+    if (dirty) {
+        s_blob.header.version = CONFIG_VERSION;
+        s_blob.header.length = sizeof(config_t);
+        s_blob.header.crc = esp_crc32_le(0, (const uint8_t*)&s_blob.config, sizeof(config_t));
+
+        ok = nvs_set_blob(s_nvs, CONFIG_NVS_KEY, &s_blob, sizeof(s_blob)) == ESP_OK &&
+             nvs_commit(s_nvs) == ESP_OK;
+        if (ok) {
+            ESP_LOGI(TAG, "Settings saved");
+        } else {
+            ESP_LOGW(TAG, "Failed to save settings");
+            // Retry with the next edit or flush
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            s_dirty = true;
+            xSemaphoreGive(s_mutex);
+        }
+    }
+
+    xSemaphoreGive(s_write_mutex);
+    return ok;
+}
+
+static void commit_timer_cb(void* arg)
+{
+    xTaskNotifyGive(s_writer_task);
+}
+
+static void writer_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        write_pending();
+    }
+}
+
+bool config_init(void)
+{
+    if (s_mutex != NULL) {
+        return true;
+    }
+
+    s_mutex = xSemaphoreCreateMutex();
+    s_write_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL || s_write_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return false;
+    }
+
+    if (xTaskCreate(writer_task, "config", CONFIG_TASK_STACK_SIZE, NULL,
+                    CONFIG_TASK_PRIORITY, &s_writer_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        return false;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = commit_timer_cb,
+        .name = "config",
+    };
+    if (esp_timer_create(&timer_args, &s_commit_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create commit timer");
+        return false;
+    }
+
+    memset(&s_config, 0, sizeof(s_config));
+
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS unavailable (%s) - settings will not survive a reboot",
+                 esp_err_to_name(err));
+        return true;
+    }
+    s_nvs_open = true;
+
+    load();
+    return true;
+}
+
+const config_t* config_acquire(void)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    return &s_config;
+}
+
+void config_release(void)
+{
+    xSemaphoreGive(s_mutex);
+}
+
+config_t* config_edit(void)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    return &s_config;
+}
+
+void config_commit(uint32_t changed)
+{
+    if (changed == 0) {
+        xSemaphoreGive(s_mutex);
+        return;
+    }
+
+    s_config.saved |= changed;
+    s_dirty = true;
+
+    for (uint8_t i = 0; i < s_listener_count; i++) {
+        if (s_listeners[i].sections & changed) {
+            s_listeners[i].fn(changed, &s_config, s_listeners[i].user_data);
+        }
+    }
+
+    xSemaphoreGive(s_mutex);
+
+    // Restart the quiet period: a burst of edits becomes one write
+    if (s_nvs_open) {
+        esp_timer_stop(s_commit_timer);
+        esp_timer_start_once(s_commit_timer, (uint64_t)CONFIG_COMMIT_DELAY_MS * 1000);
+    }
+}
+
+bool config_flush(void)
+{
+    if (s_commit_timer != NULL) {
+        esp_timer_stop(s_commit_timer);
+    }
+    return write_pending();
+}
+
+bool config_add_listener(uint32_t sections, config_listener_t listener, void* user_data)
+{
+    if (listener == NULL) {
+        return false;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool ok = s_listener_count < CONFIG_MAX_LISTENERS;
+    if (ok) {
+        s_listeners[s_listener_count].sections = sections;
+        s_listeners[s_listener_count].fn = listener;
+        s_listeners[s_listener_count].user_data = user_data;
+        s_listener_count++;
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
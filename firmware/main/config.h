@@ -0,0 +1,153 @@
+/**
+ * @file config.h
+ * @brief Persistent user settings (one cached, versioned NVS blob)
+ *
+ * All settings live in a single config_t that is read from NVS once at
+ * boot and kept in RAM; reads never touch flash. Edits change the RAM
+ * copy, notify the interested modules at once and schedule a write: the
+ * blob is written (and committed) CONFIG_COMMIT_DELAY_MS after the last
+ * in a burst of edits, so a settings screen or a series of commands
+ * costs one flash write. The write runs on a low-priority task of its
+ * own, never on the esp_timer task.
+ *
+ * The blob carries a version, its length and a CRC32. A corrupt blob is
+ * ignored (defaults are used). Fields are only ever appended, so a blob
+ * written by older firmware is shorter and is loaded over the defaults.
+ *
+ * Each section has a bit in config_t.saved that is set once the section
+ * holds a user value; until then modules keep their built-in defaults.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gui.h"
+#include "touch_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Settings sections (bit flags)
+ */
+typedef enum {
+    CONFIG_SECTION_WIFI     = 1 << 0,
+    CONFIG_SECTION_TELEGRAM = 1 << 1,
+    CONFIG_SECTION_MQTT     = 1 << 2,
+    CONFIG_SECTION_GUI      = 1 << 3,
+    CONFIG_SECTION_THEME    = 1 << 4,
+    CONFIG_SECTION_TOUCH    = 1 << 5,
+    CONFIG_SECTION_FLEET    = 1 << 6
+} config_section_t;
+
+/**
+ * @brief All persistent settings (stored as-is in NVS; append only)
+ */
+typedef struct {
+    uint32_t saved;                     // config_section_t bits holding user values
+    char wifi_ssid[33];
+    char wifi_password[65];
+    char telegram_token[64];
+    char mqtt_broker_uri[128];
+    gui_config_t gui;
+    gui_theme_t theme;
+    touch_calibration_t touch;
+    uint8_t fleet_pot;                  // 0 = fleet mode off
+    char fleet_key[65];                 // Shared fleet secret ("" = build default)
+    uint32_t fleet_epoch;               // Fleet boots so far (replay protection)
+} config_t;
+
+/**
+ * @brief Settings change callback
+ *
+ * Called from the editing task with the store locked: copy what is
+ * needed and return. Do not call config_* functions from here.
+ *
+ * @param changed   config_section_t bits that changed
+ * @param config    Current settings (valid during the call only)
+ * @param user_data Value passed to config_add_listener()
+ */
+typedef void (*config_listener_t)(uint32_t changed, const config_t* config, void* user_data);
+
+/**
+ * @brief Load the settings from NVS into RAM
+ *
+ * Call after nvs_flash_init() and before any module that reads settings.
+ *
+ * @return true on success (also with no or an unusable saved blob, in
+ *         which case the defaults are used)
+ */
+bool config_init(void);
+
+/**
+ * @brief Lock the settings for reading
+ *
+ * @return Current settings; valid until config_release()
+ */
+const config_t* config_acquire(void);
+
+/**
+ * @brief Unlock after config_acquire()
+ */
+void config_release(void);
+
+/**
+ * @brief Lock the settings for editing
+ *
+ * @return Settings to modify in place; finish with config_commit()
+ */
+config_t* config_edit(void);
+
+/**
+ * @brief Finish an edit: notify listeners, unlock, schedule the write
+ *
+ * Marks the changed sections as saved.
+ *
+ * @param changed config_section_t bits that were modified (0 = none)
+ */
+void config_commit(uint32_t changed);
+
+/**
+ * @brief Write any pending changes now (e.g. before a restart)
+ *
+ * @return true if nothing was pending or the write succeeded
+ */
+bool config_flush(void);
+
+/**
+ * @brief Register a settings change callback
+ *
+ * @param sections  config_section_t bits of interest
+ * @param listener  Callback
+ * @param user_data Passed to the callback
+ * @return true on success, false if the listener table is full
+ */
+bool config_add_listener(uint32_t sections, config_listener_t listener, void* user_data);
+
+// Bump when the meaning of an existing field changes (blobs with another
+// version are discarded); appending fields needs no bump
+#define CONFIG_VERSION          1
+
+// Quiet time after the last edit before the blob is written
+#define CONFIG_COMMIT_DELAY_MS  2000
+
+// Writer task (low priority: a write is never urgent)
+#define CONFIG_TASK_STACK_SIZE  3072
+#define CONFIG_TASK_PRIORITY    1
+
+// Maximum change listeners
+#define CONFIG_MAX_LISTENERS    4
+
+// NVS location of the settings blob
+#define CONFIG_NVS_NAMESPACE    "config"
+#define CONFIG_NVS_KEY          "settings"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONFIG_H
@@ -4,8 +4,12 @@
  */
 
 #include "crockpot.h"
+#include "dlog.h"
 #include "temperature.h"
 #include "relay.h"
+#include "history.h"
+#include "pid.h"
+#include "metrics.h"
 #include "wifi.h"
 
 #include <string.h>
@@ -15,24 +19,141 @@
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_task_wdt.h"
 
 static const char* TAG = "crockpot";
 
-// State protection mutex
+// Serializes writers (control task vs crockpot_set_state callers).
+// Readers never take it; they read the published snapshot below.
 static SemaphoreHandle_t s_state_mutex = NULL;
 
-// Current state
+// Writers' working copy, only touched with s_state_mutex held
 static crockpot_status_t s_status = {
     .state = CROCKPOT_OFF,
-    .temperature_f = 0.0f,
+    .temperature = 0,
+    .setpoint = 0,
+    .heater_duty_pct = 0,
     .uptime_seconds = 0,
     .wifi_connected = false,
     .sensor_error = false
 };
 
+// Published snapshot (single-writer seqlock). s_seq is odd while a
+// publish is in progress; readers retry if it was odd or changed. The
+// copy is done in a short critical section so a reader can never preempt
+// a half-finished publish on the single-core C3 and spin on it.
+static crockpot_status_t s_published;
+static uint32_t s_seq = 0;
+static portMUX_TYPE s_publish_lock = portMUX_INITIALIZER_UNLOCKED;
+
 // Boot timestamp for uptime calculation
 static int64_t s_boot_time_us = 0;
 
+// Heater control, only touched with s_state_mutex held
+static pid_controller_t s_pid;
+static bool s_boost = false;
+
+// Heater forced off regardless of state (see crockpot_hold_heater())
+static volatile bool s_heater_hold = false;
+
+// Consecutive healthy control cycles (control task writes, anyone reads)
+static volatile uint32_t s_healthy_cycles = 0;
+
+// Status change listeners
+static struct {
+    crockpot_listener_t fn;
+    void* user_data;
+} s_listeners[CROCKPOT_MAX_LISTENERS];
+static uint8_t s_listener_count = 0;
+
+static void notify_listeners(void)
+{
+    for (uint8_t i = 0; i < s_listener_count; i++) {
+        s_listeners[i].fn(s_listeners[i].user_data);
+    }
+}
+
+/**
+ * @brief Publish s_status to readers (caller holds s_state_mutex)
+ *
+ * Skipped if nothing changed, so the generation counter only moves on
+ * real updates.
+ */
+static void publish_status(void)
+{
+    if (s_published.state == s_status.state &&
+        s_published.temperature == s_status.temperature &&
+        s_published.setpoint == s_status.setpoint &&
+        s_published.heater_duty_pct == s_status.heater_duty_pct &&
+        s_published.wifi_connected == s_status.wifi_connected &&
+        s_published.sensor_error == s_status.sensor_error) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_publish_lock);
+    __atomic_store_n(&s_seq, s_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s_published = s_status;
+    __atomic_store_n(&s_seq, s_seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&s_publish_lock);
+}
+
+/**
+ * @brief Check whether a status update is visible to listeners
+ */
+static bool status_changed(const crockpot_status_t* a, const crockpot_status_t* b)
+{
+    return a->state != b->state ||
+           a->setpoint != b->setpoint ||
+           a->heater_duty_pct != b->heater_duty_pct ||
+           a->wifi_connected != b->wifi_connected ||
+           a->sensor_error != b->sensor_error ||
+           temp_cc_to_f10(a->temperature) != temp_cc_to_f10(b->temperature);
+}
+
+/**
+ * @brief Stop heating and restart the controller (caller holds s_state_mutex)
+ */
+static void heater_reset(void)
+{
+    relay_set(RELAY_CHANNEL_MAIN, false);
+    relay_set(RELAY_CHANNEL_AUX, false);
+    pid_reset(&s_pid);
+    s_boost = false;
+    s_status.heater_duty_pct = 0;
+}
+
+/**
+ * @brief One control step for the heater (caller holds s_state_mutex)
+ *
+ * Runs the PID on the latest reading and hands the duty to the relay
+ * driver, which time-proportions the main SSR over
+ * CROCKPOT_HEATER_WINDOW_MS. With no valid reading the heater is held off
+ * rather than guessing.
+ */
+static void heater_update(const temperature_reading_t* reading)
+{
+    if (s_status.state == CROCKPOT_OFF || !reading->valid || s_heater_hold) {
+        heater_reset();
+        return;
+    }
+
+    int32_t duty = pid_update(&s_pid, s_status.setpoint, reading->temperature,
+                              CROCKPOT_CONTROL_INTERVAL_MS);
+
+    relay_set_duty(RELAY_CHANNEL_MAIN, (uint16_t)duty);
+    s_status.heater_duty_pct = (uint8_t)((duty + 5) / 10);
+
+    // Boost with the aux element while far below target at full duty
+    temp_cc_t error = s_status.setpoint - reading->temperature;
+    if (!s_boost && duty >= 1000 && error > CROCKPOT_BOOST_BAND) {
+        s_boost = true;
+    } else if (s_boost && (duty < 1000 || error < CROCKPOT_BOOST_BAND / 2)) {
+        s_boost = false;
+    }
+    relay_set(RELAY_CHANNEL_AUX, s_boost);
+}
+
 bool crockpot_init(void)
 {
     ESP_LOGI(TAG, "Initializing crockpot control system");
@@ -59,9 +180,22 @@ bool crockpot_init(void)
     // Ensure we start in OFF state
     relay_all_off();
 
+    relay_set_window_ms(CROCKPOT_HEATER_WINDOW_MS);
+    // Gains are given per F; the loop runs in temp_cc_t (1 F = 500/9 units)
+    pid_init(&s_pid,
+             PID_GAIN_Q16(CROCKPOT_PID_KP * 9 / 500),
+             PID_GAIN_Q16(CROCKPOT_PID_KI * 9 / 500),
+             PID_GAIN_Q16(CROCKPOT_PID_KD * 9 / 500),
+             0, 1000);
+
+    history_init();
+
     // Record boot time
     s_boot_time_us = esp_timer_get_time();
 
+    // Initial snapshot
+    s_published = s_status;
+
     ESP_LOGI(TAG, "Crockpot control system initialized");
     return true;
 }
@@ -69,41 +203,112 @@ bool crockpot_init(void)
 crockpot_status_t crockpot_get_status(void)
 {
     crockpot_status_t status;
+    uint32_t seq;
 
-    if (xSemaphoreTake(s_state_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        status = s_status;
-        xSemaphoreGive(s_state_mutex);
-    } else {
-        // Return last known state on timeout
-        status = s_status;
-    }
+    do {
+        seq = __atomic_load_n(&s_seq, __ATOMIC_ACQUIRE);
+        status = s_published;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&s_seq, __ATOMIC_RELAXED));
 
+    // Uptime is derived on read so it never forces a publish
+    status.uptime_seconds = (uint32_t)((esp_timer_get_time() - s_boot_time_us) / 1000000);
     return status;
 }
 
-bool crockpot_set_state(crockpot_state_t state)
+uint32_t crockpot_get_generation(void)
 {
-    ESP_LOGI(TAG, "Setting state to: %s", crockpot_state_to_string(state));
+    return __atomic_load_n(&s_seq, __ATOMIC_ACQUIRE) / 2;
+}
 
-    if (xSemaphoreTake(s_state_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire state mutex");
+bool crockpot_add_listener(crockpot_listener_t listener, void* user_data)
+{
+    if (listener == NULL || s_listener_count >= CROCKPOT_MAX_LISTENERS) {
         return false;
     }
 
-    // Apply state to relay
-    if (!relay_apply_state(state)) {
-        ESP_LOGE(TAG, "Failed to apply state to relay");
-        xSemaphoreGive(s_state_mutex);
+    s_listeners[s_listener_count].fn = listener;
+    s_listeners[s_listener_count].user_data = user_data;
+    s_listener_count++;
+    return true;
+}
+
+bool crockpot_set_state(crockpot_state_t state)
+{
+    if (xSemaphoreTake(s_state_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        DLOGE(TAG, "Failed to acquire state mutex");
         return false;
     }
 
+    // The control task drives the relays from the next tick; a new state
+    // starts from a clean controller and the state's default setpoint
+    bool changed = (s_status.state != state);
+    if (changed) {
+        heater_reset();
+    }
     s_status.state = state;
+    s_status.setpoint = crockpot_state_setpoint(state);
+    publish_status();
     xSemaphoreGive(s_state_mutex);
 
-    ESP_LOGI(TAG, "State changed to: %s", crockpot_state_to_string(state));
+    if (changed) {
+        notify_listeners();
+        DLOGI(TAG, "State changed to: %s", crockpot_state_to_string(state));
+    }
     return true;
 }
 
+uint32_t crockpot_get_healthy_cycles(void)
+{
+    return s_healthy_cycles;
+}
+
+void crockpot_hold_heater(bool hold)
+{
+    // Enforced in the relay driver, so a control step already past the
+    // s_heater_hold check cannot switch the heater back on
+    s_heater_hold = hold;
+    relay_hold_off(hold);
+}
+
+bool crockpot_set_setpoint(temp_cc_t setpoint)
+{
+    if (setpoint < CROCKPOT_SETPOINT_MIN || setpoint > CROCKPOT_SETPOINT_MAX) {
+        return false;
+    }
+
+    if (xSemaphoreTake(s_state_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        DLOGE(TAG, "Failed to acquire state mutex");
+        return false;
+    }
+
+    bool ok = (s_status.state != CROCKPOT_OFF);
+    bool changed = ok && s_status.setpoint != setpoint;
+    if (ok) {
+        s_status.setpoint = setpoint;
+        publish_status();
+    }
+    xSemaphoreGive(s_state_mutex);
+
+    if (changed) {
+        char buf[12];
+        temp_format_f(buf, sizeof(buf), setpoint);
+        DLOG_TEXT(ESP_LOG_INFO, TAG, "Setpoint changed to %s F", buf);
+        notify_listeners();
+    }
+    return ok;
+}
+
+temp_cc_t crockpot_state_setpoint(crockpot_state_t state)
+{
+    switch (state) {
+        case CROCKPOT_WARM: return CROCKPOT_SETPOINT_WARM;
+        case CROCKPOT_LOW:  return CROCKPOT_SETPOINT_LOW;
+        case CROCKPOT_HIGH: return CROCKPOT_SETPOINT_HIGH;
+        default:            return 0;
+    }
+}
+
 const char* crockpot_state_to_string(crockpot_state_t state)
 {
     switch (state) {
@@ -141,38 +346,93 @@ bool crockpot_state_from_string(const char* str, crockpot_state_t* out)
     return false;
 }
 
+crockpot_state_t crockpot_step_state(crockpot_state_t state, int direction)
+{
+    if (direction > 0 && state < CROCKPOT_HIGH) {
+        return (crockpot_state_t)(state + 1);
+    }
+    if (direction < 0 && state > CROCKPOT_OFF) {
+        return (crockpot_state_t)(state - 1);
+    }
+    return state;
+}
+
 void crockpot_control_task(void* pvParameters)
 {
     ESP_LOGI(TAG, "Control task started");
 
+    // A hung loop leaves the heater at its last duty; the watchdog
+    // (CONFIG_ESP_TASK_WDT_PANIC) resets into the relays-off boot state
+    if (esp_task_wdt_add(NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Task watchdog unavailable - control loop unsupervised");
+    }
+
+    const int64_t interval_us = CROCKPOT_CONTROL_INTERVAL_MS * 1000LL;
     TickType_t last_wake_time = xTaskGetTickCount();
+    int64_t expected_us = esp_timer_get_time();
+    int64_t prev_start_us = expected_us - interval_us;
+    uint8_t missed_deadlines = 0;
+    uint8_t mutex_failures = 0;
+    bool force_off = false;
+    bool first_cycle = true;
 
     while (1) {
+        esp_task_wdt_reset();
+
+        // Start-to-start jitter
+        int64_t start_us = esp_timer_get_time();
+        int64_t jitter_us = (start_us - prev_start_us) - interval_us;
+        metrics_observe(METRIC_CONTROL_JITTER_US,
+                        (uint32_t)(jitter_us < 0 ? -jitter_us : jitter_us));
+        prev_start_us = start_us;
+
+        // Deadline: lateness against the fixed schedule, so a late cycle
+        // is not excused by the catch-up cycles that follow it
+        if (start_us - expected_us > CROCKPOT_DEADLINE_SLACK_MS * 1000LL) {
+            metrics_count(METRIC_CONTROL_OVERRUNS, 1);
+            missed_deadlines++;
+        } else {
+            missed_deadlines = 0;
+        }
+        expected_us += interval_us;
+
         // Read temperature
         temperature_reading_t reading = temperature_read();
 
+        bool changed = false;
+        crockpot_state_t state = s_published.state;
+
         if (xSemaphoreTake(s_state_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            crockpot_status_t previous = s_status;
+            mutex_failures = 0;
+
+            // The relays were forced off when the loop was unhealthy;
+            // make the state agree so heating is not silently resumed
+            if (force_off) {
+                s_status.state = CROCKPOT_OFF;
+                s_status.setpoint = 0;
+                force_off = false;
+            }
+
             // Update temperature
             if (reading.valid) {
-                s_status.temperature_f = reading.temperature_f;
+                s_status.temperature = reading.temperature;
                 s_status.sensor_error = false;
             } else {
                 s_status.sensor_error = true;
             }
 
-            // Update uptime
-            int64_t now_us = esp_timer_get_time();
-            s_status.uptime_seconds = (uint32_t)((now_us - s_boot_time_us) / 1000000);
-
             // Update WiFi status
             s_status.wifi_connected = wifi_is_connected();
 
             // Safety check: auto-shutoff on high temperature
-            if (reading.valid && reading.temperature_f > CROCKPOT_SAFETY_TEMP_F) {
-                ESP_LOGW(TAG, "SAFETY: Temperature %.1f F exceeds limit, shutting off",
-                         reading.temperature_f);
+            if (reading.valid && reading.temperature > CROCKPOT_SAFETY_TEMP) {
+                char buf[12];
+                temp_format_f(buf, sizeof(buf), reading.temperature);
+                DLOG_TEXT(ESP_LOG_WARN, TAG,
+                          "SAFETY: Temperature %s F exceeds limit, shutting off", buf);
                 s_status.state = CROCKPOT_OFF;
-                relay_all_off();
+                s_status.setpoint = 0;
             }
 
             // Safety check: shut off on persistent sensor error while heating
@@ -180,16 +440,58 @@ void crockpot_control_task(void* pvParameters)
                 static int error_count = 0;
                 error_count++;
                 if (error_count > 10) {  // 10 consecutive errors
-                    ESP_LOGW(TAG, "SAFETY: Persistent sensor error, shutting off");
+                    DLOGW(TAG, "SAFETY: Persistent sensor error, shutting off");
                     s_status.state = CROCKPOT_OFF;
-                    relay_all_off();
+                    s_status.setpoint = 0;
                     error_count = 0;
                 }
             }
 
+            // Regulate (turns everything off if a safety check fired)
+            heater_update(&reading);
+
+            changed = status_changed(&previous, &s_status);
+            state = s_status.state;
+            publish_status();
             xSemaphoreGive(s_state_mutex);
+        } else {
+            // Safety checks and regulation were skipped this cycle
+            metrics_count(METRIC_CONTROL_MUTEX_TIMEOUTS, 1);
+            mutex_failures++;
+            DLOGW(TAG, "State mutex timeout (%u in a row)", mutex_failures);
+        }
+
+        // Run of cycles that were on time, read the sensor and ran the
+        // safety checks (the OTA health check waits for one)
+        bool healthy = missed_deadlines == 0 && mutex_failures == 0 && reading.valid;
+        s_healthy_cycles = healthy ? s_healthy_cycles + 1 : 0;
+
+        if (missed_deadlines >= CROCKPOT_MAX_MISSED_DEADLINES ||
+            mutex_failures >= CROCKPOT_MAX_MUTEX_FAILURES) {
+            DLOGE(TAG, "SAFETY: Control loop unhealthy (%u missed deadlines, "
+                  "%u mutex timeouts), forcing relays off",
+                  missed_deadlines, mutex_failures);
+            relay_all_off();
+            metrics_count(METRIC_CONTROL_ESCALATIONS, 1);
+            force_off = true;
+            missed_deadlines = 0;
+            mutex_failures = 0;
+        }
+
+        if (first_cycle) {
+            metrics_boot_stage(METRIC_BOOT_CONTROL);
+            first_cycle = false;
         }
 
+        // Notify outside the lock so listeners can read the new status
+        if (changed) {
+            notify_listeners();
+        }
+
+        history_append((uint32_t)((esp_timer_get_time() - s_boot_time_us) / 1000000),
+                       reading.raw_q, reading.valid, state,
+                       relay_get(RELAY_CHANNEL_MAIN), relay_get(RELAY_CHANNEL_AUX));
+
         // Wait for next cycle
         vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(CROCKPOT_CONTROL_INTERVAL_MS));
     }
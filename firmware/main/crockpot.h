@@ -12,6 +12,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "temperature.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,7 +33,9 @@ typedef enum {
  */
 typedef struct {
     crockpot_state_t state;
-    float temperature_f;
+    temp_cc_t temperature;
+    temp_cc_t setpoint;         // Regulation target (0 when OFF)
+    uint8_t heater_duty_pct;    // Controller output for the current window
     uint32_t uptime_seconds;
     bool wifi_connected;
     bool sensor_error;
@@ -50,12 +54,49 @@ bool crockpot_init(void);
 /**
  * @brief Get current crockpot status
  *
- * Thread-safe function to retrieve complete status.
+ * Thread-safe and wait-free: reads a consistent published snapshot
+ * without taking the state mutex, so it never blocks the control task.
+ * uptime_seconds is computed at call time.
  *
  * @return Current status structure
  */
 crockpot_status_t crockpot_get_status(void);
 
+/**
+ * @brief Get the status generation counter
+ *
+ * Increments every time a changed status is published (uptime alone
+ * does not count). Interfaces can cache the value and skip work when it
+ * has not moved.
+ *
+ * @return Generation number
+ */
+uint32_t crockpot_get_generation(void);
+
+/**
+ * @brief Status change listener
+ *
+ * Called after the state, displayed temperature (0.1 F resolution),
+ * WiFi or sensor status changes. Uptime ticking alone does not notify.
+ * Runs in the context of the task that made the change (control task
+ * or a crockpot_set_state() caller), so it must not block; typically it
+ * just sets an event bit or task notification.
+ *
+ * @param user_data Pointer passed to crockpot_add_listener()
+ */
+typedef void (*crockpot_listener_t)(void* user_data);
+
+/**
+ * @brief Register a status change listener
+ *
+ * Call during initialization; listeners cannot be removed.
+ *
+ * @param listener Callback
+ * @param user_data Passed to the callback
+ * @return true if registered, false if the table is full
+ */
+bool crockpot_add_listener(crockpot_listener_t listener, void* user_data);
+
 /**
  * @brief Set crockpot operating state
  *
@@ -67,6 +108,46 @@ crockpot_status_t crockpot_get_status(void);
  */
 bool crockpot_set_state(crockpot_state_t state);
 
+/**
+ * @brief Consecutive control cycles that ran on time, took a valid
+ *        reading and completed the safety checks
+ *
+ * Drops to 0 on a missed deadline, a state-lock timeout or a failed
+ * reading. Safe from any task.
+ */
+uint32_t crockpot_get_healthy_cycles(void);
+
+/**
+ * @brief Hold the heater off without changing the state
+ *
+ * While held, the control task keeps running (readings, safety checks,
+ * status) but drives no relays. The state and setpoint are kept, so
+ * heating picks up where it was once released. Used around a firmware
+ * switch. Safe from any task.
+ *
+ * @param hold true to force the heater off, false to release it
+ */
+void crockpot_hold_heater(bool hold);
+
+/**
+ * @brief Override the regulation target
+ *
+ * Applies until the next crockpot_set_state(), which restores the
+ * state's default setpoint. Has no effect on the heater while OFF.
+ *
+ * @param setpoint Target, within [CROCKPOT_SETPOINT_MIN, CROCKPOT_SETPOINT_MAX]
+ * @return true on success, false if out of range or OFF
+ */
+bool crockpot_set_setpoint(temp_cc_t setpoint);
+
+/**
+ * @brief Default setpoint for a state
+ *
+ * @param state Operating state
+ * @return Setpoint (0 for OFF)
+ */
+temp_cc_t crockpot_state_setpoint(crockpot_state_t state);
+
 /**
  * @brief Convert state enum to human-readable string
  *
@@ -86,6 +167,18 @@ const char* crockpot_state_to_string(crockpot_state_t state);
  */
 bool crockpot_state_from_string(const char* str, crockpot_state_t* out);
 
+/**
+ * @brief Step one heat level up or down
+ *
+ * Order is OFF -> WARM -> LOW -> HIGH; stepping past either end stays
+ * put. Shared by the buttons, the touch UI and any other stepper.
+ *
+ * @param state Current state
+ * @param direction Positive to step up, negative to step down
+ * @return Neighbouring state (or state itself at the ends)
+ */
+crockpot_state_t crockpot_step_state(crockpot_state_t state, int direction);
+
 /**
  * @brief Main control loop task
  *
@@ -97,17 +190,77 @@ bool crockpot_state_from_string(const char* str, crockpot_state_t* out);
 void crockpot_control_task(void* pvParameters);
 
 /**
- * @brief Safety temperature limit in Fahrenheit
+ * @brief Safety temperature limit (300 F)
  *
  * If temperature exceeds this value, crockpot auto-shuts off.
  */
-#define CROCKPOT_SAFETY_TEMP_F 300.0f
+#define CROCKPOT_SAFETY_TEMP TEMP_CC_FROM_F(300)
 
 /**
  * @brief Control loop interval in milliseconds
  */
 #define CROCKPOT_CONTROL_INTERVAL_MS 1000
 
+/**
+ * @brief Control loop health limits
+ *
+ * A cycle starting more than CROCKPOT_DEADLINE_SLACK_MS after its slot
+ * has missed its deadline. That many consecutive missed deadlines, or
+ * failures to take the state mutex (each skips the safety checks), force
+ * the relays off and the state to OFF.
+ */
+#define CROCKPOT_DEADLINE_SLACK_MS      200
+#define CROCKPOT_MAX_MISSED_DEADLINES   3
+#define CROCKPOT_MAX_MUTEX_FAILURES     3
+
+/**
+ * @brief Default setpoints per heating state
+ */
+#define CROCKPOT_SETPOINT_WARM      TEMP_CC_FROM_F(165)
+#define CROCKPOT_SETPOINT_LOW       TEMP_CC_FROM_F(190)
+#define CROCKPOT_SETPOINT_HIGH      TEMP_CC_FROM_F(205)
+
+/**
+ * @brief Range accepted by crockpot_set_setpoint() (Fahrenheit)
+ */
+#define CROCKPOT_SETPOINT_MIN_F     100
+#define CROCKPOT_SETPOINT_MAX_F     250
+#define CROCKPOT_SETPOINT_MIN       TEMP_CC_FROM_F(CROCKPOT_SETPOINT_MIN_F)
+#define CROCKPOT_SETPOINT_MAX       TEMP_CC_FROM_F(CROCKPOT_SETPOINT_MAX_F)
+
+/**
+ * @brief Heater PID gains (output in permille duty, error in Fahrenheit)
+ *
+ * Tuned for a few liters of water-heavy food: the pot lags by minutes,
+ * so the loop is mostly P+I with a little D to damp overshoot.
+ */
+#define CROCKPOT_PID_KP             80.0    // Per F of error
+#define CROCKPOT_PID_KI             0.1     // Per F of error per second
+#define CROCKPOT_PID_KD             600.0   // Per F/s of temperature change
+
+/**
+ * @brief Time-proportioning window for the main SSR
+ *
+ * The relay driver latches the duty at the start of each window and
+ * switches at most twice per window (see relay_set_duty()). Sized for
+ * an SSR: the stock G5LE mechanical relays are only rated for ~100k
+ * switching operations under load, so raise this to a minute or more
+ * when driving them.
+ */
+#define CROCKPOT_HEATER_WINDOW_MS   10000
+
+/**
+ * @brief Aux (boost) element engages when the main element is at 100%
+ *        and the pot is this far below the setpoint; it drops out at half
+ *        the band.
+ */
+#define CROCKPOT_BOOST_BAND         TEMP_CC_DELTA_F(15)
+
+/**
+ * @brief Maximum number of status change listeners
+ */
+#define CROCKPOT_MAX_LISTENERS 6
+
 #ifdef __cplusplus
 }
 #endif
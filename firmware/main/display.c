@@ -2,20 +2,23 @@
  * @file display.c
  * @brief Local display interface implementation
  *
- * TODO: Implement actual display driver based on selected hardware.
- * Current implementation is a stub that logs to console.
+ * Brings up the input HAL and the TFT through the GUI layer (gui.c on
+ * top of display_hal). Without a panel it handles the buttons itself and
+ * falls back to logging what would be displayed.
  */
 
 #include "display.h"
+#include "display_hal.h"
+#include "gui.h"
+#include "touch_hal.h"
 #include "crockpot.h"
 #include "wifi.h"
 
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
-#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char* TAG = "display";
 
@@ -23,101 +26,43 @@ static const char* TAG = "display";
 static display_type_t s_display_type = DISPLAY_TYPE_NONE;
 static bool s_initialized = false;
 
-// Message overlay
+// Message overlay (expiry in ms since boot, 0 = until cleared)
 static char s_message[64] = "";
-static uint32_t s_message_timeout = 0;
+static uint32_t s_message_until_ms = 0;
 
-// Button state
-static volatile bool s_button_up_pressed = false;
-static volatile bool s_button_down_pressed = false;
-static volatile bool s_button_select_pressed = false;
-
-// Button interrupt handler
-static void IRAM_ATTR button_isr_handler(void* arg)
-{
-    uint32_t gpio_num = (uint32_t)arg;
-
-    if (gpio_num == BUTTON_UP_GPIO) {
-        s_button_up_pressed = true;
-    } else if (gpio_num == BUTTON_DOWN_GPIO) {
-        s_button_down_pressed = true;
-    } else if (gpio_num == BUTTON_SELECT_GPIO) {
-        s_button_select_pressed = true;
-    }
-}
-
-// Initialize buttons
-static bool init_buttons(void)
+// Handle a button press (headless: no GUI to route it through)
+static void handle_button(const touch_event_t* event)
 {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << BUTTON_UP_GPIO) |
-                        (1ULL << BUTTON_DOWN_GPIO) |
-                        (1ULL << BUTTON_SELECT_GPIO),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_NEGEDGE  // Trigger on button press (active low)
-    };
-
-    if (gpio_config(&io_conf) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure button GPIOs");
-        return false;
+    if (event->type != TOUCH_EVENT_PRESS) {
+        return;
     }
 
-    // Install GPIO ISR service
-    gpio_install_isr_service(0);
-
-    // Attach interrupt handlers
-    gpio_isr_handler_add(BUTTON_UP_GPIO, button_isr_handler, (void*)BUTTON_UP_GPIO);
-    gpio_isr_handler_add(BUTTON_DOWN_GPIO, button_isr_handler, (void*)BUTTON_DOWN_GPIO);
-    gpio_isr_handler_add(BUTTON_SELECT_GPIO, button_isr_handler, (void*)BUTTON_SELECT_GPIO);
-
-    ESP_LOGI(TAG, "Buttons initialized");
-    return true;
-}
-
-// Process button input
-static void process_buttons(void)
-{
     crockpot_status_t status = crockpot_get_status();
     crockpot_state_t new_state = status.state;
 
-    if (s_button_up_pressed) {
-        s_button_up_pressed = false;
-        ESP_LOGI(TAG, "UP button pressed");
-
-        // Cycle up: OFF -> WARM -> LOW -> HIGH
-        switch (status.state) {
-            case CROCKPOT_OFF:  new_state = CROCKPOT_WARM; break;
-            case CROCKPOT_WARM: new_state = CROCKPOT_LOW;  break;
-            case CROCKPOT_LOW:  new_state = CROCKPOT_HIGH; break;
-            case CROCKPOT_HIGH: new_state = CROCKPOT_HIGH; break;  // Stay at max
-        }
-    }
-
-    if (s_button_down_pressed) {
-        s_button_down_pressed = false;
-        ESP_LOGI(TAG, "DOWN button pressed");
-
-        // Cycle down: HIGH -> LOW -> WARM -> OFF
-        switch (status.state) {
-            case CROCKPOT_HIGH: new_state = CROCKPOT_LOW;  break;
-            case CROCKPOT_LOW:  new_state = CROCKPOT_WARM; break;
-            case CROCKPOT_WARM: new_state = CROCKPOT_OFF;  break;
-            case CROCKPOT_OFF:  new_state = CROCKPOT_OFF;  break;  // Stay at off
-        }
-    }
-
-    if (s_button_select_pressed) {
-        s_button_select_pressed = false;
-        ESP_LOGI(TAG, "SELECT button pressed");
+    switch (event->button) {
+        case BUTTON_UP:
+            ESP_LOGI(TAG, "UP button pressed");
+            new_state = crockpot_step_state(status.state, 1);
+            break;
+
+        case BUTTON_DOWN:
+            ESP_LOGI(TAG, "DOWN button pressed");
+            new_state = crockpot_step_state(status.state, -1);
+            break;
+
+        case BUTTON_SELECT:
+            ESP_LOGI(TAG, "SELECT button pressed");
+            // Toggle between OFF and last active state
+            if (status.state == CROCKPOT_OFF) {
+                new_state = CROCKPOT_LOW;  // Default to LOW
+            } else {
+                new_state = CROCKPOT_OFF;
+            }
+            break;
 
-        // Toggle between OFF and last active state
-        if (status.state == CROCKPOT_OFF) {
-            new_state = CROCKPOT_LOW;  // Default to LOW
-        } else {
-            new_state = CROCKPOT_OFF;
-        }
+        default:
+            break;
     }
 
     if (new_state != status.state) {
@@ -133,13 +78,18 @@ static void render_display(void)
         return;
     }
 
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        // The GUI task renders the TFT itself
+        return;
+    }
+
     crockpot_status_t status = crockpot_get_status();
+    char temp[12];
+    temp_format_f(temp, sizeof(temp), status.temperature);
 
-    // TODO: Implement actual display rendering
-    // For now, just log what would be displayed
-    ESP_LOGD(TAG, "Display: %s | %.1f F | %s",
+    ESP_LOGD(TAG, "Display: %s | %s F | %s",
              crockpot_state_to_string(status.state),
-             status.temperature_f,
+             temp,
              status.wifi_connected ? "WiFi" : "----");
 }
 
@@ -147,19 +97,21 @@ bool display_init(void)
 {
     ESP_LOGI(TAG, "Initializing display");
 
-    // TODO: Detect and initialize actual display hardware
-    // For now, just initialize buttons
-
-    if (!init_buttons()) {
-        ESP_LOGW(TAG, "Button initialization failed");
+    // Buttons (and touch) come up first so input works without a TFT
+    if (!touch_hal_init()) {
+        ESP_LOGW(TAG, "Input initialization failed");
     }
 
-    // TODO: I2C/SPI display detection
-    // For now, assume no display connected
-    s_display_type = DISPLAY_TYPE_NONE;
+    // Bring up the SPI TFT and the GUI that renders on it
+    if (gui_init() && gui_start()) {
+        s_display_type = DISPLAY_TYPE_TFT_ILI9341;
+    } else {
+        ESP_LOGW(TAG, "No TFT available - running without local screen");
+        s_display_type = DISPLAY_TYPE_NONE;
+    }
 
     s_initialized = true;
-    ESP_LOGI(TAG, "Display initialized (STUB - implement actual driver)");
+    ESP_LOGI(TAG, "Display initialized (type %d)", s_display_type);
     return true;
 }
 
@@ -167,32 +119,44 @@ void display_task(void* pvParameters)
 {
     ESP_LOGI(TAG, "Display task started");
 
-    TickType_t last_wake_time = xTaskGetTickCount();
+    // The GUI task renders the TFT and consumes input itself
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        ESP_LOGI(TAG, "GUI owns the screen and input - display task exiting");
+        vTaskDelete(NULL);
+        return;
+    }
 
     while (1) {
-        // Process button input
-        process_buttons();
+        // Sleep until an input event arrives or the message expires
+        uint32_t wait_ms = UINT32_MAX;
+        if (s_message_until_ms != 0) {
+            int32_t remaining = (int32_t)(s_message_until_ms - (uint32_t)(esp_timer_get_time() / 1000));
+            wait_ms = (remaining > 0) ? (uint32_t)remaining + 1 : 0;
+        }
+
+        touch_event_t event;
+        if (touch_hal_wait_event(&event, wait_ms)) {
+            handle_button(&event);
+        }
 
         // Check message timeout
-        if (s_message_timeout > 0) {
-            if (s_message_timeout <= DISPLAY_UPDATE_INTERVAL_MS) {
-                s_message[0] = '\0';
-                s_message_timeout = 0;
-            } else {
-                s_message_timeout -= DISPLAY_UPDATE_INTERVAL_MS;
-            }
+        if (s_message_until_ms != 0 &&
+            (int32_t)((uint32_t)(esp_timer_get_time() / 1000) - s_message_until_ms) >= 0) {
+            s_message[0] = '\0';
+            s_message_until_ms = 0;
         }
 
         // Render display
         render_display();
-
-        // Wait for next update
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(DISPLAY_UPDATE_INTERVAL_MS));
     }
 }
 
 void display_refresh(void)
 {
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        gui_refresh();
+        return;
+    }
     render_display();
 }
 
@@ -204,7 +168,13 @@ void display_show_message(const char* message, uint32_t duration_ms)
 
     strncpy(s_message, message, sizeof(s_message) - 1);
     s_message[sizeof(s_message) - 1] = '\0';
-    s_message_timeout = duration_ms;
+    s_message_until_ms = (duration_ms > 0)
+                         ? (uint32_t)(esp_timer_get_time() / 1000) + duration_ms
+                         : 0;
+
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        gui_show_message(s_message, duration_ms);
+    }
 
     ESP_LOGI(TAG, "Message: %s", s_message);
 }
@@ -212,12 +182,19 @@ void display_show_message(const char* message, uint32_t duration_ms)
 void display_clear_message(void)
 {
     s_message[0] = '\0';
-    s_message_timeout = 0;
+    s_message_until_ms = 0;
+
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        gui_dismiss_message();
+    }
 }
 
 void display_set_brightness(uint8_t brightness)
 {
-    // TODO: Implement brightness control
+    if (s_display_type == DISPLAY_TYPE_TFT_ILI9341) {
+        display_hal_set_brightness(brightness);
+        return;
+    }
     ESP_LOGI(TAG, "Set brightness: %d%%", brightness);
 }
 
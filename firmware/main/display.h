@@ -2,7 +2,7 @@
  * @file display.h
  * @brief Local display interface (OLED/touchscreen)
  *
- * Handles local UI rendering and button/touch input.
+ * Handles local UI rendering and, without a TFT, button input.
  * Display hardware TBD (OLED + buttons or touchscreen).
  */
 
@@ -40,9 +40,12 @@ bool display_init(void);
  *
  * FreeRTOS task that handles:
  * - Screen rendering/updates
- * - Button/touch input handling
+ * - Button input handling (touch_hal event queue)
  * - UI state management
  *
+ * Blocks on the input queue until an event or message expiry; it does
+ * not poll. With a TFT the GUI task owns input and this task exits.
+ *
  * @param pvParameters Task parameters (unused)
  */
 void display_task(void* pvParameters);
@@ -90,14 +93,6 @@ display_type_t display_get_type(void);
 #define DISPLAY_WIDTH    128
 #define DISPLAY_HEIGHT   64
 
-// Button GPIOs (if using OLED + buttons)
-#define BUTTON_UP_GPIO    12
-#define BUTTON_DOWN_GPIO  13
-#define BUTTON_SELECT_GPIO 14
-
-// Display update interval
-#define DISPLAY_UPDATE_INTERVAL_MS 250
-
 #ifdef __cplusplus
 }
 #endif
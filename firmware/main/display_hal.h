@@ -7,8 +7,8 @@
  *
  * Implementations:
  * - display_hal_none.c   (stub, logs only)
- * - display_hal_ili9341.c (TFT via SPI)
- * - display_hal_ssd1306.c (OLED via I2C)
+ * - display_hal_ili9341.c (TFT via SPI, also drives ST7789)
+ * - display_hal_ssd1306.c (OLED via I2C, not yet written)
  */
 
 #ifndef DISPLAY_HAL_H
@@ -55,6 +55,16 @@ typedef struct {
     bool     initialized;     // Successfully initialized
 } display_info_t;
 
+/**
+ * @brief Screen rectangle (used for dirty-region flushing)
+ */
+typedef struct {
+    int16_t x;                // Top-left X
+    int16_t y;                // Top-left Y
+    int16_t w;                // Width in pixels
+    int16_t h;                // Height in pixels
+} display_rect_t;
+
 /**
  * @brief Text alignment options
  */
@@ -226,9 +236,22 @@ void display_hal_fill_circle(int16_t x, int16_t y, int16_t r, color_t color);
 void display_hal_text(int16_t x, int16_t y, const char* text,
                       font_size_t font, color_t color, text_align_t align);
 
+/**
+ * @brief Set the colour text is drawn over
+ *
+ * Text is anti-aliased and drawn as an opaque box, so the driver needs
+ * the colour behind the text to blend edges against. Stays in effect
+ * until changed.
+ *
+ * @param color Background colour
+ */
+void display_hal_set_text_background(color_t color);
+
 /**
  * @brief Get text width in pixels
  *
+ * Sum of the glyph advances, i.e. the width display_hal_text() covers.
+ *
  * @param text Null-terminated string
  * @param font Font size
  * @return Width in pixels
@@ -263,6 +286,18 @@ void display_hal_set_brightness(uint8_t brightness);
  */
 void display_hal_flush(void);
 
+/**
+ * @brief Flush only the given screen regions
+ *
+ * Partial-update variant of display_hal_flush(). The GUI passes the
+ * merged list of regions it redrew this frame so the driver can skip
+ * pixels that did not change.
+ *
+ * @param rects Array of dirty rectangles
+ * @param count Number of rectangles (0 = nothing to flush)
+ */
+void display_hal_flush_rects(const display_rect_t* rects, uint8_t count);
+
 /**
  * @brief Set display rotation
  *
@@ -270,6 +305,16 @@ void display_hal_flush(void);
  */
 void display_hal_set_rotation(uint16_t rotation);
 
+// ILI9341 configuration (XIAO ESP32-C3)
+// The TFT shares the SPI bus with the MAX31855 (see spi_bus.h) and reuses
+// the D4/D5 pins that were reserved for the I2C OLED.
+// D0=GPIO2, D4=GPIO6, D5=GPIO7
+#define LCD_PIN_CS            6         // D4 - Chip Select
+#define LCD_PIN_DC            7         // D5 - Data/Command
+#define LCD_PIN_BL            2         // D0 - Backlight (PWM)
+#define LCD_SPI_CLOCK_HZ      40000000  // 40 MHz write clock
+#define LCD_DEFAULT_ROTATION  90        // Landscape, 320x240
+
 #ifdef __cplusplus
 }
 #endif
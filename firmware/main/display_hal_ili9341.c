@@ -0,0 +1,809 @@
+/**
+ * @file display_hal_ili9341.c
+ * @brief Display HAL for ILI9341 / ST7789 TFT panels over SPI
+ *
+ * The panel keeps its own frame memory, so there is no framebuffer on
+ * the MCU (a 320x240 RGB565 buffer would be 150 KB). Every primitive
+ * sets the panel's CASET/RASET window to exactly the pixels it covers
+ * and streams them through two small DMA-capable band buffers in
+ * ping-pong fashion: the CPU rasterizes band N+1 while SPI DMA sends
+ * band N. Pixels outside the target rectangle are never written.
+ *
+ * Drawing is therefore immediate; display_hal_flush() and
+ * display_hal_flush_rects() only wait for in-flight DMA to finish.
+ */
+
+#include "display_hal.h"
+#include "font.h"
+#include "metrics.h"
+#include "spi_bus.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char* TAG = "display_hal";
+
+// ILI9341 command set (ST7789 is compatible for everything used here)
+#define LCD_CMD_SWRESET  0x01
+#define LCD_CMD_SLPOUT   0x11
+#define LCD_CMD_DISPON   0x29
+#define LCD_CMD_CASET    0x2A
+#define LCD_CMD_RASET    0x2B
+#define LCD_CMD_RAMWR    0x2C
+#define LCD_CMD_MADCTL   0x36
+#define LCD_CMD_PIXFMT   0x3A
+
+// MADCTL bits
+#define MADCTL_MY   0x80
+#define MADCTL_MX   0x40
+#define MADCTL_MV   0x20
+#define MADCTL_BGR  0x08
+
+// Native (portrait) panel geometry
+#define LCD_NATIVE_WIDTH  240
+#define LCD_NATIVE_HEIGHT 320
+
+// Band buffers: enough for BAND_LINES rows at the widest orientation
+#define BAND_LINES   20
+#define BAND_PIXELS  (LCD_NATIVE_HEIGHT * BAND_LINES)
+#define BAND_COUNT   2
+
+// Backlight PWM
+#define BL_LEDC_TIMER    LEDC_TIMER_0
+#define BL_LEDC_CHANNEL  LEDC_CHANNEL_0
+#define BL_LEDC_FREQ_HZ  5000
+
+static display_info_t s_info = {
+    .width = LCD_NATIVE_HEIGHT,
+    .height = LCD_NATIVE_WIDTH,
+    .bits_per_pixel = 16,
+    .touch_capable = true,
+    .initialized = false
+};
+
+static spi_device_handle_t s_spi = NULL;
+
+// Ping-pong band buffers (pixels stored byte-swapped, as sent on the wire)
+static uint16_t* s_band[BAND_COUNT] = { NULL };
+static spi_transaction_t s_band_trans[BAND_COUNT];
+static bool s_band_busy[BAND_COUNT] = { false };
+static uint8_t s_band_next = 0;
+static uint8_t s_bands_in_flight = 0;
+
+// Solid fill cache: band i currently holds s_band_fill_len[i] pixels of
+// s_band_fill_color[i], so repeated fills skip re-rasterizing
+static uint16_t s_band_fill_color[BAND_COUNT];
+static uint32_t s_band_fill_len[BAND_COUNT] = { 0 };
+
+// There is no framebuffer to blend against, so anti-aliased text is
+// blended with this colour (set by the GUI to whatever is underneath)
+static color_t s_text_bg = COLOR_BLACK;
+
+/**
+ * @brief Panel init command
+ */
+typedef struct {
+    uint8_t cmd;
+    uint8_t data[15];
+    uint8_t len;
+    uint8_t delay_ms;
+} lcd_init_cmd_t;
+
+static const lcd_init_cmd_t s_init_cmds[] = {
+    { 0xEF, { 0x03, 0x80, 0x02 }, 3, 0 },
+    { 0xCF, { 0x00, 0xC1, 0x30 }, 3, 0 },               // Power control B
+    { 0xED, { 0x64, 0x03, 0x12, 0x81 }, 4, 0 },         // Power on sequence
+    { 0xE8, { 0x85, 0x00, 0x78 }, 3, 0 },               // Driver timing A
+    { 0xCB, { 0x39, 0x2C, 0x00, 0x34, 0x02 }, 5, 0 },   // Power control A
+    { 0xF7, { 0x20 }, 1, 0 },                           // Pump ratio
+    { 0xEA, { 0x00, 0x00 }, 2, 0 },                     // Driver timing B
+    { 0xC0, { 0x23 }, 1, 0 },                           // Power control 1
+    { 0xC1, { 0x10 }, 1, 0 },                           // Power control 2
+    { 0xC5, { 0x3E, 0x28 }, 2, 0 },                     // VCOM control 1
+    { 0xC7, { 0x86 }, 1, 0 },                           // VCOM control 2
+    { LCD_CMD_PIXFMT, { 0x55 }, 1, 0 },                 // 16 bits/pixel
+    { 0xB1, { 0x00, 0x18 }, 2, 0 },                     // Frame rate 79 Hz
+    { 0xB6, { 0x08, 0x82, 0x27 }, 3, 0 },               // Display function
+    { 0xF2, { 0x00 }, 1, 0 },                           // 3-gamma off
+    { 0x26, { 0x01 }, 1, 0 },                           // Gamma curve 1
+    { 0xE0, { 0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1,
+              0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00 }, 15, 0 },
+    { 0xE1, { 0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
+              0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F }, 15, 0 },
+    { LCD_CMD_SLPOUT, { 0 }, 0, 120 },
+    { LCD_CMD_DISPON, { 0 }, 0, 20 },
+};
+
+// ============================================================================
+// SPI transport
+// ============================================================================
+
+// D/C line is carried in the transaction's user field (0 = command)
+static void IRAM_ATTR lcd_spi_pre_cb(spi_transaction_t* t)
+{
+    gpio_set_level(LCD_PIN_DC, (int)(intptr_t)t->user);
+}
+
+static inline uint16_t swap_bytes(color_t c)
+{
+    return (uint16_t)((c >> 8) | (c << 8));
+}
+
+/**
+ * @brief Block until the oldest queued band transfer completes
+ */
+static void band_reap_one(void)
+{
+    spi_transaction_t* done;
+    if (spi_device_get_trans_result(s_spi, &done, portMAX_DELAY) != ESP_OK) {
+        return;
+    }
+
+    for (int i = 0; i < BAND_COUNT; i++) {
+        if (done == &s_band_trans[i]) {
+            s_band_busy[i] = false;
+        }
+    }
+    s_bands_in_flight--;
+}
+
+/**
+ * @brief Wait until every queued band transfer has completed
+ */
+static void band_wait_all(void)
+{
+    while (s_bands_in_flight > 0) {
+        band_reap_one();
+    }
+}
+
+/**
+ * @brief Get the next band buffer, waiting for its previous DMA if needed
+ */
+static uint8_t band_acquire(void)
+{
+    uint8_t idx = s_band_next;
+    s_band_next = (s_band_next + 1) % BAND_COUNT;
+
+    // Transfers complete in queue order, so reaping until this buffer is
+    // free never waits on a band queued after it
+    while (s_band_busy[idx]) {
+        band_reap_one();
+    }
+
+    return idx;
+}
+
+/**
+ * @brief Queue a band buffer for DMA transfer as pixel data
+ */
+static void band_submit(uint8_t idx, uint32_t pixels)
+{
+    spi_transaction_t* t = &s_band_trans[idx];
+    memset(t, 0, sizeof(*t));
+    t->length = pixels * 16;
+    t->tx_buffer = s_band[idx];
+    t->user = (void*)1;
+
+    if (spi_device_queue_trans(s_spi, t, portMAX_DELAY) == ESP_OK) {
+        s_band_busy[idx] = true;
+        s_bands_in_flight++;
+        metrics_count(METRIC_DISPLAY_BYTES, pixels * 2);
+    }
+}
+
+/**
+ * @brief Send a command with optional parameter bytes
+ *
+ * Waits for queued band transfers first, since the D/C line and window
+ * registers must not change under a pixel stream.
+ */
+static void lcd_cmd(uint8_t cmd, const uint8_t* data, uint8_t len)
+{
+    band_wait_all();
+
+    spi_transaction_t t = {
+        .flags = SPI_TRANS_USE_TXDATA,
+        .length = 8,
+        .user = (void*)0,
+    };
+    t.tx_data[0] = cmd;
+    spi_device_polling_transmit(s_spi, &t);
+
+    if (len == 0) {
+        return;
+    }
+
+    if (len <= 4) {
+        t.flags = SPI_TRANS_USE_TXDATA;
+        memcpy(t.tx_data, data, len);
+    } else {
+        // Parameters may live in flash; stage them in an idle band buffer
+        memcpy(s_band[0], data, len);
+        s_band_fill_len[0] = 0;
+        t.flags = 0;
+        t.tx_buffer = s_band[0];
+    }
+    t.length = len * 8;
+    t.user = (void*)1;
+    spi_device_polling_transmit(s_spi, &t);
+}
+
+/**
+ * @brief Set the panel write window and start a RAM write
+ */
+static void lcd_set_window(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    uint8_t col[4] = { x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF };
+    uint8_t row[4] = { y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF };
+
+    lcd_cmd(LCD_CMD_CASET, col, 4);
+    lcd_cmd(LCD_CMD_RASET, row, 4);
+    lcd_cmd(LCD_CMD_RAMWR, NULL, 0);
+}
+
+// ============================================================================
+// Band streaming
+// ============================================================================
+
+/**
+ * @brief Band rasterizer callback
+ *
+ * Fills @p buf with @p w x @p rows pixels (byte-swapped RGB565) for the
+ * screen region starting at (@p x, @p y).
+ *
+ * @return true if the buffer now holds a solid fill (enables fill caching)
+ */
+typedef bool (*band_raster_fn_t)(uint16_t* buf, int16_t x, int16_t y,
+                                 int16_t w, int16_t rows, void* ctx);
+
+/**
+ * @brief Clip a rectangle to the screen
+ *
+ * @return false if nothing remains
+ */
+static bool clip_rect(int16_t* x, int16_t* y, int16_t* w, int16_t* h)
+{
+    if (*x < 0) { *w += *x; *x = 0; }
+    if (*y < 0) { *h += *y; *y = 0; }
+    if (*x + *w > s_info.width)  { *w = s_info.width - *x; }
+    if (*y + *h > s_info.height) { *h = s_info.height - *y; }
+    return *w > 0 && *h > 0;
+}
+
+/**
+ * @brief Stream a rectangle to the panel band by band
+ *
+ * The rectangle is clipped to the screen and written through a window
+ * covering exactly its pixels.
+ */
+static void stream_rect(int16_t x, int16_t y, int16_t w, int16_t h,
+                        band_raster_fn_t raster, void* ctx)
+{
+    if (!s_info.initialized || !clip_rect(&x, &y, &w, &h)) {
+        return;
+    }
+
+    lcd_set_window(x, y, x + w - 1, y + h - 1);
+
+    int16_t rows_per_band = BAND_PIXELS / w;
+    if (rows_per_band > h) {
+        rows_per_band = h;
+    }
+
+    for (int16_t row = 0; row < h; row += rows_per_band) {
+        int16_t rows = (h - row < rows_per_band) ? (h - row) : rows_per_band;
+        uint8_t idx = band_acquire();
+
+        if (!raster(s_band[idx], x, y + row, w, rows, ctx)) {
+            s_band_fill_len[idx] = 0;
+        }
+        band_submit(idx, (uint32_t)w * rows);
+    }
+}
+
+static bool raster_fill(uint16_t* buf, int16_t x, int16_t y,
+                        int16_t w, int16_t rows, void* ctx)
+{
+    (void)x; (void)y;
+    uint16_t px = *(const uint16_t*)ctx;
+    uint32_t count = (uint32_t)w * rows;
+    uint8_t idx = (buf == s_band[0]) ? 0 : 1;
+
+    // Skip rasterizing if this buffer already holds enough of the colour
+    if (s_band_fill_len[idx] >= count && s_band_fill_color[idx] == px) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = px;
+    }
+    s_band_fill_color[idx] = px;
+    s_band_fill_len[idx] = count;
+    return true;
+}
+
+// ============================================================================
+// Initialization
+// ============================================================================
+
+static void backlight_init(void)
+{
+    ledc_timer_config_t timer_cfg = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .timer_num = BL_LEDC_TIMER,
+        .freq_hz = BL_LEDC_FREQ_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    ledc_timer_config(&timer_cfg);
+
+    ledc_channel_config_t ch_cfg = {
+        .gpio_num = LCD_PIN_BL,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel = BL_LEDC_CHANNEL,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = BL_LEDC_TIMER,
+        .duty = 0,
+        .hpoint = 0,
+    };
+    ledc_channel_config(&ch_cfg);
+}
+
+bool display_hal_init(void)
+{
+    if (s_info.initialized) {
+        return true;
+    }
+
+    ESP_LOGI(TAG, "Initializing ILI9341 (CS=%d, DC=%d, BL=%d)",
+             LCD_PIN_CS, LCD_PIN_DC, LCD_PIN_BL);
+
+    if (!spi_bus_shared_init()) {
+        return false;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << LCD_PIN_DC),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    if (gpio_config(&io_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure D/C GPIO");
+        return false;
+    }
+
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = LCD_SPI_CLOCK_HZ,
+        .mode = 0,
+        .spics_io_num = LCD_PIN_CS,
+        .queue_size = BAND_COUNT + 1,
+        .pre_cb = lcd_spi_pre_cb,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+    esp_err_t ret = spi_bus_add_device(SPI_BUS_HOST, &dev_cfg, &s_spi);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        return false;
+    }
+
+    for (int i = 0; i < BAND_COUNT; i++) {
+        s_band[i] = heap_caps_malloc(BAND_PIXELS * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (s_band[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate DMA band buffer");
+            return false;
+        }
+    }
+
+    backlight_init();
+
+    lcd_cmd(LCD_CMD_SWRESET, NULL, 0);
+    vTaskDelay(pdMS_TO_TICKS(120));
+
+    for (size_t i = 0; i < sizeof(s_init_cmds) / sizeof(s_init_cmds[0]); i++) {
+        lcd_cmd(s_init_cmds[i].cmd, s_init_cmds[i].data, s_init_cmds[i].len);
+        if (s_init_cmds[i].delay_ms > 0) {
+            vTaskDelay(pdMS_TO_TICKS(s_init_cmds[i].delay_ms));
+        }
+    }
+
+    s_info.initialized = true;
+    display_hal_set_rotation(LCD_DEFAULT_ROTATION);
+    display_hal_clear(COLOR_BLACK);
+
+    ESP_LOGI(TAG, "Display HAL initialized (%dx%d, %d-line DMA bands)",
+             s_info.width, s_info.height, BAND_LINES);
+    return true;
+}
+
+display_info_t display_hal_get_info(void)
+{
+    return s_info;
+}
+
+// ============================================================================
+// Drawing Primitives
+// ============================================================================
+
+void display_hal_clear(color_t color)
+{
+    display_hal_fill_rect(0, 0, s_info.width, s_info.height, color);
+}
+
+void display_hal_pixel(int16_t x, int16_t y, color_t color)
+{
+    display_hal_fill_rect(x, y, 1, 1, color);
+}
+
+void display_hal_hline(int16_t x, int16_t y, int16_t w, color_t color)
+{
+    display_hal_fill_rect(x, y, w, 1, color);
+}
+
+void display_hal_vline(int16_t x, int16_t y, int16_t h, color_t color)
+{
+    display_hal_fill_rect(x, y, 1, h, color);
+}
+
+void display_hal_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, color_t color)
+{
+    if (y0 == y1) {
+        display_hal_hline(x0 < x1 ? x0 : x1, y0, (x0 < x1 ? x1 - x0 : x0 - x1) + 1, color);
+        return;
+    }
+    if (x0 == x1) {
+        display_hal_vline(x0, y0 < y1 ? y0 : y1, (y0 < y1 ? y1 - y0 : y0 - y1) + 1, color);
+        return;
+    }
+
+    // Bresenham, emitting horizontal runs rather than single pixels
+    int16_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int16_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int16_t sx = x0 < x1 ? 1 : -1;
+    int16_t sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    int16_t run_x = x0;
+
+    while (1) {
+        bool last = (x0 == x1 && y0 == y1);
+        int16_t next_x = x0;
+        int16_t next_y = y0;
+
+        if (!last) {
+            int16_t e2 = 2 * err;
+            if (e2 >= dy) { err += dy; next_x += sx; }
+            if (e2 <= dx) { err += dx; next_y += sy; }
+        }
+
+        // Emit the run when the row changes (or the line ends)
+        if (last || next_y != y0) {
+            int16_t a = run_x < x0 ? run_x : x0;
+            int16_t b = run_x < x0 ? x0 : run_x;
+            display_hal_hline(a, y0, b - a + 1, color);
+            run_x = next_x;
+        }
+
+        if (last) {
+            break;
+        }
+        x0 = next_x;
+        y0 = next_y;
+    }
+}
+
+void display_hal_rect(int16_t x, int16_t y, int16_t w, int16_t h, color_t color)
+{
+    display_hal_hline(x, y, w, color);
+    display_hal_hline(x, y + h - 1, w, color);
+    display_hal_vline(x, y, h, color);
+    display_hal_vline(x + w - 1, y, h, color);
+}
+
+void display_hal_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, color_t color)
+{
+    uint16_t px = swap_bytes(color);
+    stream_rect(x, y, w, h, raster_fill, &px);
+}
+
+/**
+ * @brief Draw one or more quarter-circle outlines (midpoint algorithm)
+ *
+ * @param corners Bitmask: 1=top-left, 2=top-right, 4=bottom-right, 8=bottom-left
+ */
+static void draw_corners(int16_t cx, int16_t cy, int16_t r, uint8_t corners,
+                         int16_t dx, int16_t dy, color_t color)
+{
+    int16_t f = 1 - r;
+    int16_t ddf_x = 1;
+    int16_t ddf_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+
+        if (corners & 0x1) {
+            display_hal_pixel(cx - y, cy - x, color);
+            display_hal_pixel(cx - x, cy - y, color);
+        }
+        if (corners & 0x2) {
+            display_hal_pixel(cx + dx + x, cy - y, color);
+            display_hal_pixel(cx + dx + y, cy - x, color);
+        }
+        if (corners & 0x4) {
+            display_hal_pixel(cx + dx + x, cy + dy + y, color);
+            display_hal_pixel(cx + dx + y, cy + dy + x, color);
+        }
+        if (corners & 0x8) {
+            display_hal_pixel(cx - y, cy + dy + x, color);
+            display_hal_pixel(cx - x, cy + dy + y, color);
+        }
+    }
+}
+
+/**
+ * @brief Fill the left/right halves of a circle as horizontal spans
+ *
+ * @param sides Bitmask: 1=top half, 2=bottom half
+ * @param stretch Extra width between the left and right arcs
+ */
+static void fill_circle_spans(int16_t cx, int16_t cy, int16_t r, uint8_t sides,
+                              int16_t stretch, int16_t vgap, color_t color)
+{
+    int16_t f = 1 - r;
+    int16_t ddf_x = 1;
+    int16_t ddf_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+
+        if (sides & 0x1) {
+            display_hal_hline(cx - x, cy - y, 2 * x + 1 + stretch, color);
+            display_hal_hline(cx - y, cy - x, 2 * y + 1 + stretch, color);
+        }
+        if (sides & 0x2) {
+            display_hal_hline(cx - x, cy + vgap + y, 2 * x + 1 + stretch, color);
+            display_hal_hline(cx - y, cy + vgap + x, 2 * y + 1 + stretch, color);
+        }
+    }
+}
+
+void display_hal_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, color_t color)
+{
+    int16_t max_r = (w < h ? w : h) / 2;
+    if (r > max_r) r = max_r;
+
+    display_hal_hline(x + r, y, w - 2 * r, color);
+    display_hal_hline(x + r, y + h - 1, w - 2 * r, color);
+    display_hal_vline(x, y + r, h - 2 * r, color);
+    display_hal_vline(x + w - 1, y + r, h - 2 * r, color);
+
+    draw_corners(x + r, y + r, r, 0xF, w - 2 * r - 1, h - 2 * r - 1, color);
+}
+
+void display_hal_fill_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, color_t color)
+{
+    int16_t max_r = (w < h ? w : h) / 2;
+    if (r > max_r) r = max_r;
+
+    // Straight middle band, then the rounded top and bottom as spans
+    display_hal_fill_rect(x, y + r, w, h - 2 * r, color);
+    display_hal_hline(x + r, y, w - 2 * r, color);
+    display_hal_hline(x + r, y + h - 1, w - 2 * r, color);
+    fill_circle_spans(x + r, y + r, r, 0x3, w - 2 * r - 1, h - 2 * r - 1, color);
+}
+
+void display_hal_circle(int16_t x, int16_t y, int16_t r, color_t color)
+{
+    display_hal_pixel(x, y - r, color);
+    display_hal_pixel(x, y + r, color);
+    display_hal_pixel(x - r, y, color);
+    display_hal_pixel(x + r, y, color);
+    draw_corners(x, y, r, 0xF, 0, 0, color);
+}
+
+void display_hal_fill_circle(int16_t x, int16_t y, int16_t r, color_t color)
+{
+    display_hal_hline(x - r, y, 2 * r + 1, color);
+    fill_circle_spans(x, y, r, 0x3, 0, 0, color);
+}
+
+// ============================================================================
+// Text Rendering
+// ============================================================================
+
+/**
+ * @brief Text band rasterizer context
+ */
+typedef struct {
+    const font_t* font;
+    const char*   text;
+    int16_t       pen_x;       // Screen X of the first glyph's pen position
+    int16_t       top;         // Screen Y of the text's first row
+    uint16_t      palette[4];  // Byte-swapped colours per coverage level
+} text_ctx_t;
+
+static uint16_t blend565(color_t bg, color_t fg, uint8_t level)
+{
+    // level is 0..3 coverage; blend each channel separately
+    uint16_t r = (((bg >> 11) & 0x1F) * (3 - level) + ((fg >> 11) & 0x1F) * level) / 3;
+    uint16_t g = (((bg >> 5)  & 0x3F) * (3 - level) + ((fg >> 5)  & 0x3F) * level) / 3;
+    uint16_t b = ((bg & 0x1F) * (3 - level) + (fg & 0x1F) * level) / 3;
+    return (r << 11) | (g << 5) | b;
+}
+
+static bool raster_text(uint16_t* buf, int16_t x, int16_t y,
+                        int16_t w, int16_t rows, void* ctx)
+{
+    const text_ctx_t* t = ctx;
+    const font_t* font = t->font;
+    uint32_t count = (uint32_t)w * rows;
+
+    // Background as a single fill, then only inked pixels are touched
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = t->palette[0];
+    }
+
+    int16_t pen = t->pen_x;
+    int16_t first_row = y - t->top;
+
+    for (const char* p = t->text; *p && pen < x + w; p++) {
+        const font_glyph_t* g = font_glyph(font, *p);
+        int16_t gx = pen + g->x_offset;
+        pen += g->advance;
+
+        if (g->width == 0 || gx + g->width <= x) {
+            continue;
+        }
+
+        uint8_t stride = font_glyph_stride(g);
+        const uint8_t* src = font->bitmap + g->offset + first_row * stride;
+
+        for (int16_t r = 0; r < rows; r++, src += stride) {
+            uint16_t* row = buf + (uint32_t)r * w;
+
+            for (uint8_t byte = 0; byte < stride; byte++) {
+                uint8_t bits = src[byte];
+                if (bits == 0) {
+                    continue;   // Four background pixels
+                }
+                int16_t px = gx + byte * 4;
+                for (uint8_t i = 0; i < 4; i++, px++, bits <<= 2) {
+                    uint8_t level = bits >> 6;
+                    if (level && px >= x && px < x + w) {
+                        row[px - x] = t->palette[level];
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void display_hal_text(int16_t x, int16_t y, const char* text,
+                      font_size_t font, color_t color, text_align_t align)
+{
+    if (text == NULL || *text == '\0') return;
+
+    text_ctx_t ctx = {
+        .font = font_get(font),
+        .text = text,
+        .top = y,
+    };
+
+    int16_t width = display_hal_text_width(text, font);
+    if (align == ALIGN_CENTER) {
+        x -= width / 2;
+    } else if (align == ALIGN_RIGHT) {
+        x -= width;
+    }
+    ctx.pen_x = x;
+
+    for (uint8_t level = 0; level < 4; level++) {
+        ctx.palette[level] = swap_bytes(blend565(s_text_bg, color, level));
+    }
+
+    stream_rect(x, y, width, ctx.font->height, raster_text, &ctx);
+}
+
+void display_hal_set_text_background(color_t color)
+{
+    s_text_bg = color;
+}
+
+int16_t display_hal_text_width(const char* text, font_size_t font)
+{
+    if (text == NULL) return 0;
+
+    const font_t* f = font_get(font);
+    int16_t width = 0;
+
+    for (const char* p = text; *p; p++) {
+        width += font_glyph(f, *p)->advance;
+    }
+    return width;
+}
+
+int16_t display_hal_font_height(font_size_t font)
+{
+    return font_get(font)->height;
+}
+
+// ============================================================================
+// Display Control
+// ============================================================================
+
+void display_hal_set_brightness(uint8_t brightness)
+{
+    if (brightness > 100) {
+        brightness = 100;
+    }
+
+    uint32_t duty = (uint32_t)brightness * 255 / 100;
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, BL_LEDC_CHANNEL, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, BL_LEDC_CHANNEL);
+}
+
+void display_hal_flush(void)
+{
+    // Pixels go straight to panel RAM; just let queued bands finish
+    band_wait_all();
+}
+
+void display_hal_flush_rects(const display_rect_t* rects, uint8_t count)
+{
+    // Dirty regions were already written through their own windows
+    (void)rects;
+    (void)count;
+    band_wait_all();
+}
+
+void display_hal_set_rotation(uint16_t rotation)
+{
+    uint8_t madctl;
+
+    switch (rotation) {
+        case 0:   madctl = MADCTL_MX | MADCTL_BGR; break;
+        case 90:  madctl = MADCTL_MV | MADCTL_BGR; break;
+        case 180: madctl = MADCTL_MY | MADCTL_BGR; break;
+        case 270: madctl = MADCTL_MY | MADCTL_MX | MADCTL_MV | MADCTL_BGR; break;
+        default:
+            ESP_LOGW(TAG, "Unsupported rotation: %d", rotation);
+            return;
+    }
+
+    if (rotation == 0 || rotation == 180) {
+        s_info.width = LCD_NATIVE_WIDTH;
+        s_info.height = LCD_NATIVE_HEIGHT;
+    } else {
+        s_info.width = LCD_NATIVE_HEIGHT;
+        s_info.height = LCD_NATIVE_WIDTH;
+    }
+
+    lcd_cmd(LCD_CMD_MADCTL, &madctl, 1);
+}
@@ -1,9 +1,8 @@
 /**
- * @file display_hal.c
+ * @file display_hal_none.c
  * @brief Display HAL stub implementation
  *
- * Stub that logs drawing calls. Replace with actual driver implementation
- * when display hardware is selected.
+ * Stub that logs drawing calls. Useful for bring-up without a panel.
  *
  * To implement for a specific display:
  * 1. Copy this file to display_hal_<driver>.c
@@ -148,6 +147,11 @@ void display_hal_text(int16_t x, int16_t y, const char* text,
     // - Render each character glyph
 }
 
+void display_hal_set_text_background(color_t color)
+{
+    ESP_LOGV(TAG, "set_text_background(0x%04X)", color);
+}
+
 int16_t display_hal_text_width(const char* text, font_size_t font)
 {
     if (text == NULL) return 0;
@@ -179,6 +183,19 @@ void display_hal_flush(void)
     // For immediate-mode displays, this may be a no-op
 }
 
+void display_hal_flush_rects(const display_rect_t* rects, uint8_t count)
+{
+    if (rects == NULL || count == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        ESP_LOGV(TAG, "flush_rect(%d,%d,%d,%d)",
+                 rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+    }
+    // TODO: Push only these regions of the back buffer to the panel
+}
+
 void display_hal_set_rotation(uint16_t rotation)
 {
     ESP_LOGI(TAG, "set_rotation(%d)", rotation);
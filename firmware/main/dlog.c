@@ -0,0 +1,191 @@
+/**
+ * @file dlog.c
+ * @brief Deferred, rate-limited logging
+ *
+ * The C3 has no atomic instructions, so the ring is guarded by a
+ * critical section (interrupts masked for a few dozen instructions)
+ * rather than a compare-and-swap loop. Only the writer that makes the
+ * ring non-empty wakes the drain task; later writers just append.
+ */
+
+#include "dlog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+static const char* TAG = "dlog";
+
+typedef struct {
+    const dlog_site_t* site;
+    const char* tag;
+    int64_t time_us;
+    uint32_t suppressed;        // Site calls skipped before this record
+    uint32_t dropped;           // Ring overflows before this record
+    uint32_t args[DLOG_MAX_ARGS];
+    char text[DLOG_TEXT_LEN];
+} dlog_record_t;
+
+// Ring and counters (s_lock; ISR-safe)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static dlog_record_t s_ring[DLOG_RING_SIZE];
+static uint32_t s_head = 0;     // Next slot to write
+static uint32_t s_tail = 0;     // Next slot to print
+static uint32_t s_dropped = 0;  // Since the last queued record
+static uint32_t s_dropped_total = 0;
+
+static TaskHandle_t s_task = NULL;
+
+// Remote sink (drain task reads, set from any task)
+static dlog_sink_t s_sink = NULL;
+static void* s_sink_user_data = NULL;
+static esp_log_level_t s_sink_level = ESP_LOG_WARN;
+
+// Drain task only
+static dlog_record_t s_record;
+static char s_line[DLOG_LINE_MAX_LEN];
+
+static const char s_level_letters[] = "NEWIDV";
+
+void dlog_write(dlog_site_t* site, const char* tag, const char* text,
+                uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool wake = false;
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (site->interval_ms != 0 && now_us < site->next_us) {
+        site->suppressed++;
+    } else if (s_head - s_tail >= DLOG_RING_SIZE) {
+        s_dropped++;
+        s_dropped_total++;
+    } else {
+        dlog_record_t* record = &s_ring[s_head % DLOG_RING_SIZE];
+        record->site = site;
+        record->tag = tag;
+        record->time_us = now_us;
+        record->suppressed = site->suppressed;
+        record->dropped = s_dropped;
+        record->args[0] = a0;
+        record->args[1] = a1;
+        record->args[2] = a2;
+        record->args[3] = a3;
+        if (text != NULL) {
+            strncpy(record->text, text, sizeof(record->text) - 1);
+            record->text[sizeof(record->text) - 1] = '\0';
+        }
+        wake = (s_head == s_tail);
+        s_head++;
+
+        site->suppressed = 0;
+        site->next_us = now_us + (int64_t)site->interval_ms * 1000;
+        s_dropped = 0;
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+
+    if (wake && s_task != NULL) {
+        if (xPortInIsrContext()) {
+            // Lowest priority task: no point in yielding to it
+            vTaskNotifyGiveFromISR(s_task, NULL);
+        } else {
+            xTaskNotifyGive(s_task);
+        }
+    }
+}
+
+static void print_record(const dlog_record_t* record)
+{
+    const dlog_site_t* site = record->site;
+
+    if (esp_log_level_get(record->tag) < site->level) {
+        return;
+    }
+
+    size_t n;
+    if (site->text) {
+        n = (size_t)snprintf(s_line, sizeof(s_line), site->fmt, record->text,
+                             record->args[0], record->args[1], record->args[2]);
+    } else {
+        n = (size_t)snprintf(s_line, sizeof(s_line), site->fmt, record->args[0],
+                             record->args[1], record->args[2], record->args[3]);
+    }
+    if (n < sizeof(s_line) && record->suppressed > 0) {
+        snprintf(s_line + n, sizeof(s_line) - n, " (%lu suppressed)",
+                 (unsigned long)record->suppressed);
+    }
+
+    esp_log_write(site->level, record->tag, "%c (%lu) %s: %s\n",
+                  s_level_letters[site->level], (unsigned long)(record->time_us / 1000),
+                  record->tag, s_line);
+
+    dlog_sink_t sink = s_sink;
+    if (sink != NULL && site->level <= s_sink_level) {
+        sink(site->level, record->tag, s_line, s_sink_user_data);
+    }
+}
+
+static void dlog_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (1) {
+            portENTER_CRITICAL(&s_lock);
+            bool empty = (s_head == s_tail);
+            if (!empty) {
+                s_record = s_ring[s_tail % DLOG_RING_SIZE];
+                s_tail++;
+            }
+            portEXIT_CRITICAL(&s_lock);
+
+            if (empty) {
+                break;
+            }
+
+            if (s_record.dropped > 0) {
+                ESP_LOGW(TAG, "%lu log records dropped (ring full)",
+                         (unsigned long)s_record.dropped);
+            }
+            print_record(&s_record);
+        }
+    }
+}
+
+bool dlog_init(void)
+{
+    if (s_task != NULL) {
+        return true;
+    }
+
+    if (xTaskCreate(dlog_task, "dlog", DLOG_TASK_STACK_SIZE, NULL,
+                    DLOG_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create log task");
+        return false;
+    }
+
+    // Print whatever was queued before the task existed
+    xTaskNotifyGive(s_task);
+    return true;
+}
+
+void dlog_set_sink(esp_log_level_t min_level, dlog_sink_t sink, void* user_data)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_sink = NULL;
+    s_sink_level = min_level;
+    s_sink_user_data = user_data;
+    s_sink = sink;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t dlog_get_dropped(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t dropped = s_dropped_total;
+    portEXIT_CRITICAL(&s_lock);
+    return dropped;
+}
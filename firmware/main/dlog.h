@@ -0,0 +1,142 @@
+/**
+ * @file dlog.h
+ * @brief Deferred, rate-limited logging for the control and ISR paths
+ *
+ * DLOG*() stores a small binary record (call site, timestamp, up to
+ * DLOG_MAX_ARGS 32-bit arguments) in a RAM ring and returns; a
+ * low-priority task formats and prints the records later. The caller
+ * pays for one short critical section instead of a UART write, and may
+ * be an ISR.
+ *
+ * Arguments must be 32-bit integers (no float, no 64-bit) or pointers
+ * to strings that outlive the record, such as literals or
+ * crockpot_state_to_string(). DLOG_TEXT() copies one string (up to
+ * DLOG_TEXT_LEN - 1 characters) into the record instead; its format
+ * must start its conversions with that %s.
+ *
+ * Each call site can be rate limited: records within interval_ms of the
+ * last printed one are only counted, and the next printed record shows
+ * "(N suppressed)". If the ring overflows, records are dropped and the
+ * drop count is printed with the next record.
+ *
+ * Optionally, one remote sink (e.g. MQTT) gets every formatted line at
+ * or above its level.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arguments per record
+#define DLOG_MAX_ARGS   4
+
+// Bytes copied by DLOG_TEXT(), including the terminator
+#define DLOG_TEXT_LEN   24
+
+/**
+ * @brief One log call site (static, created by the DLOG macros)
+ */
+typedef struct {
+    const char* fmt;
+    esp_log_level_t level;
+    bool text;                  // First argument is the copied text
+    uint32_t interval_ms;       // Rate limit (0 = every record)
+    int64_t next_us;            // Earliest time of the next record
+    uint32_t suppressed;        // Calls counted since the last record
+} dlog_site_t;
+
+/**
+ * @brief Remote sink, called from the drain task
+ *
+ * @param level     Record level
+ * @param tag       Record tag
+ * @param line      Formatted message (no timestamp or newline)
+ * @param user_data Value passed to dlog_set_sink()
+ */
+typedef void (*dlog_sink_t)(esp_log_level_t level, const char* tag, const char* line,
+                            void* user_data);
+
+/**
+ * @brief Start the drain task
+ *
+ * Records written before this are kept and printed once it runs.
+ *
+ * @return true on success
+ */
+bool dlog_init(void);
+
+/**
+ * @brief Queue a record (use the DLOG macros instead)
+ *
+ * Safe from tasks and ISRs.
+ */
+void dlog_write(dlog_site_t* site, const char* tag, const char* text,
+                uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+/**
+ * @brief Set the remote sink (NULL to remove)
+ *
+ * @param min_level Least severe level forwarded
+ * @param sink      Callback
+ * @param user_data Passed to the callback
+ */
+void dlog_set_sink(esp_log_level_t min_level, dlog_sink_t sink, void* user_data);
+
+/**
+ * @brief Records lost to a full ring since boot
+ */
+uint32_t dlog_get_dropped(void);
+
+// Implementation helpers: cast up to DLOG_MAX_ARGS arguments, pad with 0
+#define DLOG_ARG_(x)                    ((uint32_t)(uintptr_t)(x))
+#define DLOG_ARGS_(z, a, b, c, d, ...)  DLOG_ARG_(a), DLOG_ARG_(b), DLOG_ARG_(c), DLOG_ARG_(d)
+#define DLOG_ARGS(...)                  DLOG_ARGS_(__VA_ARGS__, 0, 0, 0, 0, 0)
+
+#define DLOG_SITE_(level, interval_ms, tag, fmt, is_text, text, ...) do {       \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                        \
+            static dlog_site_t dlog_site_ = {                                    \
+                (fmt), (level), (is_text), (interval_ms), 0, 0                   \
+            };                                                                   \
+            dlog_write(&dlog_site_, (tag), (text), DLOG_ARGS(0, ##__VA_ARGS__)); \
+        }                                                                        \
+    } while (0)
+
+/**
+ * @brief Log at most once per interval_ms from this call site
+ */
+#define DLOG_LIMIT(level, interval_ms, tag, fmt, ...) \
+    DLOG_SITE_(level, interval_ms, tag, fmt, false, NULL, ##__VA_ARGS__)
+
+/**
+ * @brief Log with the first %s copied from text
+ */
+#define DLOG_TEXT(level, tag, fmt, text, ...) \
+    DLOG_SITE_(level, 0, tag, fmt, true, (text), ##__VA_ARGS__)
+
+#define DLOGE(tag, fmt, ...) DLOG_LIMIT(ESP_LOG_ERROR, 0, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_LIMIT(ESP_LOG_WARN, 0, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_LIMIT(ESP_LOG_INFO, 0, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_LIMIT(ESP_LOG_DEBUG, 0, tag, fmt, ##__VA_ARGS__)
+
+// Ring size (records of 24 + 4 * DLOG_MAX_ARGS + DLOG_TEXT_LEN bytes)
+#define DLOG_RING_SIZE      32
+
+// Longest formatted message; longer ones are truncated
+#define DLOG_LINE_MAX_LEN   160
+
+// Drain task (lowest useful priority: it only ever runs when idle)
+#define DLOG_TASK_STACK_SIZE 3072
+#define DLOG_TASK_PRIORITY   1
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
@@ -0,0 +1,908 @@
+/**
+ * @file fleet.c
+ * @brief Multi-pot fleet mode
+ *
+ * Datagram layout: packet_header_t, then a type-specific body, then
+ * FLEET_MAC_LEN bytes of HMAC-SHA256(key, header + body).
+ * - STATUS: one byte of FIELD_* bits, then each present field in bit
+ *   order. A keyframe carries every field and resets the receiver's
+ *   baseline; a delta is applied only on top of the previous sequence
+ *   number, otherwise the receiver waits for the next keyframe.
+ * - COMMAND: the target's epoch (u32), the sender's command_access_t
+ *   (u8), then the command text (not terminated).
+ * - REPLY: one byte of command_result_t, then the reply text.
+ *
+ * A packet is accepted only if its MAC is right and its (epoch, counter)
+ * is past the last one accepted from that pot.
+ */
+
+#include "fleet.h"
+#include "command.h"
+#include "config.h"
+#include "crockpot.h"
+#include "wifi.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "lwip/sockets.h"
+#include "mbedtls/md.h"
+#include "mdns.h"
+
+static const char* TAG = "fleet";
+
+#define FLEET_MAGIC             0xC7F1
+#define FLEET_PROTOCOL_VERSION  2
+
+typedef enum {
+    MSG_STATUS = 1,
+    MSG_COMMAND,
+    MSG_REPLY
+} msg_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;           // msg_type_t
+    uint8_t pot;            // Sender
+    uint8_t seq;            // STATUS: sequence number; COMMAND/REPLY: request id
+    uint32_t epoch;         // Sender's boot count
+    uint32_t counter;       // Sender's packets this boot
+} packet_header_t;
+
+// Status fields, in encoding order
+#define FIELD_STATE     0x01    // u8 crockpot_state_t
+#define FIELD_FLAGS     0x02    // u8 STATUS_FLAG_*
+#define FIELD_DUTY      0x04    // u8 percent
+#define FIELD_TEMP      0x08    // i16 centi-Celsius
+#define FIELD_SETPOINT  0x10    // i16 centi-Celsius
+#define FIELD_UPTIME    0x20    // u32 seconds (keyframes only)
+#define FIELD_ALL       0x3F
+#define FIELD_KEYFRAME  0x80
+
+#define STATUS_FLAG_SENSOR_ERROR 0x01
+#define STATUS_FLAG_COORDINATOR  0x02
+#define STATUS_FLAG_HELLO        0x04   // Just joined: peers answer with a keyframe
+
+#define PACKET_MAX_LEN  (sizeof(packet_header_t) + 1 + FLEET_REPLY_MAX_LEN + FLEET_MAC_LEN)
+
+/**
+ * @brief Compact status of one pot
+ */
+typedef struct {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t duty;
+    int16_t temp_cc;
+    int16_t setpoint_cc;
+    uint32_t uptime_s;
+} pot_status_t;
+
+typedef struct {
+    uint8_t pot;            // 0 = free slot
+    bool synced;            // Holds a keyframe baseline
+    uint8_t seq;            // Last status sequence applied
+    uint32_t addr;          // IPv4, network order
+    uint32_t epoch;         // Its boot count (commands to it must name it)
+    int64_t last_seen_ms;
+    pot_status_t status;
+} peer_t;
+
+static uint8_t s_pot = 0;
+static uint32_t s_epoch = 0;
+static char s_key[FLEET_KEY_MAX_LEN + 1];
+static int s_sock = -1;
+static TaskHandle_t s_tx_task = NULL;
+static TaskHandle_t s_rx_task = NULL;
+
+// Peer table, role and routed-command state (s_mutex)
+static SemaphoreHandle_t s_mutex = NULL;
+static peer_t s_peers[FLEET_MAX_PEERS];
+static bool s_coordinator = false;
+static bool s_keyframe_wanted = false;
+
+// Role for fleet_wait_coordinator()
+static EventGroupHandle_t s_events = NULL;
+#define COORDINATOR_BIT BIT0
+
+// Outgoing request (one at a time, s_route_mutex; reply fields s_mutex)
+static SemaphoreHandle_t s_route_mutex = NULL;
+static SemaphoreHandle_t s_reply_ready = NULL;
+static uint8_t s_request_id = 0;
+static bool s_request_pending = false;
+static uint8_t s_request_pot = 0;
+static char* s_reply_out = NULL;
+static size_t s_reply_len = 0;
+static bool s_reply_ok = false;
+
+// Receive task: buffers and the last executed request (for retries)
+static uint8_t s_rx_buf[PACKET_MAX_LEN];
+static uint8_t s_tx_reply[PACKET_MAX_LEN];
+static size_t s_tx_reply_len = 0;
+static uint8_t s_last_request_pot = 0;
+static uint8_t s_last_request_id = 0;
+static char s_command[FLEET_COMMAND_MAX_LEN + 1];
+
+// Newest (epoch, counter) accepted from each pot (receive task only). Kept
+// after a peer times out, so its old packets cannot be replayed later.
+static struct {
+    uint32_t epoch;
+    uint32_t counter;
+} s_replay[256];
+
+// Outgoing counter; held across sealing and sending so packets leave in
+// counter order (a receiver drops anything older than what it has seen)
+static SemaphoreHandle_t s_send_mutex = NULL;
+static uint32_t s_tx_counter = 0;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static int16_t clamp_cc(temp_cc_t t)
+{
+    return (int16_t)(t > INT16_MAX ? INT16_MAX : (t < INT16_MIN ? INT16_MIN : t));
+}
+
+static void header_init(packet_header_t* header, msg_type_t type, uint8_t seq)
+{
+    header->magic = FLEET_MAGIC;
+    header->version = FLEET_PROTOCOL_VERSION;
+    header->type = type;
+    header->pot = s_pot;
+    header->seq = seq;
+}
+
+static void compute_mac(const uint8_t* data, size_t len, uint8_t mac[FLEET_MAC_LEN])
+{
+    uint8_t full[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                    (const unsigned char*)s_key, strlen(s_key), data, len, full);
+    memcpy(mac, full, FLEET_MAC_LEN);
+}
+
+static bool mac_valid(const uint8_t* data, size_t len, const uint8_t* mac)
+{
+    uint8_t expected[FLEET_MAC_LEN];
+    compute_mac(data, len, expected);
+
+    // Constant time: no early exit on the first wrong byte
+    uint8_t diff = 0;
+    for (size_t i = 0; i < FLEET_MAC_LEN; i++) {
+        diff |= expected[i] ^ mac[i];
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief Stamp, sign and send a packet
+ *
+ * @param packet Header (from header_init()) and body, with FLEET_MAC_LEN
+ *               bytes free after the body
+ * @param len    Header + body length
+ */
+static void send_to(uint32_t addr, uint8_t* packet, size_t len)
+{
+    struct sockaddr_in to = {
+        .sin_family = AF_INET,
+        .sin_port = htons(FLEET_UDP_PORT),
+        .sin_addr.s_addr = addr,
+    };
+
+    xSemaphoreTake(s_send_mutex, portMAX_DELAY);
+    packet_header_t* header = (packet_header_t*)packet;
+    header->epoch = s_epoch;
+    header->counter = ++s_tx_counter;
+    compute_mac(packet, len, packet + len);
+    if (sendto(s_sock, packet, len + FLEET_MAC_LEN, 0, (struct sockaddr*)&to, sizeof(to)) < 0) {
+        ESP_LOGD(TAG, "sendto failed: %d", errno);
+    }
+    xSemaphoreGive(s_send_mutex);
+}
+
+// ============================================================================
+// Status encoding
+// ============================================================================
+
+static size_t encode_status(uint8_t* buf, uint8_t fields, const pot_status_t* s)
+{
+    uint8_t* p = buf;
+    *p++ = fields;
+    if (fields & FIELD_STATE)    *p++ = s->state;
+    if (fields & FIELD_FLAGS)    *p++ = s->flags;
+    if (fields & FIELD_DUTY)     *p++ = s->duty;
+    if (fields & FIELD_TEMP)     { memcpy(p, &s->temp_cc, 2); p += 2; }
+    if (fields & FIELD_SETPOINT) { memcpy(p, &s->setpoint_cc, 2); p += 2; }
+    if (fields & FIELD_UPTIME)   { memcpy(p, &s->uptime_s, 4); p += 4; }
+    return (size_t)(p - buf);
+}
+
+/**
+ * @return Fields decoded, or 0 if the body is truncated
+ */
+static uint8_t decode_status(const uint8_t* buf, size_t len, pot_status_t* s)
+{
+    if (len < 1) {
+        return 0;
+    }
+    uint8_t fields = buf[0];
+    size_t need = 1 + !!(fields & FIELD_STATE) + !!(fields & FIELD_FLAGS) +
+                  !!(fields & FIELD_DUTY) + 2 * !!(fields & FIELD_TEMP) +
+                  2 * !!(fields & FIELD_SETPOINT) + 4 * !!(fields & FIELD_UPTIME);
+    if (len < need || (fields & FIELD_ALL) == 0) {
+        return 0;
+    }
+
+    const uint8_t* p = buf + 1;
+    if (fields & FIELD_STATE)    s->state = *p++;
+    if (fields & FIELD_FLAGS)    s->flags = *p++;
+    if (fields & FIELD_DUTY)     s->duty = *p++;
+    if (fields & FIELD_TEMP)     { memcpy(&s->temp_cc, p, 2); p += 2; }
+    if (fields & FIELD_SETPOINT) { memcpy(&s->setpoint_cc, p, 2); p += 2; }
+    if (fields & FIELD_UPTIME)   { memcpy(&s->uptime_s, p, 4); p += 4; }
+    return fields;
+}
+
+static pot_status_t local_status(void)
+{
+    crockpot_status_t status = crockpot_get_status();
+    pot_status_t s = {
+        .state = (uint8_t)status.state,
+        .flags = (status.sensor_error ? STATUS_FLAG_SENSOR_ERROR : 0) |
+                 (fleet_is_coordinator() ? STATUS_FLAG_COORDINATOR : 0),
+        .duty = status.heater_duty_pct,
+        .temp_cc = clamp_cc(status.temperature),
+        .setpoint_cc = clamp_cc(status.setpoint),
+        .uptime_s = status.uptime_seconds,
+    };
+    return s;
+}
+
+static uint8_t changed_fields(const pot_status_t* a, const pot_status_t* b)
+{
+    int32_t dt = (int32_t)a->temp_cc - b->temp_cc;
+    return (a->state != b->state ? FIELD_STATE : 0) |
+           (a->flags != b->flags ? FIELD_FLAGS : 0) |
+           (a->duty != b->duty ? FIELD_DUTY : 0) |
+           (dt >= FLEET_TEMP_DEADBAND_CC || dt <= -FLEET_TEMP_DEADBAND_CC ? FIELD_TEMP : 0) |
+           (a->setpoint_cc != b->setpoint_cc ? FIELD_SETPOINT : 0);
+}
+
+// ============================================================================
+// Peers and election
+// ============================================================================
+
+static peer_t* find_peer_locked(uint8_t pot)
+{
+    for (int i = 0; i < FLEET_MAX_PEERS; i++) {
+        if (s_peers[i].pot == pot) {
+            return &s_peers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Elect the lowest pot heard from recently; expire silent peers
+ */
+static void elect(int64_t now)
+{
+    uint8_t lowest = s_pot;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < FLEET_MAX_PEERS; i++) {
+        peer_t* peer = &s_peers[i];
+        if (peer->pot == 0) {
+            continue;
+        }
+        if (now - peer->last_seen_ms > FLEET_PEER_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "pot%u left the fleet", peer->pot);
+            peer->pot = 0;
+            continue;
+        }
+        if (peer->pot < lowest) {
+            lowest = peer->pot;
+        }
+    }
+    bool coordinator = (lowest == s_pot);
+    bool changed = (coordinator != s_coordinator);
+    s_coordinator = coordinator;
+    xSemaphoreGive(s_mutex);
+
+    if (!changed) {
+        return;
+    }
+
+    if (coordinator) {
+        ESP_LOGI(TAG, "pot%u is now the coordinator", s_pot);
+        xEventGroupSetBits(s_events, COORDINATOR_BIT);
+    } else {
+        ESP_LOGI(TAG, "pot%u is the coordinator, standing by", lowest);
+        xEventGroupClearBits(s_events, COORDINATOR_BIT);
+    }
+    mdns_service_txt_item_set("_crockpot", "_udp", "role", coordinator ? "coordinator" : "member");
+}
+
+static void handle_status(const packet_header_t* header, uint32_t addr,
+                          const uint8_t* body, size_t len)
+{
+    pot_status_t status;
+    bool new_peer = false;
+    bool send_keyframe = false;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    peer_t* peer = find_peer_locked(header->pot);
+    if (peer == NULL) {
+        peer = find_peer_locked(0);
+        if (peer == NULL) {
+            xSemaphoreGive(s_mutex);
+            ESP_LOGW(TAG, "Peer table full, ignoring pot%u", header->pot);
+            return;
+        }
+        memset(peer, 0, sizeof(*peer));
+        peer->pot = header->pot;
+        new_peer = true;
+    }
+    peer->addr = addr;
+    peer->epoch = header->epoch;
+    peer->last_seen_ms = now_ms();
+
+    status = peer->status;
+    uint8_t fields = decode_status(body, len, &status);
+    if (fields & FIELD_KEYFRAME) {
+        peer->status = status;
+        peer->synced = true;
+        send_keyframe = (status.flags & STATUS_FLAG_HELLO) != 0;
+    } else if (fields != 0 && peer->synced && header->seq == (uint8_t)(peer->seq + 1)) {
+        peer->status = status;
+    } else {
+        peer->synced = false;   // Lost a delta: wait for the next keyframe
+    }
+    peer->seq = header->seq;
+    if (send_keyframe) {
+        s_keyframe_wanted = true;
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (new_peer) {
+        ESP_LOGI(TAG, "pot%u joined the fleet", header->pot);
+    }
+    if (new_peer || send_keyframe) {
+        xTaskNotifyGive(s_tx_task);
+    }
+}
+
+// ============================================================================
+// Routed commands
+// ============================================================================
+
+static void handle_command(const packet_header_t* header, uint32_t addr,
+                           const uint8_t* body, size_t len)
+{
+    // Only pots that have reported status may send commands
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool known = find_peer_locked(header->pot) != NULL;
+    xSemaphoreGive(s_mutex);
+
+    uint32_t target_epoch;
+    if (!known || len < sizeof(target_epoch) + 1) {
+        ESP_LOGW(TAG, "Ignoring command from unknown pot%u", header->pot);
+        return;
+    }
+    memcpy(&target_epoch, body, sizeof(target_epoch));
+    // The requesting pot vouches for its sender (it holds the fleet key)
+    command_access_t access = (body[sizeof(target_epoch)] == COMMAND_ACCESS_ADMIN)
+                              ? COMMAND_ACCESS_ADMIN : COMMAND_ACCESS_USER;
+    body += sizeof(target_epoch) + 1;
+    len -= sizeof(target_epoch) + 1;
+
+    // Meant for an earlier boot of this pot: a replay, or sent before the
+    // requester heard that this pot restarted
+    if (target_epoch != s_epoch) {
+        uint8_t packet[sizeof(packet_header_t) + 48 + FLEET_MAC_LEN];
+        header_init((packet_header_t*)packet, MSG_REPLY, header->seq);
+        packet[sizeof(packet_header_t)] = (uint8_t)COMMAND_FAILED;
+        int n = snprintf((char*)packet + sizeof(packet_header_t) + 1, 47,
+                         "Pot restarted, send the command again");
+        send_to(addr, packet, sizeof(packet_header_t) + 1 + (size_t)n);
+        return;
+    }
+
+    // A retry of the last request gets the same reply without running again
+    if (s_tx_reply_len == 0 || header->pot != s_last_request_pot ||
+        header->seq != s_last_request_id) {
+        if (len > FLEET_COMMAND_MAX_LEN) {
+            len = FLEET_COMMAND_MAX_LEN;
+        }
+        memcpy(s_command, body, len);
+        s_command[len] = '\0';
+
+        ESP_LOGI(TAG, "Command from pot%u: %s", header->pot, s_command);
+
+        packet_header_t* reply = (packet_header_t*)s_tx_reply;
+        header_init(reply, MSG_REPLY, header->seq);
+        char* text = (char*)s_tx_reply + sizeof(*reply) + 1;
+        command_result_t result = command_execute(s_command, access, text, FLEET_REPLY_MAX_LEN);
+        s_tx_reply[sizeof(*reply)] = (uint8_t)result;
+        s_tx_reply_len = sizeof(*reply) + 1 + strlen(text);
+
+        s_last_request_pot = header->pot;
+        s_last_request_id = header->seq;
+    }
+
+    send_to(addr, s_tx_reply, s_tx_reply_len);
+}
+
+static void handle_reply(const packet_header_t* header, const uint8_t* body, size_t len)
+{
+    if (len < 1) {
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_request_pending && header->pot == s_request_pot && header->seq == s_request_id) {
+        size_t n = len - 1;
+        if (n > s_reply_len - 1) {
+            n = s_reply_len - 1;
+        }
+        memcpy(s_reply_out, body + 1, n);
+        s_reply_out[n] = '\0';
+        s_reply_ok = (body[0] == COMMAND_OK);
+        s_request_pending = false;
+        xSemaphoreGive(s_reply_ready);
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+// ============================================================================
+// Tasks
+// ============================================================================
+
+static void fleet_rx_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(s_sock, s_rx_buf, sizeof(s_rx_buf), 0,
+                           (struct sockaddr*)&from, &from_len);
+        if (len < (int)sizeof(packet_header_t)) {
+            if (len < 0) {
+                ESP_LOGW(TAG, "recvfrom failed: %d", errno);
+                vTaskDelay(pdMS_TO_TICKS(1000));
+            }
+            continue;
+        }
+
+        packet_header_t header;
+        memcpy(&header, s_rx_buf, sizeof(header));
+        if (header.magic != FLEET_MAGIC || header.version != FLEET_PROTOCOL_VERSION ||
+            header.pot == 0 || header.pot == s_pot ||
+            len < (int)(sizeof(header) + FLEET_MAC_LEN)) {
+            continue;   // Not ours, or our own broadcast
+        }
+
+        size_t signed_len = (size_t)len - FLEET_MAC_LEN;
+        if (!mac_valid(s_rx_buf, signed_len, s_rx_buf + signed_len)) {
+            ESP_LOGW(TAG, "Dropping packet with a bad MAC (claims pot%u)", header.pot);
+            continue;
+        }
+
+        // Old or repeated packet of this pot
+        uint32_t last_epoch = s_replay[header.pot].epoch;
+        uint32_t last_counter = s_replay[header.pot].counter;
+        if (header.epoch < last_epoch ||
+            (header.epoch == last_epoch && header.counter <= last_counter)) {
+            ESP_LOGD(TAG, "Dropping replayed packet from pot%u", header.pot);
+            continue;
+        }
+        s_replay[header.pot].epoch = header.epoch;
+        s_replay[header.pot].counter = header.counter;
+
+        const uint8_t* body = s_rx_buf + sizeof(header);
+        size_t body_len = signed_len - sizeof(header);
+        uint32_t addr = from.sin_addr.s_addr;
+
+        switch (header.type) {
+            case MSG_STATUS:
+                handle_status(&header, addr, body, body_len);
+                break;
+            case MSG_COMMAND:
+                handle_command(&header, addr, body, body_len);
+                break;
+            case MSG_REPLY:
+                handle_reply(&header, body, body_len);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void status_listener(void* user_data)
+{
+    (void)user_data;
+    xTaskNotifyGive(s_tx_task);
+}
+
+static void fleet_tx_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    uint8_t packet[sizeof(packet_header_t) + 16 + FLEET_MAC_LEN];
+    pot_status_t sent = {0};
+    uint8_t seq = 0;
+    int64_t last_keyframe_ms = 0;
+    int64_t last_sent_ms = 0;
+    int64_t election_at_ms = 0;
+    bool joined = false;
+
+    while (1) {
+        if (!wifi_is_connected()) {
+            joined = false;
+            wifi_wait_online();
+        }
+
+        int64_t now = now_ms();
+        pot_status_t current = local_status();
+        uint8_t fields = FIELD_ALL | FIELD_KEYFRAME;
+
+        if (!joined) {
+            // Announce ourselves; peers answer with keyframes before the election
+            current.flags |= STATUS_FLAG_HELLO;
+            election_at_ms = now + FLEET_ELECTION_DELAY_MS;
+            joined = true;
+        } else {
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            bool keyframe_wanted = s_keyframe_wanted;
+            s_keyframe_wanted = false;
+            xSemaphoreGive(s_mutex);
+
+            if (!keyframe_wanted && now - last_keyframe_ms < FLEET_HEARTBEAT_MS) {
+                fields = changed_fields(&current, &sent);
+                if (now - last_sent_ms < FLEET_DELTA_MIN_MS) {
+                    fields = 0;     // Rate limited; picked up on the next wakeup
+                }
+            }
+        }
+
+        if (fields != 0) {
+            header_init((packet_header_t*)packet, MSG_STATUS, seq++);
+            size_t len = sizeof(packet_header_t) +
+                         encode_status(packet + sizeof(packet_header_t), fields, &current);
+            send_to(htonl(INADDR_BROADCAST), packet, len);
+
+            // A delta leaves unsent fields (e.g. small temperature drift) pending
+            if (fields & FIELD_KEYFRAME) {
+                sent = current;
+                sent.flags &= ~STATUS_FLAG_HELLO;
+                last_keyframe_ms = now;
+            } else {
+                pot_status_t merged = sent;
+                decode_status(packet + sizeof(packet_header_t), len - sizeof(packet_header_t),
+                              &merged);
+                sent = merged;
+            }
+            last_sent_ms = now;
+        }
+
+        if (now >= election_at_ms) {
+            elect(now);
+        }
+
+        // Next wakeup: heartbeat, election, or end of the delta rate limit
+        int64_t next = last_keyframe_ms + FLEET_HEARTBEAT_MS;
+        if (election_at_ms > now && election_at_ms < next) {
+            next = election_at_ms;
+        }
+        if (changed_fields(&current, &sent) != 0 && last_sent_ms + FLEET_DELTA_MIN_MS < next) {
+            next = last_sent_ms + FLEET_DELTA_MIN_MS;
+        }
+        TickType_t wait = (next > now) ? pdMS_TO_TICKS(next - now) : 0;
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static void advertise(void)
+{
+    char host[20];
+    char pot[4];
+    snprintf(host, sizeof(host), "crockpot-pot%u", s_pot);
+    snprintf(pot, sizeof(pot), "%u", s_pot);
+
+    if (mdns_init() != ESP_OK) {
+        ESP_LOGW(TAG, "mDNS unavailable - discoverable over UDP only");
+        return;
+    }
+    mdns_hostname_set(host);
+    mdns_instance_name_set(host);
+
+    mdns_txt_item_t txt[] = {
+        { "pot", pot },
+        { "role", "member" },
+    };
+    mdns_service_add(NULL, "_crockpot", "_udp", FLEET_UDP_PORT, txt, sizeof(txt) / sizeof(txt[0]));
+}
+
+bool fleet_init(void)
+{
+    const config_t* settings = config_acquire();
+    s_pot = (settings->saved & CONFIG_SECTION_FLEET) ? settings->fleet_pot : 0;
+    strncpy(s_key, settings->fleet_key[0] ? settings->fleet_key : FLEET_DEFAULT_KEY,
+            sizeof(s_key) - 1);
+    s_key[sizeof(s_key) - 1] = '\0';
+    config_release();
+
+    if (s_pot == 0) {
+        ESP_LOGI(TAG, "Fleet mode off");
+        return true;
+    }
+    if (strlen(s_key) < FLEET_KEY_MIN_LEN) {
+        ESP_LOGW(TAG, "Fleet mode needs a key (/join <N> <key>) - running standalone");
+        s_pot = 0;
+        return true;
+    }
+
+    // A new epoch per boot, saved before any packet goes out, so peers can
+    // tell this boot's packets from recordings of earlier ones
+    config_t* edit = config_edit();
+    s_epoch = ++edit->fleet_epoch;
+    config_commit(CONFIG_SECTION_FLEET);
+    if (!config_flush()) {
+        ESP_LOGE(TAG, "Cannot save the fleet epoch - running standalone");
+        s_pot = 0;
+        return false;
+    }
+
+    s_mutex = xSemaphoreCreateMutex();
+    s_send_mutex = xSemaphoreCreateMutex();
+    s_route_mutex = xSemaphoreCreateMutex();
+    s_reply_ready = xSemaphoreCreateBinary();
+    s_events = xEventGroupCreate();
+    if (s_mutex == NULL || s_send_mutex == NULL || s_route_mutex == NULL ||
+        s_reply_ready == NULL || s_events == NULL) {
+        ESP_LOGE(TAG, "Failed to create fleet sync objects");
+        s_pot = 0;
+        return false;
+    }
+
+    // Random first request id, so a rebooted coordinator's requests are not
+    // taken for retries of its earlier ones
+    s_request_id = (uint8_t)esp_random();
+
+    s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int broadcast = 1;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(FLEET_UDP_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (s_sock < 0 ||
+        setsockopt(s_sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast)) != 0 ||
+        bind(s_sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "Failed to open UDP port %d: %d", FLEET_UDP_PORT, errno);
+        if (s_sock >= 0) {
+            close(s_sock);
+            s_sock = -1;
+        }
+        s_pot = 0;
+        return false;
+    }
+
+    if (xTaskCreate(fleet_tx_task, "fleet_tx", FLEET_TX_STACK_SIZE, NULL,
+                    FLEET_TASK_PRIORITY, &s_tx_task) != pdPASS ||
+        xTaskCreate(fleet_rx_task, "fleet_rx", FLEET_RX_STACK_SIZE, NULL,
+                    FLEET_TASK_PRIORITY, &s_rx_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create fleet tasks");
+        s_pot = 0;
+        return false;
+    }
+
+    crockpot_add_listener(status_listener, NULL);
+    advertise();
+
+    ESP_LOGI(TAG, "Fleet mode on as pot%u (UDP port %d)", s_pot, FLEET_UDP_PORT);
+    return true;
+}
+
+bool fleet_is_enabled(void)
+{
+    return s_pot != 0;
+}
+
+uint8_t fleet_get_pot(void)
+{
+    return s_pot;
+}
+
+bool fleet_is_coordinator(void)
+{
+    return s_pot == 0 || s_coordinator;
+}
+
+void fleet_wait_coordinator(void)
+{
+    if (s_pot != 0) {
+        xEventGroupWaitBits(s_events, COORDINATOR_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+}
+
+bool fleet_route(uint8_t pot, const char* command, command_access_t access,
+                 char* out, size_t out_len)
+{
+    if (out == NULL || out_len == 0) {
+        return false;
+    }
+
+    int prefix = snprintf(out, out_len, "pot%u: ", pot);
+    if (prefix < 0 || (size_t)prefix >= out_len) {
+        return false;
+    }
+    char* reply = out + prefix;
+    size_t reply_len = out_len - (size_t)prefix;
+
+    if (s_pot == 0) {
+        snprintf(out, out_len, "Fleet mode is off");
+        return false;
+    }
+    if (pot == s_pot) {
+        return command_execute(command, access, reply, reply_len) == COMMAND_OK;
+    }
+    if (xTaskGetCurrentTaskHandle() == s_rx_task) {
+        // The reply would have to arrive on this very task
+        snprintf(reply, reply_len, "Cannot route a routed command");
+        return false;
+    }
+
+    size_t command_len = strlen(command);
+    if (command_len > FLEET_COMMAND_MAX_LEN) {
+        snprintf(reply, reply_len, "Command too long");
+        return false;
+    }
+
+    xSemaphoreTake(s_route_mutex, portMAX_DELAY);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    peer_t* peer = find_peer_locked(pot);
+    uint32_t addr = (peer != NULL) ? peer->addr : 0;
+    uint32_t target_epoch = (peer != NULL) ? peer->epoch : 0;
+    if (peer != NULL) {
+        s_request_id++;
+        s_request_pot = pot;
+        s_reply_out = reply;
+        s_reply_len = reply_len;
+        s_reply_ok = false;
+        s_request_pending = true;
+        xSemaphoreTake(s_reply_ready, 0);   // Drop a stale signal
+    }
+    uint8_t request_id = s_request_id;
+    xSemaphoreGive(s_mutex);
+
+    if (peer == NULL) {
+        xSemaphoreGive(s_route_mutex);
+        snprintf(reply, reply_len, "Not in the fleet (see /fleet)");
+        return false;
+    }
+
+    uint8_t packet[sizeof(packet_header_t) + sizeof(target_epoch) + 1 + FLEET_COMMAND_MAX_LEN +
+                   FLEET_MAC_LEN];
+    uint8_t* body = packet + sizeof(packet_header_t);
+    header_init((packet_header_t*)packet, MSG_COMMAND, request_id);
+    memcpy(body, &target_epoch, sizeof(target_epoch));
+    body[sizeof(target_epoch)] = (uint8_t)access;
+    memcpy(body + sizeof(target_epoch) + 1, command, command_len);
+    size_t packet_len = sizeof(packet_header_t) + sizeof(target_epoch) + 1 + command_len;
+
+    bool answered = false;
+    for (int attempt = 0; attempt < 2 && !answered; attempt++) {
+        send_to(addr, packet, packet_len);
+        answered = xSemaphoreTake(s_reply_ready, pdMS_TO_TICKS(FLEET_COMMAND_TIMEOUT_MS)) == pdTRUE;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_request_pending = false;
+    bool ok = answered && s_reply_ok;
+    xSemaphoreGive(s_mutex);
+
+    xSemaphoreGive(s_route_mutex);
+
+    if (!answered) {
+        snprintf(reply, reply_len, "No answer");
+    }
+    return ok;
+}
+
+size_t fleet_format_status(char* out, size_t len)
+{
+    if (s_pot == 0) {
+        return (size_t)snprintf(out, len, "Fleet mode off. /join <N> <key> joins as pot N (after reboot)");
+    }
+
+    peer_t peers[FLEET_MAX_PEERS];
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    memcpy(peers, s_peers, sizeof(peers));
+    bool coordinator = s_coordinator;
+    xSemaphoreGive(s_mutex);
+
+    pot_status_t self = local_status();
+    size_t n = (size_t)snprintf(out, len, "Fleet (this is pot%u%s):", s_pot,
+                                coordinator ? ", coordinator" : "");
+
+    // Self first, then peers in pot order
+    int last = -1;
+    for (int round = 0; round <= FLEET_MAX_PEERS && n < len; round++) {
+        const pot_status_t* s = NULL;
+        bool synced = true;
+        int pot = 256;
+
+        if (round == 0) {
+            s = &self;
+            pot = s_pot;
+        } else {
+            for (int i = 0; i < FLEET_MAX_PEERS; i++) {
+                if (peers[i].pot != 0 && peers[i].pot > last && peers[i].pot < pot) {
+                    pot = peers[i].pot;
+                    s = &peers[i].status;
+                    synced = peers[i].synced;
+                }
+            }
+            if (s == NULL) {
+                break;
+            }
+            last = pot;
+        }
+
+        if (!synced) {
+            n += (size_t)snprintf(out + n, len - n, "\npot%d: syncing", pot);
+            continue;
+        }
+
+        char temp[12] = "--";
+        if (!(s->flags & STATUS_FLAG_SENSOR_ERROR)) {
+            temp_format_f(temp, sizeof(temp), s->temp_cc);
+        }
+        n += (size_t)snprintf(out + n, len - n, "\npot%d: %s %sF %u%%%s", pot,
+                              crockpot_state_to_string((crockpot_state_t)s->state),
+                              temp, s->duty,
+                              (s->flags & STATUS_FLAG_COORDINATOR) ? " *" : "");
+    }
+
+    return (n < len) ? n : len - 1;
+}
+
+bool fleet_set_pot(uint8_t pot, const char* key)
+{
+    if (key != NULL && (strlen(key) < FLEET_KEY_MIN_LEN || strlen(key) > FLEET_KEY_MAX_LEN)) {
+        return false;
+    }
+
+    config_t* settings = config_edit();
+    settings->fleet_pot = pot;
+    if (key != NULL) {
+        strncpy(settings->fleet_key, key, sizeof(settings->fleet_key) - 1);
+        settings->fleet_key[sizeof(settings->fleet_key) - 1] = '\0';
+    }
+    config_commit(CONFIG_SECTION_FLEET);
+    return true;
+}
+
+bool fleet_has_key(void)
+{
+    const config_t* settings = config_acquire();
+    bool has_key = settings->fleet_key[0] != '\0';
+    config_release();
+    return has_key || strlen(FLEET_DEFAULT_KEY) >= FLEET_KEY_MIN_LEN;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file fleet.h
+ * @brief Multi-pot fleet mode (one upstream connection for many units)
+ *
+ * Each unit in a fleet has a pot number (1-255, unique on the LAN). Units
+ * advertise themselves over mDNS ("crockpot-pot<N>.local", service
+ * _crockpot._udp) and exchange status over UDP broadcast on
+ * FLEET_UDP_PORT: a keyframe with every field each FLEET_HEARTBEAT_MS,
+ * and in between only the fields that changed. The lowest pot number
+ * heard from within FLEET_PEER_TIMEOUT_MS is the coordinator; only the
+ * coordinator runs the Telegram poll and the MQTT connection, so the
+ * number of upstream connections no longer grows with the number of pots.
+ *
+ * "/pot3 high" on any interface runs "high" on pot 3 and returns its
+ * reply; "/fleet" lists every pot. After the coordinator drops out the
+ * next lowest pot takes over within FLEET_PEER_TIMEOUT_MS.
+ *
+ * Every packet carries a truncated HMAC-SHA256 under a key shared by the
+ * fleet, so only units holding the key can report status or run
+ * commands. Replays are refused: each packet carries the sender's boot
+ * count (kept in NVS) and a per-boot counter that must move forward, and a
+ * command names the boot of the pot it is meant for, so it is void once
+ * that pot restarts. Commands are taken only from pots already heard from.
+ *
+ * Fleet mode is off until a pot number and a key are saved
+ * (/join <N> <key>, an admin command, or FLEET_DEFAULT_KEY); it takes effect at the next
+ * boot.
+ */
+
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start fleet mode if a pot number is configured
+ *
+ * Call after config_init(), crockpot_init() and wifi_init().
+ *
+ * @return true on success (also when fleet mode is off)
+ */
+bool fleet_init(void);
+
+/**
+ * @brief Whether fleet mode is running
+ */
+bool fleet_is_enabled(void);
+
+/**
+ * @brief This unit's pot number (0 when fleet mode is off)
+ */
+uint8_t fleet_get_pot(void);
+
+/**
+ * @brief Whether this unit should hold the upstream connections
+ *
+ * Always true when fleet mode is off. False until the first election
+ * (FLEET_ELECTION_DELAY_MS after joining the network).
+ */
+bool fleet_is_coordinator(void);
+
+/**
+ * @brief Block until this unit is the coordinator
+ *
+ * Returns at once when fleet mode is off.
+ */
+void fleet_wait_coordinator(void);
+
+/**
+ * @brief Run a command on a pot and fetch its reply
+ *
+ * The local pot runs it directly; others are asked over UDP and waited
+ * for up to FLEET_COMMAND_TIMEOUT_MS (retried once; a repeated request
+ * gets the first reply, so a command never runs twice).
+ *
+ * @param pot     Pot number
+ * @param command Command text, e.g. "high"
+ * @param access  The sender's access, passed on to the pot
+ * @param out     Reply buffer
+ * @param out_len Reply buffer size
+ * @return true if the pot ran the command successfully
+ */
+bool fleet_route(uint8_t pot, const char* command, command_access_t access,
+                 char* out, size_t out_len);
+
+/**
+ * @brief Describe the fleet (pots, roles, states, temperatures)
+ *
+ * @param out Buffer
+ * @param len Buffer size
+ * @return Characters written (excluding the terminator)
+ */
+size_t fleet_format_status(char* out, size_t len);
+
+/**
+ * @brief Save this unit's pot number (0 = leave fleet mode)
+ *
+ * Takes effect at the next boot.
+ *
+ * @param pot Pot number
+ * @param key Shared fleet key, or NULL to keep the saved one
+ * @return true on success
+ */
+bool fleet_set_pot(uint8_t pot, const char* key);
+
+/**
+ * @brief Whether a fleet key is saved or built in
+ */
+bool fleet_has_key(void);
+
+// Shared key used when none is saved (same on every pot; "" = none)
+#define FLEET_DEFAULT_KEY           ""
+#define FLEET_KEY_MIN_LEN           8
+#define FLEET_KEY_MAX_LEN           64
+
+// Bytes of HMAC-SHA256 appended to each packet
+#define FLEET_MAC_LEN               16
+
+// Most pots tracked besides this one
+#define FLEET_MAX_PEERS             16
+
+// UDP port for status, commands and replies
+#define FLEET_UDP_PORT              47374
+
+// Full status at least this often; a pot unheard for the timeout is gone
+#define FLEET_HEARTBEAT_MS          10000
+#define FLEET_PEER_TIMEOUT_MS       35000
+
+// Listening time after joining before the first election
+#define FLEET_ELECTION_DELAY_MS     2000
+
+// Status deltas at most this often, temperature only past the deadband
+#define FLEET_DELTA_MIN_MS          1000
+#define FLEET_TEMP_DEADBAND_CC      25
+
+// Routed commands
+#define FLEET_COMMAND_MAX_LEN       128
+#define FLEET_REPLY_MAX_LEN         512
+#define FLEET_COMMAND_TIMEOUT_MS    1500
+
+// Tasks (receive: also runs commands routed to this pot)
+#define FLEET_RX_STACK_SIZE         4096
+#define FLEET_TX_STACK_SIZE         3072
+#define FLEET_TASK_PRIORITY         3
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLEET_H
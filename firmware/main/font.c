@@ -0,0 +1,25 @@
+/**
+ * @file font.c
+ * @brief Font atlas tables
+ *
+ * font_data.h is generated into the build directory by tools/gen_font.py
+ * (see CMakeLists.txt); it defines font_small .. font_xlarge.
+ */
+
+#include "font.h"
+#include "font_data.h"
+
+static const font_t* const s_fonts[] = {
+    [FONT_SMALL]  = &font_small,
+    [FONT_MEDIUM] = &font_medium,
+    [FONT_LARGE]  = &font_large,
+    [FONT_XLARGE] = &font_xlarge
+};
+
+const font_t* font_get(font_size_t size)
+{
+    if ((unsigned)size < sizeof(s_fonts) / sizeof(s_fonts[0])) {
+        return s_fonts[size];
+    }
+    return s_fonts[FONT_SMALL];
+}
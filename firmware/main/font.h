@@ -0,0 +1,78 @@
+/**
+ * @file font.h
+ * @brief Pre-rasterized bitmap fonts for display_hal
+ *
+ * One font per font_size_t, generated at build time by tools/gen_font.py
+ * into const tables that stay in flash (XIP). Glyphs are 2-bpp
+ * anti-aliased, cover printable ASCII, and have proportional advances.
+ */
+
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+#include "display_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Glyph metrics
+ *
+ * Bitmaps are font->height rows of 2-bpp coverage (0 = background,
+ * 3 = full ink), packed MSB-first with each row padded to a whole byte.
+ */
+typedef struct {
+    uint16_t offset;    // Byte offset into font bitmap
+    uint8_t  width;     // Bitmap width in pixels (0 = blank glyph)
+    uint8_t  advance;   // Pen advance in pixels
+    int8_t   x_offset;  // Bitmap left edge relative to pen position
+} font_glyph_t;
+
+/**
+ * @brief Font atlas
+ */
+typedef struct {
+    const uint8_t*      bitmap;   // Packed glyph bitmaps
+    const font_glyph_t* glyphs;   // Indexed by (char - first)
+    uint8_t             first;    // First character in table
+    uint8_t             last;     // Last character in table
+    uint8_t             height;   // Line height in pixels
+} font_t;
+
+/**
+ * @brief Get the font for a size
+ *
+ * @param size Font size (out-of-range values fall back to FONT_SMALL)
+ * @return Font atlas
+ */
+const font_t* font_get(font_size_t size);
+
+/**
+ * @brief Get glyph metrics for a character
+ *
+ * Characters outside the table render as '?'.
+ */
+static inline const font_glyph_t* font_glyph(const font_t* font, char c)
+{
+    uint8_t code = (uint8_t)c;
+    if (code < font->first || code > font->last) {
+        code = '?';
+    }
+    return &font->glyphs[code - font->first];
+}
+
+/**
+ * @brief Bytes per bitmap row for a glyph
+ */
+static inline uint8_t font_glyph_stride(const font_glyph_t* glyph)
+{
+    return (glyph->width + 3) / 4;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FONT_H
@@ -6,13 +6,17 @@
  */
 
 #include "gui.h"
+#include "config.h"
 #include "display_hal.h"
 #include "touch_hal.h"
 #include "crockpot.h"
+#include "metrics.h"
+#include "power.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
@@ -32,7 +36,7 @@ static SemaphoreHandle_t s_mutex = NULL;
 static gui_screen_t s_current_screen = GUI_SCREEN_MAIN;
 static gui_screen_t s_previous_screen = GUI_SCREEN_MAIN;
 
-// Configuration and theme
+// Configuration and theme (defaults until saved in the settings store)
 static gui_config_t s_config = {
     .show_temperature_c = false,
     .show_wifi_status = true,
@@ -57,6 +61,37 @@ static bool s_dimmed = false;
 // Display info cache
 static display_info_t s_display_info;
 
+// GUI task wakeup reasons. The task blocks until one of these is set;
+// the only timed wakeup is s_deadline_timer, armed for the next deadline.
+#define GUI_EVENT_STATUS       BIT0   // Crockpot status changed (or uptime minute rolled)
+#define GUI_EVENT_INPUT        BIT1   // Touch/button input queued (touch_hal)
+#define GUI_EVENT_MSG_TIMEOUT  BIT2   // Message overlay expired
+#define GUI_EVENT_DIM_TIMEOUT  BIT3   // Screen idle timeout reached
+#define GUI_EVENT_REDRAW       BIT4   // Screen, message or theme changed by API call
+#define GUI_EVENT_ALL          (GUI_EVENT_STATUS | GUI_EVENT_INPUT | GUI_EVENT_MSG_TIMEOUT | \
+                                GUI_EVENT_DIM_TIMEOUT | GUI_EVENT_REDRAW)
+
+static EventGroupHandle_t s_events = NULL;
+static esp_timer_handle_t s_deadline_timer = NULL;
+
+// Next uptime minute boundary (ms since boot, 0 = none)
+static uint32_t s_clock_deadline_ms = 0;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/**
+ * @brief Wake the GUI task (safe from any task)
+ */
+static void post_event(EventBits_t bits)
+{
+    if (s_events != NULL) {
+        xEventGroupSetBits(s_events, bits);
+    }
+}
+
 // ============================================================================
 // Default Themes
 // ============================================================================
@@ -111,71 +146,186 @@ static color_t get_state_color(crockpot_state_t state)
     }
 }
 
-/**
- * @brief Render main screen
- */
-static void render_main_screen(void)
+// FNV-1a helpers for widget content hashes
+#define HASH_INIT 2166136261u
+
+static uint32_t hash_u32(uint32_t h, uint32_t v)
 {
-    int16_t w = s_display_info.width;
-    int16_t h = s_display_info.height;
-    int16_t cx = w / 2;
+    for (int i = 0; i < 4; i++) {
+        h ^= (v >> (i * 8)) & 0xFF;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t hash_str(uint32_t h, const char* s)
+{
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
 
-    // State indicator (large, centered at top)
-    const char* state_str = crockpot_state_to_string(s_status.state);
-    color_t state_color = get_state_color(s_status.state);
+static bool rect_intersects(const display_rect_t* a, const display_rect_t* b)
+{
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
 
-    display_hal_text(cx, 20, state_str, FONT_XLARGE, state_color, ALIGN_CENTER);
+static display_rect_t rect_union(const display_rect_t* a, const display_rect_t* b)
+{
+    int16_t x0 = a->x < b->x ? a->x : b->x;
+    int16_t y0 = a->y < b->y ? a->y : b->y;
+    int16_t x1 = (a->x + a->w) > (b->x + b->w) ? (a->x + a->w) : (b->x + b->w);
+    int16_t y1 = (a->y + a->h) > (b->y + b->h) ? (a->y + a->h) : (b->y + b->h);
+    return (display_rect_t){ x0, y0, x1 - x0, y1 - y0 };
+}
 
-    // Temperature (large, centered)
-    char temp_str[16];
+static int32_t rect_area(const display_rect_t* r)
+{
+    return (int32_t)r->w * r->h;
+}
+
+// Main screen layout helpers (shared by rendering and touch handling)
+static int16_t main_button_y(void)   { return s_display_info.height - 70; }
+static int16_t main_status_bar_y(void) { return s_display_info.height - 30; }
+
+#define MAIN_BUTTON_W 60
+#define MAIN_BUTTON_H 30
+
+// Calibration targets: distance from the screen edges
+#define CAL_TARGET_MARGIN 20
+
+static void format_temperature(char* buf, size_t buf_len)
+{
+    size_t n;
     if (s_config.show_temperature_c) {
-        float temp_c = (s_status.temperature_f - 32.0f) * 5.0f / 9.0f;
-        snprintf(temp_str, sizeof(temp_str), "%.1f C", temp_c);
+        n = temp_format_c(buf, buf_len, s_status.temperature);
+        snprintf(buf + n, buf_len - n, " C");
     } else {
-        snprintf(temp_str, sizeof(temp_str), "%.1f F", s_status.temperature_f);
+        n = temp_format_f(buf, buf_len, s_status.temperature);
+        snprintf(buf + n, buf_len - n, " F");
     }
-    display_hal_text(cx, 60, temp_str, FONT_LARGE, s_theme.text, ALIGN_CENTER);
+}
+
+static void format_uptime_hm(char* buf, size_t buf_len)
+{
+    uint32_t h_up = s_status.uptime_seconds / 3600;
+    uint32_t m_up = (s_status.uptime_seconds % 3600) / 60;
+    snprintf(buf, buf_len, "%02lu:%02lu", (unsigned long)h_up, (unsigned long)m_up);
+}
 
-    // Sensor error indicator
+static bool touch_buttons_visible(void)
+{
+    touch_info_t touch_info = touch_hal_get_info();
+    return touch_info.type != TOUCH_TYPE_NONE && touch_info.type != TOUCH_TYPE_BUTTONS;
+}
+
+// ----------------------------------------------------------------------------
+// Main screen widgets
+// ----------------------------------------------------------------------------
+
+static uint32_t state_hash(void)
+{
+    uint32_t h = hash_str(HASH_INIT, crockpot_state_to_string(s_status.state));
+    return hash_u32(h, get_state_color(s_status.state));
+}
+
+static void state_draw(void)
+{
+    display_hal_text(s_display_info.width / 2, 20,
+                     crockpot_state_to_string(s_status.state),
+                     FONT_XLARGE, get_state_color(s_status.state), ALIGN_CENTER);
+}
+
+static uint32_t temp_hash(void)
+{
+    char temp_str[16];
+    format_temperature(temp_str, sizeof(temp_str));
+    return hash_str(HASH_INIT, temp_str);
+}
+
+static void temp_draw(void)
+{
+    char temp_str[16];
+    format_temperature(temp_str, sizeof(temp_str));
+    display_hal_text(s_display_info.width / 2, 60, temp_str,
+                     FONT_LARGE, s_theme.text, ALIGN_CENTER);
+}
+
+static uint32_t sensor_error_hash(void)
+{
+    return s_status.sensor_error ? 1 : 0;
+}
+
+static void sensor_error_draw(void)
+{
     if (s_status.sensor_error) {
-        display_hal_text(cx, 90, "SENSOR ERROR", FONT_SMALL, s_theme.error, ALIGN_CENTER);
+        display_hal_text(s_display_info.width / 2, 90, "SENSOR ERROR",
+                         FONT_SMALL, s_theme.error, ALIGN_CENTER);
     }
+}
 
-    // Status bar at bottom
-    int16_t bar_y = h - 30;
+static uint32_t wifi_hash(void)
+{
+    if (!s_config.show_wifi_status) {
+        return 0;
+    }
+    return s_status.wifi_connected ? 2 : 1;
+}
 
-    // WiFi indicator
+static void wifi_draw(void)
+{
     if (s_config.show_wifi_status) {
         const char* wifi_str = s_status.wifi_connected ? "WiFi" : "----";
         color_t wifi_color = s_status.wifi_connected ? s_theme.success : s_theme.text_dim;
-        display_hal_text(10, bar_y, wifi_str, FONT_SMALL, wifi_color, ALIGN_LEFT);
+        display_hal_text(10, main_status_bar_y(), wifi_str, FONT_SMALL, wifi_color, ALIGN_LEFT);
     }
+}
 
-    // Uptime
+static uint32_t uptime_hash(void)
+{
+    // Only hours and minutes are shown, so seconds must not cause redraws
+    return hash_u32(HASH_INIT, s_status.uptime_seconds / 60);
+}
+
+static void uptime_draw(void)
+{
     char uptime_str[16];
-    uint32_t h_up = s_status.uptime_seconds / 3600;
-    uint32_t m_up = (s_status.uptime_seconds % 3600) / 60;
-    snprintf(uptime_str, sizeof(uptime_str), "%02lu:%02lu", h_up, m_up);
-    display_hal_text(w - 10, bar_y, uptime_str, FONT_SMALL, s_theme.text_dim, ALIGN_RIGHT);
+    format_uptime_hm(uptime_str, sizeof(uptime_str));
+    display_hal_text(s_display_info.width - 10, main_status_bar_y(), uptime_str,
+                     FONT_SMALL, s_theme.text_dim, ALIGN_RIGHT);
+}
 
+static uint32_t buttons_hash(void)
+{
+    return touch_buttons_visible() ? 1 : 0;
+}
+
+static void buttons_draw(void)
+{
     // Touch zones (visual hints for touchscreen)
-    touch_info_t touch_info = touch_hal_get_info();
-    if (touch_info.type != TOUCH_TYPE_NONE && touch_info.type != TOUCH_TYPE_BUTTONS) {
-        // Draw state change buttons
-        int16_t btn_y = h - 70;
-        int16_t btn_w = 60;
-        int16_t btn_h = 30;
+    if (!touch_buttons_visible()) {
+        return;
+    }
+
+    int16_t w = s_display_info.width;
+    int16_t btn_y = main_button_y();
 
-        // DOWN button
-        display_hal_rect(20, btn_y, btn_w, btn_h, s_theme.text_dim);
-        display_hal_text(20 + btn_w/2, btn_y + 8, "-", FONT_MEDIUM, s_theme.text, ALIGN_CENTER);
+    // DOWN button
+    display_hal_rect(20, btn_y, MAIN_BUTTON_W, MAIN_BUTTON_H, s_theme.text_dim);
+    display_hal_text(20 + MAIN_BUTTON_W/2, btn_y + 8, "-", FONT_MEDIUM, s_theme.text, ALIGN_CENTER);
 
-        // UP button
-        display_hal_rect(w - 20 - btn_w, btn_y, btn_w, btn_h, s_theme.text_dim);
-        display_hal_text(w - 20 - btn_w/2, btn_y + 8, "+", FONT_MEDIUM, s_theme.text, ALIGN_CENTER);
-    }
+    // UP button
+    display_hal_rect(w - 20 - MAIN_BUTTON_W, btn_y, MAIN_BUTTON_W, MAIN_BUTTON_H, s_theme.text_dim);
+    display_hal_text(w - 20 - MAIN_BUTTON_W/2, btn_y + 8, "+", FONT_MEDIUM, s_theme.text, ALIGN_CENTER);
 }
 
+// ----------------------------------------------------------------------------
+// Secondary screens (rendered as a single full-screen widget)
+// ----------------------------------------------------------------------------
+
 /**
  * @brief Render settings screen
  */
@@ -226,7 +376,8 @@ static void render_info_screen(void)
     uint32_t days = s_status.uptime_seconds / 86400;
     uint32_t hours = (s_status.uptime_seconds % 86400) / 3600;
     uint32_t mins = (s_status.uptime_seconds % 3600) / 60;
-    snprintf(uptime, sizeof(uptime), "Uptime: %lud %02lu:%02lu", days, hours, mins);
+    snprintf(uptime, sizeof(uptime), "Uptime: %lud %02lu:%02lu",
+             (unsigned long)days, (unsigned long)hours, (unsigned long)mins);
     display_hal_text(cx, 50, uptime, FONT_SMALL, s_theme.text, ALIGN_CENTER);
 
     // Version
@@ -236,19 +387,62 @@ static void render_info_screen(void)
                      FONT_SMALL, s_theme.text_dim, ALIGN_CENTER);
 }
 
+// Touch calibration progress (GUI_SCREEN_CALIBRATE)
+static touch_calibration_point_t s_cal_points[3];
+static uint8_t s_cal_step = 0;
+
 /**
- * @brief Render current screen
+ * @brief Screen position of a calibration target (spread, not collinear)
  */
-static void render_screen(void)
+static void calibration_target(uint8_t step, int16_t* x, int16_t* y)
 {
-    // Clear screen
-    display_hal_clear(s_theme.background);
+    int16_t w = s_display_info.width;
+    int16_t h = s_display_info.height;
+
+    switch (step) {
+        case 0:  *x = CAL_TARGET_MARGIN;     *y = CAL_TARGET_MARGIN;     break;
+        case 1:  *x = w - CAL_TARGET_MARGIN; *y = h / 2;                 break;
+        default: *x = w / 2;                 *y = h - CAL_TARGET_MARGIN; break;
+    }
+}
+
+/**
+ * @brief Render touch calibration screen
+ */
+static void render_calibrate_screen(void)
+{
+    int16_t cx = s_display_info.width / 2;
+    int16_t x, y;
+    calibration_target(s_cal_step, &x, &y);
+
+    display_hal_hline(x - 10, y, 21, s_theme.accent);
+    display_hal_vline(x, y - 10, 21, s_theme.accent);
+    display_hal_circle(x, y, 6, s_theme.text);
+
+    char hint[32];
+    snprintf(hint, sizeof(hint), "Touch the target (%u/3)", s_cal_step + 1);
+    display_hal_text(cx, s_display_info.height / 3, hint, FONT_SMALL, s_theme.text, ALIGN_CENTER);
+}
+
+static uint32_t page_hash(void)
+{
+    uint32_t h = hash_u32(HASH_INIT, s_current_screen);
 
-    // Render active screen
     switch (s_current_screen) {
-        case GUI_SCREEN_MAIN:
-            render_main_screen();
-            break;
+        case GUI_SCREEN_WIFI:
+            return hash_u32(h, s_status.wifi_connected);
+        case GUI_SCREEN_INFO:
+            return hash_u32(h, s_status.uptime_seconds / 60);
+        case GUI_SCREEN_CALIBRATE:
+            return hash_u32(h, s_cal_step);
+        default:
+            return h;
+    }
+}
+
+static void page_draw(void)
+{
+    switch (s_current_screen) {
         case GUI_SCREEN_SETTINGS:
             render_settings_screen();
             break;
@@ -258,25 +452,266 @@ static void render_screen(void)
         case GUI_SCREEN_INFO:
             render_info_screen();
             break;
+        case GUI_SCREEN_CALIBRATE:
+            render_calibrate_screen();
+            break;
         default:
             break;
     }
+}
 
-    // Message overlay
-    if (s_message[0] != '\0') {
-        int16_t cx = s_display_info.width / 2;
-        int16_t cy = s_display_info.height / 2;
-        int16_t box_w = s_display_info.width - 40;
-        int16_t box_h = 40;
+// ----------------------------------------------------------------------------
+// Message overlay (all screens, drawn last)
+// ----------------------------------------------------------------------------
+
+static uint32_t message_hash(void)
+{
+    if (s_message[0] == '\0') {
+        return 0;
+    }
+    return hash_u32(hash_str(HASH_INIT, s_message), s_message_is_error);
+}
 
-        color_t box_color = s_message_is_error ? s_theme.error : s_theme.accent;
+static void message_draw(void)
+{
+    if (s_message[0] == '\0') {
+        return;
+    }
+
+    int16_t cx = s_display_info.width / 2;
+    int16_t cy = s_display_info.height / 2;
+    int16_t box_w = s_display_info.width - 40;
+    int16_t box_h = 40;
+
+    color_t box_color = s_message_is_error ? s_theme.error : s_theme.accent;
 
-        display_hal_fill_round_rect(20, cy - box_h/2, box_w, box_h, 5, box_color);
-        display_hal_text(cx, cy - 6, s_message, FONT_MEDIUM, COLOR_WHITE, ALIGN_CENTER);
+    display_hal_fill_round_rect(20, cy - box_h/2, box_w, box_h, 5, box_color);
+    display_hal_set_text_background(box_color);
+    display_hal_text(cx, cy - 6, s_message, FONT_MEDIUM, COLOR_WHITE, ALIGN_CENTER);
+    display_hal_set_text_background(s_theme.background);
+}
+
+// ----------------------------------------------------------------------------
+// Damage tracking
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Widget identifiers, in z-order (later widgets draw on top)
+ */
+typedef enum {
+    WIDGET_STATE,
+    WIDGET_TEMP,
+    WIDGET_SENSOR_ERROR,
+    WIDGET_WIFI,
+    WIDGET_UPTIME,
+    WIDGET_BUTTONS,
+    WIDGET_PAGE,
+    WIDGET_MESSAGE,
+    WIDGET_COUNT
+} widget_id_t;
+
+/**
+ * @brief A screen region with the hash of its last rendered content
+ */
+typedef struct {
+    display_rect_t bounds;
+    uint32_t (*hash)(void);
+    void (*draw)(void);
+    uint32_t last_hash;
+    bool drawn;             // last_hash is valid for what is on screen
+} widget_t;
+
+static widget_t s_widgets[WIDGET_COUNT] = {
+    [WIDGET_STATE]        = { .hash = state_hash,        .draw = state_draw },
+    [WIDGET_TEMP]         = { .hash = temp_hash,         .draw = temp_draw },
+    [WIDGET_SENSOR_ERROR] = { .hash = sensor_error_hash, .draw = sensor_error_draw },
+    [WIDGET_WIFI]         = { .hash = wifi_hash,         .draw = wifi_draw },
+    [WIDGET_UPTIME]       = { .hash = uptime_hash,       .draw = uptime_draw },
+    [WIDGET_BUTTONS]      = { .hash = buttons_hash,      .draw = buttons_draw },
+    [WIDGET_PAGE]         = { .hash = page_hash,         .draw = page_draw },
+    [WIDGET_MESSAGE]      = { .hash = message_hash,      .draw = message_draw },
+};
+
+// Maximum number of merged regions passed to display_hal_flush_rects()
+#define GUI_MAX_DIRTY_RECTS 6
+
+// Set when the whole screen must be cleared (screen/theme change)
+static bool s_full_redraw = true;
+
+/**
+ * @brief Compute widget bounds from the display geometry
+ */
+static void layout_widgets(void)
+{
+    int16_t w = s_display_info.width;
+    int16_t h = s_display_info.height;
+    int16_t bar_y = main_status_bar_y();
+
+    s_widgets[WIDGET_STATE].bounds        = (display_rect_t){ 0, 20, w, display_hal_font_height(FONT_XLARGE) };
+    s_widgets[WIDGET_TEMP].bounds         = (display_rect_t){ 0, 60, w, display_hal_font_height(FONT_LARGE) };
+    s_widgets[WIDGET_SENSOR_ERROR].bounds = (display_rect_t){ 0, 90, w, display_hal_font_height(FONT_SMALL) };
+    s_widgets[WIDGET_WIFI].bounds         = (display_rect_t){ 0, bar_y, w / 2, display_hal_font_height(FONT_SMALL) };
+    s_widgets[WIDGET_UPTIME].bounds       = (display_rect_t){ w / 2, bar_y, w - w / 2, display_hal_font_height(FONT_SMALL) };
+    s_widgets[WIDGET_BUTTONS].bounds      = (display_rect_t){ 20, main_button_y(), w - 40, MAIN_BUTTON_H };
+    s_widgets[WIDGET_PAGE].bounds         = (display_rect_t){ 0, 0, w, h };
+    s_widgets[WIDGET_MESSAGE].bounds      = (display_rect_t){ 20, h / 2 - 20, w - 40, 40 };
+}
+
+static bool widget_active(widget_id_t id)
+{
+    switch (id) {
+        case WIDGET_MESSAGE:
+            return true;
+        case WIDGET_PAGE:
+            return s_current_screen != GUI_SCREEN_MAIN;
+        default:
+            return s_current_screen == GUI_SCREEN_MAIN;
+    }
+}
+
+/**
+ * @brief Add a rectangle to the dirty list, merging where worthwhile
+ *
+ * Overlapping rectangles, or ones whose union wastes little area, are
+ * combined. If the list is full, the new rectangle is folded into the
+ * entry that grows least.
+ */
+static void dirty_add(display_rect_t* list, uint8_t* count, display_rect_t r)
+{
+    for (uint8_t i = 0; i < *count; ) {
+        display_rect_t u = rect_union(&list[i], &r);
+        if (rect_intersects(&list[i], &r) ||
+            rect_area(&u) <= rect_area(&list[i]) + rect_area(&r)) {
+            // Absorb the entry; the grown rectangle may now overlap
+            // entries already checked, so start over
+            r = u;
+            list[i] = list[--(*count)];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (*count < GUI_MAX_DIRTY_RECTS) {
+        list[(*count)++] = r;
+        return;
     }
 
+    uint8_t best = 0;
+    int32_t best_growth = INT32_MAX;
+    for (uint8_t i = 0; i < *count; i++) {
+        display_rect_t u = rect_union(&list[i], &r);
+        int32_t growth = rect_area(&u) - rect_area(&list[i]);
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    list[best] = rect_union(&list[best], &r);
+}
+
+/**
+ * @brief Render current screen
+ *
+ * Only widgets whose content hash changed since they were last drawn are
+ * cleared and redrawn. Widgets overlapping a changed region are redrawn
+ * as well so that z-order is preserved, and only the merged dirty
+ * regions are flushed to the panel.
+ */
+static void render_screen(void)
+{
+    bool dirty[WIDGET_COUNT] = { false };
+    uint32_t hashes[WIDGET_COUNT] = { 0 };
+    bool any_dirty = false;
+
+    if (s_full_redraw) {
+        for (int i = 0; i < WIDGET_COUNT; i++) {
+            s_widgets[i].drawn = false;
+        }
+    }
+
+    // Find widgets whose content changed
+    for (int i = 0; i < WIDGET_COUNT; i++) {
+        if (!widget_active(i)) {
+            s_widgets[i].drawn = false;
+            continue;
+        }
+        hashes[i] = s_widgets[i].hash();
+        if (!s_widgets[i].drawn || hashes[i] != s_widgets[i].last_hash) {
+            dirty[i] = true;
+            any_dirty = true;
+        }
+    }
+
+    if (!any_dirty) {
+        return;
+    }
+
+    // Rasterizing is CPU bound; finish the frame at full clock
+    power_acquire(POWER_LOCK_GUI);
+    int64_t start_us = esp_timer_get_time();
+
+    // Clearing a region erases whatever overlaps it, so overlapping
+    // widgets must be redrawn too (repeat until nothing new is added)
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < WIDGET_COUNT; i++) {
+            if (!dirty[i]) continue;
+            for (int j = 0; j < WIDGET_COUNT; j++) {
+                if (!dirty[j] && widget_active(j) &&
+                    rect_intersects(&s_widgets[i].bounds, &s_widgets[j].bounds)) {
+                    dirty[j] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    display_rect_t rects[GUI_MAX_DIRTY_RECTS];
+    uint8_t rect_count = 0;
+
+    display_hal_set_text_background(s_theme.background);
+
+    if (s_full_redraw) {
+        display_hal_clear(s_theme.background);
+        rects[rect_count++] = (display_rect_t){ 0, 0, s_display_info.width, s_display_info.height };
+    } else {
+        // Clear all damaged regions first, then draw in z-order, so a later
+        // clear never wipes an earlier widget's fresh pixels
+        for (int i = 0; i < WIDGET_COUNT; i++) {
+            if (dirty[i]) {
+                const display_rect_t* b = &s_widgets[i].bounds;
+                display_hal_fill_rect(b->x, b->y, b->w, b->h, s_theme.background);
+                dirty_add(rects, &rect_count, *b);
+            }
+        }
+    }
+
+    for (int i = 0; i < WIDGET_COUNT; i++) {
+        if (dirty[i]) {
+            s_widgets[i].draw();
+            s_widgets[i].last_hash = hashes[i];
+            s_widgets[i].drawn = true;
+        }
+    }
+
+    s_full_redraw = false;
+
     // Flush to display
-    display_hal_flush();
+    display_hal_flush_rects(rects, rect_count);
+
+    metrics_observe(METRIC_GUI_FRAME_US, (uint32_t)(esp_timer_get_time() - start_us));
+    power_release(POWER_LOCK_GUI);
+}
+
+/**
+ * @brief Invalidate the whole screen so the next frame redraws everything
+ */
+static void invalidate_screen(void)
+{
+    s_full_redraw = true;
+    post_event(GUI_EVENT_REDRAW);
 }
 
 // ============================================================================
@@ -289,33 +724,18 @@ static void render_screen(void)
 static void handle_main_touch(int16_t x, int16_t y)
 {
     int16_t w = s_display_info.width;
-    int16_t h = s_display_info.height;
 
     // Check button zones
-    int16_t btn_y = h - 70;
-    int16_t btn_h = 30;
+    int16_t btn_y = main_button_y();
 
-    if (y >= btn_y && y <= btn_y + btn_h) {
+    if (y >= btn_y && y <= btn_y + MAIN_BUTTON_H) {
         crockpot_state_t current = s_status.state;
         crockpot_state_t new_state = current;
 
-        // Left button (decrease)
         if (x < w / 3) {
-            switch (current) {
-                case CROCKPOT_HIGH: new_state = CROCKPOT_LOW;  break;
-                case CROCKPOT_LOW:  new_state = CROCKPOT_WARM; break;
-                case CROCKPOT_WARM: new_state = CROCKPOT_OFF;  break;
-                default: break;
-            }
-        }
-        // Right button (increase)
-        else if (x > 2 * w / 3) {
-            switch (current) {
-                case CROCKPOT_OFF:  new_state = CROCKPOT_WARM; break;
-                case CROCKPOT_WARM: new_state = CROCKPOT_LOW;  break;
-                case CROCKPOT_LOW:  new_state = CROCKPOT_HIGH; break;
-                default: break;
-            }
+            new_state = crockpot_step_state(current, -1);   // Left: decrease
+        } else if (x > 2 * w / 3) {
+            new_state = crockpot_step_state(current, 1);    // Right: increase
         }
 
         if (new_state != current) {
@@ -326,21 +746,98 @@ static void handle_main_touch(int16_t x, int16_t y)
 }
 
 /**
- * @brief Touch event callback
+ * @brief Record a raw reading on the current calibration target
  */
-static void touch_callback(const touch_event_t* event, void* user_data)
+static void handle_calibrate_touch(int16_t raw_x, int16_t raw_y)
 {
-    (void)user_data;
+    touch_calibration_point_t* point = &s_cal_points[s_cal_step];
+    calibration_target(s_cal_step, &point->screen_x, &point->screen_y);
+    point->raw_x = raw_x;
+    point->raw_y = raw_y;
+
+    if (++s_cal_step < 3) {
+        return;
+    }
 
+    s_cal_step = 0;
+    if (touch_hal_set_calibration(s_cal_points) && touch_hal_save_calibration()) {
+        gui_back();
+        gui_show_message("Touch calibrated", 2000);
+    } else {
+        // Still calibrating; start over from the first target
+        gui_show_error("Calibration failed - try again");
+    }
+}
+
+/**
+ * @brief Handle a button press
+ *
+ * On the main screen UP/DOWN step the state and SELECT toggles OFF/LOW;
+ * elsewhere any button goes back.
+ */
+static void handle_button(button_id_t button)
+{
+    if (s_message[0] != '\0') {
+        gui_dismiss_message();
+        return;
+    }
+
+    if (s_current_screen != GUI_SCREEN_MAIN) {
+        gui_back();
+        return;
+    }
+
+    crockpot_state_t current = s_status.state;
+    crockpot_state_t new_state = current;
+
+    switch (button) {
+        case BUTTON_UP:
+            new_state = crockpot_step_state(current, 1);
+            break;
+        case BUTTON_DOWN:
+            new_state = crockpot_step_state(current, -1);
+            break;
+        case BUTTON_SELECT:
+            new_state = (current == CROCKPOT_OFF) ? CROCKPOT_LOW : CROCKPOT_OFF;
+            break;
+        default:
+            break;
+    }
+
+    if (new_state != current) {
+        crockpot_set_state(new_state);
+        gui_show_message(crockpot_state_to_string(new_state), 1000);
+    }
+}
+
+/**
+ * @brief Handle a touch or button event (GUI task)
+ */
+static void handle_input(const touch_event_t* event)
+{
     if (event->type == TOUCH_EVENT_PRESS || event->type == TOUCH_EVENT_RELEASE) {
         // Wake display on any touch
         gui_wake();
     }
 
+    // Long press above the main screen buttons: recalibrate the touch
+    if (event->type == TOUCH_EVENT_LONG_PRESS && event->button == BUTTON_NONE &&
+        s_current_screen == GUI_SCREEN_MAIN && s_message[0] == '\0' &&
+        event->y < main_button_y()) {
+        gui_set_screen(GUI_SCREEN_CALIBRATE);
+        return;
+    }
+
     if (event->type != TOUCH_EVENT_PRESS) {
         return;
     }
 
+    if (event->button != BUTTON_NONE) {
+        ESP_LOGD(TAG, "Button %d", event->button);
+        handle_button(event->button);
+        return;
+    }
+
     ESP_LOGD(TAG, "Touch at (%d, %d)", event->x, event->y);
 
     // Dismiss message overlay first
@@ -361,6 +858,10 @@ static void touch_callback(const touch_event_t* event, void* user_data)
             gui_back();
             break;
 
+        case GUI_SCREEN_CALIBRATE:
+            handle_calibrate_touch(event->x, event->y);
+            break;
+
         default:
             break;
     }
@@ -370,49 +871,136 @@ static void touch_callback(const touch_event_t* event, void* user_data)
 // GUI Task
 // ============================================================================
 
+static uint32_t dim_deadline_ms(void)
+{
+    if (s_config.screen_timeout_s == 0 || s_dimmed) {
+        return 0;
+    }
+    return s_last_interaction_ms + s_config.screen_timeout_s * 1000;
+}
+
+static bool deadline_passed(uint32_t deadline, uint32_t now)
+{
+    return deadline != 0 && (int32_t)(now - deadline) >= 0;
+}
+
+/**
+ * @brief Deadline timer callback (esp_timer task)
+ *
+ * Translates whichever deadlines have passed into typed event bits.
+ */
+static void deadline_timer_cb(void* arg)
+{
+    (void)arg;
+    uint32_t now = now_ms();
+    EventBits_t bits = 0;
+
+    if (s_message[0] != '\0' && deadline_passed(s_message_until_ms, now)) {
+        bits |= GUI_EVENT_MSG_TIMEOUT;
+    }
+    if (deadline_passed(dim_deadline_ms(), now)) {
+        bits |= GUI_EVENT_DIM_TIMEOUT;
+    }
+    if (bits == 0) {
+        // Clock tick (or a deadline moved); re-read status and re-arm
+        bits = GUI_EVENT_STATUS;
+    }
+
+    post_event(bits);
+}
+
+/**
+ * @brief Arm the one-shot timer for the earliest pending deadline
+ */
+static void arm_deadline_timer(uint32_t now)
+{
+    uint32_t deadlines[] = {
+        s_message[0] != '\0' ? s_message_until_ms : 0,
+        dim_deadline_ms(),
+        s_clock_deadline_ms,
+    };
+
+    uint32_t wait_ms = UINT32_MAX;
+    for (size_t i = 0; i < sizeof(deadlines) / sizeof(deadlines[0]); i++) {
+        if (deadlines[i] == 0) {
+            continue;
+        }
+        int32_t remaining = (int32_t)(deadlines[i] - now);
+        uint32_t ms = remaining > 0 ? (uint32_t)remaining : 0;
+        if (ms < wait_ms) {
+            wait_ms = ms;
+        }
+    }
+
+    esp_timer_stop(s_deadline_timer);
+    if (wait_ms != UINT32_MAX) {
+        esp_timer_start_once(s_deadline_timer, (uint64_t)wait_ms * 1000 + 1000);
+    }
+}
+
+/**
+ * @brief Crockpot status listener (control task / crockpot_set_state caller)
+ */
+static void status_listener(void* user_data)
+{
+    (void)user_data;
+    post_event(GUI_EVENT_STATUS);
+}
+
+/**
+ * @brief Touch HAL callback (esp_timer task)
+ *
+ * The event is already queued in the touch HAL; just wake the GUI task.
+ */
+static void touch_event_cb(const touch_event_t* event, void* user_data)
+{
+    (void)event;
+    (void)user_data;
+    post_event(GUI_EVENT_INPUT);
+}
+
 static void gui_task(void* pvParameters)
 {
     (void)pvParameters;
 
     ESP_LOGI(TAG, "GUI task started");
 
-    TickType_t last_wake = xTaskGetTickCount();
-    const TickType_t update_period = pdMS_TO_TICKS(100);  // 10 Hz
+    s_status = crockpot_get_status();
 
     while (1) {
-        // Get current time
-        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        uint32_t now = now_ms();
 
-        // Poll for touch events
-        touch_event_t event;
-        while (touch_hal_poll_event(&event)) {
-            touch_callback(&event, NULL);
-        }
+        // Next uptime minute, so the clock widgets stay current
+        uint32_t until_minute_ms = (60 - s_status.uptime_seconds % 60) * 1000;
+        s_clock_deadline_ms = now + until_minute_ms;
 
-        // Check message timeout
-        if (s_message[0] != '\0' && s_message_until_ms > 0) {
-            if (now_ms >= s_message_until_ms) {
-                gui_dismiss_message();
-            }
-        }
+        // Render, then sleep until something changes
+        render_screen();
+        arm_deadline_timer(now);
 
-        // Check screen timeout
-        if (s_config.screen_timeout_s > 0 && !s_dimmed) {
-            uint32_t idle_ms = now_ms - s_last_interaction_ms;
-            if (idle_ms > s_config.screen_timeout_s * 1000) {
-                s_dimmed = true;
-                display_hal_set_brightness(10);  // Dim to 10%
+        EventBits_t bits = xEventGroupWaitBits(s_events, GUI_EVENT_ALL,
+                                               pdTRUE, pdFALSE, portMAX_DELAY);
+        now = now_ms();
+
+        if (bits & GUI_EVENT_INPUT) {
+            touch_event_t event;
+            while (touch_hal_poll_event(&event)) {
+                handle_input(&event);
             }
         }
 
-        // Update cached status
-        s_status = crockpot_get_status();
+        if ((bits & GUI_EVENT_MSG_TIMEOUT) && s_message[0] != '\0' &&
+            deadline_passed(s_message_until_ms, now)) {
+            gui_dismiss_message();
+        }
 
-        // Render
-        render_screen();
+        if ((bits & GUI_EVENT_DIM_TIMEOUT) && deadline_passed(dim_deadline_ms(), now)) {
+            s_dimmed = true;
+            display_hal_set_brightness(10);  // Dim to 10%
+        }
 
-        // Wait for next update
-        vTaskDelayUntil(&last_wake, update_period);
+        // Always take a fresh copy; it is cheap and keeps uptime current
+        s_status = crockpot_get_status();
     }
 }
 
@@ -420,6 +1008,22 @@ static void gui_task(void* pvParameters)
 // Public API
 // ============================================================================
 
+/**
+ * @brief Apply a saved config or theme change
+ */
+static void settings_listener(uint32_t changed, const config_t* config, void* user_data)
+{
+    if (changed & CONFIG_SECTION_GUI) {
+        s_config = config->gui;
+        display_hal_set_brightness(s_config.brightness);
+        post_event(GUI_EVENT_REDRAW);
+    }
+    if (changed & CONFIG_SECTION_THEME) {
+        s_theme = config->theme;
+        invalidate_screen();
+    }
+}
+
 bool gui_init(void)
 {
     if (s_initialized) {
@@ -435,28 +1039,62 @@ bool gui_init(void)
         return false;
     }
 
+    // Wakeup sources for the GUI task
+    s_events = xEventGroupCreate();
+    if (s_events == NULL) {
+        ESP_LOGE(TAG, "Failed to create GUI event sources");
+        return false;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = deadline_timer_cb,
+        .name = "gui_deadline",
+    };
+    if (esp_timer_create(&timer_args, &s_deadline_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create deadline timer");
+        return false;
+    }
+
     // Initialize display HAL
     if (!display_hal_init()) {
         ESP_LOGE(TAG, "Display HAL init failed");
         return false;
     }
     s_display_info = display_hal_get_info();
+    layout_widgets();
 
     // Initialize touch HAL
     if (!touch_hal_init()) {
         ESP_LOGW(TAG, "Touch HAL init failed - continuing without touch");
     }
+    touch_hal_set_rotation(LCD_DEFAULT_ROTATION);
 
-    // Set up touch callback
-    touch_hal_set_callback(touch_callback, NULL);
+    // Touch events and status changes wake the GUI task
+    touch_hal_set_callback(touch_event_cb, NULL);
+    crockpot_add_listener(status_listener, NULL);
+    post_event(GUI_EVENT_INPUT);    // Anything queued before the callback
 
-    // Load default theme
+    // Saved config and theme, else the defaults
     s_theme = gui_default_dark_theme();
+    const config_t* settings = config_acquire();
+    if (settings->saved & CONFIG_SECTION_GUI) {
+        s_config = settings->gui;
+    }
+    if (settings->saved & CONFIG_SECTION_THEME) {
+        s_theme = settings->theme;
+    }
+    config_release();
+    config_add_listener(CONFIG_SECTION_GUI | CONFIG_SECTION_THEME, settings_listener, NULL);
 
     // Set initial brightness
     display_hal_set_brightness(s_config.brightness);
 
-    s_last_interaction_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    // A resistive panel is unusable until calibrated
+    if (touch_hal_needs_calibration()) {
+        gui_set_screen(GUI_SCREEN_CALIBRATE);
+    }
+
+    s_last_interaction_ms = now_ms();
     s_initialized = true;
 
     ESP_LOGI(TAG, "GUI initialized (%dx%d display)",
@@ -496,8 +1134,17 @@ void gui_set_screen(gui_screen_t screen)
         return;
     }
 
+    // Calibration needs a touch controller; events read raw meanwhile
+    if (screen == GUI_SCREEN_CALIBRATE) {
+        if (!touch_hal_start_calibration()) {
+            return;
+        }
+        s_cal_step = 0;
+    }
+
     s_previous_screen = s_current_screen;
     s_current_screen = screen;
+    invalidate_screen();
     gui_wake();
 
     ESP_LOGD(TAG, "Screen changed to %d", screen);
@@ -510,8 +1157,13 @@ gui_screen_t gui_get_screen(void)
 
 void gui_back(void)
 {
+    if (s_current_screen == GUI_SCREEN_CALIBRATE) {
+        touch_hal_cancel_calibration();
+    }
+
     s_current_screen = s_previous_screen;
     s_previous_screen = GUI_SCREEN_MAIN;
+    invalidate_screen();
     gui_wake();
 }
 
@@ -519,6 +1171,7 @@ void gui_update_status(const crockpot_status_t* status)
 {
     if (status != NULL) {
         s_status = *status;
+        post_event(GUI_EVENT_STATUS);
     }
 }
 
@@ -533,7 +1186,7 @@ void gui_show_message(const char* message, uint32_t duration_ms)
     s_message_is_error = false;
 
     if (duration_ms > 0) {
-        s_message_until_ms = (uint32_t)(esp_timer_get_time() / 1000) + duration_ms;
+        s_message_until_ms = now_ms() + duration_ms;
     } else {
         s_message_until_ms = 0;
     }
@@ -560,6 +1213,7 @@ void gui_dismiss_message(void)
     s_message[0] = '\0';
     s_message_until_ms = 0;
     s_message_is_error = false;
+    post_event(GUI_EVENT_REDRAW);
 }
 
 gui_config_t gui_get_config(void)
@@ -570,15 +1224,19 @@ gui_config_t gui_get_config(void)
 void gui_set_config(const gui_config_t* config)
 {
     if (config != NULL) {
-        s_config = *config;
-        display_hal_set_brightness(s_config.brightness);
+        // Applied by settings_listener()
+        config_t* settings = config_edit();
+        settings->gui = *config;
+        config_commit(CONFIG_SECTION_GUI);
     }
 }
 
 void gui_set_theme(const gui_theme_t* theme)
 {
     if (theme != NULL) {
-        s_theme = *theme;
+        config_t* settings = config_edit();
+        settings->theme = *theme;
+        config_commit(CONFIG_SECTION_THEME);
     }
 }
 
@@ -589,12 +1247,15 @@ gui_theme_t gui_get_theme(void)
 
 void gui_wake(void)
 {
-    s_last_interaction_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    s_last_interaction_ms = now_ms();
 
     if (s_dimmed) {
         s_dimmed = false;
         display_hal_set_brightness(s_config.brightness);
     }
+
+    // Re-arms the dim deadline and renders any pending change
+    post_event(GUI_EVENT_REDRAW);
 }
 
 bool gui_is_dimmed(void)
@@ -604,5 +1265,6 @@ bool gui_is_dimmed(void)
 
 void gui_refresh(void)
 {
-    render_screen();
+    // Rendering happens on the GUI task
+    invalidate_screen();
 }
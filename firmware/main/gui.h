@@ -153,6 +153,8 @@ gui_config_t gui_get_config(void);
 /**
  * @brief Set GUI configuration
  *
+ * Saved in the settings store.
+ *
  * @param config New configuration
  */
 void gui_set_config(const gui_config_t* config);
@@ -160,6 +162,8 @@ void gui_set_config(const gui_config_t* config);
 /**
  * @brief Set GUI theme colors
  *
+ * Saved in the settings store.
+ *
  * @param theme Theme colors
  */
 void gui_set_theme(const gui_theme_t* theme);
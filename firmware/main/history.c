@@ -0,0 +1,309 @@
+/**
+ * @file history.c
+ * @brief In-RAM temperature/state history
+ */
+
+#include "history.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+static const char* TAG = "history";
+
+// An absolute time is kept for every HISTORY_ANCHOR_INTERVAL-th record,
+// so a seek walks at most that many deltas
+#define HISTORY_ANCHOR_INTERVAL 32
+
+// Anchors per ring: one more than the records span, so every anchor of a
+// held record survives until that record is evicted
+#define HISTORY_ANCHORS(capacity) \
+    (((capacity) + HISTORY_ANCHOR_INTERVAL - 1) / HISTORY_ANCHOR_INTERVAL + 1)
+
+/**
+ * @brief One ring of records
+ *
+ * Records are addressed by sequence number (total appended so far); the
+ * ring holds sequence numbers [seq - count, seq). anchors[(s / interval)
+ * % anchor_count] is the time of record s for s a multiple of the
+ * interval.
+ */
+typedef struct {
+    history_record_t* records;
+    uint32_t* anchors;
+    uint16_t capacity;
+    uint16_t anchor_count;
+    uint16_t head;              // Next write index
+    uint16_t count;
+    uint32_t seq;               // Sequence number of the next record
+    uint32_t oldest_time_s;     // Time of record seq - count
+    uint32_t newest_time_s;     // Time of record seq - 1
+} history_ring_t;
+
+static history_record_t s_records_1s[HISTORY_1S_CAPACITY];
+static history_record_t s_records_1min[HISTORY_1MIN_CAPACITY];
+static uint32_t s_anchors_1s[HISTORY_ANCHORS(HISTORY_1S_CAPACITY)];
+static uint32_t s_anchors_1min[HISTORY_ANCHORS(HISTORY_1MIN_CAPACITY)];
+
+static history_ring_t s_rings[HISTORY_RES_COUNT] = {
+    [HISTORY_RES_1S] = {
+        .records = s_records_1s, .anchors = s_anchors_1s,
+        .capacity = HISTORY_1S_CAPACITY,
+        .anchor_count = HISTORY_ANCHORS(HISTORY_1S_CAPACITY),
+    },
+    [HISTORY_RES_1MIN] = {
+        .records = s_records_1min, .anchors = s_anchors_1min,
+        .capacity = HISTORY_1MIN_CAPACITY,
+        .anchor_count = HISTORY_ANCHORS(HISTORY_1MIN_CAPACITY),
+    },
+};
+
+// Protects the rings; held only for O(1) appends, short copies and
+// reading the ring indices. A record is only rewritten once it has been
+// evicted, so records still held may be read without it.
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Samples accumulated for the current minute record
+static struct {
+    uint32_t minute;            // uptime_s / 60 of the samples
+    uint32_t last_time_s;
+    int32_t temp_sum;
+    uint8_t samples;
+    uint8_t valid_samples;
+    uint8_t relay_on_samples;
+    int16_t peak_q;
+    uint8_t flags;
+} s_minute;
+
+static const history_record_t* ring_at(const history_ring_t* ring, uint32_t seq)
+{
+    uint32_t back = ring->seq - seq;    // 1 = newest
+    uint32_t index = (ring->head + ring->capacity - back) % ring->capacity;
+    return &ring->records[index];
+}
+
+static uint32_t ring_oldest_seq(const history_ring_t* ring)
+{
+    return ring->seq - ring->count;
+}
+
+static uint32_t* ring_anchor(const history_ring_t* ring, uint32_t seq)
+{
+    return &ring->anchors[(seq / HISTORY_ANCHOR_INTERVAL) % ring->anchor_count];
+}
+
+static void ring_push(history_ring_t* ring, history_record_t record, uint32_t time_s)
+{
+    if (ring->count == 0) {
+        record.dt_s = 0;
+        ring->oldest_time_s = time_s;
+    } else {
+        uint32_t dt = time_s - ring->newest_time_s;
+        record.dt_s = (dt > UINT16_MAX) ? UINT16_MAX : (uint16_t)dt;
+    }
+
+    if (ring->count == ring->capacity) {
+        // Evict the oldest; its successor becomes the new oldest
+        uint16_t next = (ring->head + 1) % ring->capacity;
+        ring->oldest_time_s += ring->records[next].dt_s;
+    } else {
+        ring->count++;
+    }
+
+    ring->records[ring->head] = record;
+    if (ring->seq % HISTORY_ANCHOR_INTERVAL == 0) {
+        *ring_anchor(ring, ring->seq) = time_s;
+    }
+    ring->head = (ring->head + 1) % ring->capacity;
+    ring->seq++;
+    ring->newest_time_s = time_s;
+}
+
+static void flush_minute(void)
+{
+    history_record_t record = {
+        .temp_q = HISTORY_TEMP_INVALID,
+        .peak_q = HISTORY_TEMP_INVALID,
+        .flags = s_minute.flags,
+        .duty_pct = (uint8_t)((s_minute.relay_on_samples * 100u) / s_minute.samples),
+    };
+
+    if (s_minute.valid_samples > 0) {
+        record.temp_q = (int16_t)(s_minute.temp_sum / s_minute.valid_samples);
+        record.peak_q = s_minute.peak_q;
+    }
+
+    ring_push(&s_rings[HISTORY_RES_1MIN], record, s_minute.last_time_s);
+    memset(&s_minute, 0, sizeof(s_minute));
+}
+
+bool history_init(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < HISTORY_RES_COUNT; i++) {
+        history_ring_t* ring = &s_rings[i];
+        ring->head = 0;
+        ring->count = 0;
+        ring->seq = 0;
+        ring->oldest_time_s = 0;
+        ring->newest_time_s = 0;
+    }
+    memset(&s_minute, 0, sizeof(s_minute));
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "History: %u x 1s + %u x 1min records (%u bytes)",
+             HISTORY_1S_CAPACITY, HISTORY_1MIN_CAPACITY,
+             (unsigned)(sizeof(s_records_1s) + sizeof(s_records_1min)));
+    return true;
+}
+
+void history_append(uint32_t uptime_s, int16_t temp_q, bool valid,
+                    crockpot_state_t state, bool relay_main, bool relay_aux)
+{
+    uint8_t flags = (uint8_t)state & HISTORY_FLAG_STATE_MASK;
+    if (relay_main) flags |= HISTORY_FLAG_RELAY_MAIN;
+    if (relay_aux)  flags |= HISTORY_FLAG_RELAY_AUX;
+    if (!valid)     flags |= HISTORY_FLAG_SENSOR_FAULT;
+
+    history_record_t record = {
+        .temp_q = valid ? temp_q : HISTORY_TEMP_INVALID,
+        .peak_q = valid ? temp_q : HISTORY_TEMP_INVALID,
+        .flags = flags,
+        .duty_pct = relay_main ? 100 : 0,
+    };
+
+    portENTER_CRITICAL(&s_lock);
+
+    ring_push(&s_rings[HISTORY_RES_1S], record, uptime_s);
+
+    // Close the minute record when the sample falls in a new minute
+    uint32_t minute = uptime_s / 60;
+    if (s_minute.samples > 0 && minute != s_minute.minute) {
+        flush_minute();
+    }
+
+    s_minute.minute = minute;
+    s_minute.last_time_s = uptime_s;
+    s_minute.samples++;
+    if (valid) {
+        if (s_minute.valid_samples == 0 || temp_q > s_minute.peak_q) {
+            s_minute.peak_q = temp_q;
+        }
+        s_minute.temp_sum += temp_q;
+        s_minute.valid_samples++;
+    }
+    if (relay_main) {
+        s_minute.relay_on_samples++;
+    }
+    // Relay and fault bits accumulate; the state is the latest one
+    s_minute.flags = (s_minute.flags & ~HISTORY_FLAG_STATE_MASK) | flags;
+
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Find the first record ending at or after from_s (no lock held)
+ *
+ * Binary search over the anchors, then at most an anchor interval of
+ * deltas. Only records in [oldest, end) are read; the caller checks
+ * afterwards that *base_seq, the first one read, was not evicted meanwhile.
+ */
+static void ring_find(const history_ring_t* ring, uint32_t oldest, uint32_t oldest_time_s,
+                      uint32_t end, uint32_t from_s, uint32_t* base_seq,
+                      history_cursor_t* cursor)
+{
+    // Latest record known to end before from_s: the oldest, or a later anchor
+    uint32_t seq = oldest;
+    uint32_t time_s = oldest_time_s;
+
+    uint32_t lo = (oldest + HISTORY_ANCHOR_INTERVAL - 1) / HISTORY_ANCHOR_INTERVAL;
+    uint32_t hi = (end + HISTORY_ANCHOR_INTERVAL - 1) / HISTORY_ANCHOR_INTERVAL;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t anchor_time_s = *ring_anchor(ring, mid * HISTORY_ANCHOR_INTERVAL);
+        if (anchor_time_s < from_s) {
+            seq = mid * HISTORY_ANCHOR_INTERVAL;
+            time_s = anchor_time_s;
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *base_seq = seq;
+
+    // Step to the first record at or after from_s
+    uint32_t prev_time_s = time_s;
+    while (time_s < from_s && ++seq < end) {
+        prev_time_s = time_s;
+        time_s += ring_at(ring, seq)->dt_s;
+    }
+
+    cursor->seq = seq;
+    cursor->time_s = (seq < end) ? prev_time_s : time_s;
+}
+
+void history_seek(history_cursor_t* cursor, history_res_t res, uint32_t from_s)
+{
+    const history_ring_t* ring = &s_rings[res];
+    cursor->res = res;
+
+    while (1) {
+        portENTER_CRITICAL(&s_lock);
+        uint32_t oldest = ring_oldest_seq(ring);
+        uint32_t end = ring->seq;
+        uint32_t oldest_time_s = ring->oldest_time_s;
+        uint32_t newest_time_s = ring->newest_time_s;
+        uint32_t oldest_dt_s = (oldest != end) ? ring_at(ring, oldest)->dt_s : 0;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (oldest == end || from_s > newest_time_s) {
+            // Empty, or past the newest: wait for the next record
+            cursor->seq = end;
+            cursor->time_s = newest_time_s;
+            return;
+        }
+        if (from_s <= oldest_time_s) {
+            cursor->seq = oldest;
+            cursor->time_s = oldest_time_s - oldest_dt_s;
+            return;
+        }
+
+        uint32_t base_seq;
+        ring_find(ring, oldest, oldest_time_s, end, from_s, &base_seq, cursor);
+
+        // Valid unless the writer evicted what was read (then search again)
+        portENTER_CRITICAL(&s_lock);
+        bool valid = (int32_t)(base_seq - ring_oldest_seq(ring)) >= 0;
+        portEXIT_CRITICAL(&s_lock);
+        if (valid) {
+            return;
+        }
+    }
+}
+
+size_t history_read(history_cursor_t* cursor, history_entry_t* out, size_t max)
+{
+    const history_ring_t* ring = &s_rings[cursor->res];
+    size_t n = 0;
+
+    portENTER_CRITICAL(&s_lock);
+
+    // Fell behind the writer: resume at the oldest record
+    uint32_t oldest = ring_oldest_seq(ring);
+    if ((int32_t)(cursor->seq - oldest) < 0) {
+        cursor->seq = oldest;
+        cursor->time_s = ring->oldest_time_s - ring_at(ring, oldest)->dt_s;
+    }
+
+    while (n < max && cursor->seq < ring->seq) {
+        const history_record_t* record = ring_at(ring, cursor->seq);
+        cursor->time_s += record->dt_s;
+        out[n].time_s = cursor->time_s;
+        out[n].record = *record;
+        cursor->seq++;
+        n++;
+    }
+
+    portEXIT_CRITICAL(&s_lock);
+    return n;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file history.h
+ * @brief In-RAM temperature/state history
+ *
+ * Two fixed-size rings of packed 8-byte records: one per second for the
+ * last 10 minutes, and one per minute for the last 24 hours. The control
+ * task appends once per second; readers walk the rings with a cursor.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crockpot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief History resolution (one ring each)
+ */
+typedef enum {
+    HISTORY_RES_1S = 0,     // 1 second, last HISTORY_1S_CAPACITY seconds
+    HISTORY_RES_1MIN,       // 1 minute, last HISTORY_1MIN_CAPACITY minutes
+    HISTORY_RES_COUNT
+} history_res_t;
+
+/**
+ * @brief Packed history record (8 bytes)
+ *
+ * Time is stored as the delta from the previous record in the same ring;
+ * the ring keeps the absolute time of its oldest record.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t dt_s;          // Seconds since the previous record
+    int16_t temp_q;         // Mean temperature, 0.25 C units (MAX31855 LSB)
+    int16_t peak_q;         // Highest sample in the interval, 0.25 C units
+    uint8_t flags;          // HISTORY_FLAG_* and state
+    uint8_t duty_pct;       // Main relay on-time in the interval, 0-100
+} history_record_t;
+
+_Static_assert(sizeof(history_record_t) == 8, "history record must stay 8 bytes");
+
+// history_record_t.flags layout
+#define HISTORY_FLAG_STATE_MASK     0x03    // crockpot_state_t (last in interval)
+#define HISTORY_FLAG_RELAY_MAIN     0x04    // Main relay was on at some point
+#define HISTORY_FLAG_RELAY_AUX      0x08    // Aux relay was on at some point
+#define HISTORY_FLAG_SENSOR_FAULT   0x10    // At least one failed reading
+
+// temp_q/peak_q value when no valid reading was taken in the interval
+#define HISTORY_TEMP_INVALID        INT16_MIN
+
+/**
+ * @brief Decoded history entry, as returned to readers
+ */
+typedef struct {
+    uint32_t time_s;        // Uptime at the end of the interval
+    history_record_t record;
+} history_entry_t;
+
+/**
+ * @brief Read position in one ring
+ *
+ * Opaque to callers; fill it with history_seek().
+ */
+typedef struct {
+    history_res_t res;
+    uint32_t seq;           // Sequence number of the next record
+    uint32_t time_s;        // Time of the record before seq
+} history_cursor_t;
+
+/**
+ * @brief Initialize history storage
+ *
+ * @return true on success
+ */
+bool history_init(void);
+
+/**
+ * @brief Append one sample (O(1), called once per second)
+ *
+ * @param uptime_s  Uptime of the sample in seconds
+ * @param temp_q    Temperature in 0.25 C units (ignored if !valid)
+ * @param valid     Whether the reading succeeded
+ * @param state     Crockpot state at the time
+ * @param relay_main Main relay output
+ * @param relay_aux  Aux relay output
+ */
+void history_append(uint32_t uptime_s, int16_t temp_q, bool valid,
+                    crockpot_state_t state, bool relay_main, bool relay_aux);
+
+/**
+ * @brief Position a cursor at the first record ending at or after a time
+ *
+ * O(log n): a binary search over periodic absolute timestamps, then a few
+ * deltas. The lock is held only to copy the ring indices.
+ *
+ * @param cursor  Cursor to fill
+ * @param res     Ring to read
+ * @param from_s  Uptime to start at (0 = oldest)
+ */
+void history_seek(history_cursor_t* cursor, history_res_t res, uint32_t from_s);
+
+/**
+ * @brief Read the next records and advance the cursor
+ *
+ * If the writer has overwritten the cursor's position, reading resumes at
+ * the oldest record still held.
+ *
+ * @param cursor  Cursor from history_seek()
+ * @param out     Destination entries
+ * @param max     Capacity of out
+ * @return Number of entries written (0 = caught up with the writer)
+ */
+size_t history_read(history_cursor_t* cursor, history_entry_t* out, size_t max);
+
+// Ring sizes: 10 minutes at 1 s + 24 hours at 1 min = 16320 bytes
+// (plus 264 bytes of seek timestamps)
+#define HISTORY_1S_CAPACITY     600
+#define HISTORY_1MIN_CAPACITY   1440
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HISTORY_H
@@ -0,0 +1,335 @@
+/**
+ * @file history_store.c
+ * @brief Flash persistence for the minute history
+ *
+ * Page seq p lives in sector (p / 16) % N, slot p % 16. Sectors are
+ * filled in order, so after a reset the newest sector is the end of the
+ * run of consecutive sector numbers starting at slot 0, which a binary
+ * search finds in log2(N) reads.
+ */
+
+#include "history_store.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_crc.h"
+
+static const char* TAG = "history_store";
+
+#define PAGE_MAGIC 0xC9A5
+
+// On-flash page layout
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t boot_id;
+    uint32_t page_seq;
+    uint32_t base_time_s;
+    uint8_t count;
+    uint8_t reserved;
+    uint16_t crc;           // CRC16 of the page with this field zeroed
+    history_record_t records[HISTORY_STORE_RECORDS_PER_PAGE];
+} flash_page_t;
+
+_Static_assert(sizeof(flash_page_t) == HISTORY_STORE_PAGE_SIZE, "page layout");
+
+static const esp_partition_t* s_partition = NULL;
+static uint32_t s_sector_count = 0;
+
+// Guards flash access and s_next_page_seq (writer task vs readers)
+static SemaphoreHandle_t s_mutex = NULL;
+static uint32_t s_next_page_seq = 0;
+static bool s_have_pages = false;
+static uint16_t s_boot_id = 0;
+
+// Writer task state
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_flush_done = NULL;
+static flash_page_t s_pending;          // Records not yet written
+static flash_page_t s_read_buf;         // Scratch for recovery
+
+static uint32_t page_offset(uint32_t page_seq)
+{
+    uint32_t sector = (page_seq / HISTORY_STORE_PAGES_PER_SECTOR) % s_sector_count;
+    uint32_t slot = page_seq % HISTORY_STORE_PAGES_PER_SECTOR;
+    return sector * HISTORY_STORE_SECTOR_SIZE + slot * HISTORY_STORE_PAGE_SIZE;
+}
+
+static uint16_t page_crc(const flash_page_t* page)
+{
+    flash_page_t copy = *page;
+    copy.crc = 0;
+    return esp_crc16_le(0, (const uint8_t*)&copy, sizeof(copy));
+}
+
+static bool page_valid(const flash_page_t* page)
+{
+    return page->magic == PAGE_MAGIC &&
+           page->count > 0 && page->count <= HISTORY_STORE_RECORDS_PER_PAGE &&
+           page->crc == page_crc(page);
+}
+
+static bool page_erased(const flash_page_t* page)
+{
+    const uint8_t* bytes = (const uint8_t*)page;
+    for (size_t i = 0; i < offsetof(flash_page_t, records); i++) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_raw(uint32_t sector, uint32_t slot, flash_page_t* page)
+{
+    uint32_t offset = sector * HISTORY_STORE_SECTOR_SIZE + slot * HISTORY_STORE_PAGE_SIZE;
+    return esp_partition_read(s_partition, offset, page, sizeof(*page)) == ESP_OK;
+}
+
+/**
+ * @brief Sector number held in a physical sector (from its first page)
+ */
+static bool sector_seq(uint32_t sector, uint32_t* seq)
+{
+    if (!read_raw(sector, 0, &s_read_buf) || !page_valid(&s_read_buf)) {
+        return false;
+    }
+    *seq = s_read_buf.page_seq / HISTORY_STORE_PAGES_PER_SECTOR;
+    return true;
+}
+
+/**
+ * @brief Find the write position left by the previous boot
+ */
+static void recover_head(void)
+{
+    // Slot 0 is blank only on a fresh partition, or if power failed
+    // right after erasing it on wrap-around; then the run starts at 1.
+    uint32_t base = 0;
+    uint32_t base_seq;
+    if (!sector_seq(0, &base_seq)) {
+        base = 1;
+        if (s_sector_count < 2 || !sector_seq(1, &base_seq)) {
+            ESP_LOGI(TAG, "No stored history");
+            return;
+        }
+    }
+
+    // Largest slot whose sector continues the run from base
+    uint32_t lo = base;
+    uint32_t hi = s_sector_count - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        uint32_t seq;
+        if (sector_seq(mid, &seq) && seq == base_seq + (mid - base)) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    uint32_t head_sector = lo;
+    uint32_t head_seq = base_seq + (lo - base);
+
+    // Last programmed page in the head sector (valid or torn)
+    uint32_t used = 0;
+    for (uint32_t slot = 0; slot < HISTORY_STORE_PAGES_PER_SECTOR; slot++) {
+        if (!read_raw(head_sector, slot, &s_read_buf) || page_erased(&s_read_buf)) {
+            break;
+        }
+        if (page_valid(&s_read_buf)) {
+            s_boot_id = s_read_buf.boot_id + 1;
+        }
+        used = slot + 1;
+    }
+
+    s_next_page_seq = head_seq * HISTORY_STORE_PAGES_PER_SECTOR + used;
+    s_have_pages = true;
+
+    ESP_LOGI(TAG, "Recovered head: sector %lu (seq %lu), %lu pages used, boot %u",
+             (unsigned long)head_sector, (unsigned long)head_seq,
+             (unsigned long)used, s_boot_id);
+}
+
+static bool write_pending(void)
+{
+    bool ok = true;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    uint32_t offset = page_offset(s_next_page_seq);
+
+    // Entering a sector: erase it (this drops the oldest sector on wrap)
+    if (s_next_page_seq % HISTORY_STORE_PAGES_PER_SECTOR == 0) {
+        esp_err_t err = esp_partition_erase_range(s_partition, offset, HISTORY_STORE_SECTOR_SIZE);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Sector erase failed: %s", esp_err_to_name(err));
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        s_pending.magic = PAGE_MAGIC;
+        s_pending.boot_id = s_boot_id;
+        s_pending.page_seq = s_next_page_seq;
+        s_pending.reserved = 0xFF;
+        s_pending.crc = page_crc(&s_pending);
+
+        esp_err_t err = esp_partition_write(s_partition, offset, &s_pending, sizeof(s_pending));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Page write failed: %s", esp_err_to_name(err));
+            ok = false;
+        }
+    }
+
+    // Skip the page even on failure; it fails its CRC when read back
+    s_next_page_seq++;
+    s_have_pages = true;
+
+    xSemaphoreGive(s_mutex);
+
+    memset(&s_pending, 0xFF, sizeof(s_pending));
+    s_pending.count = 0;
+    return ok;
+}
+
+static void history_store_task(void* pvParameters)
+{
+    history_cursor_t cursor;
+    history_entry_t entries[8];
+
+    history_seek(&cursor, HISTORY_RES_1MIN, 0);
+
+    while (1) {
+        bool flush = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HISTORY_STORE_POLL_MS)) > 0;
+
+        size_t n;
+        while ((n = history_read(&cursor, entries, sizeof(entries) / sizeof(entries[0]))) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                if (s_pending.count == 0) {
+                    s_pending.base_time_s = entries[i].time_s;
+                }
+                s_pending.records[s_pending.count++] = entries[i].record;
+
+                if (s_pending.count == HISTORY_STORE_RECORDS_PER_PAGE) {
+                    write_pending();
+                }
+            }
+        }
+
+        if (flush) {
+            if (s_pending.count > 0) {
+                write_pending();
+            }
+            xSemaphoreGive(s_flush_done);
+        }
+    }
+}
+
+bool history_store_init(void)
+{
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                           ESP_PARTITION_SUBTYPE_ANY, "history");
+    if (s_partition == NULL) {
+        ESP_LOGE(TAG, "No 'history' partition");
+        return false;
+    }
+
+    s_sector_count = s_partition->size / HISTORY_STORE_SECTOR_SIZE;
+    if (s_sector_count < 2) {
+        ESP_LOGE(TAG, "History partition too small");
+        return false;
+    }
+
+    s_mutex = xSemaphoreCreateMutex();
+    s_flush_done = xSemaphoreCreateBinary();
+    if (s_mutex == NULL || s_flush_done == NULL) {
+        ESP_LOGE(TAG, "Failed to create semaphores");
+        return false;
+    }
+
+    recover_head();
+
+    memset(&s_pending, 0xFF, sizeof(s_pending));
+    s_pending.count = 0;
+
+    if (xTaskCreate(history_store_task, "history_store", HISTORY_STORE_STACK_SIZE,
+                    NULL, HISTORY_STORE_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        return false;
+    }
+
+    ESP_LOGI(TAG, "History store: %lu sectors (%lu minutes)",
+             (unsigned long)s_sector_count,
+             (unsigned long)(s_sector_count * HISTORY_STORE_PAGES_PER_SECTOR *
+                             HISTORY_STORE_RECORDS_PER_PAGE));
+    return true;
+}
+
+bool history_store_range(uint32_t* first, uint32_t* end)
+{
+    if (s_mutex == NULL) {
+        return false;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool have = s_have_pages;
+    uint32_t next = s_next_page_seq;
+    xSemaphoreGive(s_mutex);
+
+    if (!have) {
+        return false;
+    }
+
+    // The ring holds the head sector plus the N-1 before it
+    uint32_t head_sector = (next - 1) / HISTORY_STORE_PAGES_PER_SECTOR;
+    uint32_t first_sector = (head_sector >= s_sector_count - 1)
+                          ? head_sector - (s_sector_count - 1) : 0;
+
+    *first = first_sector * HISTORY_STORE_PAGES_PER_SECTOR;
+    *end = next;
+    return true;
+}
+
+bool history_store_read_page(uint32_t page_seq, history_store_page_t* page)
+{
+    uint32_t first, end;
+    if (!history_store_range(&first, &end) || page_seq < first || page_seq >= end) {
+        return false;
+    }
+
+    flash_page_t raw;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_err_t err = esp_partition_read(s_partition, page_offset(page_seq), &raw, sizeof(raw));
+    xSemaphoreGive(s_mutex);
+
+    if (err != ESP_OK || !page_valid(&raw) || raw.page_seq != page_seq) {
+        return false;
+    }
+
+    page->page_seq = raw.page_seq;
+    page->boot_id = raw.boot_id;
+    page->count = raw.count;
+    page->base_time_s = raw.base_time_s;
+    memcpy(page->records, raw.records, raw.count * sizeof(history_record_t));
+    return true;
+}
+
+uint16_t history_store_boot_id(void)
+{
+    return s_boot_id;
+}
+
+void history_store_flush(void)
+{
+    if (s_task == NULL) {
+        return;
+    }
+
+    xTaskNotifyGive(s_task);
+    xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(5000));
+}
@@ -0,0 +1,91 @@
+/**
+ * @file history_store.h
+ * @brief Flash persistence for the minute history
+ *
+ * Appends the one-minute history records to the "history" data
+ * partition so they survive resets. The partition is a ring of 4 KB
+ * sectors, each 16 pages of 30 records; a sector is erased only when the
+ * ring wraps onto it, and every page carries its own CRC. Writing happens
+ * in a low-priority task, never in the control loop.
+ */
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "history.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HISTORY_STORE_PAGE_SIZE         256
+#define HISTORY_STORE_SECTOR_SIZE       4096
+#define HISTORY_STORE_PAGES_PER_SECTOR  (HISTORY_STORE_SECTOR_SIZE / HISTORY_STORE_PAGE_SIZE)
+#define HISTORY_STORE_RECORDS_PER_PAGE  30
+
+/**
+ * @brief One flash page as read back
+ *
+ * Times are uptime of the boot identified by boot_id (which increments
+ * on every boot), so records from different boots are not comparable by
+ * time alone.
+ */
+typedef struct {
+    uint32_t page_seq;      // Position in the log (monotonic)
+    uint16_t boot_id;
+    uint8_t count;          // Valid entries in records[]
+    uint32_t base_time_s;   // Time of records[0]; later ones add dt_s
+    history_record_t records[HISTORY_STORE_RECORDS_PER_PAGE];
+} history_store_page_t;
+
+/**
+ * @brief Mount the partition, recover the head and start the writer task
+ *
+ * @return true on success, false if the partition is missing
+ */
+bool history_store_init(void);
+
+/**
+ * @brief Range of pages currently held in flash
+ *
+ * @param first Oldest valid page_seq
+ * @param end   One past the newest page_seq
+ * @return false if nothing has been stored yet
+ */
+bool history_store_range(uint32_t* first, uint32_t* end);
+
+/**
+ * @brief Read and verify one page
+ *
+ * @param page_seq Page to read (from history_store_range())
+ * @param page     Destination
+ * @return false if the page is outside the range or fails its CRC
+ */
+bool history_store_read_page(uint32_t page_seq, history_store_page_t* page);
+
+/**
+ * @brief Current boot's id (as written into new pages)
+ */
+uint16_t history_store_boot_id(void);
+
+/**
+ * @brief Write any pending records now, even as a partial page
+ *
+ * For use before a planned restart; normal operation writes full pages.
+ * Blocks until the writer task has finished.
+ */
+void history_store_flush(void);
+
+// Writer task: wakes this often to collect new minute records
+#define HISTORY_STORE_POLL_MS       60000
+#define HISTORY_STORE_STACK_SIZE    3072
+#define HISTORY_STORE_PRIORITY      1
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,367 @@
+/**
+ * @file interface_mqtt.c
+ * @brief MQTT interface for remote control and telemetry
+ *
+ * The client library runs the connection in its own task and delivers
+ * commands to mqtt_event_handler(), which executes them immediately. A
+ * small publisher task sleeps until the crockpot core reports a status
+ * change or a heartbeat/history deadline passes.
+ */
+
+#include "interface_mqtt.h"
+#include "command.h"
+#include "config.h"
+#include "dlog.h"
+#include "fleet.h"
+#include "crockpot.h"
+#include "history.h"
+#include "power.h"
+#include "wifi.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "mqtt_client.h"
+
+static const char* TAG = "mqtt";
+
+// Broker URI (from the settings store)
+static char s_broker_uri[128] = MQTT_DEFAULT_BROKER_URI;
+
+static esp_mqtt_client_handle_t s_client = NULL;
+static TaskHandle_t s_task = NULL;
+static volatile bool s_connected = false;
+
+// Set on (re)connect so the publisher sends everything at once
+static volatile bool s_resync = false;
+
+// POWER_LOCK_MQTT held for a connection attempt (client task only)
+static bool s_connect_boosted = false;
+
+// Device id and topics ("crockpot/a1b2c3/cmd", ...)
+static char s_device_id[24];
+static char s_topic_cmd[48];
+static char s_topic_reply[48];
+static char s_topic_status[48];
+static char s_topic_history[48];
+static char s_topic_online[48];
+static char s_topic_log[48];
+
+// Command handling (client task only)
+static char s_command[MQTT_COMMAND_MAX_LEN];
+static char s_reply[512];
+
+// History batching (publisher task only)
+static history_cursor_t s_history_cursor;
+static history_entry_t s_entries[MQTT_HISTORY_BATCH];
+static uint8_t s_history_payload[sizeof(uint32_t) + MQTT_HISTORY_BATCH * sizeof(history_record_t)];
+
+static void connect_boost_end(void)
+{
+    if (s_connect_boosted) {
+        power_release(POWER_LOCK_MQTT);
+        s_connect_boosted = false;
+    }
+}
+
+static void handle_command(const esp_mqtt_event_handle_t event)
+{
+    // Commands are short; ignore anything fragmented or oversized
+    if (event->current_data_offset != 0 || event->data_len != event->total_data_len ||
+        event->data_len >= (int)sizeof(s_command)) {
+        ESP_LOGW(TAG, "Ignoring oversized command (%d bytes)", event->total_data_len);
+        return;
+    }
+
+    memcpy(s_command, event->data, event->data_len);
+    s_command[event->data_len] = '\0';
+
+    DLOG_TEXT(ESP_LOG_INFO, TAG, "Processing command: %s", s_command);
+    command_execute(s_command, MQTT_ADMIN_COMMANDS ? COMMAND_ACCESS_ADMIN : COMMAND_ACCESS_USER,
+                    s_reply, sizeof(s_reply));
+    esp_mqtt_client_publish(s_client, s_topic_reply, s_reply, 0, 1, 0);
+}
+
+static void mqtt_event_handler(void* handler_args, esp_event_base_t base,
+                               int32_t event_id, void* event_data)
+{
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            // TLS handshake ahead: run it at full clock
+            if (!s_connect_boosted) {
+                power_acquire(POWER_LOCK_MQTT);
+                s_connect_boosted = true;
+            }
+            break;
+
+        case MQTT_EVENT_CONNECTED:
+            connect_boost_end();
+            ESP_LOGI(TAG, "Connected to broker");
+            esp_mqtt_client_publish(s_client, s_topic_online, "1", 1, 1, 1);
+            esp_mqtt_client_subscribe(s_client, s_topic_cmd, 1);
+            s_connected = true;
+            s_resync = true;
+            xTaskNotifyGive(s_task);
+            break;
+
+        case MQTT_EVENT_DISCONNECTED:
+            connect_boost_end();
+            if (s_connected) {
+                ESP_LOGW(TAG, "Disconnected from broker");
+            }
+            s_connected = false;
+            break;
+
+        case MQTT_EVENT_ERROR:
+            connect_boost_end();
+            break;
+
+        case MQTT_EVENT_DATA:
+            // Only the command topic is subscribed
+            handle_command(event);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Forward deferred log lines (dlog drain task)
+ *
+ * Queued in the client outbox at QoS 0, so this never waits on the network.
+ */
+static void log_sink(esp_log_level_t level, const char* tag, const char* line, void* user_data)
+{
+    (void)user_data;
+    if (!s_connected) {
+        return;
+    }
+
+    char payload[DLOG_LINE_MAX_LEN + 32];
+    int len = snprintf(payload, sizeof(payload), "%c %s: %s", "NEWIDV"[level], tag, line);
+    if (len >= (int)sizeof(payload)) {
+        len = sizeof(payload) - 1;
+    }
+    esp_mqtt_client_enqueue(s_client, s_topic_log, payload, len, 0, 0, true);
+}
+
+static void status_listener(void* user_data)
+{
+    (void)user_data;
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+static void publish_status(uint32_t generation)
+{
+    crockpot_status_t status = crockpot_get_status();
+    char temp[12] = "null";
+    char setpoint[12];
+    char payload[192];
+
+    if (!status.sensor_error) {
+        temp_format_f(temp, sizeof(temp), status.temperature);
+    }
+    temp_format_f(setpoint, sizeof(setpoint), status.setpoint);
+
+    int len = snprintf(payload, sizeof(payload),
+        "{\"gen\":%lu,\"state\":\"%s\",\"temp_f\":%s,\"setpoint_f\":%s,"
+        "\"duty\":%u,\"sensor_error\":%s,\"uptime\":%lu}",
+        (unsigned long)generation, crockpot_state_to_string(status.state),
+        temp, setpoint, status.heater_duty_pct,
+        status.sensor_error ? "true" : "false",
+        (unsigned long)status.uptime_seconds);
+
+    esp_mqtt_client_publish(s_client, s_topic_status, payload, len, 1, 1);
+}
+
+/**
+ * @brief Publish every 1 s record since the last batch
+ *
+ * @return false if a publish failed (the cursor is left at that batch)
+ */
+static bool publish_history(void)
+{
+    size_t n;
+    history_cursor_t start = s_history_cursor;
+
+    while ((n = history_read(&s_history_cursor, s_entries, MQTT_HISTORY_BATCH)) > 0) {
+        uint32_t first_time_s = s_entries[0].time_s;
+        memcpy(s_history_payload, &first_time_s, sizeof(first_time_s));   // C3 is little-endian
+
+        uint8_t* out = s_history_payload + sizeof(first_time_s);
+        for (size_t i = 0; i < n; i++) {
+            history_record_t record = s_entries[i].record;
+            if (i == 0) {
+                record.dt_s = 0;
+            }
+            memcpy(out, &record, sizeof(record));
+            out += sizeof(record);
+        }
+
+        if (esp_mqtt_client_publish(s_client, s_topic_history, (const char*)s_history_payload,
+                                    (int)(out - s_history_payload), 1, 0) < 0) {
+            s_history_cursor = start;
+            return false;
+        }
+        start = s_history_cursor;
+    }
+    return true;
+}
+
+static uint32_t ms_until(int64_t deadline_ms, int64_t now_ms)
+{
+    return (deadline_ms > now_ms) ? (uint32_t)(deadline_ms - now_ms) : 0;
+}
+
+static void mqtt_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    uint32_t last_generation = 0;
+    int64_t last_status_ms = 0;
+    int64_t last_history_ms = 0;
+
+    // Start with whatever the 1 s ring still holds
+    history_seek(&s_history_cursor, HISTORY_RES_1S, 0);
+
+    wifi_wait_online();
+    fleet_wait_coordinator();
+    esp_mqtt_client_start(s_client);
+
+    while (1) {
+        // Connected: sleep until a status change or the next deadline.
+        // Disconnected: the CONNECTED event wakes us.
+        TickType_t wait = portMAX_DELAY;
+        if (s_connected) {
+            int64_t now_ms = esp_timer_get_time() / 1000;
+            uint32_t status_ms = ms_until(last_status_ms + MQTT_HEARTBEAT_MS, now_ms);
+            uint32_t history_ms = ms_until(last_history_ms + MQTT_HISTORY_INTERVAL_MS, now_ms);
+            wait = pdMS_TO_TICKS(status_ms < history_ms ? status_ms : history_ms);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        // In a fleet only the coordinator keeps the broker connection
+        if (!fleet_is_coordinator()) {
+            ESP_LOGI(TAG, "No longer the fleet coordinator, disconnecting");
+            esp_mqtt_client_stop(s_client);
+            s_connected = false;
+            fleet_wait_coordinator();
+            esp_mqtt_client_start(s_client);
+            continue;
+        }
+
+        if (!s_connected) {
+            continue;
+        }
+
+        int64_t now_ms = esp_timer_get_time() / 1000;
+        bool resync = s_resync;
+        s_resync = false;
+
+        uint32_t generation = crockpot_get_generation();
+        if (resync || generation != last_generation ||
+            now_ms - last_status_ms >= MQTT_HEARTBEAT_MS) {
+            publish_status(generation);
+            last_generation = generation;
+            last_status_ms = now_ms;
+        }
+
+        if (resync || now_ms - last_history_ms >= MQTT_HISTORY_INTERVAL_MS) {
+            publish_history();
+            last_history_ms = now_ms;
+        }
+    }
+}
+
+bool mqtt_init(void)
+{
+    ESP_LOGI(TAG, "Initializing MQTT interface");
+
+    const config_t* settings = config_acquire();
+    if (settings->saved & CONFIG_SECTION_MQTT) {
+        strncpy(s_broker_uri, settings->mqtt_broker_uri, sizeof(s_broker_uri) - 1);
+    }
+    config_release();
+
+    if (strlen(s_broker_uri) == 0) {
+        ESP_LOGW(TAG, "MQTT broker not configured");
+        return false;
+    }
+
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(s_device_id, sizeof(s_device_id), "crockpot-%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    const char* id = s_device_id + strlen("crockpot-");
+    snprintf(s_topic_cmd, sizeof(s_topic_cmd), MQTT_TOPIC_PREFIX "/%s/cmd", id);
+    snprintf(s_topic_reply, sizeof(s_topic_reply), MQTT_TOPIC_PREFIX "/%s/reply", id);
+    snprintf(s_topic_status, sizeof(s_topic_status), MQTT_TOPIC_PREFIX "/%s/status", id);
+    snprintf(s_topic_history, sizeof(s_topic_history), MQTT_TOPIC_PREFIX "/%s/history", id);
+    snprintf(s_topic_online, sizeof(s_topic_online), MQTT_TOPIC_PREFIX "/%s/online", id);
+    snprintf(s_topic_log, sizeof(s_topic_log), MQTT_TOPIC_PREFIX "/%s/log", id);
+
+    esp_mqtt_client_config_t config = {
+        .broker.address.uri = s_broker_uri,
+        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
+        .credentials.client_id = s_device_id,
+        .session.keepalive = MQTT_KEEPALIVE_S,
+        .session.last_will = {
+            .topic = s_topic_online,
+            .msg = "0",
+            .msg_len = 1,
+            .qos = 1,
+            .retain = 1,
+        },
+    };
+
+    s_client = esp_mqtt_client_init(&config);
+    if (s_client == NULL) {
+        ESP_LOGE(TAG, "Failed to create MQTT client");
+        return false;
+    }
+    esp_mqtt_client_register_event(s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+
+    if (xTaskCreate(mqtt_task, "mqtt_pub", MQTT_TASK_STACK_SIZE, NULL,
+                    MQTT_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create publisher task");
+        return false;
+    }
+
+    crockpot_add_listener(status_listener, NULL);
+    dlog_set_sink(MQTT_LOG_LEVEL, log_sink, NULL);
+
+    ESP_LOGI(TAG, "MQTT interface initialized (topics " MQTT_TOPIC_PREFIX "/%s/...)", id);
+    return true;
+}
+
+bool mqtt_is_connected(void)
+{
+    return s_connected;
+}
+
+bool mqtt_set_broker(const char* uri)
+{
+    if (uri == NULL || strlen(uri) >= sizeof(s_broker_uri)) {
+        return false;
+    }
+
+    strncpy(s_broker_uri, uri, sizeof(s_broker_uri) - 1);
+    s_broker_uri[sizeof(s_broker_uri) - 1] = '\0';
+
+    config_t* settings = config_edit();
+    strncpy(settings->mqtt_broker_uri, uri, sizeof(settings->mqtt_broker_uri) - 1);
+    config_commit(CONFIG_SECTION_MQTT);
+
+    ESP_LOGI(TAG, "Broker set to %s", s_broker_uri);
+    return true;
+}
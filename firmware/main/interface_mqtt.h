@@ -0,0 +1,92 @@
+/**
+ * @file interface_mqtt.h
+ * @brief MQTT interface for remote control and telemetry
+ *
+ * Keeps one persistent (TLS) connection to a broker. Topics, under
+ * MQTT_TOPIC_PREFIX "/<device id>/":
+ *
+ *   cmd      (subscribed) Command line for the shared command table,
+ *            e.g. "/high" or "setpoint 190"; the reply goes to "reply".
+ *   status   (retained) Compact JSON status, published when the status
+ *            generation changes and at least every MQTT_HEARTBEAT_MS.
+ *   history  Binary batch of 1 s history records since the last batch,
+ *            every MQTT_HISTORY_INTERVAL_MS: a little-endian uint32
+ *            uptime of the first record, then packed history_record_t
+ *            entries (dt_s of the first one is 0).
+ *   online   (retained) "1" while connected, "0" as the last will.
+ *   log      Deferred log lines (dlog.h) at MQTT_LOG_LEVEL or above,
+ *            "<level letter> <tag>: <message>", QoS 0.
+ *
+ * Commands are pushed by the broker, so they are handled as soon as they
+ * arrive rather than on a polling cycle.
+ */
+
+#ifndef INTERFACE_MQTT_H
+#define INTERFACE_MQTT_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the MQTT interface and start its task
+ *
+ * The connection is opened once WiFi is up and re-established by the
+ * client library after any drop.
+ *
+ * @return true on success, false if no broker is configured
+ */
+bool mqtt_init(void);
+
+/**
+ * @brief Check if connected to the broker
+ */
+bool mqtt_is_connected(void);
+
+/**
+ * @brief Set the broker URI (e.g. "mqtts://broker.example.com")
+ *
+ * Saved in the settings store; takes effect at the next mqtt_init().
+ *
+ * @param uri Broker URI
+ * @return true on success
+ */
+bool mqtt_set_broker(const char* uri);
+
+// Default broker (empty = MQTT disabled)
+#define MQTT_DEFAULT_BROKER_URI ""
+
+// Topic prefix; the device id (from the MAC) is appended
+#define MQTT_TOPIC_PREFIX       "crockpot"
+
+// Status is republished at least this often, changed or not
+#define MQTT_HEARTBEAT_MS       60000
+
+// History batches (60 one-second records = 484 byte payload)
+#define MQTT_HISTORY_INTERVAL_MS 60000
+#define MQTT_HISTORY_BATCH       60
+
+// Broker keepalive
+#define MQTT_KEEPALIVE_S        60
+
+// Deferred log lines at or above this level go to the log topic
+#define MQTT_LOG_LEVEL          ESP_LOG_WARN
+
+// Whether cmd may run admin commands (/update). Enable only if the broker
+// authenticates clients and limits who may publish to the cmd topic.
+#define MQTT_ADMIN_COMMANDS     0
+
+// Longest command accepted on the cmd topic
+#define MQTT_COMMAND_MAX_LEN    256
+
+// Publisher task
+#define MQTT_TASK_STACK_SIZE    4096
+#define MQTT_TASK_PRIORITY      3
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INTERFACE_MQTT_H
@@ -0,0 +1,333 @@
+/**
+ * @file json_stream.c
+ * @brief Incremental (SAX-style) JSON tokenizer
+ */
+
+#include "json_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Tokenizer states
+enum {
+    JS_BETWEEN,     // Between tokens
+    JS_STRING,      // Inside a string
+    JS_ESCAPE,      // After a backslash in a string
+    JS_UNICODE,     // Inside a \uXXXX escape
+    JS_NUMBER,      // Inside a number
+    JS_LITERAL,     // Inside true/false/null
+    JS_ERROR
+};
+
+static void token_reset(json_stream_t* js)
+{
+    js->len = 0;
+    js->token[0] = '\0';
+}
+
+static void token_append(json_stream_t* js, char c)
+{
+    // Over-long tokens are truncated; the rest is still consumed
+    if (js->len < JSON_STREAM_TOKEN_MAX - 1) {
+        js->token[js->len++] = c;
+        js->token[js->len] = '\0';
+    }
+}
+
+static void token_append_utf8(json_stream_t* js, uint32_t cp)
+{
+    if (cp < 0x80) {
+        token_append(js, (char)cp);
+    } else if (cp < 0x800) {
+        token_append(js, (char)(0xC0 | (cp >> 6)));
+        token_append(js, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        token_append(js, (char)(0xE0 | (cp >> 12)));
+        token_append(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        token_append(js, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        token_append(js, (char)(0xF0 | (cp >> 18)));
+        token_append(js, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        token_append(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        token_append(js, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+static void emit(json_stream_t* js, json_token_t token)
+{
+    js->cb(token, js->token, js->depth, js->ctx);
+    token_reset(js);
+}
+
+static bool in_object(const json_stream_t* js)
+{
+    return js->depth > 0 && (js->object_mask & (1u << (js->depth - 1)));
+}
+
+static bool push(json_stream_t* js, bool object)
+{
+    if (js->depth >= JSON_STREAM_MAX_DEPTH) {
+        return false;
+    }
+    if (object) {
+        js->object_mask |= (1u << js->depth);
+    } else {
+        js->object_mask &= ~(1u << js->depth);
+    }
+    js->depth++;
+    js->expect_key = object;
+    return true;
+}
+
+static bool pop(json_stream_t* js, bool object)
+{
+    if (js->depth == 0 || in_object(js) != object) {
+        return false;
+    }
+    js->depth--;
+    js->expect_key = false;
+    return true;
+}
+
+static char unescape(char c)
+{
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        default:  return c;     // '"', '\\', '/'
+    }
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void finish_unicode(json_stream_t* js)
+{
+    uint16_t u = js->hex_value;
+
+    if (u >= 0xD800 && u <= 0xDBFF) {
+        // High surrogate; the low half follows as another \u escape
+        js->high_surrogate = u;
+        return;
+    }
+
+    if (u >= 0xDC00 && u <= 0xDFFF) {
+        if (js->high_surrogate) {
+            uint32_t cp = 0x10000 + (((uint32_t)js->high_surrogate - 0xD800) << 10) + (u - 0xDC00);
+            token_append_utf8(js, cp);
+        } else {
+            token_append(js, '?');
+        }
+    } else {
+        token_append_utf8(js, u);
+    }
+    js->high_surrogate = 0;
+}
+
+/**
+ * @brief Handle a character between tokens
+ *
+ * @return false on syntax error
+ */
+static bool between(json_stream_t* js, char c)
+{
+    switch (c) {
+        case ' ': case '\t': case '\r': case '\n':
+            return true;
+
+        case '{':
+            emit(js, JSON_OBJECT_START);
+            return push(js, true);
+
+        case '[':
+            emit(js, JSON_ARRAY_START);
+            return push(js, false);
+
+        case '}':
+            if (!pop(js, true)) return false;
+            emit(js, JSON_OBJECT_END);
+            return true;
+
+        case ']':
+            if (!pop(js, false)) return false;
+            emit(js, JSON_ARRAY_END);
+            return true;
+
+        case ',':
+            js->expect_key = in_object(js);
+            return true;
+
+        case ':':
+            js->expect_key = false;
+            return true;
+
+        case '"':
+            js->is_key = in_object(js) && js->expect_key;
+            js->high_surrogate = 0;
+            js->state = JS_STRING;
+            return true;
+
+        case 't': case 'f': case 'n':
+            token_append(js, c);
+            js->state = JS_LITERAL;
+            return true;
+
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                token_append(js, c);
+                js->state = JS_NUMBER;
+                return true;
+            }
+            return false;
+    }
+}
+
+void json_stream_init(json_stream_t* js, json_token_cb_t cb, void* ctx)
+{
+    memset(js, 0, sizeof(*js));
+    js->cb = cb;
+    js->ctx = ctx;
+    js->state = JS_BETWEEN;
+}
+
+bool json_stream_feed(json_stream_t* js, const char* data, size_t len)
+{
+    for (size_t i = 0; i < len && js->state != JS_ERROR; i++) {
+        char c = data[i];
+
+        switch (js->state) {
+            case JS_STRING:
+                if (c == '\\') {
+                    js->state = JS_ESCAPE;
+                } else if (c == '"') {
+                    js->state = JS_BETWEEN;
+                    emit(js, js->is_key ? JSON_KEY : JSON_STRING);
+                } else {
+                    token_append(js, c);
+                }
+                break;
+
+            case JS_ESCAPE:
+                if (c == 'u') {
+                    js->hex_count = 0;
+                    js->hex_value = 0;
+                    js->state = JS_UNICODE;
+                } else {
+                    token_append(js, unescape(c));
+                    js->state = JS_STRING;
+                }
+                break;
+
+            case JS_UNICODE: {
+                int digit = hex_digit(c);
+                if (digit < 0) {
+                    js->state = JS_ERROR;
+                    break;
+                }
+                js->hex_value = (js->hex_value << 4) | digit;
+                if (++js->hex_count == 4) {
+                    finish_unicode(js);
+                    js->state = JS_STRING;
+                }
+                break;
+            }
+
+            case JS_NUMBER:
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' ||
+                    c == '+' || c == '-') {
+                    token_append(js, c);
+                    break;
+                }
+                js->state = JS_BETWEEN;
+                emit(js, JSON_NUMBER);
+                if (!between(js, c)) js->state = JS_ERROR;
+                break;
+
+            case JS_LITERAL:
+                if (c >= 'a' && c <= 'z') {
+                    token_append(js, c);
+                    break;
+                }
+                js->state = JS_BETWEEN;
+                if (strcmp(js->token, "true") == 0) {
+                    emit(js, JSON_TRUE);
+                } else if (strcmp(js->token, "false") == 0) {
+                    emit(js, JSON_FALSE);
+                } else if (strcmp(js->token, "null") == 0) {
+                    emit(js, JSON_NULL);
+                } else {
+                    js->state = JS_ERROR;
+                    break;
+                }
+                if (!between(js, c)) js->state = JS_ERROR;
+                break;
+
+            default:
+                if (!between(js, c)) js->state = JS_ERROR;
+                break;
+        }
+    }
+
+    js->error = (js->state == JS_ERROR);
+    return !js->error;
+}
+
+size_t json_escape_string(char* dst, size_t dst_len, const char* src)
+{
+    size_t n = 0;
+
+    if (dst_len == 0) {
+        return 0;
+    }
+
+    for (; *src; src++) {
+        unsigned char c = (unsigned char)*src;
+        char esc[7];
+        size_t esc_len;
+
+        switch (c) {
+            case '"':  esc_len = 2; memcpy(esc, "\\\"", 2); break;
+            case '\\': esc_len = 2; memcpy(esc, "\\\\", 2); break;
+            case '\n': esc_len = 2; memcpy(esc, "\\n", 2); break;
+            case '\r': esc_len = 2; memcpy(esc, "\\r", 2); break;
+            case '\t': esc_len = 2; memcpy(esc, "\\t", 2); break;
+            default:
+                if (c < 0x20) {
+                    esc_len = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+                } else {
+                    esc_len = 1;
+                    esc[0] = (char)c;
+                }
+                break;
+        }
+
+        if (n + esc_len >= dst_len) {
+            // Out of room: drop a trailing partial UTF-8 sequence
+            size_t lead = n;
+            while (lead > 0 && ((unsigned char)dst[lead - 1] & 0xC0) == 0x80) {
+                lead--;
+            }
+            if (lead > 0 && ((unsigned char)dst[lead - 1] & 0xC0) == 0xC0) {
+                unsigned char b = (unsigned char)dst[lead - 1];
+                size_t need = (b >= 0xF0) ? 4 : (b >= 0xE0) ? 3 : 2;
+                if (n - (lead - 1) < need) {
+                    n = lead - 1;
+                }
+            }
+            break;
+        }
+        memcpy(dst + n, esc, esc_len);
+        n += esc_len;
+    }
+
+    dst[n] = '\0';
+    return n;
+}
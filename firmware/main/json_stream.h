@@ -0,0 +1,110 @@
+/**
+ * @file json_stream.h
+ * @brief Incremental (SAX-style) JSON tokenizer
+ *
+ * Parses JSON fed in arbitrary chunks, e.g. straight from
+ * HTTP_EVENT_ON_DATA, and reports tokens through a callback. Nothing is
+ * allocated and the document size is unbounded; only the current token
+ * is buffered (up to JSON_STREAM_TOKEN_MAX - 1 bytes, longer strings are
+ * truncated). Strings are delivered unescaped, as UTF-8.
+ *
+ * The tokenizer is lenient about separators (it does not check comma
+ * and colon placement), which is enough for well-formed API responses.
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Token types
+ */
+typedef enum {
+    JSON_OBJECT_START,
+    JSON_OBJECT_END,
+    JSON_ARRAY_START,
+    JSON_ARRAY_END,
+    JSON_KEY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL
+} json_token_t;
+
+/**
+ * @brief Token callback
+ *
+ * @param token Token type
+ * @param value Null-terminated text for keys, strings and numbers
+ *              (empty for other tokens)
+ * @param depth Number of enclosing containers: keys and values of the
+ *              root object are at depth 1. Start/end tokens report the
+ *              depth of the container itself (the root object is 0).
+ * @param ctx   User context from json_stream_init()
+ */
+typedef void (*json_token_cb_t)(json_token_t token, const char* value,
+                                uint8_t depth, void* ctx);
+
+// Largest buffered token, including terminator
+#define JSON_STREAM_TOKEN_MAX 256
+
+// Maximum container nesting
+#define JSON_STREAM_MAX_DEPTH 32
+
+/**
+ * @brief Tokenizer state (treat as opaque)
+ */
+typedef struct {
+    json_token_cb_t cb;
+    void* ctx;
+    uint8_t state;
+    uint8_t depth;
+    uint32_t object_mask;       // Bit n set: container at depth n is an object
+    bool expect_key;
+    bool is_key;
+    bool error;
+    uint8_t hex_count;
+    uint16_t hex_value;
+    uint16_t high_surrogate;
+    uint16_t len;
+    char token[JSON_STREAM_TOKEN_MAX];
+} json_stream_t;
+
+/**
+ * @brief Reset a tokenizer for a new document
+ */
+void json_stream_init(json_stream_t* js, json_token_cb_t cb, void* ctx);
+
+/**
+ * @brief Feed the next chunk of the document
+ *
+ * @return false once a syntax error has been seen (further input is ignored)
+ */
+bool json_stream_feed(json_stream_t* js, const char* data, size_t len);
+
+/**
+ * @brief Escape a string for use inside a JSON string literal
+ *
+ * Output is always null-terminated. If it does not fit, it is cut at a
+ * character boundary (never inside an escape sequence).
+ *
+ * @param dst     Output buffer
+ * @param dst_len Output buffer size
+ * @param src     Null-terminated input
+ * @return Length written, excluding the terminator
+ */
+size_t json_escape_string(char* dst, size_t dst_len, const char* src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_STREAM_H
@@ -11,11 +11,22 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_task_wdt.h"
+#include "nvs_flash.h"
 
 #include "wifi.h"
+#include "config.h"
 #include "crockpot.h"
+#include "dlog.h"
+#include "fleet.h"
+#include "history_store.h"
+#include "metrics.h"
+#include "ota.h"
+#include "power.h"
+#include "schedule.h"
 #include "telegram.h"
+#include "interface_mqtt.h"
 #include "display.h"
+#include "web_server.h"
 
 static const char* TAG = "main";
 
@@ -29,60 +40,69 @@ static const char* TAG = "main";
 #define TELEGRAM_TASK_PRIORITY    3
 #define DISPLAY_TASK_PRIORITY     4
 
+/**
+ * @brief Initialize NVS (settings, schedule, WiFi cache and WiFi driver data)
+ */
+static bool storage_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition was truncated, erasing...");
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize NVS: %s", esp_err_to_name(ret));
+        return false;
+    }
+    return true;
+}
+
 void app_main(void)
 {
+    metrics_boot_stage(METRIC_BOOT_APP_MAIN);
+
     ESP_LOGI(TAG, "=================================");
     ESP_LOGI(TAG, "    IoT Crockpot Controller");
     ESP_LOGI(TAG, "=================================");
     ESP_LOGI(TAG, "Firmware version: 0.1.0");
     ESP_LOGI(TAG, "Starting initialization...");
 
-    // Initialize WiFi
-    ESP_LOGI(TAG, "Initializing WiFi...");
-    if (!wifi_init()) {
-        ESP_LOGE(TAG, "WiFi initialization failed!");
-        // Continue without WiFi - local control still works
-    } else {
-        // Start WiFi connection
-        if (!wifi_connect()) {
-            ESP_LOGE(TAG, "Failed to start WiFi connection");
-        }
+    // Power management before any driver creates its PM locks
+    if (!power_init()) {
+        ESP_LOGW(TAG, "Power management unavailable - running at fixed clock");
     }
 
-    // Initialize crockpot core
-    ESP_LOGI(TAG, "Initializing crockpot core...");
-    if (!crockpot_init()) {
-        ESP_LOGE(TAG, "Crockpot initialization failed!");
-        esp_restart();
+    // Deferred log drain, before anything on the control path logs
+    if (!dlog_init()) {
+        ESP_LOGW(TAG, "Log task unavailable - deferred log records not printed");
     }
 
-    // Initialize display (local interface)
-    ESP_LOGI(TAG, "Initializing display...");
-    if (!display_init()) {
-        ESP_LOGW(TAG, "Display initialization failed - continuing without local UI");
+    // Metrics first, so every subsystem can record from its init on
+    if (!metrics_init()) {
+        ESP_LOGW(TAG, "Metrics initialization failed - task metrics unavailable");
     }
 
-    // Initialize Telegram interface
-    ESP_LOGI(TAG, "Initializing Telegram interface...");
-    if (!telegram_init()) {
-        ESP_LOGW(TAG, "Telegram initialization failed - continuing without remote control");
+    if (!storage_init()) {
+        ESP_LOGW(TAG, "NVS unavailable - settings, programs and WiFi cache not persisted");
     }
 
-    // Wait for WiFi connection (with timeout)
-    ESP_LOGI(TAG, "Waiting for WiFi connection...");
-    if (wifi_wait_connected(WIFI_CONNECT_TIMEOUT_MS)) {
-        char ip_str[16];
-        if (wifi_get_ip_string(ip_str, sizeof(ip_str))) {
-            ESP_LOGI(TAG, "WiFi connected! IP: %s", ip_str);
-        }
-    } else {
-        ESP_LOGW(TAG, "WiFi connection timed out - continuing in offline mode");
+    // Settings are read once here; everything after reads the RAM copy
+    if (!config_init()) {
+        ESP_LOGE(TAG, "Settings store initialization failed!");
+        esp_restart();
     }
 
-    // Create FreeRTOS tasks
-    ESP_LOGI(TAG, "Creating tasks...");
+    // Local control first: the heater and safety checks must not wait
+    // for the network
+    ESP_LOGI(TAG, "Initializing crockpot core...");
+    if (!crockpot_init()) {
+        ESP_LOGE(TAG, "Crockpot initialization failed!");
+        esp_restart();
+    }
 
-    // Control task - main state machine loop
+    // Control task - main state machine loop. Higher priority than this
+    // task, so it runs its first cycle as soon as it is created.
     BaseType_t ret = xTaskCreate(
         crockpot_control_task,
         "control",
@@ -96,17 +116,20 @@ void app_main(void)
         esp_restart();
     }
 
-    // Telegram task - remote control via Telegram bot
-    ret = xTaskCreate(
-        telegram_task,
-        "telegram",
-        TELEGRAM_TASK_STACK_SIZE,
-        NULL,
-        TELEGRAM_TASK_PRIORITY,
-        NULL
-    );
-    if (ret != pdPASS) {
-        ESP_LOGW(TAG, "Failed to create Telegram task");
+    // Resume any cook program interrupted by a reboot
+    if (!schedule_init()) {
+        ESP_LOGW(TAG, "Schedule engine unavailable - manual control only");
+    }
+
+    // Persist minute history to flash
+    if (!history_store_init()) {
+        ESP_LOGW(TAG, "History store unavailable - history kept in RAM only");
+    }
+
+    // Initialize display (local interface)
+    ESP_LOGI(TAG, "Initializing display...");
+    if (!display_init()) {
+        ESP_LOGW(TAG, "Display initialization failed - continuing without local UI");
     }
 
     // Display task - local UI
@@ -122,21 +145,67 @@ void app_main(void)
         ESP_LOGW(TAG, "Failed to create display task");
     }
 
+    // Network bring-up runs alongside local control; nothing below
+    // blocks on the connection (interfaces wait in wifi_wait_online())
+    ESP_LOGI(TAG, "Initializing WiFi...");
+    if (!wifi_init()) {
+        ESP_LOGE(TAG, "WiFi initialization failed!");
+        // Continue without WiFi - local control still works
+    } else {
+        // Start WiFi connection
+        if (!wifi_connect()) {
+            ESP_LOGE(TAG, "Failed to start WiFi connection");
+        }
+    }
+
+    // A freshly updated image is kept once the control loop runs healthy;
+    // the network is not required
+    if (!ota_init()) {
+        ESP_LOGW(TAG, "Firmware health check unavailable");
+    }
+
+    // Fleet mode (optional): decides which unit holds the upstream links
+    if (!fleet_init()) {
+        ESP_LOGW(TAG, "Fleet mode failed to start - running standalone");
+    }
+
+    // Initialize Telegram interface
+    ESP_LOGI(TAG, "Initializing Telegram interface...");
+    if (!telegram_init()) {
+        ESP_LOGW(TAG, "Telegram initialization failed - continuing without remote control");
+    }
+
+    // Telegram task - remote control via Telegram bot
+    ret = xTaskCreate(
+        telegram_task,
+        "telegram",
+        TELEGRAM_TASK_STACK_SIZE,
+        NULL,
+        TELEGRAM_TASK_PRIORITY,
+        NULL
+    );
+    if (ret != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create Telegram task");
+    }
+
+    // Initialize MQTT interface (optional, needs a broker URI)
+    if (!mqtt_init()) {
+        ESP_LOGW(TAG, "MQTT not started - continuing without it");
+    }
+
+    // Initialize HTTP server (UI, history export, metrics)
+    ESP_LOGI(TAG, "Starting HTTP server...");
+    if (!web_server_init()) {
+        ESP_LOGW(TAG, "HTTP server failed to start - continuing without it");
+    }
+
+    metrics_boot_stage(METRIC_BOOT_INIT_DONE);
+
     ESP_LOGI(TAG, "=================================");
     ESP_LOGI(TAG, "    Initialization complete!");
     ESP_LOGI(TAG, "=================================");
 
-    // Main task can be deleted - all work is done in other tasks
-    // Or we can use it for watchdog feeding and health monitoring
-    while (1) {
-        // Log periodic status
-        crockpot_status_t status = crockpot_get_status();
-        ESP_LOGI(TAG, "Status: %s | Temp: %.1f F | Uptime: %lu s | WiFi: %s",
-                 crockpot_state_to_string(status.state),
-                 status.temperature_f,
-                 (unsigned long)status.uptime_seconds,
-                 status.wifi_connected ? "OK" : "DISCONNECTED");
-
-        vTaskDelay(pdMS_TO_TICKS(30000));  // Log every 30 seconds
-    }
+    // All work is done in other tasks; returning deletes the main task.
+    // Status is available on demand (/status, GET /metrics) rather than
+    // from a periodic log that would wake the chip.
 }
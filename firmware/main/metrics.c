@@ -0,0 +1,423 @@
+/**
+ * @file metrics.c
+ * @brief Runtime instrumentation (tasks, heap, subsystem latencies)
+ */
+
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+static const char* TAG = "metrics";
+
+// Kernels before 10.5 have no configurable run time counter width
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
+// Longest single line of Prometheus output
+#define LINE_MAX_LEN 128
+
+typedef struct {
+    const char* name;           // Prometheus name (crockpot_ prefix added)
+    const char* label;          // Summary label
+    const char* unit;
+    const char* help;
+    uint32_t base;              // Upper bound of bucket 0
+} hist_def_t;
+
+static const hist_def_t s_hist_defs[METRIC_HIST_COUNT] = {
+    [METRIC_SPI_READ_US] = {
+        "spi_read_us", "SPI read", "us",
+        "MAX31855 read latency including shared bus wait", 4 },
+    [METRIC_TELEGRAM_POLL_MS] = {
+        "telegram_poll_ms", "Telegram poll", "ms",
+        "Telegram getUpdates round trip", 50 },
+    [METRIC_GUI_FRAME_US] = {
+        "gui_frame_us", "GUI frame", "us",
+        "Time to render and flush a GUI frame", 250 },
+    [METRIC_CONTROL_JITTER_US] = {
+        "control_jitter_us", "Control jitter", "us",
+        "Control cycle start-to-start deviation from the period", 10 },
+};
+
+typedef struct {
+    const char* name;
+    const char* help;
+} counter_def_t;
+
+static const counter_def_t s_counter_defs[METRIC_COUNTER_COUNT] = {
+    [METRIC_SPI_READ_ERRORS] = {
+        "spi_read_errors_total", "MAX31855 SPI transactions that failed" },
+    [METRIC_TELEGRAM_POLL_FAILURES] = {
+        "telegram_poll_failures_total", "Telegram polls that failed or returned non-200" },
+    [METRIC_DISPLAY_BYTES] = {
+        "display_bytes_total", "Pixel bytes queued to the display panel" },
+    [METRIC_CONTROL_OVERRUNS] = {
+        "control_overruns_total", "Control cycles that started past their deadline" },
+    [METRIC_CONTROL_MUTEX_TIMEOUTS] = {
+        "control_mutex_timeouts_total", "Control cycles that could not take the state mutex" },
+    [METRIC_CONTROL_ESCALATIONS] = {
+        "control_escalations_total", "Times the control monitor forced the relays off" },
+};
+
+static const char* const s_boot_stage_names[METRIC_BOOT_STAGE_COUNT] = {
+    [METRIC_BOOT_APP_MAIN]        = "app_main",
+    [METRIC_BOOT_CONTROL]         = "control",
+    [METRIC_BOOT_INIT_DONE]       = "init_done",
+    [METRIC_BOOT_WIFI_ASSOCIATED] = "wifi_associated",
+    [METRIC_BOOT_ONLINE]          = "online",
+};
+
+typedef struct {
+    uint32_t buckets[METRICS_HIST_BUCKETS + 1];     // Last is +Inf
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+} hist_t;
+
+static hist_t s_hists[METRIC_HIST_COUNT];
+static uint32_t s_counters[METRIC_COUNTER_COUNT];
+static uint32_t s_boot_stage_us[METRIC_BOOT_STAGE_COUNT];     // 0 = not reached
+
+// Protects s_hists/s_counters/s_boot_stage_us; held only for O(1) updates and copies
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct {
+    const char* name;
+    uint32_t caps;
+} heap_def_t;
+
+static const heap_def_t s_heap_defs[] = {
+    { "internal", MALLOC_CAP_INTERNAL },
+    { "dma",      MALLOC_CAP_DMA },
+};
+
+#define HEAP_DEF_COUNT (sizeof(s_heap_defs) / sizeof(s_heap_defs[0]))
+
+#if configUSE_TRACE_FACILITY
+// Task snapshot; reports can come from the HTTP and Telegram tasks at once
+static SemaphoreHandle_t s_report_mutex = NULL;
+static TaskStatus_t s_tasks[METRICS_MAX_TASKS];
+#endif
+
+typedef struct {
+    metrics_write_fn_t write;
+    void* ctx;
+} writer_t;
+
+static void emitf(const writer_t* w, const char* fmt, ...)
+{
+    char line[LINE_MAX_LEN];
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (n > 0) {
+        w->write(line, ((size_t)n < sizeof(line)) ? (size_t)n : sizeof(line) - 1, w->ctx);
+    }
+}
+
+static void emit_header(const writer_t* w, const char* name, const char* type, const char* help)
+{
+    emitf(w, "# HELP crockpot_%s %s\n", name, help);
+    emitf(w, "# TYPE crockpot_%s %s\n", name, type);
+}
+
+static uint8_t bucket_index(uint32_t base, uint32_t value)
+{
+    uint8_t i = 0;
+    uint32_t bound = base;
+    while (i < METRICS_HIST_BUCKETS && value > bound) {
+        bound <<= 1;
+        i++;
+    }
+    return i;
+}
+
+static void hist_snapshot(metric_hist_t hist, hist_t* out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_hists[hist];
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#if configUSE_TRACE_FACILITY
+/**
+ * @brief Sample all tasks into s_tasks (caller holds s_report_mutex)
+ *
+ * @param total_runtime Total run time counter (0 without run time stats),
+ *                      or NULL
+ * @return Number of tasks sampled
+ */
+static UBaseType_t sample_tasks(uint64_t* total_runtime)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_tasks, METRICS_MAX_TASKS, &total);
+    if (n == 0 && uxTaskGetNumberOfTasks() > METRICS_MAX_TASKS) {
+        ESP_LOGW(TAG, "More than %d tasks - task metrics skipped", METRICS_MAX_TASKS);
+    }
+    if (total_runtime != NULL) {
+        *total_runtime = total;
+    }
+    return n;
+}
+#endif
+
+bool metrics_init(void)
+{
+#if configUSE_TRACE_FACILITY
+    s_report_mutex = xSemaphoreCreateMutex();
+    if (s_report_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return false;
+    }
+#else
+    ESP_LOGW(TAG, "configUSE_TRACE_FACILITY is off - no per-task metrics");
+#endif
+    return true;
+}
+
+void metrics_observe(metric_hist_t hist, uint32_t value)
+{
+    uint8_t i = bucket_index(s_hist_defs[hist].base, value);
+    hist_t* h = &s_hists[hist];
+
+    portENTER_CRITICAL(&s_lock);
+    h->buckets[i]++;
+    h->count++;
+    h->sum += value;
+    if (value > h->max) {
+        h->max = value;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void metrics_count(metric_counter_t counter, uint32_t delta)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_counters[counter] += delta;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void metrics_boot_stage(metric_boot_stage_t stage)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_boot_stage_us[stage] == 0) {
+        s_boot_stage_us[stage] = (now_us > 0) ? now_us : 1;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void boot_stages_snapshot(uint32_t* out)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(out, s_boot_stage_us, sizeof(s_boot_stage_us));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void write_tasks(const writer_t* w)
+{
+#if configUSE_TRACE_FACILITY
+    if (s_report_mutex == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(s_report_mutex, portMAX_DELAY);
+
+    uint64_t total;
+    UBaseType_t n = sample_tasks(&total);
+
+    emit_header(w, "task_stack_free_bytes", "gauge", "Lowest free stack seen per task");
+    for (UBaseType_t i = 0; i < n; i++) {
+        // StackType_t is one byte on ESP-IDF, so the mark is in bytes
+        emitf(w, "crockpot_task_stack_free_bytes{task=\"%s\"} %lu\n",
+              s_tasks[i].pcTaskName, (unsigned long)s_tasks[i].usStackHighWaterMark);
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    emit_header(w, "task_runtime_us_total", "counter", "CPU time used per task");
+    for (UBaseType_t i = 0; i < n; i++) {
+        emitf(w, "crockpot_task_runtime_us_total{task=\"%s\"} %llu\n",
+              s_tasks[i].pcTaskName, (unsigned long long)s_tasks[i].ulRunTimeCounter);
+    }
+    emit_header(w, "runtime_us_total", "counter", "Run time counter across all tasks");
+    emitf(w, "crockpot_runtime_us_total %llu\n", (unsigned long long)total);
+#endif
+
+    xSemaphoreGive(s_report_mutex);
+#else
+    (void)w;
+#endif
+}
+
+static void write_heap(const writer_t* w)
+{
+    emit_header(w, "heap_free_bytes", "gauge", "Free heap");
+    for (size_t i = 0; i < HEAP_DEF_COUNT; i++) {
+        emitf(w, "crockpot_heap_free_bytes{caps=\"%s\"} %lu\n", s_heap_defs[i].name,
+              (unsigned long)heap_caps_get_free_size(s_heap_defs[i].caps));
+    }
+    emit_header(w, "heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    for (size_t i = 0; i < HEAP_DEF_COUNT; i++) {
+        emitf(w, "crockpot_heap_min_free_bytes{caps=\"%s\"} %lu\n", s_heap_defs[i].name,
+              (unsigned long)heap_caps_get_minimum_free_size(s_heap_defs[i].caps));
+    }
+    emit_header(w, "heap_largest_free_block_bytes", "gauge",
+                "Largest allocatable block (fragmentation)");
+    for (size_t i = 0; i < HEAP_DEF_COUNT; i++) {
+        emitf(w, "crockpot_heap_largest_free_block_bytes{caps=\"%s\"} %lu\n", s_heap_defs[i].name,
+              (unsigned long)heap_caps_get_largest_free_block(s_heap_defs[i].caps));
+    }
+}
+
+static void write_hists(const writer_t* w)
+{
+    for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+        const hist_def_t* def = &s_hist_defs[h];
+        hist_t snap;
+        hist_snapshot((metric_hist_t)h, &snap);
+
+        emit_header(w, def->name, "histogram", def->help);
+
+        // Prometheus buckets are cumulative
+        uint32_t cumulative = 0;
+        for (int i = 0; i < METRICS_HIST_BUCKETS; i++) {
+            cumulative += snap.buckets[i];
+            emitf(w, "crockpot_%s_bucket{le=\"%lu\"} %lu\n", def->name,
+                  (unsigned long)(def->base << i), (unsigned long)cumulative);
+        }
+        emitf(w, "crockpot_%s_bucket{le=\"+Inf\"} %lu\n", def->name, (unsigned long)snap.count);
+        emitf(w, "crockpot_%s_sum %llu\n", def->name, (unsigned long long)snap.sum);
+        emitf(w, "crockpot_%s_count %lu\n", def->name, (unsigned long)snap.count);
+
+        emitf(w, "# TYPE crockpot_%s_max gauge\n", def->name);
+        emitf(w, "crockpot_%s_max %lu\n", def->name, (unsigned long)snap.max);
+    }
+}
+
+static void write_counters(const writer_t* w)
+{
+    uint32_t counters[METRIC_COUNTER_COUNT];
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(counters, s_counters, sizeof(counters));
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        emit_header(w, s_counter_defs[c].name, "counter", s_counter_defs[c].help);
+        emitf(w, "crockpot_%s %lu\n", s_counter_defs[c].name, (unsigned long)counters[c]);
+    }
+}
+
+void metrics_write_prometheus(metrics_write_fn_t write, void* ctx)
+{
+    const writer_t w = { write, ctx };
+
+    emit_header(&w, "uptime_seconds", "gauge", "Time since boot");
+    emitf(&w, "crockpot_uptime_seconds %llu\n",
+          (unsigned long long)(esp_timer_get_time() / 1000000));
+
+    uint32_t stages[METRIC_BOOT_STAGE_COUNT];
+    boot_stages_snapshot(stages);
+    emit_header(&w, "boot_stage_seconds", "gauge", "Time from startup to each boot milestone");
+    for (int i = 0; i < METRIC_BOOT_STAGE_COUNT; i++) {
+        if (stages[i] != 0) {
+            emitf(&w, "crockpot_boot_stage_seconds{stage=\"%s\"} %lu.%06lu\n",
+                  s_boot_stage_names[i], (unsigned long)(stages[i] / 1000000),
+                  (unsigned long)(stages[i] % 1000000));
+        }
+    }
+
+    write_heap(&w);
+    write_tasks(&w);
+    write_hists(&w);
+    write_counters(&w);
+}
+
+void metrics_format_summary(char* out, size_t out_len)
+{
+    size_t n = (size_t)snprintf(out, out_len, "Heap: %lu free, %lu min, %lu largest",
+        (unsigned long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+
+#if configUSE_TRACE_FACILITY
+    if (s_report_mutex != NULL && n < out_len) {
+        xSemaphoreTake(s_report_mutex, portMAX_DELAY);
+
+        UBaseType_t count = sample_tasks(NULL);
+
+        // Insertion sort by stack headroom, tightest first
+        for (UBaseType_t i = 1; i < count; i++) {
+            TaskStatus_t task = s_tasks[i];
+            UBaseType_t j = i;
+            while (j > 0 && s_tasks[j - 1].usStackHighWaterMark > task.usStackHighWaterMark) {
+                s_tasks[j] = s_tasks[j - 1];
+                j--;
+            }
+            s_tasks[j] = task;
+        }
+
+        n += (size_t)snprintf(out + n, out_len - n, "\nStack free:");
+        for (UBaseType_t i = 0; i < count && i < METRICS_SUMMARY_TASKS && n < out_len; i++) {
+            n += (size_t)snprintf(out + n, out_len - n, "%s %s %lu",
+                                  i > 0 ? "," : "", s_tasks[i].pcTaskName,
+                                  (unsigned long)s_tasks[i].usStackHighWaterMark);
+        }
+
+        xSemaphoreGive(s_report_mutex);
+    }
+#endif
+
+    for (int h = 0; h < METRIC_HIST_COUNT && n < out_len; h++) {
+        const hist_def_t* def = &s_hist_defs[h];
+        hist_t snap;
+        hist_snapshot((metric_hist_t)h, &snap);
+
+        n += (size_t)snprintf(out + n, out_len - n, "\n%s: avg %lu %s, max %lu %s (%lu)",
+                              def->label,
+                              (unsigned long)(snap.count > 0 ? snap.sum / snap.count : 0),
+                              def->unit, (unsigned long)snap.max, def->unit,
+                              (unsigned long)snap.count);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t poll_failures = s_counters[METRIC_TELEGRAM_POLL_FAILURES];
+    uint32_t spi_errors = s_counters[METRIC_SPI_READ_ERRORS];
+    uint32_t overruns = s_counters[METRIC_CONTROL_OVERRUNS];
+    uint32_t escalations = s_counters[METRIC_CONTROL_ESCALATIONS];
+    portEXIT_CRITICAL(&s_lock);
+
+    if (n < out_len) {
+        n += (size_t)snprintf(out + n, out_len - n, "\nErrors: %lu SPI, %lu Telegram poll",
+                              (unsigned long)spi_errors, (unsigned long)poll_failures);
+    }
+    if (n < out_len) {
+        n += (size_t)snprintf(out + n, out_len - n, "\nControl: %lu overruns, %lu forced off",
+                              (unsigned long)overruns, (unsigned long)escalations);
+    }
+
+    uint32_t stages[METRIC_BOOT_STAGE_COUNT];
+    boot_stages_snapshot(stages);
+    if (n < out_len) {
+        n += (size_t)snprintf(out + n, out_len - n, "\nBoot (ms):");
+    }
+    for (int i = 0; i < METRIC_BOOT_STAGE_COUNT && n < out_len; i++) {
+        if (stages[i] != 0) {
+            n += (size_t)snprintf(out + n, out_len - n, " %s %lu", s_boot_stage_names[i],
+                                  (unsigned long)(stages[i] / 1000));
+        }
+    }
+}
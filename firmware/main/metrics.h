@@ -0,0 +1,119 @@
+/**
+ * @file metrics.h
+ * @brief Runtime instrumentation (tasks, heap, subsystem latencies)
+ *
+ * Subsystems record latencies into fixed log2-bucket histograms and bump
+ * counters; both are O(1) and safe from any task. Task runtime, stack
+ * high-water marks and heap figures are sampled when a report is
+ * formatted, so there is no background cost. Reports are the Prometheus
+ * text format (GET /metrics) and a short summary (/stats).
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Latency histograms
+ */
+typedef enum {
+    METRIC_SPI_READ_US = 0,     // MAX31855 transaction, including bus wait
+    METRIC_TELEGRAM_POLL_MS,    // getUpdates round trip (includes long poll)
+    METRIC_GUI_FRAME_US,        // render_screen() for frames that drew
+    METRIC_CONTROL_JITTER_US,   // Control cycle start-to-start vs. period
+    METRIC_HIST_COUNT
+} metric_hist_t;
+
+/**
+ * @brief Monotonic counters
+ */
+typedef enum {
+    METRIC_SPI_READ_ERRORS = 0,
+    METRIC_TELEGRAM_POLL_FAILURES,
+    METRIC_DISPLAY_BYTES,       // Pixel bytes queued to the panel
+    METRIC_CONTROL_OVERRUNS,    // Control cycles that missed their deadline
+    METRIC_CONTROL_MUTEX_TIMEOUTS,
+    METRIC_CONTROL_ESCALATIONS, // Relays forced off by the loop monitor
+    METRIC_COUNTER_COUNT
+} metric_counter_t;
+
+/**
+ * @brief Boot milestones (time since the esp_timer started, shortly
+ *        after the bootloader hands over)
+ */
+typedef enum {
+    METRIC_BOOT_APP_MAIN = 0,       // app_main() entered
+    METRIC_BOOT_CONTROL,            // First control cycle: relays under control
+    METRIC_BOOT_INIT_DONE,          // app_main() finished starting subsystems
+    METRIC_BOOT_WIFI_ASSOCIATED,    // First association with the AP
+    METRIC_BOOT_ONLINE,             // First IP address
+    METRIC_BOOT_STAGE_COUNT
+} metric_boot_stage_t;
+
+/**
+ * @brief Report sink: receives the output a line (or less) at a time
+ */
+typedef void (*metrics_write_fn_t)(const char* text, size_t len, void* ctx);
+
+/**
+ * @brief Initialize metrics (call before the other subsystems)
+ *
+ * @return true on success
+ */
+bool metrics_init(void);
+
+/**
+ * @brief Record one latency sample
+ */
+void metrics_observe(metric_hist_t hist, uint32_t value);
+
+/**
+ * @brief Add to a counter
+ */
+void metrics_count(metric_counter_t counter, uint32_t delta);
+
+/**
+ * @brief Record that a boot milestone was reached (first call only)
+ */
+void metrics_boot_stage(metric_boot_stage_t stage);
+
+/**
+ * @brief Write every metric in the Prometheus text exposition format
+ *
+ * @param write Sink for the output
+ * @param ctx   Passed to write
+ */
+void metrics_write_prometheus(metrics_write_fn_t write, void* ctx);
+
+/**
+ * @brief Format a short human-readable summary (for chat replies)
+ *
+ * Lists heap figures, the tasks with the least stack headroom, the
+ * mean/max of each histogram and the boot milestones.
+ *
+ * @param out     Destination buffer
+ * @param out_len Size of out
+ */
+void metrics_format_summary(char* out, size_t out_len);
+
+// Histogram buckets: bucket i holds values <= base << i, plus +Inf
+#define METRICS_HIST_BUCKETS    12
+
+// Tasks sampled per report (extra tasks are left out)
+#define METRICS_MAX_TASKS       24
+
+// Tasks listed in the summary, least stack headroom first
+#define METRICS_SUMMARY_TASKS   6
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,486 @@
+/**
+ * @file ota.c
+ * @brief Over-the-air firmware updates
+ *
+ * One update at a time, on its own task that exits when done. Progress
+ * and the last result live in s_status (s_lock) for ota_format_status().
+ */
+
+#include "ota.h"
+#include "config.h"
+#include "crockpot.h"
+#include "history_store.h"
+#include "wifi.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_app_desc.h"
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "ota";
+
+typedef enum {
+    OTA_STATE_IDLE,
+    OTA_STATE_DOWNLOADING,
+    OTA_STATE_VERIFYING,
+    OTA_STATE_RESTARTING,
+    OTA_STATE_FAILED
+} ota_state_t;
+
+typedef struct {
+    ota_state_t state;
+    uint32_t written;           // Bytes in flash so far
+    int32_t total;              // Image size (-1 = not sent by the server)
+    char message[64];           // Last failure, or the new version
+} ota_status_t;
+
+static ota_status_t s_status = { .state = OTA_STATE_IDLE, .total = -1 };
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Request for the update task (owned by it while an update runs)
+static char s_url[OTA_URL_MAX_LEN + 1];
+static uint8_t s_expected_sha[32];
+static bool s_check_sha = false;
+
+// Running image not yet confirmed (health task running)
+static volatile bool s_probation = false;
+
+static void set_state(ota_state_t state, const char* message)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_status.state = state;
+    if (message != NULL) {
+        strncpy(s_status.message, message, sizeof(s_status.message) - 1);
+        s_status.message[sizeof(s_status.message) - 1] = '\0';
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void fail(const char* message)
+{
+    ESP_LOGE(TAG, "Update failed: %s", message);
+    set_state(OTA_STATE_FAILED, message);
+}
+
+static bool parse_sha256(const char* hex, uint8_t out[32])
+{
+    for (int i = 0; i < 32; i++) {
+        unsigned int byte;
+        if (!isxdigit((unsigned char)hex[2 * i]) || !isxdigit((unsigned char)hex[2 * i + 1]) ||
+            sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+            return false;
+        }
+        out[i] = (uint8_t)byte;
+    }
+    return hex[64] == '\0' || isspace((unsigned char)hex[64]);
+}
+
+// ============================================================================
+// Download
+// ============================================================================
+
+/**
+ * @brief Open the image URL, from byte offset on
+ *
+ * @return HTTP client ready to read the body, or NULL (reason logged)
+ */
+static esp_http_client_handle_t open_stream(uint32_t offset, int32_t* content_length)
+{
+    esp_http_client_config_t config = {
+        .url = s_url,
+        .timeout_ms = OTA_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .keep_alive_enable = true,      // TCP probes catch a dead link mid-transfer
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return NULL;
+    }
+
+    char range[32];
+    if (offset > 0) {
+        snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)offset);
+        esp_http_client_set_header(client, "Range", range);
+    }
+
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err == ESP_OK) {
+        *content_length = (int32_t)esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+        if (status == (offset > 0 ? 206 : 200)) {
+            return client;
+        }
+        ESP_LOGW(TAG, "HTTP status %d%s", status,
+                 (offset > 0 && status == 200) ? " (server cannot resume)" : "");
+    } else {
+        ESP_LOGW(TAG, "Connection failed: %s", esp_err_to_name(err));
+    }
+
+    esp_http_client_cleanup(client);
+    return NULL;
+}
+
+/**
+ * @brief Stream the image into the OTA slot, hashing as it goes
+ *
+ * @return true once the whole image is written
+ */
+static bool download(esp_ota_handle_t handle, const esp_partition_t* target,
+                     mbedtls_sha256_context* sha)
+{
+    uint8_t chunk[OTA_CHUNK_SIZE];
+    uint32_t written = 0;
+    int32_t total = -1;
+    uint8_t resumes = 0;
+    uint8_t last_decile = 0;
+
+    while (1) {
+        int32_t remaining = -1;
+        esp_http_client_handle_t client = open_stream(written, &remaining);
+        if (client == NULL) {
+            if (written == 0 || ++resumes > OTA_MAX_RESUMES) {
+                fail("Cannot download image");
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        if (remaining > 0 && total < 0) {
+            total = (int32_t)written + remaining;
+            if ((uint32_t)total > target->size) {
+                esp_http_client_cleanup(client);
+                fail("Image larger than the OTA slot");
+                return false;
+            }
+            portENTER_CRITICAL(&s_lock);
+            s_status.total = total;
+            portEXIT_CRITICAL(&s_lock);
+        }
+
+        bool dropped = false;
+        while (1) {
+            int n = esp_http_client_read(client, (char*)chunk, sizeof(chunk));
+            if (n < 0) {
+                dropped = true;
+                break;
+            }
+            if (n == 0) {
+                dropped = !esp_http_client_is_complete_data_received(client);
+                break;
+            }
+
+            if (written + (uint32_t)n > target->size) {
+                esp_http_client_cleanup(client);
+                fail("Image larger than the OTA slot");
+                return false;
+            }
+
+            mbedtls_sha256_update(sha, chunk, (size_t)n);
+            esp_err_t err = esp_ota_write(handle, chunk, (size_t)n);
+            if (err != ESP_OK) {
+                esp_http_client_cleanup(client);
+                fail(err == ESP_ERR_OTA_VALIDATE_FAILED ? "Not an app image" : "Flash write failed");
+                return false;
+            }
+            written += (uint32_t)n;
+
+            portENTER_CRITICAL(&s_lock);
+            s_status.written = written;
+            portEXIT_CRITICAL(&s_lock);
+
+            if (total > 0 && written * 10 / (uint32_t)total > last_decile) {
+                last_decile = (uint8_t)(written * 10 / (uint32_t)total);
+                ESP_LOGI(TAG, "Downloaded %lu / %ld bytes", (unsigned long)written, (long)total);
+            }
+        }
+        esp_http_client_cleanup(client);
+
+        if (!dropped && (total < 0 || written == (uint32_t)total)) {
+            ESP_LOGI(TAG, "Download complete (%lu bytes)", (unsigned long)written);
+            return true;
+        }
+
+        if (++resumes > OTA_MAX_RESUMES) {
+            fail("Connection lost too often");
+            return false;
+        }
+        ESP_LOGW(TAG, "Connection lost at %lu bytes - resuming", (unsigned long)written);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+
+// ============================================================================
+// Update task
+// ============================================================================
+
+static void restart_into_new_image(void)
+{
+    // Heater stays off from verification until the reset
+    config_flush();
+    history_store_flush();
+    vTaskDelay(pdMS_TO_TICKS(OTA_RESTART_DELAY_MS));
+    esp_restart();
+}
+
+static void run_update(void)
+{
+    const esp_partition_t* target = esp_ota_get_next_update_partition(NULL);
+    if (target == NULL) {
+        fail("No OTA slot (flash the dual-slot partition table over USB)");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Updating %s from %s", target->label, s_url);
+
+    // Sequential writes erase each sector just before it is written,
+    // rather than the whole slot up front (a multi-second flash stall)
+    esp_ota_handle_t handle;
+    esp_err_t err = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin: %s", esp_err_to_name(err));
+        fail(err == ESP_ERR_OTA_ROLLBACK_INVALID_STATE
+             ? "Running image not yet confirmed" : "Cannot open the OTA slot");
+        return;
+    }
+
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+
+    bool ok = download(handle, target, &sha);
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+
+    if (!ok) {
+        esp_ota_abort(handle);
+        return;
+    }
+
+    if (s_check_sha && memcmp(digest, s_expected_sha, sizeof(digest)) != 0) {
+        esp_ota_abort(handle);
+        fail("SHA-256 mismatch");
+        return;
+    }
+
+    // From here the next boot may be the new image: heater safe first
+    set_state(OTA_STATE_VERIFYING, NULL);
+    crockpot_hold_heater(true);
+
+    err = esp_ota_end(handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(target);
+    }
+    if (err != ESP_OK) {
+        crockpot_hold_heater(false);
+        ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(err));
+        fail(err == ESP_ERR_OTA_VALIDATE_FAILED ? "Image failed verification"
+                                                : "Cannot select the new image");
+        return;
+    }
+
+    esp_app_desc_t desc;
+    char message[sizeof(s_status.message)];
+    if (esp_ota_get_partition_description(target, &desc) == ESP_OK) {
+        snprintf(message, sizeof(message), "Restarting into %.32s", desc.version);
+    } else {
+        snprintf(message, sizeof(message), "Restarting into the new image");
+    }
+    ESP_LOGI(TAG, "%s", message);
+    set_state(OTA_STATE_RESTARTING, message);
+
+    restart_into_new_image();
+}
+
+static void ota_task(void* pvParameters)
+{
+    (void)pvParameters;
+    run_update();
+    vTaskDelete(NULL);
+}
+
+bool ota_start(const char* url, const char* sha256_hex, char* out, size_t out_len)
+{
+#if !CONFIG_SECURE_SIGNED_ON_UPDATE
+    // Without signature checks any reachable HTTPS server could supply code
+    (void)url;
+    (void)sha256_hex;
+    snprintf(out, out_len, "Firmware updates need a signed-app build (see README)");
+    return false;
+#endif
+    if (url == NULL || strncmp(url, "https://", 8) != 0) {
+        snprintf(out, out_len, "Image URL must be https://");
+        return false;
+    }
+    if (strlen(url) > OTA_URL_MAX_LEN) {
+        snprintf(out, out_len, "Image URL too long (max %d)", OTA_URL_MAX_LEN);
+        return false;
+    }
+
+    uint8_t expected[32];
+    bool check_sha = sha256_hex != NULL && *sha256_hex != '\0';
+    if (check_sha && !parse_sha256(sha256_hex, expected)) {
+        snprintf(out, out_len, "SHA-256 must be 64 hex digits");
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool busy = s_status.state == OTA_STATE_DOWNLOADING ||
+                s_status.state == OTA_STATE_VERIFYING ||
+                s_status.state == OTA_STATE_RESTARTING;
+    if (!busy) {
+        s_status.state = OTA_STATE_DOWNLOADING;
+        s_status.written = 0;
+        s_status.total = -1;
+        s_status.message[0] = '\0';
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (busy) {
+        snprintf(out, out_len, "An update is already running");
+        return false;
+    }
+
+    strncpy(s_url, url, sizeof(s_url) - 1);
+    s_url[sizeof(s_url) - 1] = '\0';
+    memcpy(s_expected_sha, expected, sizeof(s_expected_sha));
+    s_check_sha = check_sha;
+
+    if (xTaskCreate(ota_task, "ota", OTA_TASK_STACK_SIZE, NULL,
+                    OTA_TASK_PRIORITY, NULL) != pdPASS) {
+        set_state(OTA_STATE_FAILED, "Cannot start update task");
+        snprintf(out, out_len, "Failed to start update");
+        return false;
+    }
+
+    snprintf(out, out_len, "Update started%s; /update shows progress",
+             check_sha ? "" : " (no SHA-256 given)");
+    return true;
+}
+
+// ============================================================================
+// Boot health check
+// ============================================================================
+
+/**
+ * @brief Probation check (own task: confirming or rolling back writes flash)
+ *
+ * Crashes, panics and watchdog resets are caught by the bootloader (the
+ * image is still unconfirmed after the reset). This catches an image that
+ * runs but cannot control the pot: the control loop must run on time with
+ * a valid reading for OTA_HEALTH_MIN_CYCLES cycles in a row. The network
+ * is not required; a router that is down after a power cut must not undo
+ * a good update.
+ */
+static void health_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(OTA_HEALTH_POLL_MS));
+        int64_t uptime_ms = esp_timer_get_time() / 1000;
+        uint32_t cycles = crockpot_get_healthy_cycles();
+
+        if (uptime_ms >= OTA_HEALTH_MIN_UPTIME_MS && cycles >= OTA_HEALTH_MIN_CYCLES) {
+            esp_ota_mark_app_valid_cancel_rollback();
+            s_probation = false;
+            ESP_LOGI(TAG, "New firmware confirmed (control loop healthy, WiFi %s)",
+                     wifi_is_connected() ? "connected" : "offline");
+            break;
+        }
+
+        if (uptime_ms >= OTA_HEALTH_TIMEOUT_MS) {
+            // The loop is unhealthy (so the heater is off or untrusted)
+            ESP_LOGE(TAG, "New firmware failed its health check (%lu good control "
+                     "cycles) - rolling back", (unsigned long)cycles);
+            crockpot_hold_heater(true);
+            config_flush();
+            esp_ota_mark_app_invalid_rollback_and_reboot();
+            break;
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+bool ota_init(void)
+{
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_app_desc_t* app = esp_app_get_description();
+    ESP_LOGI(TAG, "Running %s from %s", app->version, running ? running->label : "?");
+
+    esp_ota_img_states_t state;
+    if (running == NULL || esp_ota_get_state_partition(running, &state) != ESP_OK ||
+        state != ESP_OTA_IMG_PENDING_VERIFY) {
+        return true;
+    }
+
+    ESP_LOGW(TAG, "New firmware on probation (confirmed after %d healthy control cycles)",
+             OTA_HEALTH_MIN_CYCLES);
+
+    s_probation = true;
+    if (xTaskCreate(health_task, "ota_health", OTA_HEALTH_STACK_SIZE, NULL,
+                    OTA_HEALTH_PRIORITY, NULL) != pdPASS) {
+        // Without the check, keep the image rather than loop on rollbacks
+        ESP_LOGE(TAG, "Failed to start health check - confirming image");
+        esp_ota_mark_app_valid_cancel_rollback();
+        s_probation = false;
+        return false;
+    }
+    return true;
+}
+
+size_t ota_format_status(char* out, size_t len)
+{
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_app_desc_t* app = esp_app_get_description();
+
+    portENTER_CRITICAL(&s_lock);
+    ota_status_t status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+
+    int n = snprintf(out, len, "Firmware %s (%s%s)", app->version,
+                     running ? running->label : "?",
+                     s_probation ? ", on probation" : "");
+    if (n < 0 || (size_t)n >= len) {
+        return len - 1;
+    }
+
+    switch (status.state) {
+        case OTA_STATE_DOWNLOADING:
+            if (status.total > 0) {
+                n += snprintf(out + n, len - n, "\nUpdate: downloading %lu%% (%lu / %ld KB)",
+                              (unsigned long)((uint64_t)status.written * 100 / (uint32_t)status.total),
+                              (unsigned long)(status.written / 1024), (long)(status.total / 1024));
+            } else {
+                n += snprintf(out + n, len - n, "\nUpdate: downloading (%lu KB)",
+                              (unsigned long)(status.written / 1024));
+            }
+            break;
+        case OTA_STATE_VERIFYING:
+            n += snprintf(out + n, len - n, "\nUpdate: verifying image");
+            break;
+        case OTA_STATE_RESTARTING:
+            n += snprintf(out + n, len - n, "\nUpdate: %s", status.message);
+            break;
+        case OTA_STATE_FAILED:
+            n += snprintf(out + n, len - n, "\nLast update failed: %s", status.message);
+            break;
+        default:
+            n += snprintf(out + n, len - n, "\nUsage: /update <https-url> [sha256]");
+            break;
+    }
+    return (size_t)n < len ? (size_t)n : len - 1;
+}
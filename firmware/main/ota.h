@@ -0,0 +1,95 @@
+/**
+ * @file ota.h
+ * @brief Over-the-air firmware updates (dual app slots, rollback)
+ *
+ * "/update <url> [sha256]" on any interface downloads a new app image
+ * over HTTPS into the inactive OTA slot and boots it. The image is
+ * streamed in OTA_CHUNK_SIZE pieces straight into flash (erased sector
+ * by sector as it goes) while a SHA-256 of the stream is computed; it is
+ * never held in RAM. If the link drops, the download resumes where it
+ * stopped (HTTP Range) up to OTA_MAX_RESUMES times.
+ *
+ * Before switching, the image is checked: against the given SHA-256 if
+ * any, and by esp_ota_end() (image hash, plus the signature when signed
+ * apps are enabled). From then until the restart the heater is held
+ * off; the control task keeps running throughout.
+ *
+ * A new image boots on probation. It is kept once it has run for
+ * OTA_HEALTH_MIN_UPTIME_MS with the control loop healthy (on time, valid
+ * readings) for OTA_HEALTH_MIN_CYCLES cycles in a row; the network is not
+ * needed. If that has not happened within OTA_HEALTH_TIMEOUT_MS, or it
+ * crashes or trips the watchdog first, the previous image is restored.
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check the running image and, if it is on probation, start the
+ *        boot health check task
+ *
+ * Call once the control task is running.
+ *
+ * @return true on success
+ */
+bool ota_init(void);
+
+/**
+ * @brief Start an update in the background
+ *
+ * @param url        HTTPS URL of the app image (the .bin from the build)
+ * @param sha256_hex Expected SHA-256 of the image as 64 hex digits, or
+ *                   NULL to rely on the image's own checks
+ * @param out        Reply buffer (why it did not start, or that it did)
+ * @param out_len    Reply buffer size
+ * @return true if the update started
+ */
+bool ota_start(const char* url, const char* sha256_hex, char* out, size_t out_len);
+
+/**
+ * @brief Describe the running firmware and any update in progress
+ *
+ * @param out Buffer
+ * @param len Buffer size
+ * @return Characters written (excluding the terminator)
+ */
+size_t ota_format_status(char* out, size_t len);
+
+// Longest image URL
+#define OTA_URL_MAX_LEN             160
+
+// Bytes read from the connection and written to flash at a time
+#define OTA_CHUNK_SIZE              1024
+
+// Connection timeout, and reconnects (with Range) after a dropped link
+#define OTA_TIMEOUT_MS              15000
+#define OTA_MAX_RESUMES             5
+
+// Pause before restarting into the new image (lets the reply go out)
+#define OTA_RESTART_DELAY_MS        3000
+
+// Boot health check for a new image (cycles of CROCKPOT_CONTROL_INTERVAL_MS)
+#define OTA_HEALTH_MIN_UPTIME_MS    30000
+#define OTA_HEALTH_MIN_CYCLES       30
+#define OTA_HEALTH_TIMEOUT_MS       180000
+#define OTA_HEALTH_POLL_MS          1000
+#define OTA_HEALTH_STACK_SIZE       3072
+#define OTA_HEALTH_PRIORITY         1
+
+// Update task (TLS handshake runs on its stack); below the control,
+// temperature and UI tasks
+#define OTA_TASK_STACK_SIZE         8192
+#define OTA_TASK_PRIORITY           2
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_H
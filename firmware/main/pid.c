@@ -0,0 +1,57 @@
+/**
+ * @file pid.c
+ * @brief PID controller with anti-windup
+ */
+
+#include "pid.h"
+
+static int64_t clamp64(int64_t value, int64_t lo, int64_t hi)
+{
+    if (value < lo) return lo;
+    if (value > hi) return hi;
+    return value;
+}
+
+void pid_init(pid_controller_t* pid, int32_t kp_q16, int32_t ki_q16, int32_t kd_q16,
+              int32_t out_min, int32_t out_max)
+{
+    pid->kp_q16 = kp_q16;
+    pid->ki_q16 = ki_q16;
+    pid->kd_q16 = kd_q16;
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    pid_reset(pid);
+}
+
+void pid_reset(pid_controller_t* pid)
+{
+    pid->integral_q16 = 0;
+    pid->prev_input = 0;
+    pid->primed = false;
+}
+
+int32_t pid_update(pid_controller_t* pid, int32_t setpoint, int32_t input, uint32_t dt_ms)
+{
+    const int64_t min_q16 = (int64_t)pid->out_min << 16;
+    const int64_t max_q16 = (int64_t)pid->out_max << 16;
+    int64_t error = (int64_t)setpoint - input;
+
+    int64_t d_q16 = 0;
+    if (pid->primed && dt_ms > 0) {
+        d_q16 = -(int64_t)pid->kd_q16 * ((int64_t)input - pid->prev_input) * 1000 / dt_ms;
+    }
+    pid->prev_input = input;
+    pid->primed = true;
+
+    int64_t p_q16 = (int64_t)pid->kp_q16 * error;
+
+    // Integrate, then clamp so P + I + D stays inside the limits; this
+    // stops the integral from winding up while the output is saturated
+    int64_t i_q16 = pid->integral_q16 + (int64_t)pid->ki_q16 * error * dt_ms / 1000;
+    i_q16 = clamp64(i_q16, min_q16 - p_q16 - d_q16, max_q16 - p_q16 - d_q16);
+    i_q16 = clamp64(i_q16, min_q16, max_q16);
+    pid->integral_q16 = (int32_t)i_q16;
+
+    int64_t out_q16 = clamp64(p_q16 + i_q16 + d_q16, min_q16, max_q16);
+    return (int32_t)((out_q16 + (1 << 15)) >> 16);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file pid.h
+ * @brief PID controller with anti-windup
+ *
+ * Integer-only (the C3 has no FPU). Gains are Q16 fixed point in output
+ * units per input unit; derivative is taken on the measurement (no kick
+ * on setpoint changes) and the integral is clamped so the output never
+ * winds past its limits.
+ */
+
+#ifndef PID_H
+#define PID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Q16 gain from a constant expression (folded at compile time)
+#define PID_GAIN_Q16(g) ((int32_t)((g) * 65536.0 + 0.5))
+
+/**
+ * @brief Controller state
+ */
+typedef struct {
+    int32_t kp_q16;         // Output per unit of error
+    int32_t ki_q16;         // Output per unit of error per second
+    int32_t kd_q16;         // Output per unit/second of input change
+    int32_t out_min;
+    int32_t out_max;
+    int32_t integral_q16;   // Accumulated I term, in output units (Q16)
+    int32_t prev_input;
+    bool primed;            // prev_input is valid
+} pid_controller_t;
+
+/**
+ * @brief Set gains and output limits, and reset
+ */
+void pid_init(pid_controller_t* pid, int32_t kp_q16, int32_t ki_q16, int32_t kd_q16,
+              int32_t out_min, int32_t out_max);
+
+/**
+ * @brief Clear integral and derivative history
+ *
+ * Call when the controller is re-engaged (e.g. leaving OFF).
+ */
+void pid_reset(pid_controller_t* pid);
+
+/**
+ * @brief Run one step
+ *
+ * @param pid      Controller
+ * @param setpoint Target value
+ * @param input    Measured value
+ * @param dt_ms    Time since the previous step in milliseconds
+ * @return Output, clamped to [out_min, out_max]
+ */
+int32_t pid_update(pid_controller_t* pid, int32_t setpoint, int32_t input, uint32_t dt_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PID_H
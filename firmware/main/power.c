@@ -0,0 +1,80 @@
+/**
+ * @file power.c
+ * @brief Power management (frequency scaling, automatic light sleep)
+ */
+
+#include "power.h"
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+
+static const char* TAG = "power";
+
+#if CONFIG_PM_ENABLE
+static const char* const s_lock_names[POWER_LOCK_COUNT] = {
+    [POWER_LOCK_TELEGRAM_POLL] = "tg_poll",
+    [POWER_LOCK_TELEGRAM_SEND] = "tg_send",
+    [POWER_LOCK_GUI]           = "gui",
+    [POWER_LOCK_MQTT]          = "mqtt",
+};
+
+static esp_pm_lock_handle_t s_locks[POWER_LOCK_COUNT];
+#endif
+
+bool power_init(void)
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t config = {
+        .max_freq_mhz = POWER_MAX_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, s_lock_names[i], &s_locks[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create PM lock %s: %s",
+                     s_lock_names[i], esp_err_to_name(err));
+            return false;
+        }
+    }
+
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep %s", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ,
+             config.light_sleep_enable ? "on" : "off");
+    return true;
+#else
+    ESP_LOGI(TAG, "Power management disabled (CONFIG_PM_ENABLE)");
+    return true;
+#endif
+}
+
+void power_acquire(power_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (s_locks[lock] != NULL) {
+        esp_pm_lock_acquire(s_locks[lock]);
+    }
+#else
+    (void)lock;
+#endif
+}
+
+void power_release(power_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (s_locks[lock] != NULL) {
+        esp_pm_lock_release(s_locks[lock]);
+    }
+#else
+    (void)lock;
+#endif
+}
@@ -0,0 +1,61 @@
+/**
+ * @file power.h
+ * @brief Power management (frequency scaling, automatic light sleep)
+ *
+ * The CPU runs at POWER_MAX_FREQ_MHZ while any PM lock is held and drops
+ * to POWER_MIN_FREQ_MHZ otherwise; when every task is blocked the idle
+ * task enters light sleep until the next timer or wake-up source. The
+ * SPI, GPTimer and WiFi drivers take their own locks while active, so
+ * the locks here only cover CPU-heavy bursts (TLS handshakes, GUI
+ * frames) that should finish at full speed.
+ *
+ * Without CONFIG_PM_ENABLE everything here is a no-op.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CPU frequency locks, one per user (locks count, not nest)
+ */
+typedef enum {
+    POWER_LOCK_TELEGRAM_POLL = 0,
+    POWER_LOCK_TELEGRAM_SEND,
+    POWER_LOCK_GUI,
+    POWER_LOCK_MQTT,
+    POWER_LOCK_COUNT
+} power_lock_t;
+
+/**
+ * @brief Configure frequency scaling and light sleep, create the locks
+ *
+ * Call first in app_main(), before drivers create their own locks.
+ *
+ * @return true on success (false leaves the CPU at its default speed)
+ */
+bool power_init(void);
+
+/**
+ * @brief Hold the CPU at full speed until power_release()
+ */
+void power_acquire(power_lock_t lock);
+
+/**
+ * @brief Release a lock taken with power_acquire()
+ */
+void power_release(power_lock_t lock);
+
+#define POWER_MAX_FREQ_MHZ  160
+#define POWER_MIN_FREQ_MHZ  80
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POWER_H
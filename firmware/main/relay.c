@@ -4,8 +4,13 @@
  */
 
 #include "relay.h"
+#include "dlog.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 
 static const char* TAG = "relay";
@@ -16,12 +21,124 @@ static const gpio_num_t s_relay_gpio[RELAY_CHANNEL_COUNT] = {
     [RELAY_CHANNEL_AUX]  = RELAY_AUX_GPIO
 };
 
-// Current relay states
-static bool s_relay_states[RELAY_CHANNEL_COUNT] = { false };
+// Current relay states (written by tasks and the timer ISR)
+static volatile bool s_relay_states[RELAY_CHANNEL_COUNT] = { false };
+
+// Modulation state, shared with the timer ISR under s_lock
+static bool s_modulated[RELAY_CHANNEL_COUNT] = { false };
+static uint16_t s_duty_permille[RELAY_CHANNEL_COUNT] = { 0 };   // Requested
+static uint32_t s_on_ticks[RELAY_CHANNEL_COUNT] = { 0 };        // Latched for this window
+static uint32_t s_window_ticks = RELAY_WINDOW_MS / RELAY_TICK_MS;
+static uint32_t s_next_window_ticks = RELAY_WINDOW_MS / RELAY_TICK_MS;
+static uint32_t s_tick = 0;
+static bool s_hold = false;         // relay_hold_off(): nothing may switch on
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static gptimer_handle_t s_timer = NULL;
+
+// Serializes starting/stopping the timer; s_timer_running is under s_lock
+static SemaphoreHandle_t s_timer_mutex = NULL;
+static bool s_timer_running = false;
 
 // Initialized flag
 static bool s_initialized = false;
 
+static inline void IRAM_ATTR write_output(relay_channel_t channel, bool on)
+{
+    gpio_set_level(s_relay_gpio[channel], (on == (RELAY_ACTIVE_HIGH != 0)) ? 1 : 0);
+    s_relay_states[channel] = on;
+}
+
+/**
+ * @brief Modulation tick (every RELAY_TICK_MS)
+ */
+static bool IRAM_ATTR relay_timer_cb(gptimer_handle_t timer,
+                                     const gptimer_alarm_event_data_t* edata,
+                                     void* user_ctx)
+{
+    portENTER_CRITICAL_ISR(&s_lock);
+
+    if (s_tick == 0) {
+        // Window start: pick up new window length and duties
+        s_window_ticks = s_next_window_ticks;
+        for (int i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+            s_on_ticks[i] = (s_duty_permille[i] * s_window_ticks + 500) / 1000;
+        }
+    }
+
+    for (int i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        if (s_modulated[i]) {
+            bool on = s_tick < s_on_ticks[i];
+            if (on != s_relay_states[i]) {
+                write_output((relay_channel_t)i, on);
+            }
+        }
+    }
+
+    s_tick = (s_tick + 1 >= s_window_ticks) ? 0 : s_tick + 1;
+
+    portEXIT_CRITICAL_ISR(&s_lock);
+    return false;
+}
+
+static bool create_timer(void)
+{
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,   // 1 us
+    };
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = RELAY_TICK_MS * 1000,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = relay_timer_cb,
+    };
+
+    if (gptimer_new_timer(&timer_config, &s_timer) != ESP_OK ||
+        gptimer_register_event_callbacks(s_timer, &callbacks, NULL) != ESP_OK ||
+        gptimer_set_alarm_action(s_timer, &alarm_config) != ESP_OK) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Run the tick timer only while some channel is modulated
+ *
+ * An enabled GPTimer holds a PM lock that keeps the chip out of light
+ * sleep, and with the heater off it has nothing to do.
+ */
+static void update_timer(void)
+{
+    xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+
+    portENTER_CRITICAL(&s_lock);
+    bool needed = false;
+    for (int i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        needed |= s_modulated[i];
+    }
+    bool change = (needed != s_timer_running);
+    if (change && needed) {
+        s_tick = 0;     // First tick starts a fresh window
+    }
+    s_timer_running = needed;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (change && needed) {
+        gptimer_set_raw_count(s_timer, 0);
+        gptimer_enable(s_timer);
+        gptimer_start(s_timer);
+    } else if (change) {
+        gptimer_stop(s_timer);
+        gptimer_disable(s_timer);
+    }
+
+    xSemaphoreGive(s_timer_mutex);
+}
+
 bool relay_init(void)
 {
     ESP_LOGI(TAG, "Initializing relay control");
@@ -42,44 +159,93 @@ bool relay_init(void)
         }
 
         // Initialize to OFF state
-        int level = RELAY_ACTIVE_HIGH ? 0 : 1;
-        gpio_set_level(s_relay_gpio[i], level);
-        s_relay_states[i] = false;
+        write_output((relay_channel_t)i, false);
 
         ESP_LOGI(TAG, "Relay %d configured on GPIO %d", i, s_relay_gpio[i]);
     }
 
+    s_timer_mutex = xSemaphoreCreateMutex();
+    if (s_timer_mutex == NULL || !create_timer()) {
+        ESP_LOGE(TAG, "Failed to create modulation timer");
+        return false;
+    }
+
     s_initialized = true;
-    ESP_LOGI(TAG, "Relay control initialized");
+    ESP_LOGI(TAG, "Relay control initialized (window %d ms, tick %d ms)",
+             RELAY_WINDOW_MS, RELAY_TICK_MS);
     return true;
 }
 
 bool relay_set(relay_channel_t channel, bool on)
 {
     if (!s_initialized) {
-        ESP_LOGE(TAG, "Relay not initialized");
+        DLOGE(TAG, "Relay not initialized");
         return false;
     }
 
     if (channel >= RELAY_CHANNEL_COUNT) {
-        ESP_LOGE(TAG, "Invalid relay channel: %d", channel);
+        DLOGE(TAG, "Invalid relay channel: %d", channel);
         return false;
     }
 
-    int level;
-    if (RELAY_ACTIVE_HIGH) {
-        level = on ? 1 : 0;
-    } else {
-        level = on ? 0 : 1;
+    portENTER_CRITICAL(&s_lock);
+    bool refused = on && s_hold;
+    if (!refused) {
+        s_modulated[channel] = false;
+        write_output(channel, on);
     }
+    portEXIT_CRITICAL(&s_lock);
 
-    gpio_set_level(s_relay_gpio[channel], level);
-    s_relay_states[channel] = on;
+    if (refused) {
+        return false;
+    }
+
+    update_timer();
+
+    DLOGD(TAG, "Relay %d set to %s", channel, on ? "ON" : "OFF");
+    return true;
+}
+
+bool relay_set_duty(relay_channel_t channel, uint16_t permille)
+{
+    if (!s_initialized || channel >= RELAY_CHANNEL_COUNT) {
+        return false;
+    }
+
+    if (permille > 1000) {
+        permille = 1000;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_hold && permille > 0) {
+        portEXIT_CRITICAL(&s_lock);
+        return false;
+    }
+    s_duty_permille[channel] = permille;
+    if (!s_modulated[channel]) {
+        // Switching to modulation mid-window: hold the current output
+        // until the next window start picks up the duty
+        s_on_ticks[channel] = s_relay_states[channel] ? s_window_ticks : 0;
+        s_modulated[channel] = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
 
-    ESP_LOGI(TAG, "Relay %d set to %s", channel, on ? "ON" : "OFF");
+    update_timer();
     return true;
 }
 
+void relay_set_window_ms(uint32_t window_ms)
+{
+    uint32_t ticks = window_ms / RELAY_TICK_MS;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_next_window_ticks = ticks;
+    portEXIT_CRITICAL(&s_lock);
+}
+
 bool relay_get(relay_channel_t channel)
 {
     if (channel >= RELAY_CHANNEL_COUNT) {
@@ -88,35 +254,41 @@ bool relay_get(relay_channel_t channel)
     return s_relay_states[channel];
 }
 
-void relay_all_off(void)
+static void all_off_locked(void)
 {
-    ESP_LOGI(TAG, "Turning all relays OFF");
-
     for (int i = 0; i < RELAY_CHANNEL_COUNT; i++) {
-        int level = RELAY_ACTIVE_HIGH ? 0 : 1;
-        gpio_set_level(s_relay_gpio[i], level);
-        s_relay_states[i] = false;
+        s_modulated[i] = false;
+        s_duty_permille[i] = 0;
+        write_output((relay_channel_t)i, false);
     }
 }
 
-bool relay_apply_state(crockpot_state_t state)
+void relay_hold_off(bool hold)
 {
-    ESP_LOGI(TAG, "Applying crockpot state: %s", crockpot_state_to_string(state));
-
-    switch (state) {
-        case CROCKPOT_OFF:
-            return relay_set(RELAY_CHANNEL_MAIN, false);
-
-        case CROCKPOT_WARM:
-        case CROCKPOT_LOW:
-        case CROCKPOT_HIGH:
-            // For simple on/off relay, all heating states turn relay on
-            // TODO: Implement PWM or multi-relay for different heat levels
-            return relay_set(RELAY_CHANNEL_MAIN, true);
-
-        default:
-            ESP_LOGE(TAG, "Unknown state: %d", state);
-            relay_all_off();
-            return false;
+    // Flag and outputs change together, so a write racing with this call
+    // either lands before (and is undone) or after (and is refused)
+    portENTER_CRITICAL(&s_lock);
+    s_hold = hold;
+    if (hold) {
+        all_off_locked();
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_initialized) {
+        update_timer();
+    }
+    DLOGI(TAG, "Relays %s", hold ? "held off" : "released");
+}
+
+void relay_all_off(void)
+{
+    DLOGI(TAG, "Turning all relays OFF");
+
+    portENTER_CRITICAL(&s_lock);
+    all_off_locked();
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_initialized) {
+        update_timer();
     }
 }
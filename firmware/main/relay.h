@@ -4,13 +4,19 @@
  *
  * Abstract interface for relay/solid-state relay control.
  * Handles the high-voltage switching for crockpot heating element.
+ *
+ * Each channel is either switched (relay_set) or modulated
+ * (relay_set_duty). Modulated channels are time-proportioned by a
+ * hardware timer ISR, so their timing does not depend on task scheduling.
+ * The timer only runs while a channel is modulated, so it does not keep
+ * the chip out of light sleep when the heater is off.
  */
 
 #ifndef RELAY_H
 #define RELAY_H
 
 #include <stdbool.h>
-#include "crockpot.h"
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -58,19 +64,44 @@ bool relay_get(relay_channel_t channel);
 /**
  * @brief Turn off all relays
  *
- * Emergency shutoff function.
+ * Emergency shutoff function. Also stops modulation on every channel.
  */
 void relay_all_off(void);
 
 /**
- * @brief Apply crockpot state to relays
+ * @brief Hold every relay off until released
  *
- * Translates crockpot state to appropriate relay settings.
+ * Turns everything off at once; until released, relay_set(on) and
+ * relay_set_duty() with a non-zero duty are refused (return false).
+ * Safe from any task.
  *
- * @param state Crockpot state to apply
- * @return true on success
+ * @param hold true to hold off, false to release
  */
-bool relay_apply_state(crockpot_state_t state);
+void relay_hold_off(bool hold);
+
+/**
+ * @brief Time-proportion a channel
+ *
+ * The channel is on for permille/1000 of every window, starting at the
+ * window boundary. A new duty is picked up at the next window start, so
+ * the output switches at most twice per window. Safe to call from any
+ * task at any rate; does not log. relay_set() returns the channel to
+ * plain switching.
+ *
+ * @param channel Relay channel
+ * @param permille Duty, 0-1000 (clamped)
+ * @return true on success, false on invalid channel or not initialized
+ */
+bool relay_set_duty(relay_channel_t channel, uint16_t permille);
+
+/**
+ * @brief Change the modulation window length
+ *
+ * Takes effect at the next window start.
+ *
+ * @param window_ms Window in milliseconds (multiple of RELAY_TICK_MS)
+ */
+void relay_set_window_ms(uint32_t window_ms);
 
 // GPIO pins for relay control (configurable)
 // TODO: Move to menuconfig
@@ -81,6 +112,13 @@ bool relay_apply_state(crockpot_state_t state);
 // Relay active level (some relays are active-low)
 #define RELAY_ACTIVE_HIGH 1
 
+// Modulation timer tick: one 50 Hz half-cycle, so a zero-cross SSR
+// sees whole half-cycles. Sets the duty resolution within a window.
+#define RELAY_TICK_MS       10
+
+// Default modulation window
+#define RELAY_WINDOW_MS     10000
+
 #ifdef __cplusplus
 }
 #endif
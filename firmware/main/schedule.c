@@ -0,0 +1,760 @@
+/**
+ * @file schedule.c
+ * @brief Multi-step cook programs
+ *
+ * All engine state is owned by s_mutex and changed from the engine task
+ * or the public API. The timer callback only wakes the engine task: the
+ * evaluation waits on mutexes and writes NVS, which must not stall the
+ * esp_timer task that scans the buttons and touch panel. The crockpot
+ * listener only reads a small copy of the current step (s_watch) and
+ * fires the timer early when the state was changed behind the program's
+ * back or the step's condition is met; the task then re-evaluates
+ * against a fresh status.
+ */
+
+#include "schedule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_crc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+static const char* TAG = "schedule";
+
+#define US_PER_S    1000000LL
+
+// NVS keys: the program is written once per start, the progress at
+// every step change and checkpoint
+#define KEY_PROGRAM     "program"
+#define KEY_PROGRESS    "progress"
+
+#define STORED_VERSION      1
+#define STORED_FLAG_REPEAT  0x01
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;        // STORED_VERSION
+    uint8_t flags;          // STORED_FLAG_*
+    uint8_t count;
+    uint8_t reserved;
+    schedule_step_t steps[SCHEDULE_MAX_STEPS];  // Only count are stored
+} stored_program_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t program_crc;   // CRC16 of the stored program it belongs to
+    uint8_t step;
+    uint8_t reserved;
+    uint32_t elapsed_s;     // Time spent in the step
+} stored_progress_t;
+
+#define STORED_PROGRAM_SIZE(count) \
+    (offsetof(stored_program_t, steps) + (size_t)(count) * sizeof(schedule_step_t))
+
+typedef struct {
+    const char* name;
+    schedule_program_t program;
+} preset_t;
+
+#define STEP(s, minutes) { .state = (s), .until = SCHEDULE_UNTIL_NONE, .duration_min = (minutes) }
+
+// Same programs as the simulator's PRESET_SCHEDULES
+static const preset_t s_presets[] = {
+    { "slowcook",  { .count = 3, .steps = { STEP(CROCKPOT_HIGH, 180), STEP(CROCKPOT_LOW, 360),
+                                            STEP(CROCKPOT_WARM, 0) } } },
+    { "quickwarm", { .count = 2, .steps = { STEP(CROCKPOT_HIGH, 60), STEP(CROCKPOT_WARM, 0) } } },
+    { "allday",    { .count = 2, .steps = { STEP(CROCKPOT_LOW, 480), STEP(CROCKPOT_WARM, 0) } } },
+};
+
+#define PRESET_COUNT (sizeof(s_presets) / sizeof(s_presets[0]))
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_timer = NULL;
+static TaskHandle_t s_engine_task = NULL;
+static nvs_handle_t s_nvs;
+static bool s_nvs_open = false;
+
+// Engine state (s_mutex)
+static schedule_program_t s_program;
+static uint16_t s_program_crc = 0;
+static bool s_active = false;
+static uint8_t s_step = 0;
+static bool s_apply_pending = false;   // Step state not applied yet; retrying
+static int64_t s_step_start_us = 0;    // Shifted back by any resumed elapsed time
+static int64_t s_checkpoint_us = 0;    // Last progress save
+
+// Listener's view of the current step (s_watch_lock)
+static portMUX_TYPE s_watch_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    bool active;
+    bool applying;          // Ignore state mismatches while switching steps
+    bool kicked;            // Timer already fired early; cleared by the callback
+    crockpot_state_t state;
+    schedule_until_t until;
+    temp_cc_t until_temp;
+} s_watch;
+
+static bool condition_met(schedule_until_t until, temp_cc_t until_temp,
+                          const crockpot_status_t* status)
+{
+    if (status->sensor_error) {
+        return false;
+    }
+    switch (until) {
+        case SCHEDULE_UNTIL_ABOVE: return status->temperature >= until_temp;
+        case SCHEDULE_UNTIL_BELOW: return status->temperature <= until_temp;
+        default:                   return false;
+    }
+}
+
+static void kick_timer(void)
+{
+    esp_timer_stop(s_timer);
+    esp_timer_start_once(s_timer, 0);
+}
+
+/**
+ * @brief Runs on whichever task changed the status; never blocks
+ */
+static void status_listener(void* user_data)
+{
+    (void)user_data;
+    crockpot_status_t status = crockpot_get_status();
+    bool kick = false;
+
+    portENTER_CRITICAL(&s_watch_lock);
+    if (s_watch.active && !s_watch.kicked &&
+        ((!s_watch.applying && status.state != s_watch.state) ||
+         condition_met(s_watch.until, s_watch.until_temp, &status))) {
+        s_watch.kicked = true;
+        kick = true;
+    }
+    portEXIT_CRITICAL(&s_watch_lock);
+
+    if (kick) {
+        kick_timer();
+    }
+}
+
+static void watch_update(bool active, bool applying)
+{
+    const schedule_step_t* step = &s_program.steps[s_step];
+
+    portENTER_CRITICAL(&s_watch_lock);
+    s_watch.active = active;
+    s_watch.applying = applying;
+    s_watch.state = (crockpot_state_t)step->state;
+    s_watch.until = (schedule_until_t)step->until;
+    s_watch.until_temp = step->until_temp;
+    portEXIT_CRITICAL(&s_watch_lock);
+}
+
+static uint16_t encode_program(const schedule_program_t* program, stored_program_t* stored)
+{
+    memset(stored, 0, sizeof(*stored));
+    stored->version = STORED_VERSION;
+    stored->flags = program->repeat ? STORED_FLAG_REPEAT : 0;
+    stored->count = program->count;
+    memcpy(stored->steps, program->steps, program->count * sizeof(schedule_step_t));
+    return esp_crc16_le(0, (const uint8_t*)stored, STORED_PROGRAM_SIZE(program->count));
+}
+
+static void save_program_locked(void)
+{
+    stored_program_t stored;
+    s_program_crc = encode_program(&s_program, &stored);
+
+    if (s_nvs_open &&
+        (nvs_set_blob(s_nvs, KEY_PROGRAM, &stored, STORED_PROGRAM_SIZE(stored.count)) != ESP_OK ||
+         nvs_commit(s_nvs) != ESP_OK)) {
+        ESP_LOGW(TAG, "Failed to save program; it will not survive a reboot");
+    }
+}
+
+static void save_progress_locked(int64_t now_us)
+{
+    stored_progress_t progress = {
+        .program_crc = s_program_crc,
+        .step = s_step,
+        .elapsed_s = (uint32_t)((now_us - s_step_start_us) / US_PER_S),
+    };
+
+    if (s_nvs_open &&
+        (nvs_set_blob(s_nvs, KEY_PROGRESS, &progress, sizeof(progress)) != ESP_OK ||
+         nvs_commit(s_nvs) != ESP_OK)) {
+        ESP_LOGW(TAG, "Failed to save progress");
+    }
+    s_checkpoint_us = now_us;
+}
+
+static void erase_locked(void)
+{
+    if (s_nvs_open) {
+        nvs_erase_key(s_nvs, KEY_PROGRESS);
+        nvs_erase_key(s_nvs, KEY_PROGRAM);
+        nvs_commit(s_nvs);
+    }
+}
+
+static void stop_locked(void)
+{
+    s_active = false;
+    s_apply_pending = false;
+    watch_update(false, false);
+    esp_timer_stop(s_timer);
+    erase_locked();
+}
+
+/**
+ * @brief Arm the timer for the step end, next checkpoint or a retry
+ *
+ * Untimed steps leave it stopped: only the listener can end them.
+ */
+static void arm_locked(int64_t now_us)
+{
+    const schedule_step_t* step = &s_program.steps[s_step];
+    int64_t delay_us = -1;
+
+    if (s_apply_pending) {
+        delay_us = SCHEDULE_RETRY_MS * 1000LL;
+    } else if (step->duration_min > 0) {
+        int64_t end_us = s_step_start_us + step->duration_min * 60 * US_PER_S;
+        int64_t checkpoint_us = s_checkpoint_us + SCHEDULE_CHECKPOINT_S * US_PER_S;
+        delay_us = ((end_us < checkpoint_us) ? end_us : checkpoint_us) - now_us;
+        if (delay_us < 0) {
+            delay_us = 0;
+        }
+    }
+
+    esp_timer_stop(s_timer);
+    if (delay_us >= 0) {
+        esp_timer_start_once(s_timer, (uint64_t)delay_us);
+    }
+
+    // A kick that landed while we were evaluating must not be overridden
+    portENTER_CRITICAL(&s_watch_lock);
+    bool kicked = s_watch.kicked;
+    portEXIT_CRITICAL(&s_watch_lock);
+    if (kicked) {
+        kick_timer();
+    }
+}
+
+static bool apply_step_locked(void)
+{
+    crockpot_state_t state = (crockpot_state_t)s_program.steps[s_step].state;
+
+    watch_update(true, true);
+    s_apply_pending = !crockpot_set_state(state);
+    watch_update(true, s_apply_pending);
+
+    if (s_apply_pending) {
+        ESP_LOGW(TAG, "Failed to apply step %u (%s), retrying",
+                 s_step + 1, crockpot_state_to_string(state));
+    }
+    return !s_apply_pending;
+}
+
+/**
+ * @brief Enter a step with elapsed_s already spent in it
+ *
+ * Fires the timer right away so a condition that already holds ends the
+ * step without waiting for the next temperature change.
+ */
+static bool enter_step_locked(uint8_t step, uint32_t elapsed_s, int64_t now_us)
+{
+    s_step = step;
+    s_step_start_us = now_us - elapsed_s * US_PER_S;
+    save_progress_locked(now_us);
+
+    ESP_LOGI(TAG, "Step %u/%u: %s", step + 1, s_program.count,
+             crockpot_state_to_string((crockpot_state_t)s_program.steps[step].state));
+
+    bool applied = apply_step_locked();
+    esp_timer_stop(s_timer);
+    esp_timer_start_once(s_timer, applied ? 0 : SCHEDULE_RETRY_MS * 1000LL);
+    return applied;
+}
+
+static void advance_locked(int64_t now_us)
+{
+    uint8_t next = s_step + 1;
+
+    if (next >= s_program.count) {
+        if (!s_program.repeat) {
+            // Only a timed or conditional last step can end
+            ESP_LOGI(TAG, "Program complete");
+            stop_locked();
+            crockpot_set_state(CROCKPOT_OFF);
+            return;
+        }
+        next = 0;
+    }
+    enter_step_locked(next, 0, now_us);
+}
+
+static void evaluate_locked(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    if (s_apply_pending && !apply_step_locked()) {
+        arm_locked(now_us);
+        return;
+    }
+
+    const schedule_step_t* step = &s_program.steps[s_step];
+    crockpot_status_t status = crockpot_get_status();
+
+    if (status.state != (crockpot_state_t)step->state) {
+        ESP_LOGI(TAG, "State changed to %s outside the program, stopping",
+                 crockpot_state_to_string(status.state));
+        stop_locked();
+        return;
+    }
+
+    int64_t elapsed_us = now_us - s_step_start_us;
+    if ((step->duration_min > 0 && elapsed_us >= step->duration_min * 60 * US_PER_S) ||
+        condition_met((schedule_until_t)step->until, step->until_temp, &status)) {
+        advance_locked(now_us);
+        return;
+    }
+
+    if (step->duration_min > 0 &&
+        now_us - s_checkpoint_us >= SCHEDULE_CHECKPOINT_S * US_PER_S) {
+        save_progress_locked(now_us);
+    }
+    arm_locked(now_us);
+}
+
+static void schedule_timer_cb(void* arg)
+{
+    (void)arg;
+    xTaskNotifyGive(s_engine_task);
+}
+
+static void engine_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+        portENTER_CRITICAL(&s_watch_lock);
+        s_watch.kicked = false;
+        portEXIT_CRITICAL(&s_watch_lock);
+
+        if (s_active) {
+            evaluate_locked();
+        }
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+static bool program_valid(const schedule_program_t* program)
+{
+    if (program->count == 0 || program->count > SCHEDULE_MAX_STEPS) {
+        return false;
+    }
+    for (uint8_t i = 0; i < program->count; i++) {
+        const schedule_step_t* step = &program->steps[i];
+        if (step->state > CROCKPOT_HIGH || step->until > SCHEDULE_UNTIL_BELOW) {
+            return false;
+        }
+        // A repeating program must spend time in every step
+        if (program->repeat && step->duration_min == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Load the saved program; resume point in *step / *elapsed_s
+ */
+static bool load_locked(uint8_t* step, uint32_t* elapsed_s)
+{
+    stored_program_t stored;
+    stored_progress_t progress;
+    size_t size = sizeof(stored);
+
+    if (nvs_get_blob(s_nvs, KEY_PROGRAM, &stored, &size) != ESP_OK ||
+        stored.version != STORED_VERSION || size != STORED_PROGRAM_SIZE(stored.count)) {
+        return false;
+    }
+
+    memset(&s_program, 0, sizeof(s_program));
+    s_program.count = stored.count;
+    s_program.repeat = (stored.flags & STORED_FLAG_REPEAT) != 0;
+    if (stored.count == 0 || stored.count > SCHEDULE_MAX_STEPS) {
+        return false;
+    }
+    memcpy(s_program.steps, stored.steps, stored.count * sizeof(schedule_step_t));
+    if (!program_valid(&s_program)) {
+        return false;
+    }
+    s_program_crc = esp_crc16_le(0, (const uint8_t*)&stored, size);
+
+    size = sizeof(progress);
+    if (nvs_get_blob(s_nvs, KEY_PROGRESS, &progress, &size) != ESP_OK ||
+        size != sizeof(progress) || progress.program_crc != s_program_crc ||
+        progress.step >= s_program.count) {
+        return false;
+    }
+
+    *step = progress.step;
+    *elapsed_s = progress.elapsed_s;
+    return true;
+}
+
+bool schedule_init(void)
+{
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return false;
+    }
+
+    if (xTaskCreate(engine_task, "schedule", SCHEDULE_TASK_STACK_SIZE, NULL,
+                    SCHEDULE_TASK_PRIORITY, &s_engine_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create engine task");
+        return false;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = schedule_timer_cb,
+        .name = "schedule",
+    };
+    if (esp_timer_create(&timer_args, &s_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create timer");
+        return false;
+    }
+
+    crockpot_add_listener(status_listener, NULL);
+
+    esp_err_t err = nvs_open(SCHEDULE_NVS_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS unavailable (%s) - programs will not survive a reboot",
+                 esp_err_to_name(err));
+        return true;
+    }
+    s_nvs_open = true;
+
+    uint8_t step;
+    uint32_t elapsed_s;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (load_locked(&step, &elapsed_s)) {
+        ESP_LOGI(TAG, "Resuming program at step %u/%u (%lu s in)",
+                 step + 1, s_program.count, (unsigned long)elapsed_s);
+        s_active = true;
+        enter_step_locked(step, elapsed_s, esp_timer_get_time());
+    } else {
+        erase_locked();
+    }
+    xSemaphoreGive(s_mutex);
+
+    return true;
+}
+
+bool schedule_start(const schedule_program_t* program)
+{
+    if (program == NULL || !program_valid(program) || s_mutex == NULL) {
+        return false;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_program = *program;
+    s_active = true;
+    save_program_locked();
+
+    bool ok = enter_step_locked(0, 0, esp_timer_get_time());
+    if (!ok) {
+        stop_locked();
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (ok) {
+        ESP_LOGI(TAG, "Program started (%u steps)", program->count);
+    }
+    return ok;
+}
+
+void schedule_stop(void)
+{
+    if (s_mutex == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_active) {
+        ESP_LOGI(TAG, "Program stopped");
+        stop_locked();
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+bool schedule_is_active(void)
+{
+    return s_active;
+}
+
+/**
+ * @brief "2h", "45m", "1h30m"
+ */
+static int format_duration(char* out, size_t len, uint32_t minutes)
+{
+    if (minutes >= 60 && minutes % 60 != 0) {
+        return snprintf(out, len, "%luh%02lum", (unsigned long)(minutes / 60),
+                        (unsigned long)(minutes % 60));
+    }
+    if (minutes >= 60) {
+        return snprintf(out, len, "%luh", (unsigned long)(minutes / 60));
+    }
+    return snprintf(out, len, "%lum", (unsigned long)minutes);
+}
+
+static int format_step(char* out, size_t len, const schedule_step_t* step)
+{
+    int n = snprintf(out, len, "%s",
+                     crockpot_state_to_string((crockpot_state_t)step->state));
+
+    if (step->duration_min > 0 && (size_t)n < len) {
+        n += snprintf(out + n, len - n, " ");
+        n += format_duration(out + n, len - n, step->duration_min);
+    }
+    if (step->until != SCHEDULE_UNTIL_NONE && (size_t)n < len) {
+        char temp[12];
+        temp_format_f(temp, sizeof(temp), step->until_temp);
+        n += snprintf(out + n, len - n, " until %s%s F",
+                      step->until == SCHEDULE_UNTIL_ABOVE ? ">=" : "<=", temp);
+    }
+    return n;
+}
+
+size_t schedule_format_status(char* out, size_t len)
+{
+    if (out == NULL || len == 0) {
+        return 0;
+    }
+    if (s_mutex == NULL) {
+        return (size_t)snprintf(out, len, "Programs unavailable");
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    if (!s_active) {
+        xSemaphoreGive(s_mutex);
+        return (size_t)snprintf(out, len, "No program running");
+    }
+
+    size_t n = (size_t)snprintf(out, len, "Program:");
+    for (uint8_t i = 0; i < s_program.count && n < len; i++) {
+        n += (size_t)snprintf(out + n, len - n, "%s", i > 0 ? " ->" : "");
+        n += (size_t)snprintf(out + n, len - n, " ");
+        n += (size_t)format_step(out + n, len - n, &s_program.steps[i]);
+    }
+    if (s_program.repeat && n < len) {
+        n += (size_t)snprintf(out + n, len - n, " (repeat)");
+    }
+
+    const schedule_step_t* step = &s_program.steps[s_step];
+    if (n < len) {
+        n += (size_t)snprintf(out + n, len - n, "\nStep %u/%u: %s",
+                              s_step + 1, s_program.count,
+                              crockpot_state_to_string((crockpot_state_t)step->state));
+    }
+
+    if (step->duration_min > 0 && n < len) {
+        int64_t elapsed_s = (esp_timer_get_time() - s_step_start_us) / US_PER_S;
+        int64_t left_s = (int64_t)step->duration_min * 60 - elapsed_s;
+        uint32_t left_min = (left_s > 0) ? (uint32_t)((left_s + 59) / 60) : 0;
+        n += (size_t)snprintf(out + n, len - n, ", ");
+        n += (size_t)format_duration(out + n, len - n, left_min);
+        n += (size_t)snprintf(out + n, len - n, " left");
+    }
+    if (step->until != SCHEDULE_UNTIL_NONE && n < len) {
+        char temp[12];
+        temp_format_f(temp, sizeof(temp), step->until_temp);
+        n += (size_t)snprintf(out + n, len - n, ", until %s%s F",
+                              step->until == SCHEDULE_UNTIL_ABOVE ? ">=" : "<=", temp);
+    }
+    if (step->duration_min == 0 && step->until == SCHEDULE_UNTIL_NONE && n < len) {
+        n += (size_t)snprintf(out + n, len - n, ", holding");
+    }
+
+    xSemaphoreGive(s_mutex);
+    return (n < len) ? n : len - 1;
+}
+
+/**
+ * @brief "2h", "90m", "1h30m" -> minutes
+ */
+static bool parse_duration(const char* str, uint16_t* minutes)
+{
+    uint32_t total = 0;
+
+    if (*str == '\0') {
+        return false;
+    }
+    while (*str) {
+        if (!isdigit((unsigned char)*str)) {
+            return false;
+        }
+        uint32_t value = (uint32_t)strtoul(str, (char**)&str, 10);
+        char unit = (char)tolower((unsigned char)*str);
+        if (unit == 'h') {
+            value *= 60;
+        } else if (unit != 'm') {
+            return false;
+        }
+        str++;
+        total += value;
+        if (total > UINT16_MAX) {
+            return false;
+        }
+    }
+
+    *minutes = (uint16_t)total;
+    return total > 0;
+}
+
+/**
+ * @brief "180", "180F", "180.5f" -> temp_cc_t
+ */
+static bool parse_temp(const char* str, temp_cc_t* out)
+{
+    char buf[12];
+    size_t len = strlen(str);
+
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, str, len + 1);
+    if (buf[len - 1] == 'f' || buf[len - 1] == 'F') {
+        buf[len - 1] = '\0';
+    }
+
+    return temp_parse_f(buf, out) &&
+           *out >= TEMP_CC_FROM_F(32) && *out < CROCKPOT_SAFETY_TEMP;
+}
+
+/**
+ * @brief ">=180", "<=150F", or "180" (>=), with the operator optionally
+ *        a separate token
+ */
+static bool parse_condition(const char* op, const char* value, schedule_step_t* step)
+{
+    step->until = SCHEDULE_UNTIL_ABOVE;
+
+    if (op[0] == '>' || op[0] == '<') {
+        step->until = (op[0] == '<') ? SCHEDULE_UNTIL_BELOW : SCHEDULE_UNTIL_ABOVE;
+        op += (op[1] == '=') ? 2 : 1;
+        if (*op == '\0') {
+            op = value;     // "until >= 180"
+        }
+    }
+
+    temp_cc_t temp;
+    if (op == NULL || !parse_temp(op, &temp)) {
+        return false;
+    }
+    step->until_temp = temp;
+    return true;
+}
+
+/**
+ * @brief One "<state> [duration] [until <condition>]" segment
+ */
+static bool parse_step(char* segment, schedule_program_t* out)
+{
+    char* save = NULL;
+    char* token = strtok_r(segment, " \t", &save);
+
+    if (token == NULL || out->repeat) {
+        return false;   // Empty step, or a step after "repeat"
+    }
+    if (strcasecmp(token, "repeat") == 0) {
+        out->repeat = true;
+        return strtok_r(NULL, " \t", &save) == NULL;
+    }
+    if (out->count == SCHEDULE_MAX_STEPS) {
+        return false;
+    }
+
+    schedule_step_t* step = &out->steps[out->count];
+    crockpot_state_t state;
+    if (!crockpot_state_from_string(token, &state)) {
+        return false;
+    }
+    step->state = (uint8_t)state;
+
+    while ((token = strtok_r(NULL, " \t", &save)) != NULL) {
+        if (strcasecmp(token, "until") == 0) {
+            char* op = strtok_r(NULL, " \t", &save);
+            const char* value = NULL;
+            if (op == NULL || step->until != SCHEDULE_UNTIL_NONE) {
+                return false;
+            }
+            if ((op[0] == '>' || op[0] == '<') &&
+                op[(op[1] == '=') ? 2 : 1] == '\0') {
+                value = strtok_r(NULL, " \t", &save);
+            }
+            if (!parse_condition(op, value, step)) {
+                return false;
+            }
+        } else {
+            uint16_t minutes;
+            if (step->duration_min != 0 || !parse_duration(token, &minutes)) {
+                return false;
+            }
+            step->duration_min = minutes;
+        }
+    }
+
+    out->count++;
+    return true;
+}
+
+bool schedule_parse(const char* text, schedule_program_t* out)
+{
+    if (text == NULL || out == NULL) {
+        return false;
+    }
+    while (isspace((unsigned char)*text)) text++;
+
+    for (size_t i = 0; i < PRESET_COUNT; i++) {
+        if (strcasecmp(text, s_presets[i].name) == 0) {
+            *out = s_presets[i].program;
+            return true;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+
+    char segment[48];
+    const char* p = text;
+    while (*p) {
+        size_t n = 0;
+        while (*p && *p != ',' && !(p[0] == '-' && p[1] == '>')) {
+            if (n == sizeof(segment) - 1) {
+                return false;
+            }
+            segment[n++] = *p++;
+        }
+        segment[n] = '\0';
+        p += (*p == ',') ? 1 : (*p == '-') ? 2 : 0;
+
+        if (!parse_step(segment, out)) {
+            return false;
+        }
+    }
+
+    return program_valid(out);
+}
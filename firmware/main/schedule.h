@@ -0,0 +1,140 @@
+/**
+ * @file schedule.h
+ * @brief Multi-step cook programs ("HIGH 3h, LOW 6h, WARM")
+ *
+ * A program is a list of steps, each holding a crockpot state until its
+ * time runs out and/or a temperature condition is met. The engine keeps
+ * one esp_timer armed for the next step boundary (or progress checkpoint)
+ * and watches the filtered temperature through a crockpot listener, so
+ * nothing is polled from the control loop. Steps are evaluated, and
+ * progress saved, on the engine's own task.
+ *
+ * The program and the progress through it are kept in NVS. After a
+ * reboot the program resumes at the saved step with the saved elapsed
+ * time: time spent powered off does not count as cooking time, and at
+ * most SCHEDULE_CHECKPOINT_S of the current step is repeated.
+ *
+ * Changing the state by any other means (commands, buttons, the safety
+ * shutoff) stops the program. A program whose last step is timed turns
+ * the pot OFF when it ends; an untimed last step holds indefinitely.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crockpot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Step end condition besides the duration
+ */
+typedef enum {
+    SCHEDULE_UNTIL_NONE = 0,
+    SCHEDULE_UNTIL_ABOVE,       // Temperature >= until_temp
+    SCHEDULE_UNTIL_BELOW        // Temperature <= until_temp
+} schedule_until_t;
+
+/**
+ * @brief One program step (stored as-is in NVS)
+ *
+ * The step ends when duration_min passes or the condition is met,
+ * whichever comes first. With neither it never ends.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t state;              // crockpot_state_t
+    uint8_t until;              // schedule_until_t
+    uint16_t duration_min;      // 0 = no time limit
+    int32_t until_temp;         // temp_cc_t threshold
+} schedule_step_t;
+
+// Longest program
+#define SCHEDULE_MAX_STEPS      8
+
+/**
+ * @brief A complete program
+ */
+typedef struct {
+    uint8_t count;
+    bool repeat;                // Start over after the last step
+    schedule_step_t steps[SCHEDULE_MAX_STEPS];
+} schedule_program_t;
+
+/**
+ * @brief Load any saved program and resume it
+ *
+ * Call after crockpot_init() and nvs_flash_init().
+ *
+ * @return true on success (with or without a program to resume)
+ */
+bool schedule_init(void);
+
+/**
+ * @brief Parse a program from text
+ *
+ * Steps are separated by ',' or "->": a state, an optional duration
+ * ("2h", "90m", "1h30m") and an optional "until" condition (">=180",
+ * "<=150"; a bare temperature means >=). A final "repeat" loops the
+ * program. A preset name ("slowcook", "quickwarm", "allday") may be
+ * given instead.
+ *
+ * Example: "high until 180, low 6h, warm"
+ *
+ * @param text Program text
+ * @param out  Parsed program
+ * @return true if valid
+ */
+bool schedule_parse(const char* text, schedule_program_t* out);
+
+/**
+ * @brief Start a program from its first step (replaces any running one)
+ *
+ * @param program Program to run (copied)
+ * @return true on success, false if empty or the first state could not
+ *         be applied
+ */
+bool schedule_start(const schedule_program_t* program);
+
+/**
+ * @brief Stop the running program, leaving the current state as-is
+ */
+void schedule_stop(void);
+
+/**
+ * @brief Whether a program is running
+ */
+bool schedule_is_active(void);
+
+/**
+ * @brief Describe the running program and the current step
+ *
+ * @param out Buffer
+ * @param len Buffer size
+ * @return Characters written (excluding the terminator)
+ */
+size_t schedule_format_status(char* out, size_t len);
+
+// Progress is saved at least this often during a timed step
+#define SCHEDULE_CHECKPOINT_S   60
+
+// Retry delay when a step's state could not be applied
+#define SCHEDULE_RETRY_MS       1000
+
+// Engine task (step changes and progress saves)
+#define SCHEDULE_TASK_STACK_SIZE 3072
+#define SCHEDULE_TASK_PRIORITY   2
+
+// NVS namespace for the program and progress
+#define SCHEDULE_NVS_NAMESPACE  "schedule"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHEDULE_H
@@ -0,0 +1,41 @@
+/**
+ * @file spi_bus.c
+ * @brief Shared SPI bus setup
+ */
+
+#include "spi_bus.h"
+
+#include "esp_log.h"
+
+static const char* TAG = "spi_bus";
+
+static bool s_initialized = false;
+
+bool spi_bus_shared_init(void)
+{
+    if (s_initialized) {
+        return true;
+    }
+
+    ESP_LOGI(TAG, "Initializing shared SPI bus (CLK=%d, MISO=%d, MOSI=%d)",
+             SPI_BUS_PIN_CLK, SPI_BUS_PIN_MISO, SPI_BUS_PIN_MOSI);
+
+    spi_bus_config_t bus_cfg = {
+        .miso_io_num = SPI_BUS_PIN_MISO,
+        .mosi_io_num = SPI_BUS_PIN_MOSI,
+        .sclk_io_num = SPI_BUS_PIN_CLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = SPI_BUS_MAX_TRANSFER,
+    };
+
+    // DMA is needed for display band transfers
+    esp_err_t ret = spi_bus_initialize(SPI_BUS_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+        return false;
+    }
+
+    s_initialized = true;
+    return true;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file spi_bus.h
+ * @brief Shared SPI bus setup
+ *
+ * The ESP32-C3 has a single general-purpose SPI controller (SPI2), so the
+ * MAX31855 thermocouple interface and the TFT display share one bus.
+ * Each driver adds its own device (with its own CS line) after calling
+ * spi_bus_shared_init(); the SPI master driver arbitrates between them.
+ */
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <stdbool.h>
+#include "driver/spi_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the shared SPI bus
+ *
+ * Safe to call more than once; only the first call configures the bus.
+ * Call from app_main() context during initialization.
+ *
+ * @return true if the bus is ready
+ */
+bool spi_bus_shared_init(void);
+
+// Shared SPI bus configuration (XIAO ESP32-C3)
+// D8=GPIO8, D9=GPIO9, D10=GPIO10
+#define SPI_BUS_HOST        SPI2_HOST
+#define SPI_BUS_PIN_CLK     8   // D8 - SPI Clock
+#define SPI_BUS_PIN_MISO    9   // D9 - MISO (MAX31855 data)
+#define SPI_BUS_PIN_MOSI    10  // D10 - MOSI (display data)
+
+// Largest single DMA transfer (one display band, see display_hal)
+#define SPI_BUS_MAX_TRANSFER (320 * 20 * 2)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPI_BUS_H
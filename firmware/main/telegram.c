@@ -4,215 +4,357 @@
  */
 
 #include "telegram.h"
-#include "crockpot.h"
+#include "command.h"
+#include "config.h"
+#include "dlog.h"
+#include "fleet.h"
+#include "json_stream.h"
+#include "metrics.h"
+#include "power.h"
 #include "wifi.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_http_client.h"
 #include "esp_tls.h"
-#include "cJSON.h"
+#include "esp_crt_bundle.h"
 
 static const char* TAG = "telegram";
 
-// Bot token (loaded from NVS or hardcoded for development)
+// Bot token (from the settings store)
 static char s_bot_token[64] = "";
 
 // Last update ID for long polling
 static int64_t s_last_update_id = 0;
 
-// HTTP response buffer
-static char s_response_buffer[TELEGRAM_MAX_MESSAGE_LEN];
-static int s_response_len = 0;
+// Deepest JSON level whose key we track (message.chat.id is at 5)
+#define POLL_PATH_DEPTH 6
+#define POLL_KEY_LEN    16
+
+/**
+ * @brief The fields of one update that we act on
+ */
+typedef struct {
+    int64_t update_id;
+    int64_t chat_id;
+    bool has_chat;
+    char text[TELEGRAM_COMMAND_MAX_LEN];
+} telegram_update_t;
+
+/**
+ * @brief getUpdates response parser state
+ *
+ * The response is tokenized as it streams in; only update_id,
+ * message.chat.id and message.text are kept. getUpdates is asked for at
+ * most TELEGRAM_UPDATES_PER_POLL updates, so the array never overflows.
+ */
+typedef struct {
+    json_stream_t json;
+    char keys[POLL_PATH_DEPTH][POLL_KEY_LEN];   // Latest key at each depth
+    bool ok;
+    bool in_update;
+    telegram_update_t current;
+    telegram_update_t updates[TELEGRAM_UPDATES_PER_POLL];
+    uint8_t count;
+} telegram_poll_t;
+
+static telegram_poll_t s_poll;
+
+// sendMessage request body (sender task only)
+static char s_send_body[TELEGRAM_BATCH_MAX_LEN * 2 + 64];
 
 // Connection status
 static bool s_connected = false;
 
+// POWER_LOCK_TELEGRAM_POLL held for the current poll's connect/request
+static bool s_poll_boosted = false;
+
+/**
+ * @brief Long-lived HTTPS connection to the Bot API
+ *
+ * One per direction, so a reply never has to wait for (or tear down) the
+ * getUpdates long poll. The handle survives across requests: with
+ * HTTP/1.1 keep-alive the TCP/TLS connection is reused, and when it does
+ * drop the saved TLS session ticket makes the reconnect an abbreviated
+ * handshake.
+ */
+typedef struct {
+    const char* name;
+    esp_http_client_handle_t handle;
+    uint32_t backoff_ms;        // Next reconnect delay (poll direction)
+} telegram_conn_t;
+
+static telegram_conn_t s_poll_conn = { .name = "poll" };
+static telegram_conn_t s_send_conn = { .name = "send" };
+
+/**
+ * @brief Outbound message slot
+ *
+ * Fixed size so the queue can live in static storage; the sender task
+ * owns the send connection and drains the queue.
+ */
+typedef struct {
+    int64_t chat_id;
+    char text[TELEGRAM_OUTBOX_MSG_LEN];
+} telegram_outbound_t;
+
+static QueueHandle_t s_outbox = NULL;
+static StaticQueue_t s_outbox_struct;
+static uint8_t s_outbox_storage[TELEGRAM_OUTBOX_DEPTH * sizeof(telegram_outbound_t)];
+
+// Coalesced text for one sendMessage (sender task only)
+static char s_batch_text[TELEGRAM_BATCH_MAX_LEN];
+
+static void telegram_sender_task(void* pvParameters);
+
 // Telegram API base URL
 #define TELEGRAM_API_BASE "https://api.telegram.org/bot"
 
-// HTTP event handler
+static bool poll_key_is(const telegram_poll_t* p, uint8_t depth, const char* key)
+{
+    return depth < POLL_PATH_DEPTH && strcmp(p->keys[depth], key) == 0;
+}
+
+// Token callback for getUpdates: {"ok":true,"result":[{update}, ...]}
+static void poll_token_cb(json_token_t token, const char* value, uint8_t depth, void* ctx)
+{
+    telegram_poll_t* p = ctx;
+
+    switch (token) {
+        case JSON_KEY:
+            if (depth < POLL_PATH_DEPTH) {
+                strncpy(p->keys[depth], value, POLL_KEY_LEN - 1);
+                p->keys[depth][POLL_KEY_LEN - 1] = '\0';
+            }
+            return;
+
+        case JSON_OBJECT_START:
+        case JSON_ARRAY_START:
+            // Members of the new container start without a key
+            if (depth + 1 < POLL_PATH_DEPTH) {
+                p->keys[depth + 1][0] = '\0';
+            }
+            if (token == JSON_OBJECT_START && depth == 2 && poll_key_is(p, 1, "result")) {
+                memset(&p->current, 0, sizeof(p->current));
+                p->in_update = true;
+            }
+            return;
+
+        case JSON_OBJECT_END:
+            if (depth == 2 && p->in_update) {
+                p->in_update = false;
+                if (p->count < TELEGRAM_UPDATES_PER_POLL) {
+                    p->updates[p->count++] = p->current;
+                }
+            }
+            return;
+
+        case JSON_TRUE:
+            if (depth == 1 && poll_key_is(p, 1, "ok")) {
+                p->ok = true;
+            }
+            return;
+
+        default:
+            break;
+    }
+
+    if (!p->in_update) {
+        return;
+    }
+
+    if (token == JSON_NUMBER && depth == 3 && poll_key_is(p, 3, "update_id")) {
+        p->current.update_id = strtoll(value, NULL, 10);
+    } else if (token == JSON_NUMBER && depth == 5 && poll_key_is(p, 3, "message") &&
+               poll_key_is(p, 4, "chat") && poll_key_is(p, 5, "id")) {
+        p->current.chat_id = strtoll(value, NULL, 10);
+        p->current.has_chat = true;
+    } else if (token == JSON_STRING && depth == 4 && poll_key_is(p, 3, "message") &&
+               poll_key_is(p, 4, "text")) {
+        strncpy(p->current.text, value, sizeof(p->current.text) - 1);
+        p->current.text[sizeof(p->current.text) - 1] = '\0';
+    }
+}
+
+static void poll_reset(void)
+{
+    memset(&s_poll, 0, sizeof(s_poll));
+    json_stream_init(&s_poll.json, poll_token_cb, &s_poll);
+}
+
+// HTTP event handler: response bytes go straight into the tokenizer
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
     switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            if (s_response_len + evt->data_len < sizeof(s_response_buffer) - 1) {
-                memcpy(s_response_buffer + s_response_len, evt->data, evt->data_len);
-                s_response_len += evt->data_len;
-                s_response_buffer[s_response_len] = '\0';
+        case HTTP_EVENT_HEADERS_SENT:
+            // Connected (any TLS handshake is done) and the request is
+            // out; the long wait for the response can run at low clock
+            if (s_poll_boosted) {
+                power_release(POWER_LOCK_TELEGRAM_POLL);
+                s_poll_boosted = false;
             }
             break;
+        case HTTP_EVENT_ON_DATA:
+            json_stream_feed(&s_poll.json, evt->data, evt->data_len);
+            break;
         default:
             break;
     }
     return ESP_OK;
 }
 
-// Build status message
-static void build_status_message(char* buf, size_t buf_len)
+// Create the connection's client on first use
+static bool conn_open(telegram_conn_t* conn, const char* url, int timeout_ms,
+                      http_event_handle_cb handler)
 {
-    crockpot_status_t status = crockpot_get_status();
-
-    snprintf(buf, buf_len,
-        "Crockpot Status:\n"
-        "State: %s\n"
-        "Temperature: %.1f F\n"
-        "Uptime: %lu seconds\n"
-        "WiFi: %s\n"
-        "Sensor: %s",
-        crockpot_state_to_string(status.state),
-        status.temperature_f,
-        (unsigned long)status.uptime_seconds,
-        status.wifi_connected ? "Connected" : "Disconnected",
-        status.sensor_error ? "ERROR" : "OK"
-    );
+    if (conn->handle != NULL) {
+        return true;
+    }
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = handler,
+        .timeout_ms = timeout_ms,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .keep_alive_enable = true,      // TCP probes catch a dead link mid long-poll
+        .save_client_session = true,    // Resume TLS with a session ticket
+    };
+
+    conn->handle = esp_http_client_init(&config);
+    if (conn->handle == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s HTTP client", conn->name);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Created %s connection", conn->name);
+    return true;
 }
 
-// Build help message
-static void build_help_message(char* buf, size_t buf_len)
+// Drop the socket after an error; the handle and TLS session are kept
+static void conn_reset(telegram_conn_t* conn)
 {
-    snprintf(buf, buf_len,
-        "IoT Crockpot Commands:\n"
-        "/status - Show current status\n"
-        "/off - Turn off\n"
-        "/warm - Set to warm\n"
-        "/low - Set to low\n"
-        "/high - Set to high\n"
-        "/help - Show this help"
-    );
+    if (conn->handle != NULL) {
+        esp_http_client_close(conn->handle);
+    }
 }
 
-// Process a command and return response
-static void process_command(const char* command, int64_t chat_id)
+// Exponential reconnect backoff, reset by conn_succeeded()
+static void conn_backoff(telegram_conn_t* conn)
 {
-    char response[512];
+    if (conn->backoff_ms == 0) {
+        conn->backoff_ms = TELEGRAM_BACKOFF_MIN_MS;
+    }
 
-    ESP_LOGI(TAG, "Processing command: %s", command);
+    ESP_LOGW(TAG, "%s connection retry in %lu ms", conn->name, (unsigned long)conn->backoff_ms);
+    vTaskDelay(pdMS_TO_TICKS(conn->backoff_ms));
 
-    if (strcmp(command, "/status") == 0 || strcmp(command, "/start") == 0) {
-        build_status_message(response, sizeof(response));
-    }
-    else if (strcmp(command, "/off") == 0) {
-        if (crockpot_set_state(CROCKPOT_OFF)) {
-            snprintf(response, sizeof(response), "Crockpot turned OFF");
-        } else {
-            snprintf(response, sizeof(response), "Failed to turn off crockpot");
-        }
-    }
-    else if (strcmp(command, "/warm") == 0) {
-        if (crockpot_set_state(CROCKPOT_WARM)) {
-            snprintf(response, sizeof(response), "Crockpot set to WARM");
-        } else {
-            snprintf(response, sizeof(response), "Failed to set crockpot to warm");
-        }
+    conn->backoff_ms *= 2;
+    if (conn->backoff_ms > TELEGRAM_BACKOFF_MAX_MS) {
+        conn->backoff_ms = TELEGRAM_BACKOFF_MAX_MS;
     }
-    else if (strcmp(command, "/low") == 0) {
-        if (crockpot_set_state(CROCKPOT_LOW)) {
-            snprintf(response, sizeof(response), "Crockpot set to LOW");
-        } else {
-            snprintf(response, sizeof(response), "Failed to set crockpot to low");
+}
+
+static void conn_succeeded(telegram_conn_t* conn)
+{
+    conn->backoff_ms = 0;
+}
+
+// Whether chat_id is listed in TELEGRAM_ADMIN_CHATS
+static bool chat_is_admin(int64_t chat_id)
+{
+    const char* p = TELEGRAM_ADMIN_CHATS;
+    while (*p != '\0') {
+        char* end;
+        long long id = strtoll(p, &end, 10);
+        if (end == p) {
+            p++;  // Skip separators
+            continue;
         }
-    }
-    else if (strcmp(command, "/high") == 0) {
-        if (crockpot_set_state(CROCKPOT_HIGH)) {
-            snprintf(response, sizeof(response), "Crockpot set to HIGH");
-        } else {
-            snprintf(response, sizeof(response), "Failed to set crockpot to high");
+        if (id == chat_id) {
+            return true;
         }
+        p = end;
     }
-    else if (strcmp(command, "/help") == 0) {
-        build_help_message(response, sizeof(response));
-    }
-    else {
-        snprintf(response, sizeof(response),
-            "Unknown command: %s\nType /help for available commands.", command);
-    }
-
-    telegram_send_message(chat_id, response);
+    return false;
 }
 
-// Process updates from Telegram
-static void process_updates(const char* json_response)
+// Run a command and queue the reply
+static void process_command(const char* command, int64_t chat_id)
 {
-    cJSON* root = cJSON_Parse(json_response);
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON response");
-        return;
-    }
+    char response[TELEGRAM_OUTBOX_MSG_LEN];
 
-    cJSON* ok = cJSON_GetObjectItem(root, "ok");
-    if (!cJSON_IsTrue(ok)) {
-        ESP_LOGE(TAG, "Telegram API error");
-        cJSON_Delete(root);
-        return;
-    }
+    DLOG_TEXT(ESP_LOG_INFO, TAG, "Processing command: %s", command);
 
-    cJSON* result = cJSON_GetObjectItem(root, "result");
-    if (!cJSON_IsArray(result)) {
-        cJSON_Delete(root);
+    command_access_t access = chat_is_admin(chat_id) ? COMMAND_ACCESS_ADMIN : COMMAND_ACCESS_USER;
+    command_execute(command, access, response, sizeof(response));
+    telegram_send_message(chat_id, response);
+}
+
+// Act on the updates collected by the last poll
+static void process_updates(void)
+{
+    if (s_poll.json.error || !s_poll.ok) {
+        ESP_LOGE(TAG, "Telegram API error or malformed response");
         return;
     }
 
-    cJSON* update;
-    cJSON_ArrayForEach(update, result) {
-        // Get update ID
-        cJSON* update_id = cJSON_GetObjectItem(update, "update_id");
-        if (cJSON_IsNumber(update_id)) {
-            s_last_update_id = (int64_t)update_id->valuedouble + 1;
-        }
+    for (uint8_t i = 0; i < s_poll.count; i++) {
+        const telegram_update_t* update = &s_poll.updates[i];
 
-        // Get message
-        cJSON* message = cJSON_GetObjectItem(update, "message");
-        if (message == NULL) {
-            continue;
+        if (update->update_id >= s_last_update_id) {
+            s_last_update_id = update->update_id + 1;
         }
 
-        // Get chat ID
-        cJSON* chat = cJSON_GetObjectItem(message, "chat");
-        cJSON* chat_id = cJSON_GetObjectItem(chat, "id");
-        if (!cJSON_IsNumber(chat_id)) {
+        // Commands start with '/'; command_execute() drops any @botname
+        if (!update->has_chat || update->text[0] != '/') {
             continue;
         }
-        int64_t chat_id_val = (int64_t)chat_id->valuedouble;
-
-        // Get text
-        cJSON* text = cJSON_GetObjectItem(message, "text");
-        if (cJSON_IsString(text) && text->valuestring != NULL) {
-            // Check if it's a command (starts with /)
-            if (text->valuestring[0] == '/') {
-                // Extract command (remove @botname if present)
-                char command[64];
-                strncpy(command, text->valuestring, sizeof(command) - 1);
-                command[sizeof(command) - 1] = '\0';
-
-                char* at_sign = strchr(command, '@');
-                if (at_sign) {
-                    *at_sign = '\0';
-                }
 
-                process_command(command, chat_id_val);
-            }
-        }
+        process_command(update->text, update->chat_id);
     }
-
-    cJSON_Delete(root);
 }
 
 bool telegram_init(void)
 {
     ESP_LOGI(TAG, "Initializing Telegram interface");
 
-    // TODO: Load token from NVS
-    // For now, check if token is set
+    const config_t* config = config_acquire();
+    if (config->saved & CONFIG_SECTION_TELEGRAM) {
+        strncpy(s_bot_token, config->telegram_token, sizeof(s_bot_token) - 1);
+        s_bot_token[sizeof(s_bot_token) - 1] = '\0';
+    }
+    config_release();
+
     if (strlen(s_bot_token) == 0) {
         ESP_LOGW(TAG, "Telegram bot token not configured");
-        ESP_LOGW(TAG, "Set token using telegram_set_token() or configure in NVS");
+        ESP_LOGW(TAG, "Set token using telegram_set_token()");
         return false;
     }
 
+    if (s_outbox == NULL) {
+        s_outbox = xQueueCreateStatic(TELEGRAM_OUTBOX_DEPTH, sizeof(telegram_outbound_t),
+                                      s_outbox_storage, &s_outbox_struct);
+
+        BaseType_t ret = xTaskCreate(
+            telegram_sender_task,
+            "tg_sender",
+            TELEGRAM_SENDER_STACK_SIZE,
+            NULL,
+            TELEGRAM_SENDER_PRIORITY,
+            NULL
+        );
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create sender task");
+            return false;
+        }
+    }
+
     ESP_LOGI(TAG, "Telegram interface initialized");
     return true;
 }
@@ -222,9 +364,7 @@ void telegram_task(void* pvParameters)
     ESP_LOGI(TAG, "Telegram task started");
 
     // Wait for WiFi connection
-    while (!wifi_is_connected()) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
+    wifi_wait_online();
 
     // Check if token is configured
     if (strlen(s_bot_token) == 0) {
@@ -238,100 +378,196 @@ void telegram_task(void* pvParameters)
         // Wait for WiFi if disconnected
         if (!wifi_is_connected()) {
             s_connected = false;
-            vTaskDelay(pdMS_TO_TICKS(TELEGRAM_RETRY_INTERVAL_MS));
+            conn_reset(&s_poll_conn);
+            wifi_wait_online();
+            continue;
+        }
+
+        // In a fleet only the coordinator polls the bot
+        if (!fleet_is_coordinator()) {
+            s_connected = false;
+            conn_reset(&s_poll_conn);
+            fleet_wait_coordinator();
             continue;
         }
 
         // Build getUpdates URL
         snprintf(url, sizeof(url),
-            TELEGRAM_API_BASE "%s/getUpdates?timeout=%d&offset=%lld",
-            s_bot_token, TELEGRAM_POLL_TIMEOUT_S, (long long)s_last_update_id);
-
-        // Configure HTTP client
-        esp_http_client_config_t config = {
-            .url = url,
-            .event_handler = http_event_handler,
-            .timeout_ms = (TELEGRAM_POLL_TIMEOUT_S + 5) * 1000,
-        };
-
-        esp_http_client_handle_t client = esp_http_client_init(&config);
-        if (client == NULL) {
-            ESP_LOGE(TAG, "Failed to create HTTP client");
-            vTaskDelay(pdMS_TO_TICKS(TELEGRAM_RETRY_INTERVAL_MS));
+            TELEGRAM_API_BASE "%s/getUpdates?timeout=%d&limit=%d&offset=%lld",
+            s_bot_token, TELEGRAM_POLL_TIMEOUT_S, TELEGRAM_UPDATES_PER_POLL,
+            (long long)s_last_update_id);
+
+        if (!conn_open(&s_poll_conn, url, (TELEGRAM_POLL_TIMEOUT_S + 5) * 1000,
+                       http_event_handler)) {
+            conn_backoff(&s_poll_conn);
             continue;
         }
 
-        // Reset response buffer
-        s_response_len = 0;
-        s_response_buffer[0] = '\0';
+        // Same host every time, so the open connection is kept
+        esp_http_client_set_url(s_poll_conn.handle, url);
+
+        // Fresh parser for this response
+        poll_reset();
 
         // Perform request
-        esp_err_t err = esp_http_client_perform(client);
+        int64_t start_us = esp_timer_get_time();
+        power_acquire(POWER_LOCK_TELEGRAM_POLL);
+        s_poll_boosted = true;
+        esp_err_t err = esp_http_client_perform(s_poll_conn.handle);
+        if (s_poll_boosted) {
+            power_release(POWER_LOCK_TELEGRAM_POLL);
+            s_poll_boosted = false;
+        }
+        metrics_observe(METRIC_TELEGRAM_POLL_MS,
+                        (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+
         if (err == ESP_OK) {
-            int status_code = esp_http_client_get_status_code(client);
+            int status_code = esp_http_client_get_status_code(s_poll_conn.handle);
             if (status_code == 200) {
                 s_connected = true;
-                process_updates(s_response_buffer);
+                conn_succeeded(&s_poll_conn);
+                process_updates();
             } else {
                 ESP_LOGW(TAG, "HTTP error: %d", status_code);
+                metrics_count(METRIC_TELEGRAM_POLL_FAILURES, 1);
                 s_connected = false;
+                conn_reset(&s_poll_conn);
+                conn_backoff(&s_poll_conn);
             }
         } else {
             ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+            metrics_count(METRIC_TELEGRAM_POLL_FAILURES, 1);
             s_connected = false;
+            conn_reset(&s_poll_conn);
+            conn_backoff(&s_poll_conn);
         }
-
-        esp_http_client_cleanup(client);
-
-        // Small delay between polls
-        vTaskDelay(pdMS_TO_TICKS(100));
     }
 }
 
-bool telegram_send_message(int64_t chat_id, const char* message)
+// Blocking sendMessage over the send connection (sender task only)
+static bool post_message(int64_t chat_id, const char* message)
 {
-    if (strlen(s_bot_token) == 0) {
-        return false;
-    }
-
     char url[256];
     snprintf(url, sizeof(url), TELEGRAM_API_BASE "%s/sendMessage", s_bot_token);
 
-    // Build JSON body
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "chat_id", (double)chat_id);
-    cJSON_AddStringToObject(root, "text", message);
-
-    char* json_body = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+    // Build JSON body; leave room for the closing quote and brace
+    size_t len = (size_t)snprintf(s_send_body, sizeof(s_send_body),
+                                  "{\"chat_id\":%lld,\"text\":\"", (long long)chat_id);
+    len += json_escape_string(s_send_body + len, sizeof(s_send_body) - len - 2, message);
+    memcpy(s_send_body + len, "\"}", 3);
+    len += 2;
 
-    if (json_body == NULL) {
+    if (!conn_open(&s_send_conn, url, 10000, NULL)) {
         return false;
     }
 
-    // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_POST,
-        .timeout_ms = 10000,
-    };
+    esp_http_client_set_url(s_send_conn.handle, url);
+    esp_http_client_set_method(s_send_conn.handle, HTTP_METHOD_POST);
+    esp_http_client_set_header(s_send_conn.handle, "Content-Type", "application/json");
+    esp_http_client_set_post_field(s_send_conn.handle, s_send_body, len);
+
+    // Replies are short; run the whole exchange at full clock
+    power_acquire(POWER_LOCK_TELEGRAM_SEND);
+
+    // An idle keep-alive connection may have been closed by the server;
+    // reconnect once (resuming the TLS session) before giving up
+    esp_err_t err = esp_http_client_perform(s_send_conn.handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "sendMessage failed (%s), reconnecting", esp_err_to_name(err));
+        conn_reset(&s_send_conn);
+        err = esp_http_client_perform(s_send_conn.handle);
+    }
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        free(json_body);
-        return false;
+    power_release(POWER_LOCK_TELEGRAM_SEND);
+
+    bool success = (err == ESP_OK &&
+                    esp_http_client_get_status_code(s_send_conn.handle) == 200);
+    if (!success) {
+        conn_reset(&s_send_conn);
     }
 
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_post_field(client, json_body, strlen(json_body));
+    return success;
+}
 
-    esp_err_t err = esp_http_client_perform(client);
-    bool success = (err == ESP_OK && esp_http_client_get_status_code(client) == 200);
+/**
+ * @brief Append queued replies for the same chat that arrive in the window
+ *
+ * Stops at the first message for another chat (left queued, so order is
+ * kept) or when the batch is full.
+ */
+static void coalesce_replies(int64_t chat_id, size_t* len)
+{
+    static telegram_outbound_t next;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)TELEGRAM_COALESCE_MS * 1000;
 
-    esp_http_client_cleanup(client);
-    free(json_body);
+    while (1) {
+        int64_t remaining_us = deadline_us - esp_timer_get_time();
+        TickType_t wait = remaining_us > 0 ? pdMS_TO_TICKS(remaining_us / 1000) : 0;
 
-    return success;
+        if (xQueuePeek(s_outbox, &next, wait) != pdTRUE || next.chat_id != chat_id) {
+            return;
+        }
+
+        size_t add = strlen(next.text);
+        if (*len + 2 + add >= sizeof(s_batch_text)) {
+            return;
+        }
+
+        xQueueReceive(s_outbox, &next, 0);
+        memcpy(s_batch_text + *len, "\n\n", 2);
+        memcpy(s_batch_text + *len + 2, next.text, add + 1);
+        *len += 2 + add;
+    }
+}
+
+static void telegram_sender_task(void* pvParameters)
+{
+    (void)pvParameters;
+    static telegram_outbound_t msg;
+
+    ESP_LOGI(TAG, "Sender task started");
+
+    while (1) {
+        xQueueReceive(s_outbox, &msg, portMAX_DELAY);
+
+        size_t len = strlen(msg.text);
+        memcpy(s_batch_text, msg.text, len + 1);
+        coalesce_replies(msg.chat_id, &len);
+
+        for (int attempt = 1; ; attempt++) {
+            wifi_wait_online();
+
+            if (post_message(msg.chat_id, s_batch_text)) {
+                conn_succeeded(&s_send_conn);
+                break;
+            }
+
+            if (attempt >= TELEGRAM_SEND_ATTEMPTS) {
+                ESP_LOGE(TAG, "Dropping reply to chat %lld after %d attempts",
+                         (long long)msg.chat_id, attempt);
+                break;
+            }
+            conn_backoff(&s_send_conn);
+        }
+    }
+}
+
+bool telegram_send_message(int64_t chat_id, const char* message)
+{
+    if (s_outbox == NULL || message == NULL) {
+        return false;
+    }
+
+    telegram_outbound_t slot = { .chat_id = chat_id };
+    strncpy(slot.text, message, sizeof(slot.text) - 1);
+    slot.text[sizeof(slot.text) - 1] = '\0';
+
+    // Never block the caller on outbound I/O
+    if (xQueueSend(s_outbox, &slot, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Outbox full - dropping reply to chat %lld", (long long)chat_id);
+        return false;
+    }
+    return true;
 }
 
 bool telegram_is_connected(void)
@@ -348,7 +584,10 @@ bool telegram_set_token(const char* token)
     strncpy(s_bot_token, token, sizeof(s_bot_token) - 1);
     s_bot_token[sizeof(s_bot_token) - 1] = '\0';
 
-    // TODO: Store in NVS
+    config_t* config = config_edit();
+    strncpy(config->telegram_token, token, sizeof(config->telegram_token) - 1);
+    config_commit(CONFIG_SECTION_TELEGRAM);
+
     ESP_LOGI(TAG, "Bot token set");
     return true;
 }
@@ -19,7 +19,7 @@ extern "C" {
 /**
  * @brief Initialize Telegram bot interface
  *
- * Loads bot token from NVS and prepares HTTP client.
+ * Loads the bot token from the settings store and prepares the HTTP client.
  *
  * @return true on success, false if token not configured
  */
@@ -31,7 +31,9 @@ bool telegram_init(void);
  * FreeRTOS task that handles:
  * - Long polling for updates (getUpdates)
  * - Command parsing
- * - Response sending (sendMessage)
+ *
+ * Replies are queued and sent (sendMessage) by a separate sender task
+ * started from telegram_init(), so polling never waits on outbound I/O.
  *
  * @param pvParameters Task parameters (unused)
  */
@@ -40,9 +42,14 @@ void telegram_task(void* pvParameters);
 /**
  * @brief Send a message to a specific chat
  *
+ * Non-blocking: copies the message into the outbound queue, which a
+ * sender task drains over its own persistent connection. Replies to the
+ * same chat queued within TELEGRAM_COALESCE_MS go out as one message.
+ * Messages longer than TELEGRAM_OUTBOX_MSG_LEN are truncated.
+ *
  * @param chat_id Telegram chat ID
  * @param message Message text to send
- * @return true on success
+ * @return true if queued, false if the queue is full or not initialized
  */
 bool telegram_send_message(int64_t chat_id, const char* message);
 
@@ -56,7 +63,7 @@ bool telegram_is_connected(void);
 /**
  * @brief Set Telegram bot token
  *
- * Stores token in NVS for persistent storage.
+ * Saved in the settings store; takes effect at the next telegram_init().
  *
  * @param token Bot token from @BotFather
  * @return true on success
@@ -66,11 +73,32 @@ bool telegram_set_token(const char* token);
 // Long polling timeout in seconds
 #define TELEGRAM_POLL_TIMEOUT_S 30
 
-// Update check interval when WiFi is disconnected
-#define TELEGRAM_RETRY_INTERVAL_MS 10000
+// Reconnect backoff after API/connection errors (doubles up to the max)
+#define TELEGRAM_BACKOFF_MIN_MS 1000
+#define TELEGRAM_BACKOFF_MAX_MS 60000
+
+// Updates requested per getUpdates (the parser keeps this many)
+#define TELEGRAM_UPDATES_PER_POLL 8
+
+// Chats allowed to run admin commands such as /update
+// (comma-separated chat IDs; "" = none)
+#define TELEGRAM_ADMIN_CHATS ""
+
+// Longest command text kept from an incoming message (fits "/update <url> <sha256>")
+#define TELEGRAM_COMMAND_MAX_LEN 256
+
+// Outbound queue: slots, bytes per slot, and the coalescing window
+#define TELEGRAM_OUTBOX_DEPTH    8
+#define TELEGRAM_OUTBOX_MSG_LEN  512
+#define TELEGRAM_COALESCE_MS     300
+#define TELEGRAM_BATCH_MAX_LEN   1536
+
+// Delivery attempts per outbound message before it is dropped
+#define TELEGRAM_SEND_ATTEMPTS   3
 
-// Maximum message length
-#define TELEGRAM_MAX_MESSAGE_LEN 4096
+// Sender task
+#define TELEGRAM_SENDER_STACK_SIZE 8192
+#define TELEGRAM_SENDER_PRIORITY   3
 
 #ifdef __cplusplus
 }
@@ -4,13 +4,25 @@
  *
  * SPI driver for MAX31855 thermocouple-to-digital converter.
  * Reads K-type thermocouple temperature with 0.25C resolution.
+ *
+ * An acquisition task samples at the converter's rate (10 Hz). Each good
+ * sample goes through a median-of-N spike filter and then a fixed-point
+ * EMA; the result is published for temperature_read().
  */
 
 #include "temperature.h"
-
+#include "dlog.h"
+#include "spi_bus.h"
+#include "metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char* TAG = "temperature";
 
@@ -20,27 +32,215 @@ static spi_device_handle_t s_spi_handle = NULL;
 // Sensor initialized flag
 static bool s_initialized = false;
 
-// Last fault code for diagnostics
-static uint8_t s_last_fault = 0;
+// Latest filtered reading and the time of its last good sample, published
+// together by the acquisition task
+static temperature_reading_t s_latest;
+static int64_t s_last_good_us = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Last fault logged, for the "cleared" message (acquisition task only)
+static uint8_t s_logged_fault = 0;
+
+/**
+ * @brief Read and decode one conversion
+ *
+ * @param tc_q  Thermocouple temperature, 0.25 C units
+ * @param cj_q  Cold junction temperature, 0.0625 C units
+ * @return Fault bits (0 = good sample)
+ */
+static uint8_t read_sample(int16_t* tc_q, int16_t* cj_q)
+{
+    // A 32-bit read is over in ~8 us at 4 MHz, far less than interrupt
+    // and task-switch overhead, so use a polling transaction. The data
+    // lands in the transaction itself, since the shared bus uses DMA and
+    // a stack buffer may not be DMA-capable.
+    spi_transaction_t trans = {
+        .flags = SPI_TRANS_USE_RXDATA,
+        .length = 32,
+        .tx_buffer = NULL,
+    };
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = spi_device_polling_transmit(s_spi_handle, &trans);
+    metrics_observe(METRIC_SPI_READ_US, (uint32_t)(esp_timer_get_time() - start_us));
+
+    if (err != ESP_OK) {
+        metrics_count(METRIC_SPI_READ_ERRORS, 1);
+        return TEMPERATURE_FAULT_BUS;
+    }
+
+    // Assemble 32-bit value (MSB first)
+    const uint8_t* rx_data = trans.rx_data;
+    uint32_t raw = ((uint32_t)rx_data[0] << 24) |
+                   ((uint32_t)rx_data[1] << 16) |
+                   ((uint32_t)rx_data[2] << 8) |
+                   (uint32_t)rx_data[3];
+
+    // Fault bit (bit 16); type in bits 0-2
+    if (raw & 0x00010000) {
+        uint8_t fault = raw & 0x07;
+        return fault ? fault : TEMPERATURE_FAULT_OPEN;
+    }
+
+    // Thermocouple temperature (bits 31-18, 14-bit signed, 0.25C per LSB)
+    int16_t tc_raw = (raw >> 18) & 0x3FFF;
+    if (tc_raw & 0x2000) {
+        tc_raw |= 0xC000;
+    }
+
+    // Cold junction temperature (bits 15-4, 12-bit signed, 0.0625C per LSB)
+    int16_t cj_raw = (raw >> 4) & 0x0FFF;
+    if (cj_raw & 0x0800) {
+        cj_raw |= 0xF000;
+    }
+
+    *tc_q = tc_raw;
+    *cj_q = cj_raw;
+    return 0;
+}
+
+/**
+ * @brief Log a fault at most every TEMPERATURE_FAULT_LOG_INTERVAL_MS per kind
+ *
+ * Called for every sample; repeats in between are only counted.
+ */
+static void log_fault(uint8_t fault)
+{
+    if (fault == 0) {
+        if (s_logged_fault != 0) {
+            DLOGI(TAG, "Thermocouple fault cleared");
+            s_logged_fault = 0;
+        }
+        return;
+    }
+    s_logged_fault = fault;
+
+    if (fault & TEMPERATURE_FAULT_BUS) {
+        DLOG_LIMIT(ESP_LOG_ERROR, TEMPERATURE_FAULT_LOG_INTERVAL_MS, TAG,
+                   "SPI transaction failed");
+    }
+    if (fault & TEMPERATURE_FAULT_OPEN) {
+        DLOG_LIMIT(ESP_LOG_ERROR, TEMPERATURE_FAULT_LOG_INTERVAL_MS, TAG,
+                   "Thermocouple fault: Open circuit (no probe connected)");
+    }
+    if (fault & TEMPERATURE_FAULT_SHORT_GND) {
+        DLOG_LIMIT(ESP_LOG_ERROR, TEMPERATURE_FAULT_LOG_INTERVAL_MS, TAG,
+                   "Thermocouple fault: Short to GND");
+    }
+    if (fault & TEMPERATURE_FAULT_SHORT_VCC) {
+        DLOG_LIMIT(ESP_LOG_ERROR, TEMPERATURE_FAULT_LOG_INTERVAL_MS, TAG,
+                   "Thermocouple fault: Short to VCC");
+    }
+}
+
+static int16_t median(const int16_t* samples, uint8_t count)
+{
+    int16_t sorted[TEMPERATURE_MEDIAN_N];
+    memcpy(sorted, samples, count * sizeof(sorted[0]));
+
+    // Insertion sort; N is tiny
+    for (uint8_t i = 1; i < count; i++) {
+        int16_t v = sorted[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[count / 2];
+}
+
+static void temperature_task(void* pvParameters)
+{
+    const uint32_t samples_per_s = 1000 / TEMPERATURE_SAMPLE_INTERVAL_MS;
+
+    int16_t window[TEMPERATURE_MEDIAN_N];
+    uint8_t window_count = 0;
+    uint8_t window_pos = 0;
+
+    int32_t ema_q8 = 0;             // 0.25 C units, Q8
+    bool primed = false;
+    int16_t cj_q = 0;
+    int64_t last_good_us = 0;
+
+    // Once-per-second EMA snapshots for the slope estimate
+    int32_t slope_hist[TEMPERATURE_SLOPE_WINDOW_S + 1];
+    uint8_t slope_count = 0;
+    uint8_t slope_pos = 0;
+    uint32_t sample_index = 0;
+
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    while (1) {
+        int16_t tc_q;
+        int16_t sample_cj_q;
+        uint8_t fault = read_sample(&tc_q, &sample_cj_q);
+        int64_t now_us = esp_timer_get_time();
+
+        log_fault(fault);
+
+        if (fault == 0) {
+            window[window_pos] = tc_q;
+            window_pos = (window_pos + 1) % TEMPERATURE_MEDIAN_N;
+            if (window_count < TEMPERATURE_MEDIAN_N) {
+                window_count++;
+            }
+
+            int32_t filtered_q8 = (int32_t)median(window, window_count) << 8;
+            if (!primed) {
+                ema_q8 = filtered_q8;
+                primed = true;
+            } else {
+                ema_q8 += (filtered_q8 - ema_q8) >> TEMPERATURE_EMA_SHIFT;
+            }
+            cj_q = sample_cj_q;
+            last_good_us = now_us;
+        }
+
+        int32_t slope_cc_per_min = 0;
+        if (primed && (sample_index % samples_per_s) == 0) {
+            slope_hist[slope_pos] = ema_q8;
+            slope_pos = (slope_pos + 1) % (TEMPERATURE_SLOPE_WINDOW_S + 1);
+            if (slope_count < TEMPERATURE_SLOPE_WINDOW_S + 1) {
+                slope_count++;
+            }
+        }
+        if (slope_count > 1) {
+            // Oldest snapshot vs newest, (slope_count - 1) seconds apart
+            uint8_t oldest = (slope_pos + (TEMPERATURE_SLOPE_WINDOW_S + 1) - slope_count) %
+                             (TEMPERATURE_SLOPE_WINDOW_S + 1);
+            int32_t delta_cc = ((ema_q8 - slope_hist[oldest]) * TEMP_CC_FROM_Q(1)) >> 8;
+            slope_cc_per_min = delta_cc * 60 / (slope_count - 1);
+        }
+        sample_index++;
+
+        temperature_reading_t reading = {
+            .temperature = (ema_q8 * TEMP_CC_FROM_Q(1) + 128) >> 8,
+            .raw_q = (int16_t)((ema_q8 + 128) >> 8),
+            .cold_junction = cj_q * 25 / 4,     // 0.0625 C = 6.25 units
+            .slope_cc_per_min = slope_cc_per_min,
+            .fault = fault,
+            .valid = primed &&
+                     now_us - last_good_us < (int64_t)TEMPERATURE_STALE_MS * 1000,
+        };
+
+        portENTER_CRITICAL(&s_lock);
+        s_latest = reading;
+        s_last_good_us = last_good_us;
+        portEXIT_CRITICAL(&s_lock);
+
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(TEMPERATURE_SAMPLE_INTERVAL_MS));
+    }
+}
 
 bool temperature_init(void)
 {
     ESP_LOGI(TAG, "Initializing MAX31855 on SPI (CS=%d, CLK=%d, MISO=%d)",
              MAX31855_PIN_CS, MAX31855_PIN_CLK, MAX31855_PIN_MISO);
 
-    // Configure SPI bus
-    spi_bus_config_t bus_cfg = {
-        .miso_io_num = MAX31855_PIN_MISO,
-        .mosi_io_num = -1,  // Not used (read-only device)
-        .sclk_io_num = MAX31855_PIN_CLK,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = 4,
-    };
-
-    esp_err_t ret = spi_bus_initialize(MAX31855_SPI_HOST, &bus_cfg, SPI_DMA_DISABLED);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+    // MAX31855 shares the SPI bus with the display
+    if (!spi_bus_shared_init()) {
         return false;
     }
 
@@ -53,127 +253,113 @@ bool temperature_init(void)
         .flags = 0,
     };
 
-    ret = spi_bus_add_device(MAX31855_SPI_HOST, &dev_cfg, &s_spi_handle);
+    esp_err_t ret = spi_bus_add_device(MAX31855_SPI_HOST, &dev_cfg, &s_spi_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
-        spi_bus_free(MAX31855_SPI_HOST);
         return false;
     }
 
-    s_initialized = true;
-    ESP_LOGI(TAG, "MAX31855 thermocouple sensor initialized");
-
     // Perform initial read to verify communication
-    temperature_reading_t reading = temperature_read();
-    if (reading.valid) {
-        ESP_LOGI(TAG, "Initial reading: %.1f C (%.1f F)",
-                 reading.temperature_c, reading.temperature_f);
+    int16_t tc_q, cj_q;
+    uint8_t fault = read_sample(&tc_q, &cj_q);
+    if (fault == 0) {
+        char tc_str[12];
+        char cj_str[12];
+        temp_format_c(tc_str, sizeof(tc_str), TEMP_CC_FROM_Q(tc_q));
+        temp_format_c(cj_str, sizeof(cj_str), cj_q * 25 / 4);
+        ESP_LOGI(TAG, "Initial reading: %s C (cold junction %s C)", tc_str, cj_str);
     } else {
         ESP_LOGW(TAG, "Initial reading failed - check thermocouple connection");
+        log_fault(fault);
     }
 
+    if (xTaskCreate(temperature_task, "temperature", TEMPERATURE_TASK_STACK_SIZE,
+                    NULL, TEMPERATURE_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create acquisition task");
+        return false;
+    }
+
+    s_initialized = true;
+    ESP_LOGI(TAG, "MAX31855 thermocouple sensor initialized (%d Hz)",
+             1000 / TEMPERATURE_SAMPLE_INTERVAL_MS);
     return true;
 }
 
 temperature_reading_t temperature_read(void)
 {
-    temperature_reading_t reading = {
-        .temperature_f = 0.0f,
-        .temperature_c = 0.0f,
-        .valid = false
-    };
+    temperature_reading_t reading;
 
     if (!s_initialized) {
-        ESP_LOGW(TAG, "Sensor not initialized");
+        memset(&reading, 0, sizeof(reading));
         return reading;
     }
 
-    // Read 32 bits from MAX31855
-    uint8_t rx_data[4] = {0};
-    spi_transaction_t trans = {
-        .length = 32,
-        .rx_buffer = rx_data,
-        .tx_buffer = NULL,
-    };
+    portENTER_CRITICAL(&s_lock);
+    reading = s_latest;
+    int64_t last_good_us = s_last_good_us;
+    portEXIT_CRITICAL(&s_lock);
 
-    esp_err_t ret = spi_device_transmit(s_spi_handle, &trans);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "SPI transaction failed: %s", esp_err_to_name(ret));
-        return reading;
+    // Aged here too, so a stalled or starved acquisition task (e.g. stuck
+    // behind the display on the shared bus) cannot keep a reading valid
+    if (esp_timer_get_time() - last_good_us >= (int64_t)TEMPERATURE_STALE_MS * 1000) {
+        reading.valid = false;
     }
+    return reading;
+}
 
-    // Assemble 32-bit value (MSB first)
-    uint32_t raw = ((uint32_t)rx_data[0] << 24) |
-                   ((uint32_t)rx_data[1] << 16) |
-                   ((uint32_t)rx_data[2] << 8) |
-                   (uint32_t)rx_data[3];
+static size_t format_tenths(char* buf, size_t len, int32_t tenths)
+{
+    uint32_t mag = (tenths < 0) ? (uint32_t)(-tenths) : (uint32_t)tenths;
+    int n = snprintf(buf, len, "%s%lu.%lu", tenths < 0 ? "-" : "",
+                     (unsigned long)(mag / 10), (unsigned long)(mag % 10));
+    return (n < 0) ? 0 : ((size_t)n < len ? (size_t)n : len - 1);
+}
 
-    ESP_LOGD(TAG, "Raw data: 0x%08lX", (unsigned long)raw);
+size_t temp_format_f(char* buf, size_t len, temp_cc_t t)
+{
+    return format_tenths(buf, len, temp_cc_to_f10(t));
+}
 
-    // Check fault bit (bit 16)
-    if (raw & 0x00010000) {
-        // Fault detected - check fault type bits (0-2)
-        s_last_fault = raw & 0x07;
+size_t temp_format_c(char* buf, size_t len, temp_cc_t t)
+{
+    return format_tenths(buf, len, temp_cc_to_c10(t));
+}
 
-        if (s_last_fault & 0x01) {
-            ESP_LOGE(TAG, "Thermocouple fault: Open circuit (no probe connected)");
-        }
-        if (s_last_fault & 0x02) {
-            ESP_LOGE(TAG, "Thermocouple fault: Short to GND");
-        }
-        if (s_last_fault & 0x04) {
-            ESP_LOGE(TAG, "Thermocouple fault: Short to VCC");
-        }
+bool temp_parse_f(const char* str, temp_cc_t* out)
+{
+    while (*str == ' ') str++;
 
-        return reading;
-    }
+    bool negative = (*str == '-');
+    if (*str == '-' || *str == '+') str++;
 
-    // Extract thermocouple temperature (bits 31-18, 14-bit signed)
-    // Resolution: 0.25C per LSB
-    int16_t tc_raw = (raw >> 18) & 0x3FFF;
-    if (tc_raw & 0x2000) {
-        // Sign extend for negative temperatures
-        tc_raw |= 0xC000;
+    // Accumulate hundredths of a degree F
+    int32_t f100 = 0;
+    int digits = 0;
+    while (*str >= '0' && *str <= '9' && digits < 6) {
+        f100 = f100 * 10 + (*str++ - '0');
+        digits++;
     }
-    float temp_c = (float)tc_raw * 0.25f;
+    f100 *= 100;
 
-    // Extract cold junction temperature (bits 15-4, 12-bit signed)
-    // Resolution: 0.0625C per LSB
-    int16_t cj_raw = (raw >> 4) & 0x0FFF;
-    if (cj_raw & 0x0800) {
-        // Sign extend for negative temperatures
-        cj_raw |= 0xF000;
+    if (*str == '.') {
+        str++;
+        if (*str >= '0' && *str <= '9') { f100 += (*str++ - '0') * 10; digits++; }
+        if (*str >= '0' && *str <= '9') { f100 += (*str++ - '0'); }
+        while (*str >= '0' && *str <= '9') str++;
     }
-    float cj_temp_c = (float)cj_raw * 0.0625f;
-
-    ESP_LOGD(TAG, "Thermocouple: %.2f C, Cold Junction: %.2f C", temp_c, cj_temp_c);
-
-    reading.temperature_c = temp_c;
-    reading.temperature_f = temperature_c_to_f(temp_c);
-    reading.valid = true;
 
-    s_last_fault = 0;
-
-    return reading;
-}
-
-float temperature_c_to_f(float celsius)
-{
-    return (celsius * 9.0f / 5.0f) + 32.0f;
-}
+    if (digits == 0 || (*str != '\0' && *str != ' ')) {
+        return false;
+    }
+    if (negative) {
+        f100 = -f100;
+    }
 
-float temperature_f_to_c(float fahrenheit)
-{
-    return (fahrenheit - 32.0f) * 5.0f / 9.0f;
+    *out = (f100 - 3200) * 5 / 9;
+    return true;
 }
 
 bool temperature_sensor_ok(void)
 {
-    if (!s_initialized) {
-        return false;
-    }
-
-    // Perform a read and check validity
-    temperature_reading_t reading = temperature_read();
-    return reading.valid;
+    return temperature_read().valid;
 }
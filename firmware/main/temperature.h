@@ -3,74 +3,156 @@
  * @brief Temperature sensor driver interface
  *
  * Abstract interface for temperature sensing.
- * Concrete implementation TBD based on selected sensor.
+ *
+ * The driver samples the sensor in its own task and filters the samples
+ * (median spike filter, then an EMA). temperature_read() returns the
+ * latest filtered value without touching the bus.
  */
 
 #ifndef TEMPERATURE_H
 #define TEMPERATURE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Fixed-point temperature in hundredths of a degree Celsius
+ *
+ * Used from the sensor through control to the UI; the C3 has no FPU.
+ * One MAX31855 step (0.25 C) is exactly 25 units.
+ */
+typedef int32_t temp_cc_t;
+
+// Compile-time conversions (for constants; integer math only)
+#define TEMP_CC_FROM_Q(q)       ((temp_cc_t)(q) * 25)
+#define TEMP_CC_FROM_F(f)       ((temp_cc_t)(((f) - 32) * 500 / 9))
+#define TEMP_CC_DELTA_F(df)     ((temp_cc_t)((df) * 500 / 9))
+
 /**
  * @brief Temperature reading result
  */
 typedef struct {
-    float temperature_f;    // Temperature in Fahrenheit
-    float temperature_c;    // Temperature in Celsius
-    bool valid;             // True if reading is valid
+    temp_cc_t temperature;      // Filtered thermocouple temperature
+    int16_t raw_q;              // Same, in 0.25 C units (sensor LSB)
+    temp_cc_t cold_junction;    // Sensor die (cold junction) temperature
+    int32_t slope_cc_per_min;   // Rate of change over TEMPERATURE_SLOPE_WINDOW_S
+    uint8_t fault;              // MAX31855 fault bits of the last sample (0 = none)
+    bool valid;                 // True if reading is valid
 } temperature_reading_t;
 
 /**
  * @brief Initialize temperature sensor
  *
- * Configures GPIO and initializes sensor communication.
+ * Configures the sensor interface and starts the acquisition task.
  *
  * @return true on success, false on failure
  */
 bool temperature_init(void);
 
 /**
- * @brief Read current temperature
+ * @brief Get the latest filtered temperature
  *
- * Performs a temperature reading from the sensor.
+ * O(1) and non-blocking. Invalid once no good sample has been taken for
+ * TEMPERATURE_STALE_MS, also when the acquisition task has stopped running.
  *
  * @return Temperature reading structure with validity flag
  */
 temperature_reading_t temperature_read(void);
 
 /**
- * @brief Convert Celsius to Fahrenheit
+ * @brief Convert to tenths of a degree Fahrenheit (rounded)
+ */
+static inline int32_t temp_cc_to_f10(temp_cc_t t)
+{
+    int32_t f100 = t * 9 / 5 + 3200;
+    return (f100 + (f100 >= 0 ? 5 : -5)) / 10;
+}
+
+/**
+ * @brief Convert to tenths of a degree Celsius (rounded)
+ */
+static inline int32_t temp_cc_to_c10(temp_cc_t t)
+{
+    return (t + (t >= 0 ? 5 : -5)) / 10;
+}
+
+/**
+ * @brief Convert to float Fahrenheit
+ *
+ * For interfaces that need a float; nothing in the firmware itself does.
+ */
+static inline float temp_cc_to_f(temp_cc_t t)
+{
+    return (float)t * 0.018f + 32.0f;
+}
+
+/**
+ * @brief Format as Fahrenheit with one decimal, e.g. "165.2"
  *
- * @param celsius Temperature in Celsius
- * @return Temperature in Fahrenheit
+ * Integer-only, so no float printf is needed.
+ *
+ * @return Length written (excluding terminator)
  */
-float temperature_c_to_f(float celsius);
+size_t temp_format_f(char* buf, size_t len, temp_cc_t t);
 
 /**
- * @brief Convert Fahrenheit to Celsius
+ * @brief Format as Celsius with one decimal, e.g. "74.0"
  *
- * @param fahrenheit Temperature in Fahrenheit
- * @return Temperature in Celsius
+ * @return Length written (excluding terminator)
  */
-float temperature_f_to_c(float fahrenheit);
+size_t temp_format_c(char* buf, size_t len, temp_cc_t t);
+
+/**
+ * @brief Parse a Fahrenheit value such as "180" or "180.5"
+ *
+ * Up to two decimals; trailing text after whitespace is ignored.
+ *
+ * @param str Text to parse
+ * @param out Parsed temperature
+ * @return true if a number was parsed
+ */
+bool temp_parse_f(const char* str, temp_cc_t* out);
 
 /**
  * @brief Check if sensor is responding
  *
+ * Same as temperature_read().valid.
+ *
  * @return true if sensor is responding, false otherwise
  */
 bool temperature_sensor_ok(void);
 
 // MAX31855 SPI Configuration (XIAO ESP32-C3)
-// D1=GPIO3, D8=GPIO8, D9=GPIO9
-#define MAX31855_SPI_HOST   SPI2_HOST
+// D1=GPIO3; clock and MISO come from the shared bus (see spi_bus.h)
+#define MAX31855_SPI_HOST   SPI_BUS_HOST
 #define MAX31855_PIN_CS     3   // D1 - Chip Select
-#define MAX31855_PIN_CLK    8   // D8 - SPI Clock
-#define MAX31855_PIN_MISO   9   // D9 - SPI MISO (data from MAX31855)
+#define MAX31855_PIN_CLK    SPI_BUS_PIN_CLK
+#define MAX31855_PIN_MISO   SPI_BUS_PIN_MISO
+
+// temperature_reading_t.fault bits (low three are the MAX31855's own)
+#define TEMPERATURE_FAULT_OPEN      0x01    // No probe connected
+#define TEMPERATURE_FAULT_SHORT_GND 0x02
+#define TEMPERATURE_FAULT_SHORT_VCC 0x04
+#define TEMPERATURE_FAULT_BUS       0x80    // SPI transaction failed
+
+// Acquisition: the MAX31855 converts in ~100 ms, so sample at 10 Hz
+#define TEMPERATURE_SAMPLE_INTERVAL_MS  100
+#define TEMPERATURE_TASK_STACK_SIZE     3072
+#define TEMPERATURE_TASK_PRIORITY       6
+
+// Filtering
+#define TEMPERATURE_MEDIAN_N            5       // Spike filter length (odd)
+#define TEMPERATURE_EMA_SHIFT           2       // EMA alpha = 1/4
+#define TEMPERATURE_SLOPE_WINDOW_S      30      // dT/dt baseline
+#define TEMPERATURE_STALE_MS            1000    // Reading invalid after this long without a good sample
+
+// Repeat the same fault message at most this often (repeats are counted)
+#define TEMPERATURE_FAULT_LOG_INTERVAL_MS 30000
 
 #ifdef __cplusplus
 }
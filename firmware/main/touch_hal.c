@@ -1,29 +1,40 @@
 /**
  * @file touch_hal.c
- * @brief Touch HAL stub implementation
+ * @brief Touch HAL: event queue, GPIO buttons and XPT2046 touch
  *
- * Stub that provides no input. Replace with actual driver implementation
- * when touch hardware is selected.
+ * Every input source feeds one queue of timestamped touch_event_t.
+ * Buttons and PENIRQ are level interrupts: one firing masks itself and
+ * starts the scan timer, which debounces the input (stable for
+ * s_debounce_ms), detects long presses and, once the input is released
+ * and stable again, unmasks it. The timer re-arms itself only while an
+ * input is active, so an idle unit takes no input wakeups at all.
  *
- * To implement for specific hardware:
- * 1. Copy this file to touch_hal_<driver>.c
- * 2. Implement actual hardware communication
- * 3. Update CMakeLists.txt to use your implementation
+ * The scan runs on the esp_timer task rather than in an ISR so that the
+ * touch controller can be read over SPI from the same place.
  */
 
 #include "touch_hal.h"
+#include "config.h"
+#include "dlog.h"
+#include "xpt2046.h"
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_sleep.h"
 #include "esp_timer.h"
 
 static const char* TAG = "touch_hal";
 
-// Stub touch info
+// Touch info (filled in at init from what is found)
 static touch_info_t s_info = {
     .type = TOUCH_TYPE_NONE,
     .multitouch = false,
     .pressure_sense = false,
-    .width = 320,
-    .height = 240,
+    .width = TOUCH_PANEL_WIDTH,
+    .height = TOUCH_PANEL_HEIGHT,
     .num_buttons = 0,
     .initialized = false
 };
@@ -32,33 +43,536 @@ static touch_info_t s_info = {
 static uint32_t s_long_press_ms = 500;
 static uint32_t s_debounce_ms = 50;
 
-// Event callback
+// Event queue and the consumer's wakeup callback
+static QueueHandle_t s_events = NULL;
 static touch_callback_t s_callback = NULL;
 static void* s_callback_user_data = NULL;
 
+// Raw-to-panel calibration at rotation 0 (divisor 0 = none)
+static touch_calibration_t s_calibration = {0};
+
+// Raw-to-screen matrix in use: calibration (or the nominal one) with the
+// rotation folded in (s_scan_lock)
+static touch_calibration_t s_matrix = {0};
+static uint16_t s_rotation = 0;
+static bool s_calibrating = false;
+
+// Calibration matrices are normalized to this divisor
+#define TOUCH_CAL_ONE           65536
+
+// Nominal raw range for the uncalibrated mapping
+#define TOUCH_RAW_MIN           200
+#define TOUCH_RAW_MAX           3900
+
 // Touch state
 static bool s_pressed = false;
 static int16_t s_last_x = 0;
 static int16_t s_last_y = 0;
 
+/**
+ * @brief Pen state (same scheme as the buttons; IDLE has PENIRQ armed)
+ */
+typedef enum {
+    PEN_STATE_IDLE,
+    PEN_STATE_PENDING,          // PENIRQ fired; waiting for real pressure
+    PEN_STATE_DOWN,             // Press reported
+    PEN_STATE_LIFTING           // Pressure gone; waiting for it to stay gone
+} pen_state_t;
+
+static bool s_touch_present = false;
+static volatile pen_state_t s_pen_state = PEN_STATE_IDLE;
+static volatile int64_t s_pen_since_us = 0;
+static int64_t s_pen_down_us = 0;
+static int16_t s_pen_start_x = 0;
+static int16_t s_pen_start_y = 0;
+static uint8_t s_pen_pressure = 0;
+static bool s_pen_long_reported = false;
+static bool s_pen_travelled = false;
+
+/**
+ * @brief Debounce state of one button
+ *
+ * IDLE is the only state with the interrupt enabled; the ISR moves a
+ * button to PRESSING, the scan timer does everything else.
+ */
+typedef enum {
+    BUTTON_STATE_IDLE,          // Released, interrupt armed
+    BUTTON_STATE_PRESSING,      // Went low; waiting for it to stay low
+    BUTTON_STATE_HELD,          // Press reported
+    BUTTON_STATE_RELEASING      // Went high; waiting for it to stay high
+} button_state_t;
+
+typedef struct {
+    gpio_num_t gpio;
+    button_id_t id;
+    volatile button_state_t state;
+    volatile int64_t since_us;  // Entry into the current level
+    int64_t pressed_us;         // Start of the reported press
+    bool long_reported;
+} button_t;
+
+static button_t s_buttons[] = {
+    { .gpio = BUTTON_UP_GPIO,     .id = BUTTON_UP },
+    { .gpio = BUTTON_DOWN_GPIO,   .id = BUTTON_DOWN },
+    { .gpio = BUTTON_SELECT_GPIO, .id = BUTTON_SELECT },
+};
+#define BUTTON_COUNT (sizeof(s_buttons) / sizeof(s_buttons[0]))
+
+// Scan timer (runs only while an input is active)
+static esp_timer_handle_t s_scan_timer = NULL;
+static portMUX_TYPE s_scan_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t us_to_ms(int64_t us)
+{
+    return (uint32_t)(us / 1000);
+}
+
+/**
+ * @brief Queue an event and wake the consumer (scan timer context)
+ */
+static void emit_event(touch_event_type_t type, button_id_t button, int16_t x, int16_t y,
+                       uint8_t pressure, int64_t when_us)
+{
+    touch_event_t event = {
+        .type = type,
+        .x = x,
+        .y = y,
+        .button = button,
+        .timestamp_ms = us_to_ms(when_us),
+        .pressure = pressure,
+    };
+
+    ESP_LOGD(TAG, "Event: type=%d x=%d y=%d button=%d",
+             event.type, event.x, event.y, event.button);
+
+    if (xQueueSend(s_events, &event, 0) != pdTRUE) {
+        DLOGW(TAG, "Event queue full - dropping event type %d", event.type);
+        return;
+    }
+
+    if (s_callback) {
+        s_callback(&event, s_callback_user_data);
+    }
+}
+
+static bool any_input_active(void)
+{
+    if (s_pen_state != PEN_STATE_IDLE) {
+        return true;
+    }
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        if (s_buttons[i].state != BUTTON_STATE_IDLE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void IRAM_ATTR start_scan_from_isr(void)
+{
+    if (!esp_timer_is_active(s_scan_timer)) {
+        esp_timer_start_once(s_scan_timer, TOUCH_SCAN_INTERVAL_MS * 1000);
+    }
+}
+
+// Button interrupt handler
+static void IRAM_ATTR button_isr_handler(void* arg)
+{
+    button_t* button = (button_t*)arg;
+
+    // Level-triggered (edges are not seen in light sleep): mask until
+    // the scan has seen the button released
+    gpio_intr_disable(button->gpio);
+
+    portENTER_CRITICAL_ISR(&s_scan_lock);
+    button->state = BUTTON_STATE_PRESSING;
+    button->since_us = esp_timer_get_time();
+    start_scan_from_isr();
+    portEXIT_CRITICAL_ISR(&s_scan_lock);
+}
+
+// PENIRQ handler
+static void IRAM_ATTR pen_isr_handler(void* arg)
+{
+    (void)arg;
+    gpio_intr_disable(XPT2046_PIN_IRQ);
+
+    portENTER_CRITICAL_ISR(&s_scan_lock);
+    s_pen_state = PEN_STATE_PENDING;
+    s_pen_since_us = esp_timer_get_time();
+    start_scan_from_isr();
+    portEXIT_CRITICAL_ISR(&s_scan_lock);
+}
+
+// ============================================================================
+// Coordinate mapping
+// ============================================================================
+
+static bool rotated_sideways(uint16_t rotation)
+{
+    return rotation == 90 || rotation == 270;
+}
+
+/**
+ * @brief Fold a rotation into a raw-to-panel matrix
+ *
+ * Rows are (a, b, c) for x and (d, e, f) for y. Screen coordinates at
+ * each rotation, from rotation-0 panel coordinates (x0, y0):
+ *   90: (y0, W-1-x0)   180: (W-1-x0, H-1-y0)   270: (H-1-y0, x0)
+ * which matches the ILI9341 MADCTL settings in display_hal_ili9341.c.
+ */
+static touch_calibration_t rotate_matrix(const touch_calibration_t* m, uint16_t rotation)
+{
+    const int32_t w = TOUCH_PANEL_WIDTH - 1;
+    const int32_t h = TOUCH_PANEL_HEIGHT - 1;
+    touch_calibration_t r = *m;
+
+    switch (rotation) {
+        case 90:
+            r.a = m->d;  r.b = m->e;  r.c = m->f;
+            r.d = -m->a; r.e = -m->b; r.f = w * m->divisor - m->c;
+            break;
+        case 180:
+            r.a = -m->a; r.b = -m->b; r.c = w * m->divisor - m->c;
+            r.d = -m->d; r.e = -m->e; r.f = h * m->divisor - m->f;
+            break;
+        case 270:
+            r.a = -m->d; r.b = -m->e; r.c = h * m->divisor - m->f;
+            r.d = m->a;  r.e = m->b;  r.f = m->c;
+            break;
+        default:
+            break;
+    }
+    return r;
+}
+
+/**
+ * @brief Screen point at the current rotation to rotation-0 panel point
+ */
+static void unrotate_point(int32_t x, int32_t y, int32_t* x0, int32_t* y0)
+{
+    const int32_t w = TOUCH_PANEL_WIDTH - 1;
+    const int32_t h = TOUCH_PANEL_HEIGHT - 1;
+
+    switch (s_rotation) {
+        case 90:  *x0 = w - y; *y0 = x;     break;
+        case 180: *x0 = w - x; *y0 = h - y; break;
+        case 270: *x0 = y;     *y0 = h - x; break;
+        default:  *x0 = x;     *y0 = y;     break;
+    }
+}
+
+/**
+ * @brief Rebuild s_matrix from the calibration and rotation
+ */
+static void update_matrix(void)
+{
+    touch_calibration_t base = s_calibration;
+    if (base.divisor == 0) {
+        // Uncalibrated: stretch the nominal raw range over the panel
+        int32_t span = TOUCH_RAW_MAX - TOUCH_RAW_MIN;
+        base = (touch_calibration_t){
+            .a = TOUCH_PANEL_WIDTH * TOUCH_CAL_ONE / span, .b = 0,
+            .c = -TOUCH_RAW_MIN * (TOUCH_PANEL_WIDTH * TOUCH_CAL_ONE / span),
+            .d = 0, .e = TOUCH_PANEL_HEIGHT * TOUCH_CAL_ONE / span,
+            .f = -TOUCH_RAW_MIN * (TOUCH_PANEL_HEIGHT * TOUCH_CAL_ONE / span),
+            .divisor = TOUCH_CAL_ONE,
+        };
+    }
+
+    touch_calibration_t m = rotate_matrix(&base, s_rotation);
+
+    portENTER_CRITICAL(&s_scan_lock);
+    s_matrix = m;
+    portEXIT_CRITICAL(&s_scan_lock);
+}
+
+static int16_t clamp_coord(int32_t v, int32_t size)
+{
+    return (int16_t)(v < 0 ? 0 : (v >= size ? size - 1 : v));
+}
+
+/**
+ * @brief Raw reading to event coordinates (raw while calibrating)
+ */
+static void map_point(const xpt2046_sample_t* sample, int16_t* x, int16_t* y)
+{
+    portENTER_CRITICAL(&s_scan_lock);
+    touch_calibration_t m = s_matrix;
+    bool raw = s_calibrating;
+    portEXIT_CRITICAL(&s_scan_lock);
+
+    if (raw) {
+        *x = (int16_t)sample->x;
+        *y = (int16_t)sample->y;
+        return;
+    }
+
+    int32_t rx = sample->x;
+    int32_t ry = sample->y;
+    *x = clamp_coord((m.a * rx + m.b * ry + m.c) / m.divisor, s_info.width);
+    *y = clamp_coord((m.d * rx + m.e * ry + m.f) / m.divisor, s_info.height);
+}
+
+// ============================================================================
+// Scanning
+// ============================================================================
+
+/**
+ * @brief Advance one button's debounce state
+ */
+static void scan_button(button_t* button, int64_t now_us)
+{
+    bool low = gpio_get_level(button->gpio) == 0;
+    int64_t stable_us = (int64_t)s_debounce_ms * 1000;
+
+    switch (button->state) {
+        case BUTTON_STATE_PRESSING:
+            if (!low) {
+                // Bounce or glitch shorter than the debounce time
+                button->state = BUTTON_STATE_IDLE;
+                gpio_intr_enable(button->gpio);
+            } else if (now_us - button->since_us >= stable_us) {
+                button->state = BUTTON_STATE_HELD;
+                button->pressed_us = button->since_us;
+                button->long_reported = false;
+                emit_event(TOUCH_EVENT_PRESS, button->id, 0, 0, 0, button->pressed_us);
+            }
+            break;
+
+        case BUTTON_STATE_HELD:
+            if (!low) {
+                button->state = BUTTON_STATE_RELEASING;
+                button->since_us = now_us;
+            } else if (!button->long_reported &&
+                       now_us - button->pressed_us >= (int64_t)s_long_press_ms * 1000) {
+                button->long_reported = true;
+                emit_event(TOUCH_EVENT_LONG_PRESS, button->id, 0, 0, 0, now_us);
+            }
+            break;
+
+        case BUTTON_STATE_RELEASING:
+            if (low) {
+                button->state = BUTTON_STATE_HELD;
+            } else if (now_us - button->since_us >= stable_us) {
+                emit_event(TOUCH_EVENT_RELEASE, button->id, 0, 0, 0, button->since_us);
+                button->state = BUTTON_STATE_IDLE;
+                gpio_intr_enable(button->gpio);
+            }
+            break;
+
+        case BUTTON_STATE_IDLE:
+        default:
+            break;
+    }
+}
+
+static void pen_up(void)
+{
+    s_pressed = false;
+    s_pen_state = PEN_STATE_IDLE;
+    gpio_intr_enable(XPT2046_PIN_IRQ);
+}
+
+/**
+ * @brief Advance the pen state from one filtered sample
+ */
+static void scan_pen(int64_t now_us)
+{
+    xpt2046_sample_t sample;
+    bool touched = xpt2046_read(&sample) && sample.z >= XPT2046_Z_THRESHOLD;
+    int64_t stable_us = (int64_t)s_debounce_ms * 1000;
+
+    int16_t x = s_last_x;
+    int16_t y = s_last_y;
+    if (touched) {
+        map_point(&sample, &x, &y);
+        s_pen_pressure = (uint8_t)(sample.z > 4095 ? 255 : sample.z >> 4);
+    }
+
+    switch (s_pen_state) {
+        case PEN_STATE_PENDING:
+            if (touched) {
+                s_pen_state = PEN_STATE_DOWN;
+                s_pen_down_us = s_pen_since_us;
+                s_pen_start_x = x;
+                s_pen_start_y = y;
+                s_pen_long_reported = false;
+                s_pen_travelled = false;
+                s_last_x = x;
+                s_last_y = y;
+                s_pressed = true;
+                emit_event(TOUCH_EVENT_PRESS, BUTTON_NONE, x, y, s_pen_pressure, s_pen_down_us);
+            } else if (now_us - s_pen_since_us >= stable_us) {
+                // PENIRQ glitch or a touch too light to count
+                pen_up();
+            }
+            break;
+
+        case PEN_STATE_DOWN:
+            if (!touched) {
+                s_pen_state = PEN_STATE_LIFTING;
+                s_pen_since_us = now_us;
+                break;
+            }
+            if (abs(x - s_pen_start_x) >= TOUCH_MOVE_THRESHOLD_PX ||
+                abs(y - s_pen_start_y) >= TOUCH_MOVE_THRESHOLD_PX) {
+                s_pen_travelled = true;
+            }
+            if (s_pen_travelled &&
+                (abs(x - s_last_x) >= TOUCH_MOVE_THRESHOLD_PX ||
+                 abs(y - s_last_y) >= TOUCH_MOVE_THRESHOLD_PX)) {
+                s_last_x = x;
+                s_last_y = y;
+                emit_event(TOUCH_EVENT_MOVE, BUTTON_NONE, x, y, s_pen_pressure, now_us);
+            }
+            if (!s_pen_long_reported && !s_pen_travelled &&
+                now_us - s_pen_down_us >= (int64_t)s_long_press_ms * 1000) {
+                s_pen_long_reported = true;
+                emit_event(TOUCH_EVENT_LONG_PRESS, BUTTON_NONE, s_last_x, s_last_y,
+                           s_pen_pressure, now_us);
+            }
+            break;
+
+        case PEN_STATE_LIFTING:
+            if (touched) {
+                s_pen_state = PEN_STATE_DOWN;
+            } else if (now_us - s_pen_since_us >= stable_us) {
+                emit_event(TOUCH_EVENT_RELEASE, BUTTON_NONE, s_last_x, s_last_y, 0,
+                           s_pen_since_us);
+                pen_up();
+            }
+            break;
+
+        case PEN_STATE_IDLE:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Scan timer callback (esp_timer task)
+ */
+static void scan_timer_cb(void* arg)
+{
+    (void)arg;
+    int64_t now_us = esp_timer_get_time();
+
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        scan_button(&s_buttons[i], now_us);
+    }
+    if (s_pen_state != PEN_STATE_IDLE) {
+        scan_pen(now_us);
+    }
+
+    // Re-arm while anything is active; checked under the lock so a press
+    // arriving now either sees the timer running or starts it itself
+    portENTER_CRITICAL(&s_scan_lock);
+    if (any_input_active() && !esp_timer_is_active(s_scan_timer)) {
+        esp_timer_start_once(s_scan_timer, TOUCH_SCAN_INTERVAL_MS * 1000);
+    }
+    portEXIT_CRITICAL(&s_scan_lock);
+}
+
+// Initialize buttons
+static bool init_buttons(void)
+{
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 0,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_LOW_LEVEL  // Button press (active low)
+    };
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        io_conf.pin_bit_mask |= 1ULL << s_buttons[i].gpio;
+    }
+
+    if (gpio_config(&io_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure button GPIOs");
+        return false;
+    }
+
+    // Attach interrupt handlers; a press also wakes from light sleep
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        gpio_isr_handler_add(s_buttons[i].gpio, button_isr_handler, &s_buttons[i]);
+        gpio_wakeup_enable(s_buttons[i].gpio, GPIO_INTR_LOW_LEVEL);
+    }
+    esp_sleep_enable_gpio_wakeup();
+
+    ESP_LOGI(TAG, "Buttons initialized");
+    return true;
+}
+
+// Initialize the touch controller; PENIRQ also wakes from light sleep
+static bool init_touch(void)
+{
+    if (!xpt2046_init()) {
+        return false;
+    }
+
+    gpio_set_intr_type(XPT2046_PIN_IRQ, GPIO_INTR_LOW_LEVEL);
+    gpio_isr_handler_add(XPT2046_PIN_IRQ, pen_isr_handler, NULL);
+    gpio_wakeup_enable(XPT2046_PIN_IRQ, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    gpio_intr_enable(XPT2046_PIN_IRQ);
+    return true;
+}
+
 bool touch_hal_init(void)
 {
-    ESP_LOGI(TAG, "Touch HAL initializing (STUB)");
+    if (s_info.initialized) {
+        return true;
+    }
 
-    // TODO: Initialize actual touch hardware here
-    // For XPT2046 (resistive):
-    //   - Configure SPI for touch controller
-    //   - Load calibration from NVS
-    // For FT6236 (capacitive):
-    //   - Configure I2C
-    //   - Read chip ID to verify communication
-    // For buttons:
-    //   - Configure GPIO inputs with pull-ups/interrupts
+    ESP_LOGI(TAG, "Touch HAL initializing");
+
+    s_events = xQueueCreate(TOUCH_EVENT_QUEUE_LEN, sizeof(touch_event_t));
+    if (s_events == NULL) {
+        ESP_LOGE(TAG, "Failed to create event queue");
+        return false;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = scan_timer_cb,
+        .name = "touch_scan",
+    };
+    if (esp_timer_create(&timer_args, &s_scan_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create scan timer");
+        return false;
+    }
+
+    const config_t* settings = config_acquire();
+    if (settings->saved & CONFIG_SECTION_TOUCH) {
+        s_calibration = settings->touch;
+    }
+    config_release();
+    update_matrix();
+
+    // Install GPIO ISR service (already installed is fine)
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service");
+        return false;
+    }
+
+    if (init_buttons()) {
+        s_info.type = TOUCH_TYPE_BUTTONS;
+        s_info.num_buttons = BUTTON_COUNT;
+    } else {
+        ESP_LOGW(TAG, "Button initialization failed");
+    }
+
+    if (init_touch()) {
+        s_touch_present = true;
+        s_info.type = TOUCH_TYPE_RESISTIVE;
+        s_info.pressure_sense = true;
+    }
 
-    s_info.type = TOUCH_TYPE_NONE;
     s_info.initialized = true;
 
-    ESP_LOGI(TAG, "Touch HAL initialized (STUB - implement real driver)");
+    ESP_LOGI(TAG, "Touch HAL initialized (type %d, %d buttons)",
+             s_info.type, s_info.num_buttons);
     return true;
 }
 
@@ -69,7 +583,11 @@ touch_info_t touch_hal_get_info(void)
 
 bool touch_hal_is_pressed(void)
 {
-    // TODO: Check actual touch/button state
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        if (touch_hal_button_pressed(s_buttons[i].id)) {
+            return true;
+        }
+    }
     return s_pressed;
 }
 
@@ -87,33 +605,37 @@ bool touch_hal_get_point(int16_t* x, int16_t* y)
 
 uint8_t touch_hal_get_pressure(void)
 {
-    // TODO: For resistive touch, calculate pressure from Z measurements
-    return s_pressed ? 128 : 0;
+    return s_pressed ? s_pen_pressure : 0;
 }
 
 bool touch_hal_button_pressed(button_id_t button)
 {
-    // TODO: Check specific button GPIO state
-    (void)button;
+    for (size_t i = 0; i < BUTTON_COUNT; i++) {
+        if (s_buttons[i].id == button) {
+            button_state_t state = s_buttons[i].state;
+            return state == BUTTON_STATE_HELD || state == BUTTON_STATE_RELEASING;
+        }
+    }
     return false;
 }
 
 bool touch_hal_poll_event(touch_event_t* event)
 {
-    if (event == NULL) {
+    return touch_hal_wait_event(event, 0);
+}
+
+bool touch_hal_wait_event(touch_event_t* event, uint32_t timeout_ms)
+{
+    if (event == NULL || s_events == NULL) {
         return false;
     }
 
-    // TODO: Implement actual event detection:
-    // 1. Read current touch/button state
-    // 2. Compare with previous state
-    // 3. Detect press, release, move, long_press
-    // 4. Apply debouncing
-    // 5. Populate event structure
-
-    // Stub: no events
-    event->type = TOUCH_EVENT_NONE;
-    return false;
+    TickType_t wait = (timeout_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xQueueReceive(s_events, event, wait) != pdTRUE) {
+        event->type = TOUCH_EVENT_NONE;
+        return false;
+    }
+    return true;
 }
 
 void touch_hal_set_callback(touch_callback_t callback, void* user_data)
@@ -124,32 +646,106 @@ void touch_hal_set_callback(touch_callback_t callback, void* user_data)
 
 bool touch_hal_start_calibration(void)
 {
-    ESP_LOGI(TAG, "start_calibration() - STUB");
+    if (!s_touch_present) {
+        return false;
+    }
 
-    // TODO: For resistive touch, implement 3-point calibration:
-    // 1. Display target at top-left, wait for touch
-    // 2. Display target at top-right, wait for touch
-    // 3. Display target at bottom-center, wait for touch
-    // 4. Calculate calibration matrix
+    portENTER_CRITICAL(&s_scan_lock);
+    s_calibrating = true;
+    portEXIT_CRITICAL(&s_scan_lock);
 
-    return false;
+    ESP_LOGI(TAG, "Calibration started");
+    return true;
+}
+
+bool touch_hal_set_calibration(const touch_calibration_point_t points[3])
+{
+    if (points == NULL) {
+        return false;
+    }
+
+    // Targets in rotation-0 panel coordinates, so one calibration serves
+    // every rotation
+    int64_t xs[3], ys[3], xr[3], yr[3];
+    for (int i = 0; i < 3; i++) {
+        int32_t x0, y0;
+        unrotate_point(points[i].screen_x, points[i].screen_y, &x0, &y0);
+        xs[i] = x0;
+        ys[i] = y0;
+        xr[i] = points[i].raw_x;
+        yr[i] = points[i].raw_y;
+    }
+
+    // Solve the affine map through the three points (exact in 64 bits)
+    int64_t div = (xr[0] - xr[2]) * (yr[1] - yr[2]) - (xr[1] - xr[2]) * (yr[0] - yr[2]);
+    if (div == 0) {
+        ESP_LOGW(TAG, "Calibration points are collinear");
+        return false;
+    }
+
+    int64_t n[6] = {
+        (xs[0] - xs[2]) * (yr[1] - yr[2]) - (xs[1] - xs[2]) * (yr[0] - yr[2]),
+        (xr[0] - xr[2]) * (xs[1] - xs[2]) - (xs[0] - xs[2]) * (xr[1] - xr[2]),
+        yr[0] * (xr[2] * xs[1] - xr[1] * xs[2]) +
+        yr[1] * (xr[0] * xs[2] - xr[2] * xs[0]) +
+        yr[2] * (xr[1] * xs[0] - xr[0] * xs[1]),
+        (ys[0] - ys[2]) * (yr[1] - yr[2]) - (ys[1] - ys[2]) * (yr[0] - yr[2]),
+        (xr[0] - xr[2]) * (ys[1] - ys[2]) - (ys[0] - ys[2]) * (xr[1] - xr[2]),
+        yr[0] * (xr[2] * ys[1] - xr[1] * ys[2]) +
+        yr[1] * (xr[0] * ys[2] - xr[2] * ys[0]) +
+        yr[2] * (xr[1] * ys[0] - xr[0] * ys[1]),
+    };
+
+    // Normalize to TOUCH_CAL_ONE so the per-sample math fits in 32 bits;
+    // a slope beyond one pixel per raw unit means a bad reading
+    int32_t m[6];
+    for (int i = 0; i < 6; i++) {
+        int64_t v = n[i] * TOUCH_CAL_ONE / div;
+        bool slope = (i % 3) != 2;
+        if (slope ? (v > TOUCH_CAL_ONE || v < -TOUCH_CAL_ONE)
+                  : (v > (1 << 28) || v < -(1 << 28))) {
+            ESP_LOGW(TAG, "Calibration out of range - touch the targets again");
+            return false;
+        }
+        m[i] = (int32_t)v;
+    }
+
+    s_calibration = (touch_calibration_t){
+        .a = m[0], .b = m[1], .c = m[2],
+        .d = m[3], .e = m[4], .f = m[5],
+        .divisor = TOUCH_CAL_ONE,
+    };
+    update_matrix();
+    touch_hal_cancel_calibration();
+
+    ESP_LOGI(TAG, "Calibration applied");
+    return true;
+}
+
+void touch_hal_cancel_calibration(void)
+{
+    portENTER_CRITICAL(&s_scan_lock);
+    s_calibrating = false;
+    portEXIT_CRITICAL(&s_scan_lock);
 }
 
 bool touch_hal_needs_calibration(void)
 {
-    // TODO: Check if calibration data exists in NVS
-    // For resistive: usually needs calibration
-    // For capacitive: usually pre-calibrated
-    return (s_info.type == TOUCH_TYPE_RESISTIVE);
+    // Capacitive panels are factory calibrated
+    return (s_info.type == TOUCH_TYPE_RESISTIVE) && s_calibration.divisor == 0;
 }
 
 bool touch_hal_save_calibration(void)
 {
-    ESP_LOGI(TAG, "save_calibration() - STUB");
-
-    // TODO: Save calibration matrix to NVS
+    if (s_calibration.divisor == 0) {
+        ESP_LOGW(TAG, "No calibration to save");
+        return false;
+    }
 
-    return false;
+    config_t* settings = config_edit();
+    settings->touch = s_calibration;
+    config_commit(CONFIG_SECTION_TOUCH);
+    return true;
 }
 
 void touch_hal_set_long_press_duration(uint32_t duration_ms)
@@ -164,29 +760,13 @@ void touch_hal_set_debounce(uint32_t debounce_ms)
 
 void touch_hal_set_rotation(uint16_t rotation)
 {
-    ESP_LOGI(TAG, "set_rotation(%d)", rotation);
-
-    // TODO: Update coordinate transformation matrix
-    // to match display rotation
-}
-
-// ============================================================================
-// Internal helper for drivers to emit events
-// ============================================================================
-
-/**
- * @brief Emit a touch event (call from driver implementation)
- *
- * @param event Event to emit
- */
-void touch_hal_emit_event(const touch_event_t* event)
-{
-    if (event == NULL) return;
-
-    ESP_LOGD(TAG, "Event: type=%d x=%d y=%d button=%d",
-             event->type, event->x, event->y, event->button);
-
-    if (s_callback) {
-        s_callback(event, s_callback_user_data);
+    if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270) {
+        ESP_LOGW(TAG, "Unsupported rotation: %d", rotation);
+        return;
     }
+
+    s_rotation = rotation;
+    s_info.width = rotated_sideways(rotation) ? TOUCH_PANEL_HEIGHT : TOUCH_PANEL_WIDTH;
+    s_info.height = rotated_sideways(rotation) ? TOUCH_PANEL_WIDTH : TOUCH_PANEL_HEIGHT;
+    update_matrix();
 }
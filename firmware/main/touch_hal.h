@@ -5,11 +5,15 @@
  * Abstract interface for touch and button input. Allows GUI code to be
  * developed independently of the actual input hardware.
  *
- * Implementations:
- * - touch_hal_none.c     (stub, no input)
- * - touch_hal_buttons.c  (GPIO buttons)
- * - touch_hal_xpt2046.c  (resistive touch via SPI)
- * - touch_hal_ft6236.c   (capacitive touch via I2C)
+ * All input arrives as timestamped touch_event_t on one queue: GPIO
+ * buttons (debounced, with long press) and the XPT2046 resistive touch
+ * controller (xpt2046.c). Inputs are interrupt driven (button level,
+ * PENIRQ); nothing is sampled while they are idle. One task consumes
+ * the queue (the GUI task with a TFT, else the display task).
+ *
+ * Touch coordinates come from an integer affine matrix: the saved
+ * 3-point calibration (raw to rotation-0 panel coordinates) with the
+ * display rotation folded in, so a sample costs four multiplies.
  */
 
 #ifndef TOUCH_HAL_H
@@ -85,7 +89,29 @@ typedef struct {
 } touch_info_t;
 
 /**
- * @brief Touch event callback type
+ * @brief Raw-to-screen calibration (affine, fixed point)
+ *
+ * x = (a * raw_x + b * raw_y + c) / divisor
+ * y = (d * raw_x + e * raw_y + f) / divisor
+ */
+typedef struct {
+    int32_t a, b, c;
+    int32_t d, e, f;
+    int32_t divisor;            // 0 = not calibrated
+} touch_calibration_t;
+
+/**
+ * @brief One calibration target and the raw reading taken on it
+ */
+typedef struct {
+    int16_t screen_x;           // Target, screen coordinates (current rotation)
+    int16_t screen_y;
+    int16_t raw_x;              // Event coordinates while calibrating
+    int16_t raw_y;
+} touch_calibration_point_t;
+
+/**
+ * @brief Touch event callback type (see touch_hal_set_callback())
  */
 typedef void (*touch_callback_t)(const touch_event_t* event, void* user_data);
 
@@ -156,10 +182,21 @@ bool touch_hal_button_pressed(button_id_t button);
  */
 bool touch_hal_poll_event(touch_event_t* event);
 
+/**
+ * @brief Wait for the next touch event
+ *
+ * @param event      Pointer to store event data
+ * @param timeout_ms Longest wait (UINT32_MAX = forever)
+ * @return true if an event arrived
+ */
+bool touch_hal_wait_event(touch_event_t* event, uint32_t timeout_ms);
+
 /**
  * @brief Register touch event callback
  *
- * Callback is invoked from touch task when events occur.
+ * Called from the esp_timer task after each event is queued, for
+ * consumers that sleep on something other than the queue. It should
+ * only wake the consumer, which then reads touch_hal_poll_event().
  *
  * @param callback Function to call on events
  * @param user_data User data passed to callback
@@ -173,12 +210,31 @@ void touch_hal_set_callback(touch_callback_t callback, void* user_data);
 /**
  * @brief Start touch calibration
  *
- * For resistive touchscreens, initiates calibration sequence.
+ * For resistive touchscreens: until touch_hal_set_calibration() or
+ * touch_hal_cancel_calibration(), touch events carry raw ADC
+ * coordinates instead of screen coordinates.
  *
  * @return true if calibration started
  */
 bool touch_hal_start_calibration(void);
 
+/**
+ * @brief Compute and apply a calibration from three targets
+ *
+ * The targets must not be collinear; spread them across the screen.
+ * Ends calibration mode on success. Use touch_hal_save_calibration()
+ * to keep the result.
+ *
+ * @param points Targets and their raw readings
+ * @return true on success, false if the points are degenerate
+ */
+bool touch_hal_set_calibration(const touch_calibration_point_t points[3]);
+
+/**
+ * @brief Leave calibration mode, keeping the previous calibration
+ */
+void touch_hal_cancel_calibration(void);
+
 /**
  * @brief Check if calibration is needed
  *
@@ -187,7 +243,7 @@ bool touch_hal_start_calibration(void);
 bool touch_hal_needs_calibration(void);
 
 /**
- * @brief Save calibration to NVS
+ * @brief Save the current calibration to the settings store
  *
  * @return true on success
  */
@@ -220,6 +276,24 @@ void touch_hal_set_debounce(uint32_t debounce_ms);
  */
 void touch_hal_set_rotation(uint16_t rotation);
 
+// Button GPIOs (active low, internal pull-ups)
+#define BUTTON_UP_GPIO        12
+#define BUTTON_DOWN_GPIO      13
+#define BUTTON_SELECT_GPIO    14
+
+// Queued events not yet read by the consumer
+#define TOUCH_EVENT_QUEUE_LEN 16
+
+// Sampling interval while an input is active (idle inputs are not sampled)
+#define TOUCH_SCAN_INTERVAL_MS 10
+
+// Touch panel size at rotation 0 (matches the LCD's native orientation)
+#define TOUCH_PANEL_WIDTH     240
+#define TOUCH_PANEL_HEIGHT    320
+
+// Travel that turns a held touch into MOVE events (and rules out a long press)
+#define TOUCH_MOVE_THRESHOLD_PX 8
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,545 @@
+/**
+ * @file web_server.c
+ * @brief On-device HTTP server
+ */
+
+#include "web_server.h"
+#include "command.h"
+#include "crockpot.h"
+#include "dlog.h"
+#include "history.h"
+#include "history_store.h"
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+#include "esp_crc.h"
+
+static const char* TAG = "web_server";
+
+static httpd_handle_t s_server = NULL;
+
+// Gzipped UI page, embedded by CMakeLists.txt
+extern const uint8_t s_index_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t s_index_gz_end[] asm("_binary_index_html_gz_end");
+
+// Quoted CRC-32 of the page, computed once at init
+static char s_index_etag[12];
+
+// Status push: the listener queues one push at a time onto the server task
+static portMUX_TYPE s_push_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_push_pending = false;
+static uint32_t s_pushed_generation = 0;
+static web_status_frame_t s_status_frame;
+
+// WebSocket command handling (server task only)
+static char s_command[WEB_SERVER_COMMAND_MAX_LEN];
+static char s_reply[512];
+
+// Longest formatted history row (CSV or JSON)
+#define ROW_MAX_LEN 160
+
+typedef enum {
+    FORMAT_CSV,
+    FORMAT_JSON
+} export_format_t;
+
+/**
+ * @brief Streaming export state
+ *
+ * Rows are formatted straight into s_chunk and sent whenever it fills,
+ * so memory use does not depend on the size of the range.
+ */
+typedef struct {
+    httpd_req_t* req;
+    export_format_t format;
+    uint32_t to_s;
+    uint32_t rows;
+    size_t len;
+    bool failed;            // Client went away; stop producing
+    bool done;              // Passed to_s
+} export_ctx_t;
+
+// The server runs handlers on a single task, so one buffer serves all
+static char s_chunk[WEB_SERVER_CHUNK_SIZE];
+static history_store_page_t s_page;
+
+static void chunk_flush(export_ctx_t* ctx)
+{
+    if (ctx->len > 0 && !ctx->failed) {
+        if (httpd_resp_send_chunk(ctx->req, s_chunk, ctx->len) != ESP_OK) {
+            ESP_LOGW(TAG, "Client closed during export");
+            ctx->failed = true;
+        }
+    }
+    ctx->len = 0;
+}
+
+static void chunk_printf(export_ctx_t* ctx, const char* fmt, ...)
+{
+    if (sizeof(s_chunk) - ctx->len < ROW_MAX_LEN) {
+        chunk_flush(ctx);
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(s_chunk + ctx->len, sizeof(s_chunk) - ctx->len, fmt, args);
+    va_end(args);
+
+    if (n > 0) {
+        ctx->len += ((size_t)n < sizeof(s_chunk) - ctx->len) ? (size_t)n
+                                                             : sizeof(s_chunk) - ctx->len - 1;
+    }
+}
+
+static void format_temp(char* buf, size_t len, int16_t temp_q, export_format_t format)
+{
+    if (temp_q == HISTORY_TEMP_INVALID) {
+        snprintf(buf, len, "%s", format == FORMAT_JSON ? "null" : "");
+    } else {
+        temp_format_f(buf, len, TEMP_CC_FROM_Q(temp_q));
+    }
+}
+
+/**
+ * @brief Write one record; sets ctx->done once past the range
+ */
+static void export_row(export_ctx_t* ctx, uint32_t time_s, const history_record_t* record)
+{
+    if (time_s > ctx->to_s) {
+        ctx->done = true;
+        return;
+    }
+
+    char temp[12];
+    char peak[12];
+    format_temp(temp, sizeof(temp), record->temp_q, ctx->format);
+    format_temp(peak, sizeof(peak), record->peak_q, ctx->format);
+
+    const char* state = crockpot_state_to_string(
+        (crockpot_state_t)(record->flags & HISTORY_FLAG_STATE_MASK));
+    int relay_main = (record->flags & HISTORY_FLAG_RELAY_MAIN) != 0;
+    int relay_aux = (record->flags & HISTORY_FLAG_RELAY_AUX) != 0;
+    int fault = (record->flags & HISTORY_FLAG_SENSOR_FAULT) != 0;
+
+    if (ctx->format == FORMAT_CSV) {
+        chunk_printf(ctx, "%lu,%s,%s,%s,%d,%d,%u,%d\n",
+                     (unsigned long)time_s, temp, peak, state,
+                     relay_main, relay_aux, record->duty_pct, fault);
+    } else {
+        chunk_printf(ctx,
+                     "%s{\"timestamp\":%lu,\"temperature_f\":%s,\"peak_f\":%s,"
+                     "\"state\":\"%s\",\"relay_main\":%s,\"relay_aux\":%s,"
+                     "\"duty_pct\":%u,\"sensor_error\":%s}",
+                     ctx->rows > 0 ? "," : "",
+                     (unsigned long)time_s, temp, peak, state,
+                     relay_main ? "true" : "false", relay_aux ? "true" : "false",
+                     record->duty_pct, fault ? "true" : "false");
+    }
+    ctx->rows++;
+}
+
+/**
+ * @brief Stream the current boot's history from the RAM ring
+ */
+static void stream_ram(export_ctx_t* ctx, history_res_t res, uint32_t from_s)
+{
+    history_cursor_t cursor;
+    history_entry_t entries[16];
+    size_t n;
+
+    history_seek(&cursor, res, from_s);
+
+    while (!ctx->failed && !ctx->done &&
+           (n = history_read(&cursor, entries, sizeof(entries) / sizeof(entries[0]))) > 0) {
+        for (size_t i = 0; i < n && !ctx->done; i++) {
+            export_row(ctx, entries[i].time_s, &entries[i].record);
+        }
+    }
+}
+
+/**
+ * @brief Whether a page starts at or before (boot, from_s)
+ *
+ * Unreadable pages count as "before" so the search moves past them.
+ */
+static bool page_before(uint32_t page_seq, uint16_t boot_id, uint32_t from_s)
+{
+    if (!history_store_read_page(page_seq, &s_page)) {
+        return true;
+    }
+    return s_page.boot_id < boot_id ||
+           (s_page.boot_id == boot_id && s_page.base_time_s <= from_s);
+}
+
+/**
+ * @brief Stream an earlier boot's minute history from flash
+ */
+static void stream_flash(export_ctx_t* ctx, uint16_t boot_id, uint32_t from_s)
+{
+    uint32_t first, end;
+    if (!history_store_range(&first, &end)) {
+        return;
+    }
+
+    // Pages are ordered by (boot, time): binary search for the first page
+    // starting after from_s; the one before it may still contain from_s.
+    uint32_t lo = first;
+    uint32_t hi = end;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (page_before(mid, boot_id, from_s)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (uint32_t seq = (lo > first) ? lo - 1 : first;
+         seq < end && !ctx->failed && !ctx->done; seq++) {
+        if (!history_store_read_page(seq, &s_page) || s_page.boot_id < boot_id) {
+            continue;
+        }
+        if (s_page.boot_id > boot_id) {
+            break;
+        }
+
+        uint32_t time_s = s_page.base_time_s;
+        for (uint8_t i = 0; i < s_page.count && !ctx->done; i++) {
+            if (i > 0) {
+                time_s += s_page.records[i].dt_s;
+            }
+            if (time_s >= from_s) {
+                export_row(ctx, time_s, &s_page.records[i]);
+            }
+        }
+    }
+}
+
+static bool query_u32(const char* query, const char* key, uint32_t* out)
+{
+    char value[16];
+    if (httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    *out = (uint32_t)strtoul(value, NULL, 10);
+    return true;
+}
+
+static esp_err_t history_handler(httpd_req_t* req)
+{
+    char query[128] = "";
+    char value[8];
+    uint32_t from_s = 0;
+    uint32_t to_s = UINT32_MAX;
+    uint32_t boot_id = history_store_boot_id();
+    history_res_t res = HISTORY_RES_1MIN;
+    export_format_t format = FORMAT_CSV;
+
+    httpd_req_get_url_query_str(req, query, sizeof(query));
+    query_u32(query, "from", &from_s);
+    query_u32(query, "to", &to_s);
+    query_u32(query, "boot", &boot_id);
+
+    if (httpd_query_key_value(query, "res", value, sizeof(value)) == ESP_OK) {
+        if (strcmp(value, "1s") == 0) {
+            res = HISTORY_RES_1S;
+        } else if (strcmp(value, "1m") != 0) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "res must be 1s or 1m");
+        }
+    }
+    if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+        if (strcmp(value, "json") == 0) {
+            format = FORMAT_JSON;
+        } else if (strcmp(value, "csv") != 0) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "format must be csv or json");
+        }
+    }
+
+    bool current_boot = (boot_id == history_store_boot_id());
+    if (!current_boot && res == HISTORY_RES_1S) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                   "1s history is only kept for the current boot");
+    }
+
+    httpd_resp_set_type(req, format == FORMAT_JSON ? "application/json" : "text/csv");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    export_ctx_t ctx = {
+        .req = req,
+        .format = format,
+        .to_s = to_s,
+    };
+
+    if (format == FORMAT_CSV) {
+        chunk_printf(&ctx, "timestamp,temperature_f,peak_f,state,relay_main,relay_aux,"
+                           "duty_pct,sensor_error\n");
+    } else {
+        chunk_printf(&ctx, "{\"boot\":%lu,\"res\":\"%s\",\"records\":[",
+                     (unsigned long)boot_id, res == HISTORY_RES_1S ? "1s" : "1m");
+    }
+
+    if (current_boot) {
+        stream_ram(&ctx, res, from_s);
+    } else {
+        stream_flash(&ctx, (uint16_t)boot_id, from_s);
+    }
+
+    if (format == FORMAT_JSON) {
+        chunk_printf(&ctx, "]}");
+    }
+    chunk_flush(&ctx);
+
+    if (ctx.failed) {
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "History export: %lu rows", (unsigned long)ctx.rows);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief metrics_write_fn_t sink: copy into s_chunk, sending as it fills
+ */
+static void metrics_write(const char* text, size_t len, void* arg)
+{
+    export_ctx_t* ctx = (export_ctx_t*)arg;
+
+    while (len > 0 && !ctx->failed) {
+        if (ctx->len == sizeof(s_chunk)) {
+            chunk_flush(ctx);
+        }
+        size_t n = sizeof(s_chunk) - ctx->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s_chunk + ctx->len, text, n);
+        ctx->len += n;
+        text += n;
+        len -= n;
+    }
+}
+
+static esp_err_t metrics_handler(httpd_req_t* req)
+{
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    export_ctx_t ctx = { .req = req };
+    metrics_write_prometheus(metrics_write, &ctx);
+    chunk_flush(&ctx);
+
+    if (ctx.failed) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t index_handler(httpd_req_t* req)
+{
+    char etag[sizeof(s_index_etag)];
+
+    httpd_resp_set_hdr(req, "ETag", s_index_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+        strcmp(etag, s_index_etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)s_index_gz_start,
+                           s_index_gz_end - s_index_gz_start);
+}
+
+static void encode_status(web_status_frame_t* frame)
+{
+    // Read the generation first: if the status changes in between, the
+    // frame is newer than its generation and the next push resends it
+    uint32_t generation = crockpot_get_generation();
+    crockpot_status_t status = crockpot_get_status();
+
+    frame->version = WEB_STATUS_FRAME_VERSION;
+    frame->state = (uint8_t)status.state;
+    frame->flags = (status.sensor_error ? WEB_STATUS_FLAG_SENSOR_ERROR : 0) |
+                   (status.wifi_connected ? WEB_STATUS_FLAG_WIFI : 0);
+    frame->duty_pct = status.heater_duty_pct;
+    frame->temperature_cc = status.temperature;
+    frame->setpoint_cc = status.setpoint;
+    frame->uptime_s = status.uptime_seconds;
+    frame->generation = generation;
+}
+
+static esp_err_t send_status(httpd_req_t* req, const web_status_frame_t* status)
+{
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t*)status,
+        .len = sizeof(*status),
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+/**
+ * @brief Server task work item: encode once, send to every WebSocket client
+ */
+static void push_status(void* arg)
+{
+    (void)arg;
+
+    portENTER_CRITICAL(&s_push_lock);
+    s_push_pending = false;
+    portEXIT_CRITICAL(&s_push_lock);
+
+    encode_status(&s_status_frame);
+    if (s_status_frame.generation == s_pushed_generation) {
+        return;
+    }
+    s_pushed_generation = s_status_frame.generation;
+
+    int fds[WEB_SERVER_MAX_SOCKETS];
+    size_t count = sizeof(fds) / sizeof(fds[0]);
+    if (httpd_get_client_list(s_server, &count, fds) != ESP_OK) {
+        return;
+    }
+
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t*)&s_status_frame,
+        .len = sizeof(s_status_frame),
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        if (httpd_ws_get_fd_info(s_server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            httpd_ws_send_frame_async(s_server, fds[i], &frame);
+        }
+    }
+}
+
+/**
+ * @brief crockpot listener: hand the push to the server task
+ *
+ * Runs on the control task, so only queues work; changes arriving while
+ * a push is still queued are picked up by that push.
+ */
+static void status_listener(void* user_data)
+{
+    (void)user_data;
+    bool queue = false;
+
+    portENTER_CRITICAL(&s_push_lock);
+    if (!s_push_pending) {
+        s_push_pending = true;
+        queue = true;
+    }
+    portEXIT_CRITICAL(&s_push_lock);
+
+    if (queue && httpd_queue_work(s_server, push_status, NULL) != ESP_OK) {
+        portENTER_CRITICAL(&s_push_lock);
+        s_push_pending = false;
+        portEXIT_CRITICAL(&s_push_lock);
+    }
+}
+
+static esp_err_t ws_handler(httpd_req_t* req)
+{
+    if (req->method == HTTP_GET) {
+        // Handshake done: start the client off with the current status
+        web_status_frame_t status;
+        encode_status(&status);
+        return send_status(req, &status);
+    }
+
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Control frames are answered by the server; only text carries commands
+    if (frame.len >= sizeof(s_command)) {
+        ESP_LOGW(TAG, "Closing WebSocket: %u byte frame", (unsigned)frame.len);
+        return ESP_FAIL;
+    }
+
+    frame.payload = (uint8_t*)s_command;
+    err = httpd_ws_recv_frame(req, &frame, sizeof(s_command) - 1);
+    if (err != ESP_OK || frame.type != HTTPD_WS_TYPE_TEXT) {
+        return err;
+    }
+    s_command[frame.len] = '\0';
+
+    DLOG_TEXT(ESP_LOG_INFO, TAG, "Processing command: %s", s_command);
+    // Anyone on the LAN can open the socket: user commands only
+    command_execute(s_command, COMMAND_ACCESS_USER, s_reply, sizeof(s_reply));
+
+    httpd_ws_frame_t reply = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t*)s_reply,
+        .len = strlen(s_reply),
+    };
+    return httpd_ws_send_frame(req, &reply);
+}
+
+bool web_server_init(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = WEB_SERVER_PORT;
+    config.stack_size = WEB_SERVER_STACK_SIZE;
+    config.max_open_sockets = WEB_SERVER_MAX_SOCKETS;
+    config.lru_purge_enable = true;
+
+    snprintf(s_index_etag, sizeof(s_index_etag), "\"%08lx\"",
+             (unsigned long)esp_crc32_le(0, s_index_gz_start,
+                                         s_index_gz_end - s_index_gz_start));
+
+    esp_err_t err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP server: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    static const httpd_uri_t index_uri = {
+        .uri = "/",
+        .method = HTTP_GET,
+        .handler = index_handler,
+    };
+    httpd_register_uri_handler(s_server, &index_uri);
+
+    static const httpd_uri_t ws_uri = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+    httpd_register_uri_handler(s_server, &ws_uri);
+
+    static const httpd_uri_t history_uri = {
+        .uri = "/history",
+        .method = HTTP_GET,
+        .handler = history_handler,
+    };
+    httpd_register_uri_handler(s_server, &history_uri);
+
+    static const httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+    };
+    httpd_register_uri_handler(s_server, &metrics_uri);
+
+    crockpot_add_listener(status_listener, NULL);
+
+    ESP_LOGI(TAG, "HTTP server listening on port %d", WEB_SERVER_PORT);
+    return true;
+}
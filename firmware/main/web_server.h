@@ -0,0 +1,79 @@
+/**
+ * @file web_server.h
+ * @brief On-device HTTP server
+ *
+ * Endpoints:
+ *   GET /
+ *       Single-page control UI, embedded gzipped at build time (see
+ *       tools/gen_web.py). Served with an ETag so reloads cost a 304.
+ *   GET /ws  (WebSocket)
+ *       Pushes a binary web_status_frame_t on connect and whenever the
+ *       crockpot status generation changes; the frame is encoded once per
+ *       change and sent to every client. Text frames are run through the
+ *       shared command table ("/high", "setpoint 190") and the reply is
+ *       sent back to that client as a text frame.
+ *   GET /history?from=&to=&res=1s|1m&boot=&format=csv|json
+ *       Streams history with chunked encoding. from/to are uptime seconds
+ *       of the selected boot. Without boot (or with the current boot id)
+ *       records come from RAM; an earlier boot id reads the flash log.
+ *   GET /metrics
+ *       Task, heap and latency metrics in the Prometheus text format.
+ */
+
+#ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Status frame pushed to WebSocket clients (little-endian)
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t version;            // WEB_STATUS_FRAME_VERSION
+    uint8_t state;              // crockpot_state_t
+    uint8_t flags;              // WEB_STATUS_FLAG_*
+    uint8_t duty_pct;
+    int32_t temperature_cc;     // temp_cc_t
+    int32_t setpoint_cc;        // temp_cc_t, 0 when OFF
+    uint32_t uptime_s;
+    uint32_t generation;        // crockpot_get_generation()
+} web_status_frame_t;
+
+#define WEB_STATUS_FRAME_VERSION    1
+
+#define WEB_STATUS_FLAG_SENSOR_ERROR    0x01
+#define WEB_STATUS_FLAG_WIFI            0x02
+
+/**
+ * @brief Start the HTTP server
+ *
+ * Safe to call before WiFi is connected; requests are served once an IP
+ * is assigned.
+ *
+ * @return true on success
+ */
+bool web_server_init(void);
+
+#define WEB_SERVER_PORT         80
+#define WEB_SERVER_STACK_SIZE   6144
+
+// Concurrent connections, WebSocket clients included (the least recently
+// used one is closed to make room; LWIP_MAX_SOCKETS must allow 3 more)
+#define WEB_SERVER_MAX_SOCKETS  7
+
+// Chunk buffer for streamed responses (reused by every request)
+#define WEB_SERVER_CHUNK_SIZE   1024
+
+// Longest command accepted in a WebSocket text frame
+#define WEB_SERVER_COMMAND_MAX_LEN  256
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEB_SERVER_H
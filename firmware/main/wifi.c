@@ -4,6 +4,8 @@
  */
 
 #include "wifi.h"
+#include "config.h"
+#include "metrics.h"
 
 #include <string.h>
 #include "freertos/FreeRTOS.h"
@@ -12,7 +14,8 @@
 #include "esp_wifi.h"
 #include "esp_log.h"
 #include "esp_event.h"
-#include "nvs_flash.h"
+#include "esp_mac.h"
+#include "nvs.h"
 
 static const char* TAG = "wifi";
 
@@ -29,6 +32,91 @@ static wifi_status_t s_status = WIFI_STATUS_DISCONNECTED;
 // Retry counter
 static int s_retry_count = 0;
 
+/**
+ * @brief Last AP we associated with (NVS blob)
+ *
+ * With the BSSID and channel known the station joins directly instead of
+ * scanning every channel, which is most of the time to reconnect after a
+ * reset or brownout.
+ */
+typedef struct {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+static wifi_ap_cache_t s_ap_cache;
+static bool s_using_cache = false;     // Current attempt targets the cached AP
+
+static bool ap_cache_load(const char* ssid)
+{
+    nvs_handle_t nvs;
+    size_t size = sizeof(s_ap_cache);
+
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    bool ok = nvs_get_blob(nvs, WIFI_NVS_KEY_AP, &s_ap_cache, &size) == ESP_OK &&
+              size == sizeof(s_ap_cache) &&
+              s_ap_cache.ssid[sizeof(s_ap_cache.ssid) - 1] == '\0' &&
+              strcmp(s_ap_cache.ssid, ssid) == 0;
+    nvs_close(nvs);
+    return ok;
+}
+
+static void ap_cache_store(const wifi_ap_cache_t* ap)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (ap == NULL) {
+        nvs_erase_key(nvs, WIFI_NVS_KEY_AP);
+    } else {
+        nvs_set_blob(nvs, WIFI_NVS_KEY_AP, ap, sizeof(*ap));
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+/**
+ * @brief Remember the AP just joined, if it differs from the cache
+ */
+static void ap_cache_update(const wifi_event_sta_connected_t* event)
+{
+    wifi_ap_cache_t ap = { 0 };
+    size_t len = (event->ssid_len < sizeof(ap.ssid)) ? event->ssid_len : sizeof(ap.ssid) - 1;
+    memcpy(ap.ssid, event->ssid, len);
+    memcpy(ap.bssid, event->bssid, sizeof(ap.bssid));
+    ap.channel = event->channel;
+
+    if (memcmp(&ap, &s_ap_cache, sizeof(ap)) != 0) {
+        ESP_LOGI(TAG, "Caching AP " MACSTR " on channel %u", MAC2STR(ap.bssid), ap.channel);
+        s_ap_cache = ap;
+        ap_cache_store(&ap);
+    }
+}
+
+/**
+ * @brief The cached AP did not answer: forget it and scan normally
+ */
+static void ap_cache_drop(void)
+{
+    wifi_config_t config;
+
+    ESP_LOGW(TAG, "Cached AP unavailable, scanning");
+    s_using_cache = false;
+    memset(&s_ap_cache, 0, sizeof(s_ap_cache));
+    ap_cache_store(NULL);
+
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK) {
+        config.sta.bssid_set = false;
+        config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+}
+
 // WiFi event handler
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data)
@@ -41,8 +129,22 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 esp_wifi_connect();
                 break;
 
+            case WIFI_EVENT_STA_CONNECTED:
+                metrics_boot_stage(METRIC_BOOT_WIFI_ASSOCIATED);
+                s_using_cache = false;
+                ap_cache_update((const wifi_event_sta_connected_t*)event_data);
+                break;
+
             case WIFI_EVENT_STA_DISCONNECTED:
-                if (s_retry_count < WIFI_MAX_RETRY) {
+                if (s_wifi_event_group) {
+                    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+                }
+                if (s_using_cache) {
+                    // Retry straight away with a scan; not counted as a retry
+                    ap_cache_drop();
+                    s_status = WIFI_STATUS_CONNECTING;
+                    esp_wifi_connect();
+                } else if (s_retry_count < WIFI_MAX_RETRY) {
                     ESP_LOGI(TAG, "Disconnected, retrying (%d/%d)...",
                              s_retry_count + 1, WIFI_MAX_RETRY);
                     s_retry_count++;
@@ -63,6 +165,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Connected! IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        metrics_boot_stage(METRIC_BOOT_ONLINE);
         s_retry_count = 0;
         s_status = WIFI_STATUS_CONNECTED;
         if (s_wifi_event_group) {
@@ -75,18 +178,6 @@ bool wifi_init(void)
 {
     ESP_LOGI(TAG, "Initializing WiFi");
 
-    // Initialize NVS
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_LOGW(TAG, "NVS partition was truncated, erasing...");
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize NVS: %s", esp_err_to_name(ret));
-        return false;
-    }
-
     // Create event group
     s_wifi_event_group = xEventGroupCreate();
     if (s_wifi_event_group == NULL) {
@@ -107,6 +198,10 @@ bool wifi_init(void)
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
+    // The config is rebuilt from defaults at every boot; keeping it out
+    // of flash saves a write per boot
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+
     // Register event handlers
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
         WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, NULL));
@@ -125,6 +220,7 @@ bool wifi_connect(void)
     wifi_config_t wifi_config = {
         .sta = {
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+            .listen_interval = WIFI_LISTEN_INTERVAL,
             .pmf_cfg = {
                 .capable = true,
                 .required = false
@@ -132,24 +228,40 @@ bool wifi_connect(void)
         },
     };
 
-    // TODO: Load credentials from NVS
-    // For now, use defaults from sdkconfig
-    strncpy((char*)wifi_config.sta.ssid, WIFI_DEFAULT_SSID,
+    // Saved credentials, else the build-time defaults
+    const config_t* settings = config_acquire();
+    bool saved = (settings->saved & CONFIG_SECTION_WIFI) != 0;
+    strncpy((char*)wifi_config.sta.ssid, saved ? settings->wifi_ssid : WIFI_DEFAULT_SSID,
             sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char*)wifi_config.sta.password, WIFI_DEFAULT_PASS,
+    strncpy((char*)wifi_config.sta.password, saved ? settings->wifi_password : WIFI_DEFAULT_PASS,
             sizeof(wifi_config.sta.password) - 1);
+    config_release();
 
     if (strlen((char*)wifi_config.sta.ssid) == 0) {
         ESP_LOGE(TAG, "WiFi SSID not configured");
         return false;
     }
 
-    ESP_LOGI(TAG, "Connecting to SSID: %s", wifi_config.sta.ssid);
+    // Join the last known AP directly; falls back to a scan if it is gone
+    s_using_cache = ap_cache_load((const char*)wifi_config.sta.ssid);
+    if (s_using_cache) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_ap_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = s_ap_cache.channel;
+        ESP_LOGI(TAG, "Connecting to SSID: %s (cached AP " MACSTR ", channel %u)",
+                 wifi_config.sta.ssid, MAC2STR(s_ap_cache.bssid), s_ap_cache.channel);
+    } else {
+        ESP_LOGI(TAG, "Connecting to SSID: %s", wifi_config.sta.ssid);
+    }
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
+    // Sleep the radio between beacons; the AP buffers frames meanwhile.
+    // Adds up to one listen interval of latency to inbound traffic.
+    esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+
     s_retry_count = 0;
     s_status = WIFI_STATUS_CONNECTING;
 
@@ -176,6 +288,17 @@ bool wifi_wait_connected(uint32_t timeout_ms)
     return false;
 }
 
+void wifi_wait_online(void)
+{
+    if (s_wifi_event_group == NULL) {
+        // WiFi never initialized: there is nothing to wait for
+        vTaskSuspend(NULL);
+    }
+
+    xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT,
+                        pdFALSE, pdTRUE, portMAX_DELAY);
+}
+
 wifi_status_t wifi_get_status(void)
 {
     return s_status;
@@ -211,11 +334,27 @@ void wifi_disconnect(void)
     ESP_LOGI(TAG, "Disconnecting WiFi");
     esp_wifi_disconnect();
     s_status = WIFI_STATUS_DISCONNECTED;
+    if (s_wifi_event_group) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+    }
 }
 
 bool wifi_set_credentials(const char* ssid, const char* password)
 {
-    // TODO: Store in NVS
-    ESP_LOGI(TAG, "Setting WiFi credentials (NVS storage not yet implemented)");
+    if (ssid == NULL || password == NULL) {
+        return false;
+    }
+
+    config_t* settings = config_edit();
+    if (strlen(ssid) >= sizeof(settings->wifi_ssid) ||
+        strlen(password) >= sizeof(settings->wifi_password)) {
+        config_commit(0);
+        return false;
+    }
+    strncpy(settings->wifi_ssid, ssid, sizeof(settings->wifi_ssid) - 1);
+    strncpy(settings->wifi_password, password, sizeof(settings->wifi_password) - 1);
+    config_commit(CONFIG_SECTION_WIFI);
+
+    ESP_LOGI(TAG, "WiFi credentials set for SSID: %s", ssid);
     return true;
 }
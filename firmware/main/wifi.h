@@ -28,7 +28,7 @@ typedef enum {
 /**
  * @brief Initialize WiFi subsystem
  *
- * Initializes NVS, netif, and event loop.
+ * Initializes netif and the event loop. NVS must already be initialized.
  * Must be called before wifi_connect().
  *
  * @return true on success, false on failure
@@ -38,7 +38,9 @@ bool wifi_init(void);
 /**
  * @brief Connect to configured WiFi network
  *
- * Attempts to connect using credentials from NVS or defaults.
+ * Attempts to connect using credentials from NVS or defaults. If the
+ * SSID matches the AP cached from the last association, joins that
+ * BSSID/channel without scanning (dropping the cache if it fails).
  * Non-blocking - use wifi_wait_connected() or wifi_get_status().
  *
  * @return true if connection attempt started, false on failure
@@ -55,6 +57,15 @@ bool wifi_connect(void);
  */
 bool wifi_wait_connected(uint32_t timeout_ms);
 
+/**
+ * @brief Block until WiFi has an IP address
+ *
+ * Unlike wifi_wait_connected() this ignores connection failures and has
+ * no timeout; tasks that only make sense online sleep here instead of
+ * polling wifi_is_connected().
+ */
+void wifi_wait_online(void);
+
 /**
  * @brief Get current WiFi status
  *
@@ -86,7 +97,7 @@ void wifi_disconnect(void);
 /**
  * @brief Set WiFi credentials
  *
- * Stores credentials in NVS for persistent storage.
+ * Saved in the settings store; used from the next wifi_connect().
  *
  * @param ssid Network SSID
  * @param password Network password
@@ -94,7 +105,7 @@ void wifi_disconnect(void);
  */
 bool wifi_set_credentials(const char* ssid, const char* password);
 
-// Default credentials (for development - use NVS in production)
+// Default credentials when none are saved (for development)
 #define WIFI_DEFAULT_SSID ""
 #define WIFI_DEFAULT_PASS ""
 
@@ -104,6 +115,15 @@ bool wifi_set_credentials(const char* ssid, const char* password);
 // Maximum reconnection attempts before giving up
 #define WIFI_MAX_RETRY 5
 
+// Modem sleep: wake for every 3rd beacon (~300 ms at the usual 100 TU
+// interval) to collect buffered traffic. Should be a multiple of the AP's
+// DTIM period so broadcast traffic is not missed.
+#define WIFI_LISTEN_INTERVAL 3
+
+// NVS location of the cached AP (BSSID + channel) for fast reconnect
+#define WIFI_NVS_NAMESPACE  "wifi_cache"
+#define WIFI_NVS_KEY_AP     "ap"
+
 #ifdef __cplusplus
 }
 #endif
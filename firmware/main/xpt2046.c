@@ -0,0 +1,183 @@
+/**
+ * @file xpt2046.c
+ * @brief XPT2046 resistive touch controller driver
+ *
+ * Command bytes are differential, 12-bit conversions. All but the last
+ * keep the ADC on with PENIRQ disabled (PD = 01), so the pen interrupt
+ * stays quiet during the read; the last one (PD = 00) powers the chip
+ * down and re-arms PENIRQ. The first conversion after switching axes is
+ * discarded while the panel settles.
+ */
+
+#include "xpt2046.h"
+#include "spi_bus.h"
+
+#include <string.h>
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char* TAG = "xpt2046";
+
+// Control bytes: start | channel | 12-bit differential | power mode
+#define XPT2046_CMD_X           0xD1    // X position, ADC on
+#define XPT2046_CMD_Y           0x91    // Y position, ADC on
+#define XPT2046_CMD_Z1          0xB1    // Pressure Z1, ADC on
+#define XPT2046_CMD_Z2          0xC1    // Pressure Z2, ADC on
+#define XPT2046_CMD_POWER_DOWN  0x90    // Y position, then power down with PENIRQ on
+
+#define XPT2046_ADC_MAX         4095
+
+// Z1, Z2, one settling + XPT2046_SAMPLES per axis, power down
+#define XPT2046_CONVERSIONS     (2 + 2 * (1 + XPT2046_SAMPLES) + 1)
+
+// Each command overlaps the previous result: 2 bytes per conversion,
+// plus the first command byte
+#define XPT2046_BATCH_BYTES     (2 * XPT2046_CONVERSIONS + 1)
+
+static spi_device_handle_t s_spi = NULL;
+
+// Batch buffers (the shared bus uses DMA)
+static DMA_ATTR uint8_t s_tx[XPT2046_BATCH_BYTES];
+static DMA_ATTR uint8_t s_rx[XPT2046_BATCH_BYTES];
+
+/**
+ * @brief Build the command stream once; it never changes
+ */
+static void build_batch(void)
+{
+    uint8_t cmds[XPT2046_CONVERSIONS];
+    size_t n = 0;
+
+    cmds[n++] = XPT2046_CMD_Z1;
+    cmds[n++] = XPT2046_CMD_Z2;
+    for (int i = 0; i <= XPT2046_SAMPLES; i++) {
+        cmds[n++] = XPT2046_CMD_X;
+    }
+    for (int i = 0; i <= XPT2046_SAMPLES; i++) {
+        cmds[n++] = XPT2046_CMD_Y;
+    }
+    cmds[n++] = XPT2046_CMD_POWER_DOWN;
+
+    memset(s_tx, 0, sizeof(s_tx));
+    for (size_t i = 0; i < n; i++) {
+        s_tx[2 * i] = cmds[i];
+    }
+}
+
+/**
+ * @brief Result of conversion n: busy bit, 12 data bits, 3 zero bits
+ */
+static uint16_t result(size_t n)
+{
+    return (uint16_t)((((uint16_t)s_rx[2 * n + 1] << 8) | s_rx[2 * n + 2]) >> 3) & XPT2046_ADC_MAX;
+}
+
+/**
+ * @brief Median of XPT2046_SAMPLES conversions starting at first
+ */
+static uint16_t median(size_t first)
+{
+    uint16_t v[XPT2046_SAMPLES];
+
+    // Insertion sort; seven values
+    for (size_t i = 0; i < XPT2046_SAMPLES; i++) {
+        uint16_t x = result(first + i);
+        size_t j = i;
+        while (j > 0 && v[j - 1] > x) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = x;
+    }
+    return v[XPT2046_SAMPLES / 2];
+}
+
+static bool transfer(void)
+{
+    spi_transaction_t trans = {
+        .length = XPT2046_BATCH_BYTES * 8,
+        .tx_buffer = s_tx,
+        .rx_buffer = s_rx,
+    };
+
+    // ~160 us at 2 MHz: polling beats interrupt and task-switch overhead
+    return spi_device_polling_transmit(s_spi, &trans) == ESP_OK;
+}
+
+bool xpt2046_read(xpt2046_sample_t* sample)
+{
+    if (s_spi == NULL || sample == NULL || !transfer()) {
+        return false;
+    }
+
+    // Conversion order matches build_batch()
+    const size_t x_first = 2 + 1;
+    const size_t y_first = x_first + XPT2046_SAMPLES + 1;
+
+    int32_t z = (int32_t)result(0) + XPT2046_ADC_MAX - (int32_t)result(1);
+    sample->z = (result(0) == 0 || z < 0) ? 0 : (uint16_t)z;
+    sample->x = median(x_first);
+    sample->y = median(y_first);
+    return true;
+}
+
+bool xpt2046_init(void)
+{
+    ESP_LOGI(TAG, "Initializing XPT2046 on SPI (CS=%d, IRQ=%d)",
+             XPT2046_PIN_CS, XPT2046_PIN_IRQ);
+
+    if (!spi_bus_shared_init()) {
+        return false;
+    }
+
+    // PENIRQ: open drain on the chip, so pull up here
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << XPT2046_PIN_IRQ,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    if (gpio_config(&io_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure PENIRQ GPIO");
+        return false;
+    }
+
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = XPT2046_SPI_CLOCK_HZ,
+        .mode = 0,                   // SPI Mode 0 (CPOL=0, CPHA=0)
+        .spics_io_num = XPT2046_PIN_CS,
+        .queue_size = 1,
+        .flags = 0,
+    };
+
+    esp_err_t ret = spi_bus_add_device(SPI_BUS_HOST, &dev_cfg, &s_spi);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        return false;
+    }
+
+    build_batch();
+
+    // An absent chip leaves MISO stuck: every word reads all 0s or all 1s
+    bool all_zero = true;
+    bool all_ones = true;
+    if (transfer()) {
+        for (size_t i = 0; i < XPT2046_CONVERSIONS; i++) {
+            uint16_t v = result(i);
+            all_zero = all_zero && v == 0;
+            all_ones = all_ones && v == XPT2046_ADC_MAX;
+        }
+    }
+    if (all_zero || all_ones) {
+        ESP_LOGW(TAG, "No XPT2046 found");
+        spi_bus_remove_device(s_spi);
+        s_spi = NULL;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "XPT2046 touch controller initialized");
+    return true;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file xpt2046.h
+ * @brief XPT2046 resistive touch controller (SPI)
+ *
+ * Chip-level driver used by touch_hal.c. One call reads Z1/Z2 and
+ * XPT2046_SAMPLES conversions each of X and Y in a single SPI
+ * transaction (16 clocks per conversion, each command overlapping the
+ * previous result), returns the median X and Y, and leaves the chip
+ * powered down with PENIRQ armed.
+ *
+ * The controller shares the SPI bus with the MAX31855 and the TFT (see
+ * spi_bus.h); the SPI master's bus lock arbitrates between them, so a
+ * read waits at most for the display band already in flight.
+ */
+
+#ifndef XPT2046_H
+#define XPT2046_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One filtered reading (raw 12-bit ADC units)
+ */
+typedef struct {
+    uint16_t x;                 // Median X
+    uint16_t y;                 // Median Y
+    uint16_t z;                 // Pressure (0 = not touched, higher = firmer)
+} xpt2046_sample_t;
+
+/**
+ * @brief Add the controller to the shared SPI bus and set up PENIRQ
+ *
+ * PENIRQ is configured as an input with its interrupt disabled; the
+ * caller attaches the handler.
+ *
+ * @return true if the controller answered
+ */
+bool xpt2046_init(void);
+
+/**
+ * @brief Read a filtered sample
+ *
+ * Call from task context.
+ *
+ * @param sample Result
+ * @return true on success (sample->z tells whether the panel is touched)
+ */
+bool xpt2046_read(xpt2046_sample_t* sample);
+
+// XPT2046 wiring (XIAO ESP32-C3, D6=GPIO21, D7=GPIO20; the console runs
+// over USB Serial/JTAG so UART0's pins are free)
+#define XPT2046_PIN_CS        21        // D6 - Chip Select
+#define XPT2046_PIN_IRQ       20        // D7 - PENIRQ (active low, open drain)
+#define XPT2046_SPI_CLOCK_HZ  2000000   // 2 MHz (chip maximum 2.5 MHz)
+
+// Conversions per axis per read (odd, for the median)
+#define XPT2046_SAMPLES       7
+
+// Pressure below which the panel counts as not touched
+#define XPT2046_Z_THRESHOLD   300
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XPT2046_H
@@ -0,0 +1,169 @@
+/**
+ * @file bench.c
+ * @brief Benchmark runner and baseline check
+ *
+ *   bench            run, compare with baselines.txt, exit 1 on regression
+ *   bench --update   run and rewrite baselines.txt with the new figures
+ */
+
+#include "bench.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_METRICS   32
+#define BENCH_NAME_LEN      48
+#define BENCH_UNIT_LEN      16
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    char unit[BENCH_UNIT_LEN];
+    double value;
+    bench_kind_t kind;
+} metric_t;
+
+static metric_t s_results[BENCH_MAX_METRICS];
+static size_t s_result_count = 0;
+
+static metric_t s_baselines[BENCH_MAX_METRICS];
+static size_t s_baseline_count = 0;
+
+static bool s_failed = false;
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void bench_report(const char* name, double value, const char* unit, bench_kind_t kind)
+{
+    if (s_result_count >= BENCH_MAX_METRICS) {
+        fprintf(stderr, "bench: too many metrics\n");
+        exit(2);
+    }
+    metric_t* m = &s_results[s_result_count++];
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    snprintf(m->unit, sizeof(m->unit), "%s", unit);
+    m->value = value;
+    m->kind = kind;
+}
+
+void bench_fail(const char* name, const char* reason)
+{
+    fprintf(stderr, "bench: %s: %s\n", name, reason);
+    s_failed = true;
+}
+
+static void load_baselines(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "bench: no baselines at %s\n", path);
+        return;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), f) != NULL && s_baseline_count < BENCH_MAX_METRICS) {
+        metric_t* m = &s_baselines[s_baseline_count];
+        if (line[0] == '#' ||
+            sscanf(line, "%47s %lf %15s", m->name, &m->value, m->unit) != 3) {
+            continue;
+        }
+        s_baseline_count++;
+    }
+    fclose(f);
+}
+
+static const metric_t* find_baseline(const char* name)
+{
+    for (size_t i = 0; i < s_baseline_count; i++) {
+        if (strcmp(s_baselines[i].name, name) == 0) {
+            return &s_baselines[i];
+        }
+    }
+    return NULL;
+}
+
+static bool write_baselines(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return false;
+    }
+
+    fprintf(f, "# Host benchmark baselines: name value unit\n"
+               "# Regenerate with `bench --update` on a quiet machine after an\n"
+               "# intended change; times fail above value * BENCH_TOLERANCE\n"
+               "# (default %.1f), counts fail on any increase.\n",
+            BENCH_DEFAULT_TOLERANCE);
+    for (size_t i = 0; i < s_result_count; i++) {
+        const metric_t* m = &s_results[i];
+        if (m->kind == BENCH_TIME) {
+            fprintf(f, "%s %.1f %s\n", m->name, m->value, m->unit);
+        } else {
+            fprintf(f, "%s %.0f %s\n", m->name, m->value, m->unit);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void check_results(double tolerance)
+{
+    printf("%-32s %12s %12s  %s\n", "metric", "value", "baseline", "unit");
+    for (size_t i = 0; i < s_result_count; i++) {
+        const metric_t* m = &s_results[i];
+        const metric_t* base = find_baseline(m->name);
+
+        const char* verdict = "";
+        if (base == NULL) {
+            verdict = "  (no baseline)";
+        } else if (m->kind == BENCH_TIME && m->value > base->value * tolerance) {
+            verdict = "  REGRESSED";
+            s_failed = true;
+        } else if (m->kind == BENCH_COUNT && m->value > base->value) {
+            verdict = "  REGRESSED";
+            s_failed = true;
+        }
+
+        if (base != NULL) {
+            printf("%-32s %12.1f %12.1f  %s%s\n", m->name, m->value, base->value,
+                   m->unit, verdict);
+        } else {
+            printf("%-32s %12.1f %12s  %s%s\n", m->name, m->value, "-", m->unit, verdict);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool update = (argc > 1 && strcmp(argv[1], "--update") == 0);
+
+    const char* env = getenv("BENCH_TOLERANCE");
+    double tolerance = env ? atof(env) : BENCH_DEFAULT_TOLERANCE;
+    if (tolerance < 1.0) {
+        tolerance = BENCH_DEFAULT_TOLERANCE;
+    }
+
+    bench_core();
+    bench_telegram();
+    bench_gui();
+
+    if (update) {
+        if (s_failed || !write_baselines(BENCH_BASELINES)) {
+            return 1;
+        }
+        printf("bench: wrote %zu baselines to %s\n", s_result_count, BENCH_BASELINES);
+        return 0;
+    }
+
+    load_baselines(BENCH_BASELINES);
+    check_results(tolerance);
+    return s_failed ? 1 : 0;
+}
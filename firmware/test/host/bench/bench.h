@@ -0,0 +1,53 @@
+/**
+ * @file bench.h
+ * @brief Microbenchmarks of the firmware hot paths, checked against baselines
+ *
+ * Each benchmark reports named metrics through bench_report(). Times are
+ * host nanoseconds (the best of several runs, so they track the code and
+ * not the machine's noise); counts are deterministic work figures such as
+ * pixels drawn or bytes flushed. bench.c compares every metric with
+ * bench/baselines.txt and fails the run on a regression.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+typedef enum {
+    BENCH_TIME,     // Fails above baseline * BENCH_TOLERANCE
+    BENCH_COUNT     // Fails on any increase
+} bench_kind_t;
+
+/**
+ * @brief Record one metric
+ *
+ * @param name  Baseline key (lowercase, no spaces)
+ * @param value Measured value
+ * @param unit  Unit, for the report only
+ * @param kind  How a regression is judged
+ */
+void bench_report(const char* name, double value, const char* unit, bench_kind_t kind);
+
+/**
+ * @brief Report a benchmark that could not run (e.g. wrong parse result)
+ */
+void bench_fail(const char* name, const char* reason);
+
+/**
+ * @brief Monotonic host time in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+// Runs of each timed loop; the fastest counts
+#define BENCH_RUNS 7
+
+// Default allowed slowdown for BENCH_TIME metrics (env BENCH_TOLERANCE)
+#define BENCH_DEFAULT_TOLERANCE 2.0
+
+// Benchmarks (bench_core.c, bench_telegram.c, bench_gui.c)
+void bench_core(void);
+void bench_telegram(void);
+void bench_gui(void);
+
+#endif // BENCH_H
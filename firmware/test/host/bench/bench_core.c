@@ -0,0 +1,63 @@
+/**
+ * @file bench_core.c
+ * @brief Status snapshot and PID step cost
+ *
+ * crockpot_get_status() is read by every interface on every request and
+ * render; pid_update() runs once per control cycle.
+ */
+
+#include "bench.h"
+
+#include "crockpot.h"
+#include "pid.h"
+
+#define SNAPSHOT_ITERATIONS 1000000
+#define PID_ITERATIONS      1000000
+
+static volatile int32_t s_sink;
+
+static void bench_status_snapshot(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < SNAPSHOT_ITERATIONS; i++) {
+            crockpot_status_t status = crockpot_get_status();
+            s_sink = status.temperature;
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    bench_report("status_snapshot", (double)best / SNAPSHOT_ITERATIONS, "ns/op", BENCH_TIME);
+}
+
+static void bench_pid_step(void)
+{
+    // The control loop's own gains, on a slowly wandering input so the
+    // output moves through the unsaturated range
+    pid_controller_t pid;
+    pid_init(&pid,
+             PID_GAIN_Q16(CROCKPOT_PID_KP * 9 / 500),
+             PID_GAIN_Q16(CROCKPOT_PID_KI * 9 / 500),
+             PID_GAIN_Q16(CROCKPOT_PID_KD * 9 / 500),
+             0, 1000);
+
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < PID_ITERATIONS; i++) {
+            int32_t input = CROCKPOT_SETPOINT_HIGH - 200 + (i & 0x1FF);
+            s_sink = pid_update(&pid, CROCKPOT_SETPOINT_HIGH, input,
+                                CROCKPOT_CONTROL_INTERVAL_MS);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    bench_report("pid_step", (double)best / PID_ITERATIONS, "ns/op", BENCH_TIME);
+}
+
+void bench_core(void)
+{
+    bench_status_snapshot();
+    bench_pid_step();
+}
@@ -0,0 +1,104 @@
+/**
+ * @file bench_gui.c
+ * @brief Status screen render cost: time, pixels drawn, bytes flushed
+ *
+ * Includes gui.c to call render_screen() directly on the framebuffer
+ * display HAL, without the GUI task. The pixel and byte counts are what
+ * the ILI9341 driver would rasterize and push over SPI for the same frame.
+ */
+
+#include "bench.h"
+#include "mock.h"
+
+#include "gui.c"
+
+#define FULL_ITERATIONS         200
+#define INCREMENTAL_ITERATIONS  2000
+
+static const crockpot_status_t s_bench_status = {
+    .state = CROCKPOT_HIGH,
+    .temperature = CROCKPOT_SETPOINT_HIGH,
+    .setpoint = CROCKPOT_SETPOINT_HIGH,
+    .heater_duty_pct = 36,
+    .uptime_seconds = 3 * 3600 + 25 * 60,
+    .wifi_connected = true,
+    .sensor_error = false,
+};
+
+static void bench_full_frame(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < FULL_ITERATIONS; i++) {
+            s_full_redraw = true;
+            render_screen();
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+
+    mock_display_reset_stats();
+    s_full_redraw = true;
+    render_screen();
+    mock_display_stats_t stats = mock_display_stats();
+
+    bench_report("gui_full_frame", (double)best / FULL_ITERATIONS / 1000.0, "us", BENCH_TIME);
+    bench_report("gui_full_frame_pixels", (double)stats.pixels_written, "px", BENCH_COUNT);
+    bench_report("gui_full_frame_bytes", (double)stats.bytes_flushed, "B", BENCH_COUNT);
+}
+
+static void bench_temperature_frame(void)
+{
+    // The common frame: only the temperature reading moved (by 0.1 F)
+    const temp_cc_t temps[2] = { CROCKPOT_SETPOINT_HIGH, CROCKPOT_SETPOINT_HIGH + 6 };
+
+    uint64_t best = UINT64_MAX;
+    int flip = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < INCREMENTAL_ITERATIONS; i++) {
+            s_status.temperature = temps[flip ^= 1];
+            render_screen();
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+
+    mock_display_reset_stats();
+    s_status.temperature = temps[flip ^= 1];
+    render_screen();
+    mock_display_stats_t stats = mock_display_stats();
+
+    if (stats.flushes != 1) {
+        bench_fail("gui_temp_frame", "temperature change did not render");
+        return;
+    }
+    bench_report("gui_temp_frame", (double)best / INCREMENTAL_ITERATIONS / 1000.0, "us",
+                 BENCH_TIME);
+    bench_report("gui_temp_frame_pixels", (double)stats.pixels_written, "px", BENCH_COUNT);
+    bench_report("gui_temp_frame_bytes", (double)stats.bytes_flushed, "B", BENCH_COUNT);
+}
+
+static void bench_idle_frame(void)
+{
+    // Nothing changed: the frame must be skipped after hashing
+    mock_display_reset_stats();
+    render_screen();
+    mock_display_stats_t stats = mock_display_stats();
+    bench_report("gui_idle_frame_pixels", (double)stats.pixels_written, "px", BENCH_COUNT);
+    bench_report("gui_idle_frame_bytes", (double)stats.bytes_flushed, "B", BENCH_COUNT);
+}
+
+void bench_gui(void)
+{
+    if (!gui_init()) {
+        bench_fail("gui", "gui_init() failed");
+        return;
+    }
+    s_status = s_bench_status;
+
+    bench_full_frame();
+    bench_temperature_frame();
+    bench_idle_frame();
+}
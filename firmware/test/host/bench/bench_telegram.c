@@ -0,0 +1,64 @@
+/**
+ * @file bench_telegram.c
+ * @brief getUpdates parse cost per KB of response
+ *
+ * Includes telegram.c to drive its streaming parser (poll_reset() and the
+ * token callback) directly, the way http_event_handler() feeds it.
+ */
+
+#include "bench.h"
+
+#include "telegram.c"
+
+#define PARSE_ITERATIONS    2000
+#define PARSE_CHUNK         512     // Typical TLS record payload seen by ON_DATA
+
+static char s_body[8192];
+static size_t s_body_len = 0;
+
+static void build_body(void)
+{
+    size_t n = (size_t)snprintf(s_body, sizeof(s_body), "{\"ok\":true,\"result\":[");
+    for (int i = 0; i < TELEGRAM_UPDATES_PER_POLL; i++) {
+        n += (size_t)snprintf(s_body + n, sizeof(s_body) - n,
+            "%s{\"update_id\":%d,\"message\":{\"message_id\":%d,"
+            "\"from\":{\"id\":123456789,\"is_bot\":false,\"first_name\":\"Cook\","
+            "\"username\":\"cook\",\"language_code\":\"en\"},"
+            "\"chat\":{\"id\":123456789,\"first_name\":\"Cook\",\"username\":\"cook\","
+            "\"type\":\"private\"},\"date\":1760000000,"
+            "\"text\":\"/setpoint 19%d\","
+            "\"entities\":[{\"offset\":0,\"length\":9,\"type\":\"bot_command\"}]}}",
+            i ? "," : "", 500000000 + i, 1000 + i, i);
+    }
+    n += (size_t)snprintf(s_body + n, sizeof(s_body) - n, "]}");
+    s_body_len = n;
+}
+
+void bench_telegram(void)
+{
+    build_body();
+
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < PARSE_ITERATIONS; i++) {
+            poll_reset();
+            for (size_t pos = 0; pos < s_body_len; pos += PARSE_CHUNK) {
+                size_t len = s_body_len - pos < PARSE_CHUNK ? s_body_len - pos : PARSE_CHUNK;
+                json_stream_feed(&s_poll.json, s_body + pos, len);
+            }
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+
+    if (s_poll.json.error || !s_poll.ok || s_poll.count != TELEGRAM_UPDATES_PER_POLL ||
+        strcmp(s_poll.updates[TELEGRAM_UPDATES_PER_POLL - 1].text, "/setpoint 197") != 0) {
+        bench_fail("telegram_parse", "response parsed wrongly");
+        return;
+    }
+
+    double us_per_parse = (double)best / PARSE_ITERATIONS / 1000.0;
+    bench_report("telegram_parse", us_per_parse * 1024.0 / (double)s_body_len,
+                 "us/KB", BENCH_TIME);
+}
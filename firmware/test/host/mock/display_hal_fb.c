@@ -0,0 +1,306 @@
+/**
+ * @file display_hal_fb.c
+ * @brief Display HAL on an in-memory RGB565 framebuffer
+ *
+ * Draws like display_hal_ili9341.c (same font atlas, same opaque
+ * anti-aliased text boxes) but into host memory, and counts the work: every
+ * framebuffer store, and the bytes a flush would push over SPI.
+ */
+
+#include "display_hal.h"
+#include "font.h"
+#include "mock.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FB_WIDTH    320
+#define FB_HEIGHT   240
+
+static color_t s_fb[FB_WIDTH * FB_HEIGHT];
+static color_t s_text_bg = COLOR_BLACK;
+static mock_display_stats_t s_stats;
+
+static display_info_t s_info = {
+    .width = FB_WIDTH,
+    .height = FB_HEIGHT,
+    .bits_per_pixel = 16,
+    .touch_capable = true,
+    .initialized = false
+};
+
+mock_display_stats_t mock_display_stats(void)
+{
+    return s_stats;
+}
+
+void mock_display_reset_stats(void)
+{
+    uint8_t brightness = s_stats.brightness;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.brightness = brightness;
+}
+
+color_t mock_display_pixel(int16_t x, int16_t y)
+{
+    if (x < 0 || y < 0 || x >= s_info.width || y >= s_info.height) {
+        return 0;
+    }
+    return s_fb[y * s_info.width + x];
+}
+
+static inline void put(int16_t x, int16_t y, color_t color)
+{
+    if (x < 0 || y < 0 || x >= s_info.width || y >= s_info.height) {
+        return;
+    }
+    s_fb[y * s_info.width + x] = color;
+    s_stats.pixels_written++;
+}
+
+bool display_hal_init(void)
+{
+    s_info.initialized = true;
+    return true;
+}
+
+display_info_t display_hal_get_info(void)
+{
+    return s_info;
+}
+
+void display_hal_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, color_t color)
+{
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t x1 = (x + w > s_info.width) ? s_info.width : x + w;
+    int16_t y1 = (y + h > s_info.height) ? s_info.height : y + h;
+
+    for (int16_t row = y0; row < y1; row++) {
+        for (int16_t col = x0; col < x1; col++) {
+            s_fb[row * s_info.width + col] = color;
+        }
+    }
+    if (x1 > x0 && y1 > y0) {
+        s_stats.pixels_written += (uint64_t)(x1 - x0) * (y1 - y0);
+    }
+}
+
+void display_hal_clear(color_t color)
+{
+    display_hal_fill_rect(0, 0, s_info.width, s_info.height, color);
+}
+
+void display_hal_pixel(int16_t x, int16_t y, color_t color)
+{
+    put(x, y, color);
+}
+
+void display_hal_hline(int16_t x, int16_t y, int16_t w, color_t color)
+{
+    display_hal_fill_rect(x, y, w, 1, color);
+}
+
+void display_hal_vline(int16_t x, int16_t y, int16_t h, color_t color)
+{
+    display_hal_fill_rect(x, y, 1, h, color);
+}
+
+void display_hal_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, color_t color)
+{
+    int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+
+    while (1) {
+        put(x0, y0, color);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int16_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+void display_hal_rect(int16_t x, int16_t y, int16_t w, int16_t h, color_t color)
+{
+    display_hal_hline(x, y, w, color);
+    display_hal_hline(x, y + h - 1, w, color);
+    display_hal_vline(x, y, h, color);
+    display_hal_vline(x + w - 1, y, h, color);
+}
+
+/**
+ * @brief Midpoint circle quadrants
+ *
+ * Quadrant centres are (x, y), (x + dx, y), (x, y + dy) and
+ * (x + dx, y + dy), so the same walk serves circles and rounded corners.
+ */
+static void circle_points(int16_t x, int16_t y, int16_t r, int16_t dx, int16_t dy,
+                          bool fill, color_t color)
+{
+    int16_t f = 1 - r, ddx = 1, ddy = -2 * r;
+    int16_t px = 0, py = r;
+
+    while (px <= py) {
+        if (fill) {
+            display_hal_hline(x - py, y - px, 2 * py + 1 + dx, color);
+            display_hal_hline(x - px, y - py, 2 * px + 1 + dx, color);
+            display_hal_hline(x - py, y + px + dy, 2 * py + 1 + dx, color);
+            display_hal_hline(x - px, y + py + dy, 2 * px + 1 + dx, color);
+        } else {
+            put(x + dx + px, y + dy + py, color);
+            put(x + dx + py, y + dy + px, color);
+            put(x - px, y + dy + py, color);
+            put(x - py, y + dy + px, color);
+            put(x + dx + px, y - py, color);
+            put(x + dx + py, y - px, color);
+            put(x - px, y - py, color);
+            put(x - py, y - px, color);
+        }
+        if (f >= 0) {
+            py--;
+            ddy += 2;
+            f += ddy;
+        }
+        px++;
+        ddx += 2;
+        f += ddx;
+    }
+}
+
+void display_hal_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, color_t color)
+{
+    int16_t max_r = (w < h ? w : h) / 2;
+    if (r > max_r) r = max_r;
+
+    display_hal_hline(x + r, y, w - 2 * r, color);
+    display_hal_hline(x + r, y + h - 1, w - 2 * r, color);
+    display_hal_vline(x, y + r, h - 2 * r, color);
+    display_hal_vline(x + w - 1, y + r, h - 2 * r, color);
+    circle_points(x + r, y + r, r, w - 2 * r - 1, h - 2 * r - 1, false, color);
+}
+
+void display_hal_fill_round_rect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, color_t color)
+{
+    int16_t max_r = (w < h ? w : h) / 2;
+    if (r > max_r) r = max_r;
+
+    display_hal_fill_rect(x, y + r, w, h - 2 * r, color);
+    circle_points(x + r, y + r, r, w - 2 * r - 1, h - 2 * r - 1, true, color);
+}
+
+void display_hal_circle(int16_t x, int16_t y, int16_t r, color_t color)
+{
+    circle_points(x, y, r, 0, 0, false, color);
+}
+
+void display_hal_fill_circle(int16_t x, int16_t y, int16_t r, color_t color)
+{
+    circle_points(x, y, r, 0, 0, true, color);
+}
+
+static color_t blend565(color_t bg, color_t fg, uint8_t level)
+{
+    uint16_t r = (((bg >> 11) & 0x1F) * (3 - level) + ((fg >> 11) & 0x1F) * level) / 3;
+    uint16_t g = (((bg >> 5)  & 0x3F) * (3 - level) + ((fg >> 5)  & 0x3F) * level) / 3;
+    uint16_t b = ((bg & 0x1F) * (3 - level) + (fg & 0x1F) * level) / 3;
+    return (color_t)((r << 11) | (g << 5) | b);
+}
+
+void display_hal_text(int16_t x, int16_t y, const char* text,
+                      font_size_t font, color_t color, text_align_t align)
+{
+    if (text == NULL || *text == '\0') return;
+
+    const font_t* f = font_get(font);
+    int16_t width = display_hal_text_width(text, font);
+    if (align == ALIGN_CENTER) {
+        x -= width / 2;
+    } else if (align == ALIGN_RIGHT) {
+        x -= width;
+    }
+
+    color_t palette[4];
+    for (uint8_t level = 0; level < 4; level++) {
+        palette[level] = blend565(s_text_bg, color, level);
+    }
+
+    // Opaque box, then the inked pixels
+    display_hal_fill_rect(x, y, width, f->height, palette[0]);
+
+    int16_t pen = x;
+    for (const char* p = text; *p; p++) {
+        const font_glyph_t* g = font_glyph(f, *p);
+        int16_t gx = pen + g->x_offset;
+        pen += g->advance;
+
+        uint8_t stride = font_glyph_stride(g);
+        const uint8_t* src = f->bitmap + g->offset;
+        for (int16_t row = 0; g->width != 0 && row < f->height; row++, src += stride) {
+            for (uint8_t col = 0; col < g->width; col++) {
+                uint8_t level = (src[col / 4] >> (6 - 2 * (col % 4))) & 0x3;
+                int16_t px = gx + col;
+                if (level && px >= x && px < x + width) {
+                    put(px, y + row, palette[level]);
+                }
+            }
+        }
+    }
+}
+
+void display_hal_set_text_background(color_t color)
+{
+    s_text_bg = color;
+}
+
+int16_t display_hal_text_width(const char* text, font_size_t font)
+{
+    if (text == NULL) return 0;
+
+    const font_t* f = font_get(font);
+    int16_t width = 0;
+    for (const char* p = text; *p; p++) {
+        width += font_glyph(f, *p)->advance;
+    }
+    return width;
+}
+
+int16_t display_hal_font_height(font_size_t font)
+{
+    return font_get(font)->height;
+}
+
+void display_hal_set_brightness(uint8_t brightness)
+{
+    s_stats.brightness = brightness > 100 ? 100 : brightness;
+}
+
+void display_hal_flush(void)
+{
+    s_stats.flushes++;
+    s_stats.bytes_flushed += (uint64_t)s_info.width * s_info.height * sizeof(color_t);
+}
+
+void display_hal_flush_rects(const display_rect_t* rects, uint8_t count)
+{
+    if (rects == NULL || count == 0) {
+        return;
+    }
+
+    s_stats.flushes++;
+    for (uint8_t i = 0; i < count; i++) {
+        int32_t w = rects[i].w, h = rects[i].h;
+        if (w > 0 && h > 0) {
+            s_stats.bytes_flushed += (uint64_t)w * h * sizeof(color_t);
+        }
+    }
+}
+
+void display_hal_set_rotation(uint16_t rotation)
+{
+    bool portrait = (rotation == 0 || rotation == 180);
+    s_info.width = portrait ? FB_HEIGHT : FB_WIDTH;
+    s_info.height = portrait ? FB_WIDTH : FB_HEIGHT;
+}
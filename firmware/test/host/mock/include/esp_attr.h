@@ -0,0 +1,14 @@
+/**
+ * @file esp_attr.h
+ * @brief Host shim for ESP-IDF placement attributes (all no-ops)
+ */
+
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // ESP_ATTR_H
@@ -0,0 +1,21 @@
+/**
+ * @file esp_crt_bundle.h
+ * @brief Host shim for the certificate bundle
+ */
+
+#ifndef ESP_CRT_BUNDLE_H
+#define ESP_CRT_BUNDLE_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_crt_bundle_attach(void* conf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESP_CRT_BUNDLE_H
@@ -0,0 +1,22 @@
+/**
+ * @file esp_event.h
+ * @brief Host shim for the event loop types used in headers
+ */
+
+#ifndef ESP_EVENT_H
+#define ESP_EVENT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef const char* esp_event_base_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESP_EVENT_H
@@ -0,0 +1,28 @@
+/**
+ * @file esp_task_wdt.h
+ * @brief Host shim for the task watchdog
+ *
+ * The simulator aborts the run if a subscribed task goes
+ * CONFIG_ESP_TASK_WDT_TIMEOUT_S of virtual time without a reset.
+ */
+
+#ifndef ESP_TASK_WDT_H
+#define ESP_TASK_WDT_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_task_wdt_add(TaskHandle_t task);
+esp_err_t esp_task_wdt_delete(TaskHandle_t task);
+esp_err_t esp_task_wdt_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESP_TASK_WDT_H
@@ -0,0 +1,11 @@
+/**
+ * @file esp_tls.h
+ * @brief Host shim for esp-tls (nothing the host build uses)
+ */
+
+#ifndef ESP_TLS_H
+#define ESP_TLS_H
+
+#include "esp_err.h"
+
+#endif // ESP_TLS_H
@@ -0,0 +1,15 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host build configuration (the subset of sdkconfig.defaults the
+ *        compiled modules read)
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_IDF_TARGET_ESP32C3           1
+#define CONFIG_FREERTOS_HZ                  1000
+#define CONFIG_ESP_TASK_WDT_TIMEOUT_S       10
+#define CONFIG_LOG_DEFAULT_LEVEL            2
+
+#endif // SDKCONFIG_H
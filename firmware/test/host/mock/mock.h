@@ -0,0 +1,200 @@
+/**
+ * @file mock.h
+ * @brief Test-side controls for the host mocks
+ *
+ * The firmware sees ordinary ESP-IDF and module APIs; tests use these
+ * functions to feed the mocks (thermocouple frames, HTTP responses,
+ * touch events) and to observe their outputs (GPIO levels, framebuffer,
+ * sent messages).
+ */
+
+#ifndef MOCK_H
+#define MOCK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "display_hal.h"
+#include "touch_hal.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// GPIO (mock_hal.c)
+// ============================================================================
+
+/**
+ * @brief Current output level of a pin
+ */
+int mock_gpio_level(int pin);
+
+/**
+ * @brief Virtual time the pin has been high since the last stats reset
+ */
+int64_t mock_gpio_high_us(int pin);
+
+/**
+ * @brief Number of level changes since the last stats reset
+ */
+uint32_t mock_gpio_edges(int pin);
+
+/**
+ * @brief Restart the high-time and edge counters of every pin
+ */
+void mock_gpio_reset_stats(void);
+
+// ============================================================================
+// MAX31855 on the SPI bus (mock_max31855.c)
+// ============================================================================
+
+/**
+ * @brief Produces the next 32-bit frame the converter returns
+ */
+typedef uint32_t (*mock_max31855_source_t)(void* ctx);
+
+/**
+ * @brief Encode a good conversion
+ *
+ * @param tc_q Thermocouple temperature, 0.25 C units
+ * @param cj_q Cold junction temperature, 0.0625 C units
+ */
+uint32_t mock_max31855_frame(int16_t tc_q, int16_t cj_q);
+
+/**
+ * @brief Encode a fault (TEMPERATURE_FAULT_OPEN / _SHORT_GND / _SHORT_VCC)
+ */
+uint32_t mock_max31855_fault_frame(uint8_t fault);
+
+/**
+ * @brief Answer reads from a fixed list of frames
+ *
+ * @param frames Frames in read order (not copied; keep it alive)
+ * @param count  Number of frames
+ * @param loop   Start over after the last frame, else repeat the last one
+ */
+void mock_max31855_play(const uint32_t* frames, size_t count, bool loop);
+
+/**
+ * @brief Answer reads from a callback (e.g. a thermal model)
+ */
+void mock_max31855_set_source(mock_max31855_source_t source, void* ctx);
+
+/**
+ * @brief Fail SPI transactions until cleared
+ */
+void mock_max31855_set_bus_error(bool error);
+
+/**
+ * @brief Hold SPI transactions (the caller blocks) until cleared
+ */
+void mock_max31855_set_stalled(bool stalled);
+
+/**
+ * @brief SPI reads served so far
+ */
+uint32_t mock_max31855_reads(void);
+
+// ============================================================================
+// Framebuffer display (display_hal_fb.c)
+// ============================================================================
+
+typedef struct {
+    uint64_t pixels_written;    // Framebuffer stores by drawing calls
+    uint64_t bytes_flushed;     // RGB565 bytes the panel driver would send
+    uint32_t flushes;           // display_hal_flush*() calls with work to do
+    uint8_t brightness;         // Last backlight setting
+} mock_display_stats_t;
+
+mock_display_stats_t mock_display_stats(void);
+void mock_display_reset_stats(void);
+
+/**
+ * @brief Pixel in the framebuffer (what the panel would show after a flush)
+ */
+color_t mock_display_pixel(int16_t x, int16_t y);
+
+// ============================================================================
+// Touch input (mock_modules.c)
+// ============================================================================
+
+/**
+ * @brief Queue an input event and call the registered touch callback
+ */
+void mock_touch_push(const touch_event_t* event);
+
+// ============================================================================
+// Settings and connectivity (mock_modules.c)
+// ============================================================================
+
+/**
+ * @brief The settings the config_* stubs serve
+ *
+ * Tests fill it in (and set `saved` bits) before initializing modules.
+ */
+config_t* mock_config(void);
+
+/**
+ * @brief Set the WiFi link state; wifi_wait_online() blocks while down
+ */
+void mock_wifi_set_connected(bool connected);
+
+/**
+ * @brief Calls that reached ota_start() (an admin-only path)
+ */
+uint32_t mock_ota_start_calls(void);
+
+/**
+ * @brief Calls that reached fleet_set_pot() (an admin-only path)
+ */
+uint32_t mock_fleet_set_pot_calls(void);
+
+// ============================================================================
+// HTTP client (mock_http.c)
+// ============================================================================
+
+/**
+ * @brief Queue the body of the next getUpdates response
+ *
+ * A poll with nothing queued is held for the URL's long-poll timeout and
+ * then answered with an empty result, like the Bot API.
+ *
+ * @param body   Response body (copied)
+ * @param status HTTP status code
+ */
+void mock_http_queue_poll(const char* body, int status);
+
+/**
+ * @brief Deliver response bodies in pieces of this size (0 = whole body)
+ */
+void mock_http_set_chunk_size(size_t size);
+
+/**
+ * @brief Answer the next `count` POSTs with HTTP 500
+ */
+void mock_http_fail_posts(uint32_t count);
+
+/**
+ * @brief getUpdates requests performed so far
+ */
+uint32_t mock_http_poll_count(void);
+
+/**
+ * @brief URL of the latest getUpdates request
+ */
+const char* mock_http_last_poll_url(void);
+
+/**
+ * @brief POST bodies that were answered with 200, oldest first
+ */
+size_t mock_http_post_count(void);
+const char* mock_http_post_body(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOCK_H
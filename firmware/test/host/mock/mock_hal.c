@@ -0,0 +1,165 @@
+/**
+ * @file mock_hal.c
+ * @brief Host versions of the small ESP-IDF services: logging, error
+ *        names, heap figures and GPIO outputs
+ */
+
+#include "mock.h"
+#include "sim.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "driver/gpio.h"
+#include "esp_crt_bundle.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+// ============================================================================
+// Logging
+// ============================================================================
+
+static int s_log_level = -1;
+
+esp_log_level_t esp_log_level_get(const char* tag)
+{
+    (void)tag;
+    if (s_log_level < 0) {
+        const char* env = getenv("SIM_LOG_LEVEL");
+        s_log_level = env ? atoi(env) : ESP_LOG_WARN;
+    }
+    return (esp_log_level_t)s_log_level;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    if (level > esp_log_level_get(tag)) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(sim_now_us() / 1000);
+}
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ERROR";
+    }
+}
+
+esp_err_t esp_crt_bundle_attach(void* conf)
+{
+    (void)conf;
+    return ESP_OK;
+}
+
+// ============================================================================
+// Heap (fixed figures; the host heap says nothing about the target's)
+// ============================================================================
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_DMA) ? 160 * 1024 : 200 * 1024;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps) - 16 * 1024;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps) / 2;
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+static struct {
+    int level;
+    int64_t changed_us;         // Time of the last edge (or stats reset)
+    int64_t high_us;            // High time before changed_us
+    uint32_t edges;
+} s_pins[GPIO_NUM_MAX];
+
+esp_err_t gpio_config(const gpio_config_t* config)
+{
+    if (config->pin_bit_mask == 0 || config->pin_bit_mask >> GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio < 0 || gpio >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int new_level = level ? 1 : 0;
+    if (new_level != s_pins[gpio].level) {
+        int64_t now = sim_now_us();
+        if (s_pins[gpio].level) {
+            s_pins[gpio].high_us += now - s_pins[gpio].changed_us;
+        }
+        s_pins[gpio].changed_us = now;
+        s_pins[gpio].level = new_level;
+        s_pins[gpio].edges++;
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    return mock_gpio_level(gpio);
+}
+
+int mock_gpio_level(int pin)
+{
+    return (pin >= 0 && pin < GPIO_NUM_MAX) ? s_pins[pin].level : 0;
+}
+
+int64_t mock_gpio_high_us(int pin)
+{
+    if (pin < 0 || pin >= GPIO_NUM_MAX) {
+        return 0;
+    }
+    int64_t high = s_pins[pin].high_us;
+    if (s_pins[pin].level) {
+        high += sim_now_us() - s_pins[pin].changed_us;
+    }
+    return high;
+}
+
+uint32_t mock_gpio_edges(int pin)
+{
+    return (pin >= 0 && pin < GPIO_NUM_MAX) ? s_pins[pin].edges : 0;
+}
+
+void mock_gpio_reset_stats(void)
+{
+    int64_t now = sim_now_us();
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        s_pins[i].high_us = 0;
+        s_pins[i].changed_us = now;
+        s_pins[i].edges = 0;
+    }
+}
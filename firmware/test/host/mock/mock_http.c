@@ -0,0 +1,245 @@
+/**
+ * @file mock_http.c
+ * @brief esp_http_client shim with a scripted Bot API server
+ *
+ * getUpdates requests are answered from a queue the test fills; an empty
+ * queue holds the request for its long-poll timeout (virtual time) and
+ * then answers with no updates. POSTs are recorded for inspection.
+ */
+
+#include "mock.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_http_client.h"
+
+#define MOCK_HTTP_MAX_CLIENTS   4
+#define MOCK_HTTP_MAX_POLLS     32
+#define MOCK_HTTP_MAX_POSTS     64
+#define MOCK_HTTP_URL_LEN       512
+
+struct sim_http_client {
+    bool used;
+    esp_http_client_config_t config;
+    char url[MOCK_HTTP_URL_LEN];
+    esp_http_client_method_t method;
+    const char* post_data;
+    int post_len;
+    int status;
+};
+
+typedef struct {
+    char* body;
+    int status;
+} poll_response_t;
+
+static struct sim_http_client s_clients[MOCK_HTTP_MAX_CLIENTS];
+
+static poll_response_t s_polls[MOCK_HTTP_MAX_POLLS];
+static size_t s_poll_head = 0;
+static size_t s_poll_count = 0;
+static uint32_t s_polls_performed = 0;
+static char s_last_poll_url[MOCK_HTTP_URL_LEN];
+
+static char* s_posts[MOCK_HTTP_MAX_POSTS];
+static size_t s_post_count = 0;
+static uint32_t s_fail_posts = 0;
+
+static size_t s_chunk_size = 0;
+
+void mock_http_queue_poll(const char* body, int status)
+{
+    if (s_poll_count >= MOCK_HTTP_MAX_POLLS) {
+        sim_fail("mock_http: poll queue full");
+    }
+    poll_response_t* slot = &s_polls[(s_poll_head + s_poll_count) % MOCK_HTTP_MAX_POLLS];
+    slot->body = strdup(body);
+    slot->status = status;
+    s_poll_count++;
+    sim_signal(s_polls);
+}
+
+void mock_http_set_chunk_size(size_t size)
+{
+    s_chunk_size = size;
+}
+
+void mock_http_fail_posts(uint32_t count)
+{
+    s_fail_posts = count;
+}
+
+uint32_t mock_http_poll_count(void)
+{
+    return s_polls_performed;
+}
+
+const char* mock_http_last_poll_url(void)
+{
+    return s_last_poll_url;
+}
+
+size_t mock_http_post_count(void)
+{
+    return s_post_count;
+}
+
+const char* mock_http_post_body(size_t index)
+{
+    return index < s_post_count ? s_posts[index] : NULL;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config)
+{
+    for (int i = 0; i < MOCK_HTTP_MAX_CLIENTS; i++) {
+        if (!s_clients[i].used) {
+            s_clients[i] = (struct sim_http_client){
+                .used = true,
+                .config = *config,
+                .method = HTTP_METHOD_GET,
+            };
+            esp_http_client_set_url(&s_clients[i], config->url);
+            return &s_clients[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char* url)
+{
+    if (url == NULL || strlen(url) >= sizeof(client->url)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    strcpy(client->url, url);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client,
+                                     esp_http_client_method_t method)
+{
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+                                     const char* key, const char* value)
+{
+    (void)client;
+    (void)key;
+    (void)value;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client,
+                                         const char* data, int len)
+{
+    client->post_data = data;
+    client->post_len = len;
+    return ESP_OK;
+}
+
+static void emit(esp_http_client_handle_t client, esp_http_client_event_id_t id,
+                 char* data, int len)
+{
+    if (client->config.event_handler == NULL) {
+        return;
+    }
+    esp_http_client_event_t evt = {
+        .event_id = id,
+        .client = client,
+        .data = data,
+        .data_len = len,
+        .user_data = client->config.user_data,
+    };
+    client->config.event_handler(&evt);
+}
+
+static esp_err_t perform_poll(esp_http_client_handle_t client)
+{
+    s_polls_performed++;
+    strcpy(s_last_poll_url, client->url);
+    emit(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+
+    // Long poll: hold the request until a response is queued
+    const char* timeout = strstr(client->url, "timeout=");
+    int64_t hold_us = (timeout ? atoi(timeout + 8) : 0) * 1000000LL;
+    int64_t deadline = sim_now_us() + hold_us;
+    while (s_poll_count == 0 && sim_now_us() < deadline) {
+        sim_wait(s_polls, deadline);
+    }
+
+    poll_response_t response = { .body = NULL, .status = 200 };
+    if (s_poll_count > 0) {
+        response = s_polls[s_poll_head];
+        s_poll_head = (s_poll_head + 1) % MOCK_HTTP_MAX_POLLS;
+        s_poll_count--;
+    } else {
+        response.body = strdup("{\"ok\":true,\"result\":[]}");
+    }
+
+    size_t len = strlen(response.body);
+    size_t chunk = s_chunk_size ? s_chunk_size : len;
+    for (size_t pos = 0; pos < len; pos += chunk) {
+        size_t n = (len - pos < chunk) ? len - pos : chunk;
+        emit(client, HTTP_EVENT_ON_DATA, response.body + pos, (int)n);
+    }
+    emit(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+
+    client->status = response.status;
+    free(response.body);
+    return ESP_OK;
+}
+
+static esp_err_t perform_post(esp_http_client_handle_t client)
+{
+    emit(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+
+    if (s_fail_posts > 0) {
+        s_fail_posts--;
+        client->status = 500;
+        return ESP_OK;
+    }
+    if (s_post_count >= MOCK_HTTP_MAX_POSTS) {
+        sim_fail("mock_http: too many POSTs recorded");
+    }
+
+    char* body = malloc((size_t)client->post_len + 1);
+    memcpy(body, client->post_data, (size_t)client->post_len);
+    body[client->post_len] = '\0';
+    s_posts[s_post_count++] = body;
+
+    client->status = 200;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    if (strstr(client->url, "/getUpdates") != NULL) {
+        return perform_poll(client);
+    }
+    if (client->method == HTTP_METHOD_POST) {
+        return perform_post(client);
+    }
+    client->status = 404;
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    (void)client;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    client->used = false;
+    return ESP_OK;
+}
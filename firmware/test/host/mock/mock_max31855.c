@@ -0,0 +1,134 @@
+/**
+ * @file mock_max31855.c
+ * @brief SPI master shim answering reads with MAX31855 frames
+ *
+ * Frames come from a list (mock_max31855_play()) or a callback such as a
+ * thermal model (mock_max31855_set_source()). With neither, the
+ * converter reports an open thermocouple, like a board with no probe.
+ */
+
+#include "mock.h"
+#include "sim.h"
+
+#include "driver/spi_master.h"
+#include "temperature.h"
+
+struct sim_spi_device {
+    spi_device_interface_config_t config;
+};
+
+static struct sim_spi_device s_device;
+static bool s_device_added = false;
+
+static const uint32_t* s_frames = NULL;
+static size_t s_frame_count = 0;
+static size_t s_frame_pos = 0;
+static bool s_loop = false;
+
+static mock_max31855_source_t s_source = NULL;
+static void* s_source_ctx = NULL;
+
+static bool s_bus_error = false;
+static bool s_stalled = false;
+static uint32_t s_reads = 0;
+
+uint32_t mock_max31855_frame(int16_t tc_q, int16_t cj_q)
+{
+    // D31-D18 thermocouple (14-bit), D15-D4 cold junction (12-bit)
+    return ((uint32_t)(tc_q & 0x3FFF) << 18) | ((uint32_t)(cj_q & 0x0FFF) << 4);
+}
+
+uint32_t mock_max31855_fault_frame(uint8_t fault)
+{
+    // D16 fault flag, D2-D0 fault type; a faulted read keeps the cold
+    // junction (25 C here) and reports the thermocouple as 0
+    return mock_max31855_frame(0, 25 * 16) | 0x00010000 | (fault & 0x07);
+}
+
+void mock_max31855_play(const uint32_t* frames, size_t count, bool loop)
+{
+    s_frames = frames;
+    s_frame_count = count;
+    s_frame_pos = 0;
+    s_loop = loop;
+    s_source = NULL;
+}
+
+void mock_max31855_set_source(mock_max31855_source_t source, void* ctx)
+{
+    s_source = source;
+    s_source_ctx = ctx;
+    s_frames = NULL;
+}
+
+void mock_max31855_set_bus_error(bool error)
+{
+    s_bus_error = error;
+}
+
+void mock_max31855_set_stalled(bool stalled)
+{
+    s_stalled = stalled;
+    if (!stalled) {
+        sim_signal(&s_stalled);
+    }
+}
+
+uint32_t mock_max31855_reads(void)
+{
+    return s_reads;
+}
+
+static uint32_t next_frame(void)
+{
+    if (s_source != NULL) {
+        return s_source(s_source_ctx);
+    }
+    if (s_frames == NULL || s_frame_count == 0) {
+        return mock_max31855_fault_frame(TEMPERATURE_FAULT_OPEN);
+    }
+
+    uint32_t frame = s_frames[s_frame_pos];
+    if (s_frame_pos + 1 < s_frame_count) {
+        s_frame_pos++;
+    } else if (s_loop) {
+        s_frame_pos = 0;
+    }
+    return frame;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle)
+{
+    (void)host;
+    if (s_device_added || config->clock_speed_hz > 5000000 || config->mode != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_device.config = *config;
+    s_device_added = true;
+    *handle = &s_device;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans)
+{
+    if (handle != &s_device || trans->length != 32 || !(trans->flags & SPI_TRANS_USE_RXDATA)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_bus_error) {
+        return ESP_ERR_TIMEOUT;
+    }
+    while (s_stalled) {
+        sim_wait(&s_stalled, INT64_MAX);
+    }
+
+    uint32_t frame = next_frame();
+    s_reads++;
+
+    // MSB first on the wire
+    trans->rx_data[0] = (uint8_t)(frame >> 24);
+    trans->rx_data[1] = (uint8_t)(frame >> 16);
+    trans->rx_data[2] = (uint8_t)(frame >> 8);
+    trans->rx_data[3] = (uint8_t)frame;
+    return ESP_OK;
+}
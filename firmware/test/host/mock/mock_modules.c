@@ -0,0 +1,351 @@
+/**
+ * @file mock_modules.c
+ * @brief Stand-ins for the firmware modules the host build leaves out
+ *
+ * Settings, WiFi, fleet, OTA, cook programs, touch input, power locks and
+ * the shared SPI bus are replaced by the least that lets the modules
+ * under test run; tests drive them through mock.h.
+ */
+
+#include "mock.h"
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "fleet.h"
+#include "ota.h"
+#include "power.h"
+#include "schedule.h"
+#include "spi_bus.h"
+#include "touch_hal.h"
+#include "wifi.h"
+
+// ============================================================================
+// Settings store
+// ============================================================================
+
+#define MOCK_CONFIG_MAX_LISTENERS 8
+
+static config_t s_config;
+static struct {
+    uint32_t sections;
+    config_listener_t fn;
+    void* user_data;
+} s_config_listeners[MOCK_CONFIG_MAX_LISTENERS];
+static uint8_t s_config_listener_count = 0;
+
+config_t* mock_config(void)
+{
+    return &s_config;
+}
+
+bool config_init(void)
+{
+    return true;
+}
+
+const config_t* config_acquire(void)
+{
+    return &s_config;
+}
+
+void config_release(void)
+{
+}
+
+config_t* config_edit(void)
+{
+    return &s_config;
+}
+
+void config_commit(uint32_t changed)
+{
+    s_config.saved |= changed;
+    for (uint8_t i = 0; i < s_config_listener_count; i++) {
+        if (s_config_listeners[i].sections & changed) {
+            s_config_listeners[i].fn(changed, &s_config, s_config_listeners[i].user_data);
+        }
+    }
+}
+
+bool config_flush(void)
+{
+    return true;
+}
+
+bool config_add_listener(uint32_t sections, config_listener_t listener, void* user_data)
+{
+    if (s_config_listener_count >= MOCK_CONFIG_MAX_LISTENERS) {
+        return false;
+    }
+    s_config_listeners[s_config_listener_count].sections = sections;
+    s_config_listeners[s_config_listener_count].fn = listener;
+    s_config_listeners[s_config_listener_count].user_data = user_data;
+    s_config_listener_count++;
+    return true;
+}
+
+// ============================================================================
+// WiFi
+// ============================================================================
+
+static bool s_wifi_connected = true;
+
+void mock_wifi_set_connected(bool connected)
+{
+    s_wifi_connected = connected;
+    sim_signal(&s_wifi_connected);
+}
+
+bool wifi_is_connected(void)
+{
+    return s_wifi_connected;
+}
+
+void wifi_wait_online(void)
+{
+    while (!s_wifi_connected) {
+        sim_wait(&s_wifi_connected, INT64_MAX);
+    }
+}
+
+wifi_status_t wifi_get_status(void)
+{
+    return s_wifi_connected ? WIFI_STATUS_CONNECTED : WIFI_STATUS_DISCONNECTED;
+}
+
+bool wifi_get_ip_string(char* buf, size_t buf_len)
+{
+    if (!s_wifi_connected) {
+        return false;
+    }
+    snprintf(buf, buf_len, "192.0.2.10");
+    return true;
+}
+
+// ============================================================================
+// Fleet (single pot, always the coordinator)
+// ============================================================================
+
+bool fleet_is_enabled(void)
+{
+    return false;
+}
+
+uint8_t fleet_get_pot(void)
+{
+    return 0;
+}
+
+bool fleet_is_coordinator(void)
+{
+    return true;
+}
+
+void fleet_wait_coordinator(void)
+{
+}
+
+bool fleet_route(uint8_t pot, const char* command, command_access_t access,
+                 char* out, size_t out_len)
+{
+    (void)command;
+    (void)access;
+    snprintf(out, out_len, "Pot %u: not in this build", pot);
+    return false;
+}
+
+size_t fleet_format_status(char* out, size_t len)
+{
+    int n = snprintf(out, len, "Fleet mode off");
+    return (n < 0) ? 0 : ((size_t)n < len ? (size_t)n : len - 1);
+}
+
+static uint32_t s_fleet_set_pot_calls = 0;
+
+uint32_t mock_fleet_set_pot_calls(void)
+{
+    return s_fleet_set_pot_calls;
+}
+
+bool fleet_set_pot(uint8_t pot, const char* key)
+{
+    (void)pot;
+    (void)key;
+    s_fleet_set_pot_calls++;
+    return false;
+}
+
+bool fleet_has_key(void)
+{
+    return false;
+}
+
+// ============================================================================
+// Firmware updates
+// ============================================================================
+
+static uint32_t s_ota_start_calls = 0;
+
+uint32_t mock_ota_start_calls(void)
+{
+    return s_ota_start_calls;
+}
+
+bool ota_start(const char* url, const char* sha256_hex, char* out, size_t out_len)
+{
+    (void)sha256_hex;
+    s_ota_start_calls++;
+    snprintf(out, out_len, "Updating from %s", url);
+    return true;
+}
+
+size_t ota_format_status(char* out, size_t len)
+{
+    int n = snprintf(out, len, "Firmware host-test");
+    return (n < 0) ? 0 : ((size_t)n < len ? (size_t)n : len - 1);
+}
+
+// ============================================================================
+// Cook programs
+// ============================================================================
+
+bool schedule_parse(const char* text, schedule_program_t* out)
+{
+    (void)text;
+    (void)out;
+    return false;
+}
+
+bool schedule_start(const schedule_program_t* program)
+{
+    (void)program;
+    return false;
+}
+
+void schedule_stop(void)
+{
+}
+
+bool schedule_is_active(void)
+{
+    return false;
+}
+
+size_t schedule_format_status(char* out, size_t len)
+{
+    int n = snprintf(out, len, "No program running");
+    return (n < 0) ? 0 : ((size_t)n < len ? (size_t)n : len - 1);
+}
+
+// ============================================================================
+// Touch input
+// ============================================================================
+
+static touch_event_t s_touch_queue[TOUCH_EVENT_QUEUE_LEN];
+static uint8_t s_touch_head = 0;
+static uint8_t s_touch_count = 0;
+static touch_callback_t s_touch_cb = NULL;
+static void* s_touch_user_data = NULL;
+
+void mock_touch_push(const touch_event_t* event)
+{
+    if (s_touch_count < TOUCH_EVENT_QUEUE_LEN) {
+        s_touch_queue[(s_touch_head + s_touch_count) % TOUCH_EVENT_QUEUE_LEN] = *event;
+        s_touch_count++;
+    }
+    if (s_touch_cb != NULL) {
+        s_touch_cb(event, s_touch_user_data);
+    }
+}
+
+bool touch_hal_init(void)
+{
+    return true;
+}
+
+touch_info_t touch_hal_get_info(void)
+{
+    // A calibrated resistive panel plus the board's three buttons
+    return (touch_info_t){
+        .type = TOUCH_TYPE_RESISTIVE,
+        .pressure_sense = true,
+        .width = 320,
+        .height = 240,
+        .num_buttons = 3,
+        .initialized = true,
+    };
+}
+
+bool touch_hal_poll_event(touch_event_t* event)
+{
+    if (s_touch_count == 0) {
+        return false;
+    }
+    *event = s_touch_queue[s_touch_head];
+    s_touch_head = (s_touch_head + 1) % TOUCH_EVENT_QUEUE_LEN;
+    s_touch_count--;
+    return true;
+}
+
+void touch_hal_set_callback(touch_callback_t callback, void* user_data)
+{
+    s_touch_cb = callback;
+    s_touch_user_data = user_data;
+}
+
+bool touch_hal_start_calibration(void)
+{
+    return false;
+}
+
+bool touch_hal_set_calibration(const touch_calibration_point_t points[3])
+{
+    (void)points;
+    return false;
+}
+
+void touch_hal_cancel_calibration(void)
+{
+}
+
+bool touch_hal_needs_calibration(void)
+{
+    return false;
+}
+
+bool touch_hal_save_calibration(void)
+{
+    return false;
+}
+
+void touch_hal_set_rotation(uint16_t rotation)
+{
+    (void)rotation;
+}
+
+// ============================================================================
+// Power management and the shared SPI bus
+// ============================================================================
+
+static uint32_t s_power_locks[POWER_LOCK_COUNT];
+
+void power_acquire(power_lock_t lock)
+{
+    s_power_locks[lock]++;
+}
+
+void power_release(power_lock_t lock)
+{
+    if (s_power_locks[lock] == 0) {
+        sim_fail("power_release(%d) without acquire", lock);
+    }
+    s_power_locks[lock]--;
+}
+
+bool spi_bus_shared_init(void)
+{
+    return true;
+}
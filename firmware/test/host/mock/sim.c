@@ -0,0 +1,945 @@
+/**
+ * @file sim.c
+ * @brief Cooperative FreeRTOS, esp_timer, GPTimer and task watchdog on a
+ *        virtual clock (see sim.h)
+ *
+ * Each task is a ucontext coroutine. A blocking call records what the
+ * task waits for and swaps back to the scheduler loop in sim_run_for(),
+ * which runs the highest-priority ready task (round robin among equals)
+ * or, when none is ready, moves the clock to the earliest pending event.
+ * Waiters are woken by address: every object a task can block on is
+ * signalled with sim_signal() and the woken task re-checks its condition.
+ */
+
+#include "sim.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "driver/gptimer.h"
+#include "esp_task_wdt.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+// Task switches in a row without the clock moving before we call it a livelock
+#define SIM_MAX_SWITCHES_PER_INSTANT 10000000
+
+typedef enum {
+    TASK_READY,
+    TASK_BLOCKED,
+    TASK_SUSPENDED,
+    TASK_DONE
+} task_state_t;
+
+struct sim_task {
+    char name[16];
+    TaskFunction_t fn;
+    void* param;
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    ucontext_t ctx;
+    void* stack;
+    task_state_t state;
+    const void* wait_obj;       // NULL while in a plain delay
+    int64_t wake_us;            // Timeout (INT64_MAX = none)
+    bool signalled;
+    uint32_t notify;
+    bool wdt;                   // Subscribed to the task watchdog
+    int64_t wdt_reset_us;
+    uint64_t runs;
+};
+
+struct sim_semaphore {
+    uint32_t count;
+    uint32_t max;
+};
+
+struct sim_queue {
+    uint8_t* storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct sim_event_group {
+    EventBits_t bits;
+};
+
+struct sim_timer {
+    bool used;
+    esp_timer_create_args_t args;
+    int64_t alarm_us;           // INT64_MAX = not armed
+    uint64_t period_us;         // 0 = one-shot
+};
+
+struct sim_gptimer {
+    bool used;
+    uint32_t resolution_hz;
+    gptimer_event_callbacks_t cbs;
+    void* user_ctx;
+    gptimer_alarm_config_t alarm;
+    bool enabled;
+    bool running;
+    int64_t next_us;
+    uint64_t count;
+};
+
+static struct sim_task s_tasks[SIM_MAX_TASKS];
+static int s_task_count = 0;
+static int s_last_run = -1;
+static struct sim_task* s_current = NULL;   // NULL: test body or a timer callback
+static ucontext_t s_main_ctx;
+
+static int64_t s_now_us = 0;
+static uint32_t s_critical = 0;
+static bool s_in_isr = false;
+static uint32_t s_switches = 0;
+
+static struct sim_timer s_timers[SIM_MAX_TIMERS];
+static struct sim_gptimer s_gptimers[SIM_MAX_GPTIMERS];
+
+void sim_fail(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "SIM FAILURE at %lld us (task %s): ", (long long)s_now_us,
+            s_current ? s_current->name : "-");
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    abort();
+}
+
+// ============================================================================
+// Scheduler
+// ============================================================================
+
+static void task_entry(int index)
+{
+    struct sim_task* t = &s_tasks[index];
+    t->fn(t->param);
+    sim_fail("task %s returned from its function", t->name);
+}
+
+// Give the CPU back to the scheduler loop (caller set the task's state)
+static void task_switch_out(void)
+{
+    struct sim_task* t = s_current;
+    if (t == NULL) {
+        sim_fail("blocking call outside a task");
+    }
+    if (s_critical != 0) {
+        sim_fail("blocking call inside a critical section");
+    }
+    if (s_in_isr) {
+        sim_fail("blocking call from an ISR");
+    }
+    swapcontext(&t->ctx, &s_main_ctx);
+}
+
+static int64_t deadline_for(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return INT64_MAX;
+    }
+    return s_now_us + (int64_t)ticks * (1000000 / configTICK_RATE_HZ);
+}
+
+bool sim_wait(const void* obj, int64_t deadline_us)
+{
+    struct sim_task* t = s_current;
+    if (t == NULL) {
+        sim_fail("blocking call outside a task");
+    }
+    t->wait_obj = obj;
+    t->wake_us = deadline_us;
+    t->signalled = false;
+    t->state = TASK_BLOCKED;
+    task_switch_out();
+    return t->signalled;
+}
+
+// Wait unless the deadline is already here (a zero timeout never blocks)
+static bool wait_on(const void* obj, int64_t deadline_us)
+{
+    if (deadline_us <= s_now_us) {
+        return false;
+    }
+    return sim_wait(obj, deadline_us);
+}
+
+void sim_signal(const void* obj)
+{
+    for (int i = 0; i < s_task_count; i++) {
+        struct sim_task* t = &s_tasks[i];
+        if (t->state == TASK_BLOCKED && t->wait_obj == obj && obj != NULL) {
+            t->state = TASK_READY;
+            t->signalled = true;
+            t->wait_obj = NULL;
+        }
+    }
+}
+
+static struct sim_task* pick_ready(void)
+{
+    struct sim_task* best = NULL;
+    for (int n = 1; n <= s_task_count; n++) {
+        int i = (s_last_run + n) % s_task_count;
+        struct sim_task* t = &s_tasks[i];
+        if (t->state == TASK_READY && (best == NULL || t->priority > best->priority)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void run_task(struct sim_task* t)
+{
+    if (++s_switches > SIM_MAX_SWITCHES_PER_INSTANT) {
+        sim_fail("livelock: %u task switches without time passing", s_switches);
+    }
+    s_last_run = (int)(t - s_tasks);
+    s_current = t;
+    t->runs++;
+    swapcontext(&s_main_ctx, &t->ctx);
+    s_current = NULL;
+}
+
+static int64_t next_event_us(void)
+{
+    int64_t next = INT64_MAX;
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i].state == TASK_BLOCKED && s_tasks[i].wake_us < next) {
+            next = s_tasks[i].wake_us;
+        }
+    }
+    for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+        if (s_timers[i].used && s_timers[i].alarm_us < next) {
+            next = s_timers[i].alarm_us;
+        }
+    }
+    for (int i = 0; i < SIM_MAX_GPTIMERS; i++) {
+        if (s_gptimers[i].running && s_gptimers[i].next_us < next) {
+            next = s_gptimers[i].next_us;
+        }
+    }
+    return next;
+}
+
+static void check_watchdog(void)
+{
+    const int64_t timeout_us = CONFIG_ESP_TASK_WDT_TIMEOUT_S * 1000000LL;
+    for (int i = 0; i < s_task_count; i++) {
+        const struct sim_task* t = &s_tasks[i];
+        if (t->wdt && t->state != TASK_DONE && s_now_us - t->wdt_reset_us > timeout_us) {
+            sim_fail("task watchdog: %s not reset for %lld ms", t->name,
+                     (long long)((s_now_us - t->wdt_reset_us) / 1000));
+        }
+    }
+}
+
+// Fire every alarm due at the current time, earliest first
+static void fire_timers(void)
+{
+    while (1) {
+        struct sim_timer* timer = NULL;
+        struct sim_gptimer* gptimer = NULL;
+        int64_t due = s_now_us + 1;
+
+        for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+            if (s_timers[i].used && s_timers[i].alarm_us < due) {
+                due = s_timers[i].alarm_us;
+                timer = &s_timers[i];
+            }
+        }
+        for (int i = 0; i < SIM_MAX_GPTIMERS; i++) {
+            if (s_gptimers[i].running && s_gptimers[i].next_us < due) {
+                due = s_gptimers[i].next_us;
+                gptimer = &s_gptimers[i];
+                timer = NULL;
+            }
+        }
+
+        if (gptimer != NULL) {
+            uint64_t period_us = gptimer->alarm.alarm_count * 1000000ULL /
+                                 gptimer->resolution_hz;
+            gptimer_alarm_event_data_t edata = {
+                .count_value = gptimer->alarm.alarm_count,
+                .alarm_value = gptimer->alarm.alarm_count,
+            };
+            if (gptimer->alarm.flags.auto_reload_on_alarm) {
+                gptimer->next_us += (int64_t)period_us;
+            } else {
+                gptimer->running = false;
+            }
+            if (gptimer->cbs.on_alarm != NULL) {
+                s_in_isr = true;
+                gptimer->cbs.on_alarm(gptimer, &edata, gptimer->user_ctx);
+                s_in_isr = false;
+            }
+        } else if (timer != NULL) {
+            if (timer->period_us != 0) {
+                timer->alarm_us += (int64_t)timer->period_us;
+            } else {
+                timer->alarm_us = INT64_MAX;
+            }
+            timer->args.callback(timer->args.arg);
+        } else {
+            return;
+        }
+    }
+}
+
+static void advance_to(int64_t t_us)
+{
+    if (t_us > s_now_us) {
+        s_now_us = t_us;
+        s_switches = 0;
+    }
+
+    fire_timers();
+
+    for (int i = 0; i < s_task_count; i++) {
+        struct sim_task* t = &s_tasks[i];
+        if (t->state == TASK_BLOCKED && t->wake_us <= s_now_us) {
+            t->state = TASK_READY;
+            t->signalled = false;
+            t->wait_obj = NULL;
+        }
+    }
+
+    check_watchdog();
+}
+
+void sim_run_for(uint32_t ms)
+{
+    if (s_current != NULL) {
+        sim_fail("sim_run_for() called from a task");
+    }
+
+    const int64_t end_us = s_now_us + (int64_t)ms * 1000;
+
+    while (1) {
+        struct sim_task* t = pick_ready();
+        if (t != NULL) {
+            run_task(t);
+            continue;
+        }
+
+        int64_t next = next_event_us();
+        if (next > end_us) {
+            advance_to(end_us);
+            if (pick_ready() == NULL) {
+                return;
+            }
+            continue;
+        }
+        advance_to(next);
+    }
+}
+
+void sim_run_idle(void)
+{
+    sim_run_for(0);
+}
+
+int64_t sim_now_us(void)
+{
+    return s_now_us;
+}
+
+bool sim_task_exists(const char* name)
+{
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i].state != TASK_DONE && strcmp(s_tasks[i].name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Port layer
+// ============================================================================
+
+void vPortEnterCritical(portMUX_TYPE* mux)
+{
+    mux->count++;
+    s_critical++;
+}
+
+void vPortExitCritical(portMUX_TYPE* mux)
+{
+    if (mux->count == 0 || s_critical == 0) {
+        sim_fail("critical section exit without entry");
+    }
+    mux->count--;
+    s_critical--;
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return s_in_isr ? pdTRUE : pdFALSE;
+}
+
+// ============================================================================
+// Tasks
+// ============================================================================
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle)
+{
+    if (s_task_count >= SIM_MAX_TASKS) {
+        return pdFAIL;
+    }
+
+    int index = s_task_count;
+    struct sim_task* t = &s_tasks[index];
+    memset(t, 0, sizeof(*t));
+    strncpy(t->name, name, sizeof(t->name) - 1);
+    t->fn = fn;
+    t->param = param;
+    t->priority = priority;
+    t->stack_depth = stack_depth;
+    t->state = TASK_READY;
+    t->wake_us = INT64_MAX;
+
+    t->stack = malloc(SIM_TASK_STACK_SIZE);
+    if (t->stack == NULL || getcontext(&t->ctx) != 0) {
+        free(t->stack);
+        return pdFAIL;
+    }
+    t->ctx.uc_stack.ss_sp = t->stack;
+    t->ctx.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+    t->ctx.uc_link = NULL;
+    makecontext(&t->ctx, (void (*)(void))task_entry, 1, index);
+
+    s_task_count++;
+    if (handle != NULL) {
+        *handle = t;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    struct sim_task* t = task ? task : s_current;
+    if (t == NULL) {
+        sim_fail("vTaskDelete(NULL) outside a task");
+    }
+    t->state = TASK_DONE;
+    if (t == s_current) {
+        task_switch_out();
+    }
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    struct sim_task* t = task ? task : s_current;
+    if (t == NULL) {
+        sim_fail("vTaskSuspend(NULL) outside a task");
+    }
+    t->state = TASK_SUSPENDED;
+    if (t == s_current) {
+        task_switch_out();
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        s_current->state = TASK_READY;
+        task_switch_out();
+        return;
+    }
+    sim_wait(NULL, deadline_for(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+    int64_t wake_us = (int64_t)*previous_wake * (1000000 / configTICK_RATE_HZ);
+
+    if (wake_us > s_now_us) {
+        sim_wait(NULL, wake_us);
+    } else {
+        // Behind schedule: yield but do not sleep
+        s_current->state = TASK_READY;
+        task_switch_out();
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / (1000000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+const char* pcTaskGetName(TaskHandle_t task)
+{
+    struct sim_task* t = task ? task : s_current;
+    return t ? t->name : "test";
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notify++;
+    sim_signal(&task->notify);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken)
+{
+    xTaskNotifyGive(task);
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct sim_task* t = s_current;
+    if (t == NULL) {
+        sim_fail("ulTaskNotifyTake() outside a task");
+    }
+
+    int64_t deadline = deadline_for(ticks);
+    while (t->notify == 0) {
+        if (!wait_on(&t->notify, deadline) && t->notify == 0) {
+            return 0;
+        }
+    }
+
+    uint32_t value = t->notify;
+    t->notify = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t n = 0;
+    for (int i = 0; i < s_task_count; i++) {
+        n += (s_tasks[i].state != TASK_DONE);
+    }
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t count,
+                                 configRUN_TIME_COUNTER_TYPE* total_runtime)
+{
+    UBaseType_t n = 0;
+    uint64_t total = 0;
+
+    if (uxTaskGetNumberOfTasks() > count) {
+        return 0;
+    }
+
+    for (int i = 0; i < s_task_count; i++) {
+        struct sim_task* t = &s_tasks[i];
+        if (t->state == TASK_DONE) {
+            continue;
+        }
+        static const eTaskState states[] = {
+            [TASK_READY] = eReady,
+            [TASK_BLOCKED] = eBlocked,
+            [TASK_SUSPENDED] = eSuspended,
+            [TASK_DONE] = eDeleted,
+        };
+        status[n] = (TaskStatus_t){
+            .xHandle = t,
+            .pcTaskName = t->name,
+            .xTaskNumber = (UBaseType_t)i,
+            .eCurrentState = (t == s_current) ? eRunning : states[t->state],
+            .uxCurrentPriority = t->priority,
+            .uxBasePriority = t->priority,
+            .ulRunTimeCounter = t->runs,
+            .pxStackBase = t->stack,
+            .usStackHighWaterMark = t->stack_depth,
+        };
+        total += t->runs;
+        n++;
+    }
+
+    if (total_runtime != NULL) {
+        *total_runtime = total;
+    }
+    return n;
+}
+
+// ============================================================================
+// Semaphores
+// ============================================================================
+
+static SemaphoreHandle_t semaphore_create(uint32_t count, uint32_t max)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) {
+        sem->count = count;
+        sem->max = max;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_create(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_create(0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    int64_t deadline = deadline_for(ticks);
+    while (sem->count == 0) {
+        if (!wait_on(sem, deadline) && sem->count == 0) {
+            return pdFALSE;
+        }
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    sim_signal(sem);
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+// ============================================================================
+// Queues
+// ============================================================================
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t* storage, StaticQueue_t* buffer)
+{
+    (void)buffer;
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    if (queue != NULL) {
+        queue->storage = storage;
+        queue->length = length;
+        queue->item_size = item_size;
+    }
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    uint8_t* storage = malloc((size_t)length * item_size);
+    if (storage == NULL) {
+        return NULL;
+    }
+    return xQueueCreateStatic(length, item_size, storage, NULL);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    int64_t deadline = deadline_for(ticks);
+    while (queue->count == queue->length) {
+        if (!wait_on(queue, deadline) && queue->count == queue->length) {
+            return pdFALSE;
+        }
+    }
+
+    UBaseType_t slot = (queue->head + queue->count) % queue->length;
+    memcpy(queue->storage + (size_t)slot * queue->item_size, item, queue->item_size);
+    queue->count++;
+    sim_signal(queue);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+static BaseType_t queue_take(QueueHandle_t queue, void* item, TickType_t ticks, bool remove)
+{
+    int64_t deadline = deadline_for(ticks);
+    while (queue->count == 0) {
+        if (!wait_on(queue, deadline) && queue->count == 0) {
+            return pdFALSE;
+        }
+    }
+
+    memcpy(item, queue->storage + (size_t)queue->head * queue->item_size, queue->item_size);
+    if (remove) {
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        sim_signal(queue);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    return queue_take(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    return queue_take(queue, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+// ============================================================================
+// Event groups
+// ============================================================================
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    sim_signal(group);
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks)
+{
+    int64_t deadline = deadline_for(ticks);
+
+    while (1) {
+        EventBits_t value = group->bits;
+        bool met = wait_for_all ? (value & bits) == bits : (value & bits) != 0;
+        if (met) {
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            return value;
+        }
+        if (!wait_on(group, deadline)) {
+            return group->bits;
+        }
+    }
+}
+
+// ============================================================================
+// esp_timer
+// ============================================================================
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out)
+{
+    for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+        if (!s_timers[i].used) {
+            s_timers[i] = (struct sim_timer){
+                .used = true,
+                .args = *args,
+                .alarm_us = INT64_MAX,
+            };
+            *out = &s_timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t after_us, uint64_t period_us)
+{
+    if (timer->alarm_us != INT64_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm_us = s_now_us + (int64_t)after_us;
+    timer->period_us = period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer->alarm_us == INT64_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm_us = INT64_MAX;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    timer->used = false;
+    timer->alarm_us = INT64_MAX;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->alarm_us != INT64_MAX;
+}
+
+// ============================================================================
+// GPTimer
+// ============================================================================
+
+esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* out)
+{
+    for (int i = 0; i < SIM_MAX_GPTIMERS; i++) {
+        if (!s_gptimers[i].used) {
+            s_gptimers[i] = (struct sim_gptimer){
+                .used = true,
+                .resolution_hz = config->resolution_hz,
+            };
+            *out = &s_gptimers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer,
+                                           const gptimer_event_callbacks_t* cbs,
+                                           void* user_ctx)
+{
+    timer->cbs = *cbs;
+    timer->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t* config)
+{
+    if (config->alarm_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->alarm = *config;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_raw_count(gptimer_handle_t timer, uint64_t value)
+{
+    timer->count = value;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+    if (timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+    if (!timer->enabled || timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+    if (!timer->enabled || timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint64_t remaining = timer->alarm.alarm_count > timer->count
+                         ? timer->alarm.alarm_count - timer->count : 0;
+    timer->next_us = s_now_us + (int64_t)(remaining * 1000000ULL / timer->resolution_hz);
+    timer->running = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+    if (!timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->running = false;
+    return ESP_OK;
+}
+
+// ============================================================================
+// Task watchdog
+// ============================================================================
+
+esp_err_t esp_task_wdt_add(TaskHandle_t task)
+{
+    struct sim_task* t = task ? task : s_current;
+    if (t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    t->wdt = true;
+    t->wdt_reset_us = s_now_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_delete(TaskHandle_t task)
+{
+    struct sim_task* t = task ? task : s_current;
+    if (t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    t->wdt = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset(void)
+{
+    if (s_current == NULL || !s_current->wdt) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_current->wdt_reset_us = s_now_us;
+    return ESP_OK;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file sim.h
+ * @brief Deterministic FreeRTOS/esp_timer simulator for host tests
+ *
+ * Firmware tasks run as cooperative coroutines on one host thread and
+ * switch only where they would block on the device (delays, semaphores,
+ * queues, event groups, notifications). Time is virtual: it stands still
+ * while a task runs and jumps to the next timeout, esp_timer alarm or
+ * GPTimer alarm when every task is blocked. The same test therefore
+ * always sees the same interleaving, and an hour of cooking runs in
+ * milliseconds.
+ *
+ * The test body itself is not a task. It may call any firmware API that
+ * does not have to wait; a call that would block aborts the run.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run tasks and timers for a span of virtual time
+ *
+ * Returns once every task is blocked past the end of the span, with the
+ * clock set to the end of it.
+ *
+ * @param ms Virtual milliseconds to run
+ */
+void sim_run_for(uint32_t ms);
+
+/**
+ * @brief Run until nothing is ready to run, without advancing the clock
+ */
+void sim_run_idle(void);
+
+/**
+ * @brief Current virtual time in microseconds (as esp_timer_get_time())
+ */
+int64_t sim_now_us(void);
+
+/**
+ * @brief Find a task by name
+ *
+ * @return true if a task of that name exists and has not returned
+ */
+bool sim_task_exists(const char* name);
+
+/**
+ * @brief Block the calling task until sim_signal(obj) or the deadline
+ *
+ * For mocks that model a blocking driver call (e.g. an HTTP long poll).
+ *
+ * @param obj         Any address identifying the wait
+ * @param deadline_us Virtual time to give up at (INT64_MAX = never)
+ * @return true if signalled, false on timeout
+ */
+bool sim_wait(const void* obj, int64_t deadline_us);
+
+/**
+ * @brief Wake every task waiting on obj
+ */
+void sim_signal(const void* obj);
+
+/**
+ * @brief Report a fatal simulation error and abort
+ */
+void sim_fail(const char* fmt, ...) __attribute__((format(printf, 1, 2), noreturn));
+
+// Host stack per simulated task (host code needs more than the target)
+#define SIM_TASK_STACK_SIZE (256 * 1024)
+
+// Simulated tasks, esp_timers and GPTimers
+#define SIM_MAX_TASKS       16
+#define SIM_MAX_TIMERS      16
+#define SIM_MAX_GPTIMERS    4
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_H
@@ -0,0 +1,52 @@
+/**
+ * @file host_test.h
+ * @brief Minimal assertions for the host tests
+ *
+ * Each test binary is one scenario: cases run in order against the same
+ * simulated device, so later cases start from the state earlier ones
+ * left. The first failed check ends the binary with a non-zero status.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#define CHECK(cond) do {                                                          \
+        if (!(cond)) {                                                            \
+            fprintf(stderr, "%s:%d: [t=%lld ms] check failed: %s\n",              \
+                    __FILE__, __LINE__, (long long)(sim_now_us() / 1000), #cond); \
+            exit(1);                                                              \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do {                                           \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);           \
+        if (a_ != e_) {                                                           \
+            fprintf(stderr, "%s:%d: [t=%lld ms] %s == %lld, expected %lld\n",     \
+                    __FILE__, __LINE__, (long long)(sim_now_us() / 1000),         \
+                    #actual, a_, e_);                                             \
+            exit(1);                                                              \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do {                              \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);           \
+        long long t_ = (long long)(tolerance);                                    \
+        if (a_ < e_ - t_ || a_ > e_ + t_) {                                       \
+            fprintf(stderr, "%s:%d: [t=%lld ms] %s == %lld, expected %lld +/- %lld\n", \
+                    __FILE__, __LINE__, (long long)(sim_now_us() / 1000),         \
+                    #actual, a_, e_, t_);                                         \
+            exit(1);                                                              \
+        }                                                                         \
+    } while (0)
+
+#define RUN_CASE(fn) do {                   \
+        fprintf(stderr, "-- %s\n", #fn);    \
+        fn();                               \
+    } while (0)
+
+#endif // HOST_TEST_H
@@ -0,0 +1,207 @@
+/**
+ * @file test_crockpot.c
+ * @brief Closed-loop regulation and safety shutoffs
+ *
+ * A lumped thermal model of the pot closes the loop: it integrates the
+ * heater power the relay GPIOs actually delivered and answers the
+ * MAX31855 reads with the resulting temperature. The control task, the
+ * acquisition task and the relay timer all run as they do on the device.
+ */
+
+#include "host_test.h"
+#include "mock.h"
+
+#include "crockpot.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "relay.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// About 1.5 l of stew in a stoneware crock
+#define PLANT_HEAT_CAPACITY_J_PER_K 6300.0
+#define PLANT_MAIN_W                250.0
+#define PLANT_AUX_W                 250.0
+#define PLANT_LOSS_W_PER_K          1.2
+#define PLANT_AMBIENT_C             22.0
+
+typedef struct {
+    double temp_c;
+    int64_t last_us;
+    int64_t main_high_us;
+    int64_t aux_high_us;
+} plant_t;
+
+static plant_t s_plant = { .temp_c = PLANT_AMBIENT_C };
+
+static uint32_t plant_source(void* ctx)
+{
+    plant_t* p = ctx;
+    int64_t now = sim_now_us();
+    int64_t main_high = mock_gpio_high_us(RELAY_MAIN_GPIO);
+    int64_t aux_high = mock_gpio_high_us(RELAY_AUX_GPIO);
+
+    double joules = (main_high - p->main_high_us) * 1e-6 * PLANT_MAIN_W +
+                    (aux_high - p->aux_high_us) * 1e-6 * PLANT_AUX_W -
+                    (now - p->last_us) * 1e-6 * PLANT_LOSS_W_PER_K *
+                    (p->temp_c - PLANT_AMBIENT_C);
+    p->temp_c += joules / PLANT_HEAT_CAPACITY_J_PER_K;
+    p->last_us = now;
+    p->main_high_us = main_high;
+    p->aux_high_us = aux_high;
+
+    double q = p->temp_c * 4.0;
+    return mock_max31855_frame((int16_t)(q + (q >= 0 ? 0.5 : -0.5)), 25 * 16);
+}
+
+static uint32_t s_notifications = 0;
+
+static void on_status(void* user_data)
+{
+    (void)user_data;
+    s_notifications++;
+}
+
+static void test_starts_off(void)
+{
+    CHECK(dlog_init());
+    CHECK(metrics_init());
+    mock_max31855_set_source(plant_source, &s_plant);
+    CHECK(crockpot_init());
+    CHECK(crockpot_add_listener(on_status, NULL));
+    CHECK(xTaskCreate(crockpot_control_task, "crockpot_ctrl", 4096, NULL, 5, NULL) == pdPASS);
+
+    sim_run_for(60000);
+    crockpot_status_t s = crockpot_get_status();
+    CHECK_EQ(s.state, CROCKPOT_OFF);
+    CHECK_EQ(s.setpoint, 0);
+    CHECK(!s.sensor_error);
+    CHECK(s.wifi_connected);
+    CHECK_NEAR(s.temperature, 2200, 25);
+    CHECK_EQ(s.uptime_seconds, 60);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO), 0);
+
+    // Sensor and schedule were healthy all along
+    CHECK_NEAR(crockpot_get_healthy_cycles(), 60, 1);
+}
+
+static void test_state_changes_notify(void)
+{
+    uint32_t generation = crockpot_get_generation();
+    s_notifications = 0;
+
+    CHECK(crockpot_set_state(CROCKPOT_HIGH));
+    CHECK_EQ(s_notifications, 1);
+    CHECK(crockpot_get_generation() > generation);
+    crockpot_status_t s = crockpot_get_status();
+    CHECK_EQ(s.state, CROCKPOT_HIGH);
+    CHECK_EQ(s.setpoint, CROCKPOT_SETPOINT_HIGH);
+
+    // Setting the same state again is not a change
+    CHECK(crockpot_set_state(CROCKPOT_HIGH));
+    CHECK_EQ(s_notifications, 1);
+
+    CHECK(!crockpot_set_setpoint(TEMP_CC_FROM_F(CROCKPOT_SETPOINT_MIN_F - 1)));
+    CHECK(!crockpot_set_setpoint(TEMP_CC_FROM_F(CROCKPOT_SETPOINT_MAX_F + 1)));
+}
+
+static void test_regulates_high(void)
+{
+    // Boost and heat up from cold
+    sim_run_for(60000);
+    CHECK_EQ(crockpot_get_status().heater_duty_pct, 100);
+    CHECK(mock_gpio_level(RELAY_AUX_GPIO) == 1);
+
+    sim_run_for(90 * 60000);
+    CHECK_EQ(mock_gpio_level(RELAY_AUX_GPIO), 0);
+
+    // Then hold 205 F for half an hour
+    temp_cc_t lowest = INT32_MAX, highest = INT32_MIN;
+    int64_t main_high = mock_gpio_high_us(RELAY_MAIN_GPIO);
+    int64_t aux_high = mock_gpio_high_us(RELAY_AUX_GPIO);
+    for (int i = 0; i < 180; i++) {
+        sim_run_for(10000);
+        temp_cc_t t = crockpot_get_status().temperature;
+        lowest = t < lowest ? t : lowest;
+        highest = t > highest ? t : highest;
+    }
+    CHECK_NEAR(lowest, CROCKPOT_SETPOINT_HIGH, TEMP_CC_DELTA_F(2));
+    CHECK_NEAR(highest, CROCKPOT_SETPOINT_HIGH, TEMP_CC_DELTA_F(2));
+    CHECK_EQ(mock_gpio_high_us(RELAY_AUX_GPIO) - aux_high, 0);
+
+    // Holding needs as much power as the pot loses
+    double loss_w = PLANT_LOSS_W_PER_K * ((CROCKPOT_SETPOINT_HIGH / 100.0) - PLANT_AMBIENT_C);
+    int64_t expected_us = (int64_t)(loss_w / PLANT_MAIN_W * 1800e6);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_MAIN_GPIO) - main_high, expected_us, expected_us / 10);
+
+    CHECK(crockpot_get_healthy_cycles() > 5000);
+}
+
+static void test_hold_heater(void)
+{
+    crockpot_hold_heater(true);
+    int64_t main_high = mock_gpio_high_us(RELAY_MAIN_GPIO);
+    sim_run_for(60000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO) - main_high, 0);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_HIGH);
+    CHECK_EQ(crockpot_get_status().heater_duty_pct, 0);
+
+    crockpot_hold_heater(false);
+    main_high = mock_gpio_high_us(RELAY_MAIN_GPIO);
+    sim_run_for(60000);
+    CHECK(mock_gpio_high_us(RELAY_MAIN_GPIO) - main_high > 0);
+}
+
+static uint32_t s_frames[1];
+
+static void test_overheat_shutoff(void)
+{
+    s_notifications = 0;
+    s_frames[0] = mock_max31855_frame((int16_t)((310 - 32) * 4 * 5 / 9), 25 * 16);
+    mock_max31855_play(s_frames, 1, false);
+
+    sim_run_for(3000);
+    crockpot_status_t s = crockpot_get_status();
+    CHECK_EQ(s.state, CROCKPOT_OFF);
+    CHECK_EQ(s.setpoint, 0);
+    CHECK(s.temperature > CROCKPOT_SAFETY_TEMP);
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+    CHECK_EQ(mock_gpio_level(RELAY_AUX_GPIO), 0);
+    CHECK(s_notifications > 0);
+}
+
+static void test_sensor_fault_shutoff(void)
+{
+    mock_max31855_set_source(plant_source, &s_plant);
+    sim_run_for(5000);
+    CHECK(crockpot_set_state(CROCKPOT_LOW));
+    sim_run_for(5000);
+
+    s_frames[0] = mock_max31855_fault_frame(TEMPERATURE_FAULT_OPEN);
+    mock_max31855_play(s_frames, 1, false);
+
+    // Heater off as soon as the reading goes stale...
+    sim_run_for(2000);
+    crockpot_status_t s = crockpot_get_status();
+    CHECK(s.sensor_error);
+    CHECK_EQ(s.state, CROCKPOT_LOW);
+    CHECK_EQ(s.heater_duty_pct, 0);
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+    CHECK_EQ(crockpot_get_healthy_cycles(), 0);
+
+    // ...and the pot turns itself off after ten failed cycles
+    sim_run_for(11000);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_OFF);
+}
+
+int main(void)
+{
+    RUN_CASE(test_starts_off);
+    RUN_CASE(test_state_changes_notify);
+    RUN_CASE(test_regulates_high);
+    RUN_CASE(test_hold_heater);
+    RUN_CASE(test_overheat_shutoff);
+    RUN_CASE(test_sensor_fault_shutoff);
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file test_gui.c
+ * @brief Event-driven rendering and damage tracking on the status screen
+ *
+ * The GUI task draws into the framebuffer display HAL; the checks are on
+ * what it flushed and when, which is what the SPI panel would have cost.
+ */
+
+#include "host_test.h"
+#include "mock.h"
+
+#include "crockpot.h"
+#include "dlog.h"
+#include "gui.h"
+#include "metrics.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define SCREEN_BYTES    (320 * 240 * 2)
+
+static uint32_t s_frames[1];
+
+static void press(button_id_t button, int16_t x, int16_t y)
+{
+    touch_event_t event = {
+        .type = TOUCH_EVENT_PRESS,
+        .x = x,
+        .y = y,
+        .button = button,
+        .timestamp_ms = (uint32_t)(sim_now_us() / 1000),
+    };
+    mock_touch_push(&event);
+    event.type = TOUCH_EVENT_RELEASE;
+    mock_touch_push(&event);
+}
+
+static void test_first_frame_is_full(void)
+{
+    CHECK(dlog_init());
+    CHECK(metrics_init());
+
+    // Pot at a steady 25 C, control loop running
+    s_frames[0] = mock_max31855_frame(100, 25 * 16);
+    mock_max31855_play(s_frames, 1, false);
+    CHECK(crockpot_init());
+    CHECK(xTaskCreate(crockpot_control_task, "crockpot_ctrl", 4096, NULL, 5, NULL) == pdPASS);
+    sim_run_for(2000);
+
+    CHECK(gui_init());
+    CHECK(gui_start());
+    sim_run_for(100);
+
+    mock_display_stats_t s = mock_display_stats();
+    CHECK_EQ(s.flushes, 1);
+    CHECK_EQ(s.bytes_flushed, SCREEN_BYTES);
+    CHECK(s.pixels_written >= 320 * 240);
+    CHECK_EQ(s.brightness, 80);
+    CHECK_EQ(gui_get_screen(), GUI_SCREEN_MAIN);
+    CHECK_EQ(mock_display_pixel(0, 0), gui_get_theme().background);
+}
+
+static void test_idle_draws_nothing(void)
+{
+    mock_display_reset_stats();
+    sim_run_for(20000);
+    mock_display_stats_t s = mock_display_stats();
+    CHECK_EQ(s.flushes, 0);
+    CHECK_EQ(s.pixels_written, 0);
+}
+
+static void test_state_change_is_partial(void)
+{
+    mock_display_reset_stats();
+    CHECK(crockpot_set_state(CROCKPOT_LOW));
+    sim_run_for(100);
+
+    // Only the state line (and what overlaps it) is redrawn and flushed
+    mock_display_stats_t s = mock_display_stats();
+    CHECK_EQ(s.flushes, 1);
+    CHECK(s.bytes_flushed > 0);
+    CHECK(s.bytes_flushed <= 320 * 40 * 2);
+
+    // Heating starts on the next control cycle, which changes nothing shown
+    mock_display_reset_stats();
+    sim_run_for(5000);
+    CHECK_EQ(mock_display_stats().flushes, 0);
+}
+
+static void test_button_steps_state(void)
+{
+    gui_theme_t theme = gui_get_theme();
+    mock_display_reset_stats();
+
+    press(BUTTON_UP, 0, 0);
+    sim_run_for(100);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_HIGH);
+
+    // "HIGH" overlay in the accent colour, gone after a second
+    CHECK_EQ(mock_display_pixel(30, 120), theme.accent);
+    sim_run_for(1500);
+    CHECK_EQ(mock_display_pixel(30, 120), theme.background);
+    CHECK(mock_display_stats().bytes_flushed < SCREEN_BYTES);
+
+    // Touch zones on the button row: right steps up (already at HIGH),
+    // left steps down
+    press(BUTTON_NONE, 300, 185);
+    sim_run_for(100);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_HIGH);
+    press(BUTTON_NONE, 20, 185);
+    sim_run_for(100);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_LOW);
+
+    // A press while the overlay is up only dismisses it
+    press(BUTTON_DOWN, 0, 0);
+    sim_run_for(100);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_LOW);
+    CHECK_EQ(mock_display_pixel(30, 120), theme.background);
+}
+
+static void test_dims_when_idle(void)
+{
+    sim_run_for(25000);
+    CHECK(!gui_is_dimmed());
+    sim_run_for(6000);
+    CHECK(gui_is_dimmed());
+    CHECK_EQ(mock_display_stats().brightness, 10);
+
+    // Any touch wakes the screen back to the configured level
+    press(BUTTON_NONE, 160, 20);
+    sim_run_for(100);
+    CHECK(!gui_is_dimmed());
+    CHECK_EQ(mock_display_stats().brightness, gui_get_config().brightness);
+}
+
+static void test_clock_ticks_once_a_minute(void)
+{
+    mock_display_reset_stats();
+    sim_run_for(60000);
+
+    // The minute rolled over once (and the screen dimmed, which draws
+    // nothing): one small flush for the uptime text
+    mock_display_stats_t s = mock_display_stats();
+    CHECK_EQ(s.flushes, 1);
+    CHECK(s.bytes_flushed <= 160 * 20 * 2);
+}
+
+static void test_theme_and_screens_redraw_fully(void)
+{
+    gui_theme_t light = gui_default_light_theme();
+    mock_display_reset_stats();
+    gui_set_theme(&light);
+    sim_run_for(100);
+    CHECK_EQ(mock_display_stats().bytes_flushed, SCREEN_BYTES);
+    CHECK_EQ(mock_display_pixel(0, 0), light.background);
+
+    mock_display_reset_stats();
+    gui_set_screen(GUI_SCREEN_INFO);
+    sim_run_for(100);
+    CHECK_EQ(gui_get_screen(), GUI_SCREEN_INFO);
+    CHECK_EQ(mock_display_stats().bytes_flushed, SCREEN_BYTES);
+
+    // Any button goes back
+    press(BUTTON_SELECT, 0, 0);
+    sim_run_for(100);
+    CHECK_EQ(gui_get_screen(), GUI_SCREEN_MAIN);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_LOW);
+}
+
+int main(void)
+{
+    RUN_CASE(test_first_frame_is_full);
+    RUN_CASE(test_idle_draws_nothing);
+    RUN_CASE(test_state_change_is_partial);
+    RUN_CASE(test_button_steps_state);
+    RUN_CASE(test_dims_when_idle);
+    RUN_CASE(test_clock_ticks_once_a_minute);
+    RUN_CASE(test_theme_and_screens_redraw_fully);
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_relay.c
+ * @brief Time-proportioned relay output and the OTA hold
+ *
+ * The GPTimer tick runs on the virtual clock, so high time measured on the
+ * mock GPIO is exact to the tick.
+ */
+
+#include "host_test.h"
+#include "mock.h"
+
+#include "relay.h"
+
+#define TICK_US     (RELAY_TICK_MS * 1000)
+
+static void test_refused_before_init(void)
+{
+    CHECK(!relay_set(RELAY_CHANNEL_MAIN, true));
+    CHECK(!relay_set_duty(RELAY_CHANNEL_MAIN, 500));
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+}
+
+static void test_on_off(void)
+{
+    CHECK(relay_init());
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+    CHECK_EQ(mock_gpio_level(RELAY_AUX_GPIO), 0);
+
+    CHECK(relay_set(RELAY_CHANNEL_MAIN, true));
+    CHECK(relay_get(RELAY_CHANNEL_MAIN));
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 1);
+    CHECK_EQ(mock_gpio_level(RELAY_AUX_GPIO), 0);
+
+    CHECK(relay_set(RELAY_CHANNEL_MAIN, false));
+    CHECK(!relay_get(RELAY_CHANNEL_MAIN));
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+
+    CHECK(!relay_set(RELAY_CHANNEL_COUNT, true));
+}
+
+static void test_duty_cycle(void)
+{
+    // 30% of a 10 s window: 3 s on from each window start
+    mock_gpio_reset_stats();
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 300));
+    sim_run_for(30000);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_MAIN_GPIO), 9000000, TICK_US);
+    CHECK_EQ(mock_gpio_edges(RELAY_MAIN_GPIO), 6);
+
+    // A new duty waits for the next window
+    sim_run_for(5000);
+    mock_gpio_reset_stats();
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 700));
+    sim_run_for(5000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO), 0);
+    sim_run_for(10000);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_MAIN_GPIO), 7000000, TICK_US);
+}
+
+static void test_saturated_duty(void)
+{
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 1000));
+    sim_run_for(10000);
+    mock_gpio_reset_stats();
+    sim_run_for(30000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO), 30000000);
+    CHECK_EQ(mock_gpio_edges(RELAY_MAIN_GPIO), 0);
+
+    // Over-range requests clamp to full on
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 5000));
+    sim_run_for(10000);
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 1);
+
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 0));
+    sim_run_for(10000);
+    mock_gpio_reset_stats();
+    sim_run_for(30000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO), 0);
+}
+
+static void test_window_and_channels(void)
+{
+    // Shorter windows, each channel on its own duty
+    relay_set_window_ms(1000);
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 250));
+    CHECK(relay_set_duty(RELAY_CHANNEL_AUX, 750));
+    sim_run_for(10000);
+
+    mock_gpio_reset_stats();
+    sim_run_for(10000);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_MAIN_GPIO), 2500000, TICK_US);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_AUX_GPIO), 7500000, TICK_US);
+    CHECK_NEAR(mock_gpio_edges(RELAY_MAIN_GPIO), 20, 1);
+
+    // A plain write takes the channel out of modulation
+    CHECK(relay_set(RELAY_CHANNEL_AUX, false));
+    mock_gpio_reset_stats();
+    sim_run_for(5000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_AUX_GPIO), 0);
+    CHECK_NEAR(mock_gpio_high_us(RELAY_MAIN_GPIO), 1250000, TICK_US);
+}
+
+static void test_hold_refuses_heat(void)
+{
+    relay_hold_off(true);
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+    CHECK_EQ(mock_gpio_level(RELAY_AUX_GPIO), 0);
+
+    CHECK(!relay_set(RELAY_CHANNEL_MAIN, true));
+    CHECK(!relay_set_duty(RELAY_CHANNEL_MAIN, 500));
+    CHECK(relay_set_duty(RELAY_CHANNEL_MAIN, 0));
+    CHECK(relay_set(RELAY_CHANNEL_MAIN, false));
+
+    mock_gpio_reset_stats();
+    sim_run_for(20000);
+    CHECK_EQ(mock_gpio_high_us(RELAY_MAIN_GPIO), 0);
+    CHECK_EQ(mock_gpio_high_us(RELAY_AUX_GPIO), 0);
+
+    relay_hold_off(false);
+    CHECK(relay_set(RELAY_CHANNEL_MAIN, true));
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 1);
+
+    relay_all_off();
+    CHECK_EQ(mock_gpio_level(RELAY_MAIN_GPIO), 0);
+    CHECK(!relay_get(RELAY_CHANNEL_MAIN));
+}
+
+int main(void)
+{
+    RUN_CASE(test_refused_before_init);
+    RUN_CASE(test_on_off);
+    RUN_CASE(test_duty_cycle);
+    RUN_CASE(test_saturated_duty);
+    RUN_CASE(test_window_and_channels);
+    RUN_CASE(test_hold_refuses_heat);
+    return 0;
+}
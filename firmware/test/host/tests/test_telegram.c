@@ -0,0 +1,248 @@
+/**
+ * @file test_telegram.c
+ * @brief Telegram long poll, command dispatch and reply delivery
+ *
+ * The mock Bot API serves scripted getUpdates bodies and records
+ * sendMessage POSTs; telegram.c, json_stream.c and command.c run
+ * unchanged against it, with the real control loop behind the commands.
+ */
+
+#include "host_test.h"
+#include "mock.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "crockpot.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "telegram.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define CHAT    42
+#define OTHER   77
+
+static uint32_t s_frames[1];
+static int64_t s_next_update_id = 100;
+
+/**
+ * @brief Format one update as the Bot API sends it
+ */
+static size_t format_update(char* out, size_t len, int64_t chat_id, const char* text)
+{
+    return (size_t)snprintf(out, len,
+        "{\"update_id\":%lld,\"message\":{\"message_id\":%lld,"
+        "\"from\":{\"id\":%lld,\"is_bot\":false,\"first_name\":\"Cook\"},"
+        "\"chat\":{\"id\":%lld,\"first_name\":\"Cook\",\"type\":\"private\"},"
+        "\"date\":1760000000,\"text\":\"%s\"}}",
+        (long long)s_next_update_id, (long long)s_next_update_id,
+        (long long)chat_id, (long long)chat_id, text);
+}
+
+/**
+ * @brief Queue a getUpdates response carrying one message per text
+ */
+static void queue_messages(int64_t chat_id, const char* const* texts, size_t count)
+{
+    char body[2048];
+    size_t n = (size_t)snprintf(body, sizeof(body), "{\"ok\":true,\"result\":[");
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            body[n++] = ',';
+        }
+        n += format_update(body + n, sizeof(body) - n, chat_id, texts[i]);
+        s_next_update_id++;
+    }
+    snprintf(body + n, sizeof(body) - n, "]}");
+    mock_http_queue_poll(body, 200);
+}
+
+static void queue_message(int64_t chat_id, const char* text)
+{
+    queue_messages(chat_id, &text, 1);
+}
+
+static const char* last_post(void)
+{
+    size_t count = mock_http_post_count();
+    return count ? mock_http_post_body(count - 1) : "";
+}
+
+static bool offset_is(int64_t offset)
+{
+    char expected[32];
+    snprintf(expected, sizeof(expected), "offset=%lld", (long long)offset);
+    return strstr(mock_http_last_poll_url(), expected) != NULL;
+}
+
+static void test_starts_long_poll(void)
+{
+    CHECK(dlog_init());
+    CHECK(metrics_init());
+
+    s_frames[0] = mock_max31855_frame(100, 25 * 16);
+    mock_max31855_play(s_frames, 1, false);
+    CHECK(crockpot_init());
+    CHECK(xTaskCreate(crockpot_control_task, "crockpot_ctrl", 4096, NULL, 5, NULL) == pdPASS);
+
+    // No token, no Telegram
+    CHECK(!telegram_init());
+
+    config_t* config = mock_config();
+    strcpy(config->telegram_token, "123456:TEST");
+    config->saved |= CONFIG_SECTION_TELEGRAM;
+    CHECK(telegram_init());
+    CHECK(xTaskCreate(telegram_task, "telegram", 8192, NULL, 4, NULL) == pdPASS);
+
+    sim_run_for(2000);
+    CHECK_EQ(mock_http_poll_count(), 1);
+    CHECK(strstr(mock_http_last_poll_url(), "/bot123456:TEST/getUpdates?timeout=30") != NULL);
+    CHECK(offset_is(0));
+}
+
+static void test_status_reply(void)
+{
+    queue_message(CHAT, "/status");
+    sim_run_for(1000);
+
+    CHECK_EQ(mock_http_post_count(), 1);
+    CHECK(strstr(last_post(), "\"chat_id\":42,") != NULL);
+    CHECK(strstr(last_post(), "State: OFF\\nTemperature: 77.0 F") != NULL);
+    CHECK(telegram_is_connected());
+
+    // The next poll acknowledges the update
+    CHECK_EQ(mock_http_poll_count(), 2);
+    CHECK(offset_is(s_next_update_id));
+}
+
+static void test_replies_coalesce(void)
+{
+    const char* texts[] = { "/high", "hello", "/status@crockpot_bot" };
+    queue_messages(CHAT, texts, 3);
+    sim_run_for(1000);
+
+    // Both replies in one sendMessage; plain text is not a command
+    CHECK_EQ(mock_http_post_count(), 2);
+    CHECK(strstr(last_post(), "Crockpot set to HIGH\\n\\nCrockpot Status:\\nState: HIGH") != NULL);
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_HIGH);
+    CHECK(offset_is(s_next_update_id));
+
+    // Another chat's reply is a message of its own
+    queue_message(CHAT, "/status");
+    queue_message(OTHER, "/status");
+    sim_run_for(1000);
+    CHECK_EQ(mock_http_post_count(), 4);
+    CHECK(strstr(mock_http_post_body(2), "\"chat_id\":42,") != NULL);
+    CHECK(strstr(mock_http_post_body(3), "\"chat_id\":77,") != NULL);
+}
+
+static void test_update_needs_admin(void)
+{
+    queue_message(CHAT, "/update https://example.com/crockpot.bin");
+    sim_run_for(1000);
+    CHECK_EQ(mock_ota_start_calls(), 0);
+    CHECK(strstr(last_post(), "/update is not allowed from here") != NULL);
+}
+
+static void test_join_needs_admin(void)
+{
+    // Anyone may look at the fleet; only an admin may set its key
+    queue_message(CHAT, "/fleet");
+    sim_run_for(1000);
+    CHECK(strstr(last_post(), "Fleet mode off") != NULL);
+
+    queue_message(CHAT, "/join 3 0123456789abcdef");
+    queue_message(OTHER, "/join off");
+    sim_run_for(1000);
+    CHECK_EQ(mock_fleet_set_pot_calls(), 0);
+    const char* refused = mock_http_post_body(mock_http_post_count() - 2);
+    CHECK(strstr(refused, "/join is not allowed from here") != NULL);
+    CHECK(strstr(refused, "0123456789abcdef") == NULL);
+    CHECK(strstr(last_post(), "/join is not allowed from here") != NULL);
+}
+
+static void test_chunked_response(void)
+{
+    // The tokenizer must not care where the TLS records split the body
+    mock_http_set_chunk_size(1);
+    queue_message(CHAT, "/low");
+    sim_run_for(1000);
+    mock_http_set_chunk_size(0);
+
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_LOW);
+    CHECK(strstr(last_post(), "Crockpot set to LOW") != NULL);
+    CHECK(offset_is(s_next_update_id));
+}
+
+static void test_bad_responses_ignored(void)
+{
+    size_t posts = mock_http_post_count();
+    int64_t offset = s_next_update_id;
+
+    // Cut off mid-update
+    mock_http_queue_poll("{\"ok\":true,\"result\":[{\"update_id\":900,\"message\":"
+                         "{\"chat\":{\"id\":42},\"text\":\"/off\"", 200);
+    // Not ok
+    mock_http_queue_poll("{\"ok\":false,\"result\":[{\"update_id\":901,\"message\":"
+                         "{\"chat\":{\"id\":42},\"text\":\"/off\"}}]}", 200);
+    // Not JSON
+    mock_http_queue_poll("<html>Bad Gateway</html>", 200);
+    sim_run_for(1000);
+
+    CHECK_EQ(crockpot_get_status().state, CROCKPOT_LOW);
+    CHECK_EQ(mock_http_post_count(), posts);
+    CHECK(offset_is(offset));
+
+    // An HTTP error (answering the poll already waiting) backs off
+    // before polling again
+    uint32_t polls = mock_http_poll_count();
+    mock_http_queue_poll("{\"ok\":false}", 502);
+    sim_run_for(500);
+    CHECK(!telegram_is_connected());
+    CHECK_EQ(mock_http_poll_count(), polls);
+    sim_run_for(TELEGRAM_BACKOFF_MIN_MS);
+    CHECK_EQ(mock_http_poll_count(), polls + 1);
+}
+
+static void test_empty_long_poll(void)
+{
+    // Nothing to say: one request per timeout, no replies
+    sim_run_for(1000);
+    uint32_t polls = mock_http_poll_count();
+    size_t posts = mock_http_post_count();
+    sim_run_for(TELEGRAM_POLL_TIMEOUT_S * 2 * 1000);
+    CHECK_EQ(mock_http_poll_count(), polls + 2);
+    CHECK_EQ(mock_http_post_count(), posts);
+    CHECK(telegram_is_connected());
+}
+
+static void test_failed_send_retried(void)
+{
+    size_t posts = mock_http_post_count();
+    mock_http_fail_posts(1);
+    queue_message(CHAT, "/status");
+
+    sim_run_for(1000);
+    CHECK_EQ(mock_http_post_count(), posts);
+
+    // Delivered by the retry after the backoff
+    sim_run_for(TELEGRAM_BACKOFF_MIN_MS + 500);
+    CHECK_EQ(mock_http_post_count(), posts + 1);
+    CHECK(strstr(last_post(), "State: LOW") != NULL);
+}
+
+int main(void)
+{
+    RUN_CASE(test_starts_long_poll);
+    RUN_CASE(test_status_reply);
+    RUN_CASE(test_replies_coalesce);
+    RUN_CASE(test_update_needs_admin);
+    RUN_CASE(test_join_needs_admin);
+    RUN_CASE(test_chunked_response);
+    RUN_CASE(test_bad_responses_ignored);
+    RUN_CASE(test_empty_long_poll);
+    RUN_CASE(test_failed_send_retried);
+    return 0;
+}
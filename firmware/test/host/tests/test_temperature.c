@@ -0,0 +1,203 @@
+/**
+ * @file test_temperature.c
+ * @brief MAX31855 decoding, filtering, faults and staleness
+ *
+ * The mock SPI bus answers with 32-bit frames laid out as in the
+ * datasheet, so these cases exercise temperature.c's decoding unchanged.
+ */
+
+#include "host_test.h"
+#include "mock.h"
+
+#include <string.h>
+
+#include "temperature.h"
+
+#define CJ_25C  (25 * 16)
+
+static uint32_t s_frames[64];
+
+static void play_constant(int16_t tc_q)
+{
+    s_frames[0] = mock_max31855_frame(tc_q, CJ_25C);
+    mock_max31855_play(s_frames, 1, false);
+}
+
+static void test_unreadable_before_init(void)
+{
+    CHECK(!temperature_read().valid);
+    CHECK(!temperature_sensor_ok());
+}
+
+static void test_decodes_datasheet_frames(void)
+{
+    // Datasheet table: +25.00 C is 0x0064, cold junction +25.00 is 0x190
+    CHECK_EQ(mock_max31855_frame(100, CJ_25C), 0x01901900);
+    play_constant(100);
+    CHECK(temperature_init());
+    CHECK(sim_task_exists("temperature"));
+
+    sim_run_for(1000);
+    temperature_reading_t r = temperature_read();
+    CHECK(r.valid);
+    CHECK_EQ(r.fault, 0);
+    CHECK_EQ(r.raw_q, 100);
+    CHECK_EQ(r.temperature, 2500);
+    CHECK_EQ(r.cold_junction, 2500);
+    CHECK(temperature_sensor_ok());
+
+    // -1.00 C is 0x3FFC: 14-bit two's complement
+    play_constant(-4);
+    sim_run_for(5000);
+    r = temperature_read();
+    CHECK_EQ(r.raw_q, -4);
+    CHECK_EQ(r.temperature, -100);
+
+    // +100.75 C is 0x0193
+    play_constant(0x0193);
+    sim_run_for(5000);
+    r = temperature_read();
+    CHECK_EQ(r.raw_q, 403);
+    CHECK_EQ(r.temperature, 10075);
+}
+
+static void test_median_rejects_spikes(void)
+{
+    // Two back-to-back 1000 C glitches (a loose probe wire) must not
+    // reach the filtered value at all
+    size_t n = 0;
+    for (int i = 0; i < 20; i++) s_frames[n++] = mock_max31855_frame(403, CJ_25C);
+    s_frames[n++] = mock_max31855_frame(4000, CJ_25C);
+    s_frames[n++] = mock_max31855_frame(4000, CJ_25C);
+    for (int i = 0; i < 20; i++) s_frames[n++] = mock_max31855_frame(403, CJ_25C);
+    mock_max31855_play(s_frames, n, false);
+
+    temp_cc_t highest = 0;
+    for (int i = 0; i < 50; i++) {
+        sim_run_for(TEMPERATURE_SAMPLE_INTERVAL_MS);
+        temperature_reading_t r = temperature_read();
+        CHECK(r.valid);
+        if (r.temperature > highest) {
+            highest = r.temperature;
+        }
+    }
+    CHECK_EQ(highest, 10075);
+}
+
+static void test_fault_goes_stale(void)
+{
+    s_frames[0] = mock_max31855_fault_frame(TEMPERATURE_FAULT_OPEN);
+    mock_max31855_play(s_frames, 1, false);
+
+    // Reported at once, but the last good value stays usable for a while
+    sim_run_for(500);
+    temperature_reading_t r = temperature_read();
+    CHECK_EQ(r.fault, TEMPERATURE_FAULT_OPEN);
+    CHECK(r.valid);
+    CHECK_EQ(r.temperature, 10075);
+
+    sim_run_for(TEMPERATURE_STALE_MS);
+    CHECK(!temperature_read().valid);
+
+    s_frames[0] = mock_max31855_fault_frame(TEMPERATURE_FAULT_SHORT_VCC);
+    sim_run_for(200);
+    CHECK_EQ(temperature_read().fault, TEMPERATURE_FAULT_SHORT_VCC);
+
+    // A good sample makes the reading valid again straight away
+    play_constant(100);
+    sim_run_for(TEMPERATURE_SAMPLE_INTERVAL_MS);
+    r = temperature_read();
+    CHECK(r.valid);
+    CHECK_EQ(r.fault, 0);
+}
+
+static void test_bus_error(void)
+{
+    sim_run_for(5000);
+    uint32_t reads = mock_max31855_reads();
+
+    mock_max31855_set_bus_error(true);
+    sim_run_for(200);
+    CHECK_EQ(temperature_read().fault, TEMPERATURE_FAULT_BUS);
+    CHECK_EQ(mock_max31855_reads(), reads);
+    sim_run_for(TEMPERATURE_STALE_MS);
+    CHECK(!temperature_read().valid);
+
+    mock_max31855_set_bus_error(false);
+    sim_run_for(TEMPERATURE_SAMPLE_INTERVAL_MS);
+    CHECK(temperature_read().valid);
+    CHECK_EQ(temperature_read().temperature, 2500);
+}
+
+static void test_stalled_task_goes_stale(void)
+{
+    sim_run_for(1000);
+    CHECK(temperature_read().valid);
+
+    // The acquisition task stops publishing; readers must see the age
+    mock_max31855_set_stalled(true);
+    sim_run_for(TEMPERATURE_STALE_MS / 2);
+    CHECK(temperature_read().valid);
+    sim_run_for(TEMPERATURE_STALE_MS);
+    CHECK(!temperature_read().valid);
+    CHECK(!temperature_sensor_ok());
+
+    mock_max31855_set_stalled(false);
+    sim_run_for(TEMPERATURE_SAMPLE_INTERVAL_MS);
+    CHECK(temperature_read().valid);
+    CHECK_EQ(temperature_read().temperature, 2500);
+}
+
+static int64_t s_ramp_start_us;
+
+static uint32_t ramp_source(void* ctx)
+{
+    // 0.1 C/s: one sensor LSB (0.25 C) every 2.5 s
+    (void)ctx;
+    int64_t elapsed_ms = (sim_now_us() - s_ramp_start_us) / 1000;
+    return mock_max31855_frame((int16_t)(100 + elapsed_ms / 2500), CJ_25C);
+}
+
+static void test_slope_on_ramp(void)
+{
+    CHECK_NEAR(temperature_read().slope_cc_per_min, 0, 0);
+
+    s_ramp_start_us = sim_now_us();
+    mock_max31855_set_source(ramp_source, NULL);
+    sim_run_for((TEMPERATURE_SLOPE_WINDOW_S + 10) * 1000);
+
+    // 6 C/min, give or take one LSB over the window
+    temperature_reading_t r = temperature_read();
+    CHECK(r.valid);
+    CHECK_NEAR(r.slope_cc_per_min, 600, 60);
+}
+
+static void test_format_and_parse(void)
+{
+    char buf[16];
+    temp_format_f(buf, sizeof(buf), 2500);
+    CHECK(strcmp(buf, "77.0") == 0);
+    temp_format_c(buf, sizeof(buf), -100);
+    CHECK(strcmp(buf, "-1.0") == 0);
+
+    temp_cc_t t;
+    CHECK(temp_parse_f("205", &t));
+    CHECK_EQ(t, TEMP_CC_FROM_F(205));
+    CHECK(temp_parse_f(" 98.6", &t));
+    CHECK_EQ(t, 3700);
+    CHECK(!temp_parse_f("hot", &t));
+    CHECK(!temp_parse_f("", &t));
+}
+
+int main(void)
+{
+    RUN_CASE(test_unreadable_before_init);
+    RUN_CASE(test_decodes_datasheet_frames);
+    RUN_CASE(test_median_rejects_spikes);
+    RUN_CASE(test_fault_goes_stale);
+    RUN_CASE(test_bus_error);
+    RUN_CASE(test_stalled_task_goes_stale);
+    RUN_CASE(test_slope_on_ramp);
+    RUN_CASE(test_format_and_parse);
+    return 0;
+}
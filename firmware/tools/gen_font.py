@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""
+Generate the display font atlas (font_data.h) for display_hal.
+
+The glyphs are defined here as strokes (polylines and elliptical arcs) on
+a small unit grid and rasterized at each font_size_t pixel height with
+4x4 supersampling into 2-bpp anti-aliased bitmaps with proportional
+advance widths. Only the Python standard library is needed, so this
+runs in the ESP-IDF Python environment as part of the build.
+
+Unit grid: baseline at y=0, cap/ascender height 10, x-height 7,
+descender -3. One line spans y=11 (top) to y=-3 (bottom).
+
+Usage: gen_font.py --output font_data.h [--preview SIZE]
+"""
+
+import argparse
+import math
+import sys
+
+FIRST_CHAR = 32
+LAST_CHAR = 126
+
+# Line metrics in units
+ASCENT = 11.0
+DESCENT = 3.0
+
+# (C name, pixel height, stroke width in pixels)
+FONT_SIZES = [
+    ("font_small", 8, 1.0),
+    ("font_medium", 12, 1.3),
+    ("font_large", 16, 1.8),
+    ("font_xlarge", 24, 2.6),
+]
+
+SUPERSAMPLE = 4
+SPACING = 1.2   # Units between glyph boxes
+
+
+# ----------------------------------------------------------------------------
+# Stroke primitives
+# ----------------------------------------------------------------------------
+
+def L(*points):
+    """Polyline through the given points."""
+    return [tuple(map(float, p)) for p in points]
+
+
+def A(cx, cy, rx, ry, start, end):
+    """Elliptical arc from start to end degrees (either direction)."""
+    steps = max(6, int(abs(end - start) / 12))
+    pts = []
+    for i in range(steps + 1):
+        a = math.radians(start + (end - start) * i / steps)
+        pts.append((cx + rx * math.cos(a), cy + ry * math.sin(a)))
+    return pts
+
+
+def E(cx, cy, rx, ry):
+    """Closed ellipse."""
+    return A(cx, cy, rx, ry, 0, 360)
+
+
+def D(x, y):
+    """Dot."""
+    return [(x, y), (x, y + 0.01)]
+
+
+# Each glyph: (advance width in units, [strokes])
+GLYPHS = {
+    ' ': (3.0, []),
+    '!': (2.0, [L((1, 10), (1, 3)), D(1, 0)]),
+    '"': (4.0, [L((1, 10), (1, 7)), L((3, 10), (3, 7))]),
+    '#': (6.0, [L((2.2, 10), (1.2, 0)), L((4.8, 10), (3.8, 0)),
+                L((0, 6.8), (6, 6.8)), L((0, 3.2), (6, 3.2))]),
+    '$': (6.0, [A(3, 7.5, 2.5, 2.5, 30, 270), A(3, 2.5, 2.7, 2.5, 90, -150),
+                L((3, 11), (3, -1))]),
+    '%': (6.0, [E(1.5, 8.5, 1.4, 1.5), E(4.5, 1.5, 1.4, 1.5), L((5.5, 10), (0.5, 0))]),
+    '&': (6.5, [L((6, 0), (1.3, 6.4)), A(2.5, 8.2, 1.5, 1.8, 215, -35),
+                L((3.7, 7.1), (0.6, 3.2)), A(2.6, 2.2, 2.1, 2.2, 160, 300),
+                L((3.6, 0.3), (6, 3.5))]),
+    "'": (2.0, [L((1, 10), (1, 7))]),
+    '(': (3.5, [A(4.5, 4, 3.5, 7, 120, 240)]),
+    ')': (3.5, [A(-1.0, 4, 3.5, 7, 60, -60)]),
+    '*': (5.0, [L((2.5, 9.5), (2.5, 5.5)), L((0.8, 8.5), (4.2, 6.5)),
+                L((0.8, 6.5), (4.2, 8.5))]),
+    '+': (6.0, [L((3, 7), (3, 1)), L((0, 4), (6, 4))]),
+    ',': (2.0, [L((1.2, 0.5), (0.5, -1.5))]),
+    '-': (5.0, [L((0.5, 4), (4.5, 4))]),
+    '.': (2.0, [D(1, 0)]),
+    '/': (4.0, [L((4, 10), (0, -1))]),
+    '0': (6.0, [E(3, 5, 2.7, 5)]),
+    '1': (6.0, [L((1, 8), (3.2, 10), (3.2, 0)), L((1, 0), (5.4, 0))]),
+    '2': (6.0, [A(3, 7.5, 2.6, 2.5, 160, -20), L((5.44, 6.64), (0.3, 0), (5.7, 0))]),
+    '3': (6.0, [A(3, 7.6, 2.5, 2.4, 150, -90), A(3, 2.6, 2.7, 2.6, 90, -150)]),
+    '4': (6.0, [L((4.5, 0), (4.5, 10), (0, 3), (6, 3))]),
+    '5': (6.0, [L((5.5, 10), (1, 10), (0.8, 5.3)), A(3, 3.2, 2.8, 3.1, 140, -150)]),
+    '6': (6.0, [A(3, 5, 2.7, 5, 75, 200), E(3, 3, 2.7, 3)]),
+    '7': (6.0, [L((0.3, 10), (5.7, 10), (2, 0))]),
+    '8': (6.0, [E(3, 7.6, 2.3, 2.4), E(3, 2.6, 2.7, 2.6)]),
+    '9': (6.0, [E(3, 7, 2.7, 3), A(3, 5, 2.7, 5, -105, 20)]),
+    ':': (2.0, [D(1, 0), D(1, 6)]),
+    ';': (2.0, [D(1.2, 6), L((1.2, 0.5), (0.5, -1.5))]),
+    '<': (6.0, [L((5, 8), (0.5, 4), (5, 0))]),
+    '=': (6.0, [L((0.5, 5.5), (5.5, 5.5)), L((0.5, 2.5), (5.5, 2.5))]),
+    '>': (6.0, [L((1, 8), (5.5, 4), (1, 0))]),
+    '?': (5.5, [A(2.8, 7.6, 2.4, 2.4, 160, -70), L((3.62, 5.34), (2.8, 3.5), (2.8, 3)),
+                D(2.8, 0)]),
+    '@': (8.0, [E(3.8, 4.4, 1.4, 1.8), L((5.2, 6.2), (5.2, 3.2)),
+                A(6.2, 3.2, 1.0, 1.0, 180, 360), A(4, 4.4, 3.7, 4.6, 0, 300)]),
+    'A': (6.0, [L((0, 0), (3, 10), (6, 0)), L((1.1, 3.5), (4.9, 3.5))]),
+    'B': (6.0, [L((0.5, 0), (0.5, 10), (3.5, 10)), A(3.5, 7.6, 2.2, 2.4, 90, -90),
+                L((0.5, 5.2), (3.7, 5.2)), A(3.7, 2.6, 2.4, 2.6, 90, -90),
+                L((3.7, 0), (0.5, 0))]),
+    'C': (6.5, [A(3.6, 5, 3.3, 5, 45, 315)]),
+    'D': (6.5, [L((0.5, 0), (0.5, 10), (2.5, 10)), A(2.5, 5, 3.5, 5, 90, -90),
+                L((2.5, 0), (0.5, 0))]),
+    'E': (6.0, [L((5.5, 10), (0.5, 10), (0.5, 0), (5.5, 0)), L((0.5, 5), (4.5, 5))]),
+    'F': (5.5, [L((5.5, 10), (0.5, 10), (0.5, 0)), L((0.5, 5), (4.5, 5))]),
+    'G': (7.0, [A(3.6, 5, 3.3, 5, 40, 330), L((6.46, 2.5), (6.46, 4.5), (4, 4.5))]),
+    'H': (6.0, [L((0.5, 0), (0.5, 10)), L((5.5, 0), (5.5, 10)), L((0.5, 5), (5.5, 5))]),
+    'I': (2.0, [L((1, 0), (1, 10))]),
+    'J': (5.5, [L((4.5, 10), (4.5, 3)), A(2.5, 3, 2, 3, 0, -180)]),
+    'K': (6.0, [L((0.5, 0), (0.5, 10)), L((5.5, 10), (0.5, 3.5)), L((2.2, 5.5), (5.8, 0))]),
+    'L': (5.5, [L((0.5, 10), (0.5, 0), (5, 0))]),
+    'M': (7.5, [L((0.5, 0), (0.5, 10), (3.75, 3), (7, 10), (7, 0))]),
+    'N': (6.0, [L((0.5, 0), (0.5, 10), (5.5, 0), (5.5, 10))]),
+    'O': (7.0, [E(3.5, 5, 3.2, 5)]),
+    'P': (6.0, [L((0.5, 0), (0.5, 10), (3.5, 10)), A(3.5, 7.4, 2.2, 2.6, 90, -90),
+                L((3.5, 4.8), (0.5, 4.8))]),
+    'Q': (7.0, [E(3.5, 5, 3.2, 5), L((4, 2), (6.8, -0.6))]),
+    'R': (6.0, [L((0.5, 0), (0.5, 10), (3.5, 10)), A(3.5, 7.4, 2.2, 2.6, 90, -90),
+                L((3.5, 4.8), (0.5, 4.8)), L((3, 4.8), (5.7, 0))]),
+    'S': (6.0, [A(3, 7.5, 2.5, 2.5, 30, 270), A(3, 2.5, 2.7, 2.5, 90, -150)]),
+    'T': (6.0, [L((0, 10), (6, 10)), L((3, 10), (3, 0))]),
+    'U': (6.0, [L((0.5, 10), (0.5, 3)), A(3, 3, 2.5, 3, 180, 360), L((5.5, 3), (5.5, 10))]),
+    'V': (6.0, [L((0, 10), (3, 0), (6, 10))]),
+    'W': (8.0, [L((0, 10), (2, 0), (4, 7), (6, 0), (8, 10))]),
+    'X': (6.0, [L((0.3, 10), (5.7, 0)), L((5.7, 10), (0.3, 0))]),
+    'Y': (6.0, [L((0, 10), (3, 5), (6, 10)), L((3, 5), (3, 0))]),
+    'Z': (6.0, [L((0.5, 10), (5.5, 10), (0.5, 0), (5.5, 0))]),
+    '[': (3.5, [L((3, 11), (1, 11), (1, -2), (3, -2))]),
+    '\\': (4.0, [L((0, 10), (4, -1))]),
+    ']': (3.5, [L((0.5, 11), (2.5, 11), (2.5, -2), (0.5, -2))]),
+    '^': (6.0, [L((0.5, 7), (3, 10), (5.5, 7))]),
+    '_': (6.0, [L((0, -2), (6, -2))]),
+    '`': (3.0, [L((1, 10), (2, 8.5))]),
+    'a': (5.5, [E(2.6, 3.5, 2.3, 3.5), L((4.9, 7), (4.9, 0))]),
+    'b': (5.5, [L((0.5, 10), (0.5, 0)), E(2.9, 3.5, 2.4, 3.5)]),
+    'c': (5.0, [A(3, 3.5, 2.6, 3.5, 50, 310)]),
+    'd': (5.5, [L((5, 10), (5, 0)), E(2.6, 3.5, 2.4, 3.5)]),
+    'e': (5.5, [L((0.4, 3.6), (5.2, 3.6)), A(2.8, 3.5, 2.4, 3.5, 0, 320)]),
+    'f': (4.0, [L((1.6, 0), (1.6, 8)), A(3.2, 8, 1.6, 2, 180, 60), L((0.3, 7), (3.6, 7))]),
+    'g': (5.5, [E(2.6, 3.5, 2.3, 3.5), L((4.9, 7), (4.9, -1)), A(2.6, -1, 2.3, 2, 0, -160)]),
+    'h': (5.5, [L((0.5, 10), (0.5, 0)), A(2.8, 4.5, 2.3, 2.5, 180, 0), L((5.1, 4.5), (5.1, 0))]),
+    'i': (2.0, [L((1, 7), (1, 0)), D(1, 9.3)]),
+    'j': (3.0, [L((2, 7), (2, -1)), A(0.5, -1, 1.5, 2, 0, -120), D(2, 9.3)]),
+    'k': (5.0, [L((0.5, 10), (0.5, 0)), L((4.6, 7), (0.5, 2.8)), L((2, 4.3), (5, 0))]),
+    'l': (2.0, [L((1, 10), (1, 0))]),
+    'm': (8.2, [L((0.5, 7), (0.5, 0)), A(2.3, 5, 1.8, 2, 180, 0), L((4.1, 5), (4.1, 0)),
+                A(5.9, 5, 1.8, 2, 180, 0), L((7.7, 5), (7.7, 0))]),
+    'n': (5.6, [L((0.5, 7), (0.5, 0)), A(2.8, 4.5, 2.3, 2.5, 180, 0), L((5.1, 4.5), (5.1, 0))]),
+    'o': (5.6, [E(2.8, 3.5, 2.5, 3.5)]),
+    'p': (5.5, [L((0.5, 7), (0.5, -3)), E(2.9, 3.5, 2.4, 3.5)]),
+    'q': (5.5, [L((5, 7), (5, -3)), E(2.6, 3.5, 2.4, 3.5)]),
+    'r': (4.2, [L((0.5, 7), (0.5, 0)), A(3, 4.3, 2.5, 2.7, 180, 60)]),
+    's': (5.0, [A(2.5, 5.3, 2, 1.7, 30, 270), A(2.5, 1.75, 2.2, 1.75, 90, -150)]),
+    't': (4.5, [L((1.8, 9.5), (1.8, 1.5)), A(3.3, 1.5, 1.5, 1.5, 180, 300), L((0.3, 7), (4, 7))]),
+    'u': (5.6, [L((0.5, 7), (0.5, 2.5)), A(2.8, 2.5, 2.3, 2.5, 180, 360), L((5.1, 7), (5.1, 0))]),
+    'v': (5.4, [L((0, 7), (2.7, 0), (5.4, 7))]),
+    'w': (7.2, [L((0, 7), (1.8, 0), (3.6, 5), (5.4, 0), (7.2, 7))]),
+    'x': (5.3, [L((0.3, 7), (5, 0)), L((5, 7), (0.3, 0))]),
+    'y': (5.4, [L((0, 7), (2.7, 0)), L((5.4, 7), (1.6, -3))]),
+    'z': (5.5, [L((0.5, 7), (5, 7), (0.5, 0), (5, 0))]),
+    '{': (3.5, [L((3, 11), (2, 10.5), (2, 5.5), (0.8, 4.5), (2, 3.5), (2, -1.5), (3, -2))]),
+    '|': (2.0, [L((1, 11), (1, -2))]),
+    '}': (3.5, [L((0.5, 11), (1.5, 10.5), (1.5, 5.5), (2.7, 4.5), (1.5, 3.5),
+                  (1.5, -1.5), (0.5, -2))]),
+    '~': (5.0, [L((0.5, 4), (1.8, 5), (3.2, 4), (4.5, 5))]),
+}
+
+
+# ----------------------------------------------------------------------------
+# Rasterizer
+# ----------------------------------------------------------------------------
+
+def seg_dist2(px, py, ax, ay, bx, by):
+    dx, dy = bx - ax, by - ay
+    l2 = dx * dx + dy * dy
+    t = 0.0 if l2 == 0 else max(0.0, min(1.0, ((px - ax) * dx + (py - ay) * dy) / l2))
+    qx, qy = ax + t * dx - px, ay + t * dy - py
+    return qx * qx + qy * qy
+
+
+def rasterize(strokes, height, stroke_px):
+    """Return (x_offset, width, rows) where rows are lists of 0..3 levels."""
+    scale = height / (ASCENT + DESCENT)
+    radius = stroke_px / 2.0
+    ss = SUPERSAMPLE
+
+    # Segments in pixel space (y down)
+    segs = []
+    for stroke in strokes:
+        pts = [(x * scale + radius, (ASCENT - y) * scale) for x, y in stroke]
+        for i in range(len(pts) - 1):
+            segs.append(pts[i] + pts[i + 1])
+
+    if not segs:
+        return 0, 0, []
+
+    min_x = min(min(s[0], s[2]) for s in segs) - radius
+    max_x = max(max(s[0], s[2]) for s in segs) + radius
+    x0 = int(math.floor(min_x))
+    x1 = int(math.ceil(max_x))
+    width = max(1, x1 - x0)
+
+    hits = [[0] * (width * ss) for _ in range(height * ss)]
+    r2 = radius * radius
+
+    for ax, ay, bx, by in segs:
+        sx0 = max(0, int((min(ax, bx) - radius - x0) * ss))
+        sx1 = min(width * ss - 1, int((max(ax, bx) + radius - x0) * ss) + 1)
+        sy0 = max(0, int((min(ay, by) - radius) * ss))
+        sy1 = min(height * ss - 1, int((max(ay, by) + radius) * ss) + 1)
+        for sy in range(sy0, sy1 + 1):
+            py = (sy + 0.5) / ss
+            row = hits[sy]
+            for sx in range(sx0, sx1 + 1):
+                if row[sx]:
+                    continue
+                px = (sx + 0.5) / ss + x0
+                if seg_dist2(px, py, ax, ay, bx, by) <= r2:
+                    row[sx] = 1
+
+    rows = []
+    full = ss * ss
+    for y in range(height):
+        row = []
+        for x in range(width):
+            count = 0
+            for sy in range(y * ss, (y + 1) * ss):
+                count += sum(hits[sy][x * ss:(x + 1) * ss])
+            row.append(int(round(3.0 * count / full)))
+        rows.append(row)
+
+    return x0, width, rows
+
+
+def pack_rows(rows, width):
+    """Pack 2-bpp rows MSB-first, each row padded to a whole byte."""
+    out = []
+    for row in rows:
+        for i in range(0, width, 4):
+            b = 0
+            for j in range(4):
+                level = row[i + j] if i + j < width else 0
+                b |= level << (6 - 2 * j)
+            out.append(b)
+    return out
+
+
+def build_font(name, height, stroke_px):
+    scale = height / (ASCENT + DESCENT)
+    bitmap = []
+    glyphs = []
+
+    for code in range(FIRST_CHAR, LAST_CHAR + 1):
+        ch = chr(code)
+        advance_units, strokes = GLYPHS[ch]
+        x_off, width, rows = rasterize(strokes, height, stroke_px)
+        advance = max(1, int(round((advance_units + SPACING) * scale + stroke_px)))
+        glyphs.append((len(bitmap), width, advance, x_off, ch))
+        if width:
+            bitmap.extend(pack_rows(rows, width))
+
+    return {"name": name, "height": height, "bitmap": bitmap, "glyphs": glyphs}
+
+
+# ----------------------------------------------------------------------------
+# Output
+# ----------------------------------------------------------------------------
+
+def c_char_comment(ch):
+    if ch == '\\':
+        return "backslash"
+    return "'" + ch + "'"
+
+
+def emit(fonts, out):
+    out.write("// Generated by tools/gen_font.py - do not edit\n")
+    out.write("// Included once by font.c, which provides the font_t objects.\n\n")
+
+    for f in fonts:
+        name = f["name"]
+        out.write("static const uint8_t s_%s_bitmap[%d] = {\n" % (name, max(1, len(f["bitmap"]))))
+        data = f["bitmap"] or [0]
+        for i in range(0, len(data), 16):
+            out.write("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",\n")
+        out.write("};\n\n")
+
+        out.write("static const font_glyph_t s_%s_glyphs[%d] = {\n" % (name, len(f["glyphs"])))
+        for offset, width, advance, x_off, ch in f["glyphs"]:
+            out.write("    { %5d, %2d, %2d, %2d },  // %s\n"
+                      % (offset, width, advance, x_off, c_char_comment(ch)))
+        out.write("};\n\n")
+
+        out.write("static const font_t %s = {\n" % name)
+        out.write("    .bitmap = s_%s_bitmap,\n" % name)
+        out.write("    .glyphs = s_%s_glyphs,\n" % name)
+        out.write("    .first = %d,\n" % FIRST_CHAR)
+        out.write("    .last = %d,\n" % LAST_CHAR)
+        out.write("    .height = %d,\n" % f["height"])
+        out.write("};\n\n")
+
+
+def preview(font, text):
+    shades = " .+#"
+    height = font["height"]
+    glyphs = {g[4]: g for g in font["glyphs"]}
+    lines = [""] * height
+    for ch in text:
+        offset, width, advance, x_off, _ = glyphs[ch]
+        stride = (width + 3) // 4
+        cells = [[" "] * max(advance, x_off + width) for _ in range(height)]
+        for y in range(height):
+            for x in range(width):
+                b = font["bitmap"][offset + y * stride + x // 4] if width else 0
+                level = (b >> (6 - 2 * (x % 4))) & 3
+                if level and 0 <= x + x_off < len(cells[y]):
+                    cells[y][x + x_off] = shades[level]
+        for y in range(height):
+            lines[y] += "".join(cells[y][:advance])
+    print("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--output", help="Generated header path")
+    parser.add_argument("--preview", type=int, help="Print a sample at this pixel height")
+    args = parser.parse_args()
+
+    missing = [chr(c) for c in range(FIRST_CHAR, LAST_CHAR + 1) if chr(c) not in GLYPHS]
+    if missing:
+        sys.exit("gen_font.py: missing glyphs: " + "".join(missing))
+
+    if args.preview:
+        for name, height, stroke in FONT_SIZES:
+            if height == args.preview:
+                preview(build_font(name, height, stroke),
+                        "OFF WARM LOW HIGH 148.5 F 12:34 WiFi Sensor? (j)")
+                return
+        sys.exit("gen_font.py: no font with height %d" % args.preview)
+
+    if not args.output:
+        parser.error("--output is required")
+
+    fonts = [build_font(name, height, stroke) for name, height, stroke in FONT_SIZES]
+    with open(args.output, "w") as out:
+        emit(fonts, out)
+
+
+if __name__ == "__main__":
+    main()
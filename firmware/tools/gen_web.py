@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+"""
+Compress the web UI (main/www/index.html) for embedding in the firmware.
+
+The page is gzipped at the highest level with a zero timestamp so the
+output, and with it the ETag the server derives from it, only changes
+when the page itself does. Browsers get the compressed bytes as-is with
+Content-Encoding: gzip. Only the Python standard library is needed.
+
+Usage: gen_web.py --input index.html --output index.html.gz
+"""
+
+import argparse
+import gzip
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--input", required=True, help="page to compress")
+    parser.add_argument("--output", required=True, help="gzip file to write")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        page = f.read()
+
+    data = gzip.compress(page, compresslevel=9, mtime=0)
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    print(f"{args.input}: {len(page)} -> {len(data)} bytes", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())